@@ -1,8 +1,5 @@
 #include "AppManager.h"
 #include "renderer/SimpleRenderSystem.h"
-#include "camera/skCamera.h"
-#include "controller/KeyboardMovementController.h"
-#include "model/skBuffer.h"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -11,28 +8,28 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <iostream>
+#include <limits>
 #include <stdexcept>
+#include <string>
 
 namespace sk
 {	
-	struct GlobalUbo
-	{
-		glm::mat4 projectionView{ 1.f };
-		glm::vec4 ambientLightColor{ 1.f, 1.f, 1.f, .02f }; // w is intensity
-		glm::vec4 lightPosition{ -1.f };
-		alignas(16) glm::vec4 lightColor{ 1.f };		// w is light intensity
-	};
-
 	AppManager::AppManager()
 	{
 		// I'm able to link function calls like this because each function/method returns a REFERENCE to the object.
 		m_globalPool = skDescriptorPool::Builder(m_Device)
-			.setMaxSets(skSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, skSwapChain::MAX_FRAMES_IN_FLIGHT)
+			.setMaxSets(1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
 			.build();
+		m_Device.setMemoryBudgetCallback([this](uint32_t heapIndex, const skMemoryAllocator::Stats &stats)
+			{
+				onMemoryBudgetExceeded(heapIndex, stats);
+			});
+		m_skRenderer.setRecordingSliceCount(RECORDING_SLICES);
 		loadGameObjects();
 	}
 
@@ -40,106 +37,320 @@ namespace sk
 
 	void AppManager::run()
 	{
-		std::vector<std::unique_ptr<skBuffer>> uboBuffers(skSwapChain::MAX_FRAMES_IN_FLIGHT);
-		for (int i = 0; i < uboBuffers.size(); i++)
-		{
-			uboBuffers[i] = std::make_unique<skBuffer>(
-				m_Device,
-				sizeof(GlobalUbo),
-				1,
-				VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-				VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT
-			);
-			uboBuffers[i]->map();
-		}
-
+		// a single set for every frame, the GlobalUbo of each frame is a slice of the frame allocator picked by dynamic offset
 		auto globalSetLayout =
 			sk::skDescriptorSetLayout::Builder(m_Device)
-			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
 			.build();
 
-		std::vector<VkDescriptorSet> globalDescriptorSets(skSwapChain::MAX_FRAMES_IN_FLIGHT);
-		for (int i = 0; i < globalDescriptorSets.size(); i++)
-		{
-			auto bufferInfo = uboBuffers[i]->descriptorInfo();
-			skDescriptorWriter(*globalSetLayout, *m_globalPool)
-				.writeBuffer(0, &bufferInfo)
-				.build(globalDescriptorSets[i]);
-		}
+		VkDescriptorSet globalDescriptorSet;
+		VkDescriptorBufferInfo uboInfo{ m_skRenderer.getFrameAllocator().getBuffer(), 0, sizeof(GlobalUbo) };
+		skDescriptorWriter(*globalSetLayout, *m_globalPool)
+			.writeBuffer(0, &uboInfo)
+			.build(globalDescriptorSet);
 
 		SimpleRenderSystem simpleRenderSystem{ m_Device, m_skRenderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout() };
 		skCamera camera{};
-		camera.setViewTarget(glm::vec3(-1.f, -2.f, 2.f), glm::vec3(0.f, 0.f, 2.5f));
 
-		auto viewerObject = skGameObject::createGameObject();
-		viewerObject.transform.translation.z = -2.5f;
-		KeyboardMovementController cameraController{};
+		// the camera and transforms now live on the simulation thread, the loop below only renders their snapshots
+		TransformComponent viewer{};
+		viewer.translation.z = -2.5f;
+		m_simulation.setCamera(viewer);
+		for (uint32_t i = 0; i < m_gameObjects.size(); i++)
+			m_simulation.addObject(m_gameObjects.entities()[i], m_gameObjects.transforms().get(i));
+		m_simulation.start();
 
 		auto currentTime = std::chrono::high_resolution_clock::now();
+		float memoryLogTimer = 0.f;
+		float rateLogTimer = 0.f;
+		uint32_t framesSinceRateLog = 0;
+		uint64_t ticksAtRateLog = 0;
+		bool exportKeyDown = false;
 
 		std::cout << "maxPushConstantSize = " << m_Device.properties.limits.maxPushConstantsSize << std::endl;
+		const bool parallelRecording = m_skRenderer.getRecordingSliceCount() > 1;
+		std::cout << "Job system on " << m_jobSystem.threadCount() << " threads, recording draws "
+			<< (parallelRecording ? "in " + std::to_string(m_skRenderer.getRecordingSliceCount()) + " slices" : "inline") << std::endl;
 		while (!m_skWindow.shouldClose())
 		{
-			glfwPollEvents();
+			m_telemetry.beginFrame();
+			{
+				auto poll = m_telemetry.scopedPhase(skFramePhase::Poll);
+				glfwPollEvents();
+				m_simulation.sampleInput(m_skWindow.getGLFWwindow());
+
+				bool exportKey = glfwGetKey(m_skWindow.getGLFWwindow(), TELEMETRY_EXPORT_KEY) == GLFW_PRESS;
+				if (exportKey && !exportKeyDown)
+					exportTelemetry("telemetry_" + std::to_string(m_telemetry.frameCount()));
+				exportKeyDown = exportKey;
+			}
+			auto updateStart = std::chrono::steady_clock::now();
+
+			// models still loading are simply not drawn, the loop never waits on them
+			m_modelLoader.update();
+			resolvePendingModels();
+			m_Device.checkMemoryBudget();
 
 			auto newTime = std::chrono::high_resolution_clock::now();
 			float frameTime = std::chrono::duration<float, std::chrono::seconds::period>(newTime - currentTime).count();
 			currentTime = newTime;
-			
-			//frameTime = glm::min(frameTime, MAX_FRAME_TIME);
 
-			cameraController.moveInPlaneXZ(m_skWindow.getGLFWwindow(), frameTime, viewerObject);
-			camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+			memoryLogTimer += frameTime;
+			if (MEMORY_LOG_INTERVAL > 0.f && memoryLogTimer >= MEMORY_LOG_INTERVAL)
+			{
+				m_Device.printMemoryStats();
+				memoryLogTimer = 0.f;
+			}
+
+			// the two rates are independent: the simulation ticks at its fixed rate whatever the frame rate
+			rateLogTimer += frameTime;
+			if (RATE_LOG_INTERVAL > 0.f && rateLogTimer >= RATE_LOG_INTERVAL)
+			{
+				uint64_t ticks = m_simulation.tickCount();
+				skTelemetry::Summary telemetry = m_telemetry.summarize();
+				std::cout << "Simulation: " << (ticks - ticksAtRateLog) / rateLogTimer << " ticks/s (target " << m_simulation.tickRate()
+					<< "), render: " << framesSinceRateLog / rateLogTimer << " frames/s, frame time p50 " << telemetry.frame.p50
+					<< " ms, p99 " << telemetry.frame.p99 << " ms" << std::endl;
+				ticksAtRateLog = ticks;
+				framesSinceRateLog = 0;
+				rateLogTimer = 0.f;
+			}
+
+			// ticks finished since the last frame collapse into the newest, frames without a new tick redraw the same one
+			bool newSnapshot = false;
+			const SceneSnapshot &snapshot = m_simulation.latestSnapshot(&newSnapshot);
+			if (newSnapshot)
+				applySnapshot(snapshot, camera);
 
 			float aspect = m_skRenderer.getAspectRatio();
 			camera.setPerspectiveProjection(glm::radians(50.f), aspect, .1f, 100.f);
 
-			if (auto commandBuffer = m_skRenderer.beginFrame()) // beginFrame() will return a nullptr if the swapchain needs to be created
+			// record is whatever of beginFrame ... endFrame the swap chain timings do not cover
+			auto frameStart = std::chrono::steady_clock::now();
+			m_telemetry.addPhase(skFramePhase::Update, frameStart - updateStart);
+			auto addSwapChainPhases = [this]
+				{
+					const skSwapChain::Timings &timings = m_skRenderer.getFrameTimings();
+					m_telemetry.addPhase(skFramePhase::FenceWait, timings.fenceWait);
+					m_telemetry.addPhase(skFramePhase::Acquire, timings.acquire);
+					m_telemetry.addPhase(skFramePhase::Submit, timings.submit);
+					m_telemetry.addPhase(skFramePhase::Present, timings.present);
+					return timings.fenceWait + timings.acquire + timings.submit + timings.present;
+				};
+
+			auto commandBuffer = m_skRenderer.beginFrame(); // beginFrame() will return a nullptr if the swapchain needs to be created
+			if (!commandBuffer)
+				addSwapChainPhases();
+			else
 			{
 				int frameIndex = m_skRenderer.getFrameIndex();
-				FrameInfo frameInfo{ frameIndex, frameTime, commandBuffer, camera, globalDescriptorSets[frameIndex], m_gameObjects};
+				// the slot's fence signaled, the geometry its last frame drew may be reused now
+				m_geometryArena.beginFrame(static_cast<uint32_t>(frameIndex));
+				skFrameAllocator &frameAllocator = m_skRenderer.getFrameAllocator();
+				skGpuProfiler &gpuProfiler = m_skRenderer.getGpuProfiler();
+				// read back by beginFrame, from when this frame slot was last recorded
+				for (const skGpuProfiler::ScopeTiming &timing : gpuProfiler.results())
+					m_telemetry.addGpuScope(timing.name, timing.ms);
 
 				// update
 				GlobalUbo ubo{};
 				ubo.projectionView = camera.getProjection() * camera.getView();
-				uboBuffers[frameIndex]->writeToBuffer(&ubo);
-				uboBuffers[frameIndex]->flush();
+				ubo.ambientLightColor = snapshot.ambientLightColor;
+				ubo.lightPosition = snapshot.lightPosition;
+				ubo.lightColor = snapshot.lightColor;
+				auto uboSlice = frameAllocator.push(ubo);
+
+				FrameInfo frameInfo{ frameIndex, frameTime, commandBuffer, camera, globalDescriptorSet,
+					static_cast<uint32_t>(uboSlice.offset), m_gameObjects, m_skRenderer.getSwapChainExtent(), frameAllocator };
+				frameInfo.jobSystem = &m_jobSystem;
+				frameInfo.gpuProfiler = &gpuProfiler;
 
 				/* beginFrame() and beginSwapChainRenderPass() aren't combined into a single function because this down the line this will help us
 				 *  integrate multiple renderpasses for things such as reflections, shadows and post-processing effects. */
 				// render
-				m_skRenderer.beginSwapChainRenderPass(commandBuffer);
+				if (parallelRecording)
+				{
+					m_skRenderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+					frameInfo.parallelRecorder = &m_skRenderer.getParallelRecorder();
+				}
+				else
+					m_skRenderer.beginSwapChainRenderPass(commandBuffer);
 				simpleRenderSystem.renderGameObjects(frameInfo);
 				m_skRenderer.endSwapChainRenderPass(commandBuffer);
 				m_skRenderer.endFrame();
+				auto blocked = addSwapChainPhases();
+				m_telemetry.addPhase(skFramePhase::Record, std::chrono::steady_clock::now() - frameStart - blocked);
+				framesSinceRateLog++;
 			}
+
+			// whatever the frame scheduled and did not wait on finishes here, the job storage is recycled
+			m_jobSystem.waitFrame();
 		}
 
+		m_simulation.stop();
 		vkDeviceWaitIdle(m_Device.device());
+		exportTelemetry("telemetry");
+	}
+
+	void AppManager::applySnapshot(const SceneSnapshot &snapshot, skCamera &camera)
+	{
+		camera.setViewYXZ(snapshot.camera.translation, snapshot.camera.rotation);
+		m_viewerPosition = snapshot.camera.translation;
+		if (snapshot.transformsRevision == m_appliedTransformsRevision)
+			return;
+		m_appliedTransformsRevision = snapshot.transformsRevision;
+		for (const auto &[entity, transform] : snapshot.transforms)
+		{
+			if (m_gameObjects.contains(entity))
+				m_gameObjects.setTransform(entity, transform);
+		}
+	}
+
+	void AppManager::exportTelemetry(const std::string &name)
+	{
+		skTelemetry::Summary summary = m_telemetry.summarize();
+		std::cout << "Frame time over the last " << summary.frames << " frames: mean " << summary.frame.mean << " ms, p50 "
+			<< summary.frame.p50 << ", p95 " << summary.frame.p95 << ", p99 " << summary.frame.p99 << ", max " << summary.frame.max
+			<< ", variance " << summary.frame.variance << " ms^2, " << summary.hitches << " hitches" << std::endl;
+		for (uint32_t phase = 0; phase < FRAME_PHASE_COUNT; phase++)
+		{
+			const skTelemetry::Distribution &distribution = summary.phases[phase];
+			std::cout << "  " << toString(static_cast<skFramePhase>(phase)) << ": p50 " << distribution.p50 << " ms, p99 "
+				<< distribution.p99 << " ms, max " << distribution.max << " ms" << std::endl;
+		}
+		for (const auto &[scope, distribution] : summary.gpuScopes)
+		{
+			std::cout << "  gpu " << scope << ": p50 " << distribution.p50 << " ms, p99 " << distribution.p99 << " ms, max "
+				<< distribution.max << " ms" << std::endl;
+		}
+
+		if (m_telemetry.exportCsv(name + ".csv") && m_telemetry.exportJson(name + ".json"))
+			std::cout << "Telemetry written to " << name << ".csv and " << name << ".json" << std::endl;
 	}
 
 	void AppManager::loadGameObjects()
 	{
-		std::shared_ptr<skModel> model = skModel::createModelFromFile(m_Device, "res\\models\\flat_vase.obj");
-		auto flatVase = skGameObject::createGameObject();
-		flatVase.model = model;
-		flatVase.transform.translation = { -.5f, .5f, 0.f };
-		flatVase.transform.scale = { 3.f, 1.5f, 3.f };
-		m_gameObjects.emplace(flatVase.getId(), std::move(flatVase));
+		m_loadStart = std::chrono::steady_clock::now();
+
+		// the vases use the packed vertex format, the floor keeps full floats
+		TransformComponent flatVase{};
+		flatVase.translation = { -.5f, .5f, 0.f };
+		flatVase.scale = { 3.f, 1.5f, 3.f };
+		m_pendingModels.emplace_back(m_gameObjects.create(flatVase), m_modelLoader.load("res\\models\\flat_vase.obj", skModel::VertexFormat::Packed));
 		
-		model = skModel::createModelFromFile(m_Device, "res\\models\\smooth_vase.obj");
-		auto smoothVase = skGameObject::createGameObject();
-		smoothVase.model = model;
-		smoothVase.transform.translation = { .5f, .5f, 0.f };
-		smoothVase.transform.scale = { 3.f, 1.5f, 3.f };
-		m_gameObjects.emplace(smoothVase.getId(), std::move(smoothVase));
-
-		model = skModel::createModelFromFile(m_Device, "res\\models\\quad.obj");
-		auto floor = skGameObject::createGameObject();
-		floor.model = model;
-		floor.transform.translation = { .0f, .5f, 0.f };
-		floor.transform.scale = { 3.f, 1.f, 3.f };
-		m_gameObjects.emplace(floor.getId(), std::move(floor));
+		TransformComponent smoothVase{};
+		smoothVase.translation = { .5f, .5f, 0.f };
+		smoothVase.scale = { 3.f, 1.5f, 3.f };
+		m_pendingModels.emplace_back(m_gameObjects.create(smoothVase), m_modelLoader.load("res\\models\\smooth_vase.obj", skModel::VertexFormat::Packed));
+
+		TransformComponent floor{};
+		floor.translation = { .0f, .5f, 0.f };
+		floor.scale = { 3.f, 1.f, 3.f };
+		m_pendingModels.emplace_back(m_gameObjects.create(floor), m_modelLoader.load("res\\models\\quad.obj"));
+
+		std::cout << "Loading " << m_pendingModels.size() << " models on " << m_modelLoader.threadCount() << " threads, uploading through the "
+			<< (m_uploadContext.usesTransferQueue() ? "dedicated transfer queue" : "graphics queue") << std::endl;
+	}
+
+	void AppManager::resolvePendingModels()
+	{
+		if (m_pendingModels.empty())
+			return;
+
+		std::erase_if(m_pendingModels, [this](const std::pair<skEntity, skModelLoader::Handle> &pending)
+			{
+				const skModelLoader::Handle &handle = pending.second;
+				if (handle.failed())
+					std::cerr << "Failed to load " << handle.filepath() << " : " << handle.error() << std::endl;
+				else if (handle.ready())
+				{
+					if (m_gameObjects.contains(pending.first)) // the object may be gone by the time its model is
+						m_gameObjects.setModel(pending.first, m_gameObjects.addModel(handle.get()));
+				}
+				else
+					return false;
+				return true;
+			});
+
+		if (m_pendingModels.empty())
+		{
+			float loadTime = std::chrono::duration<float, std::chrono::milliseconds::period>(std::chrono::steady_clock::now() - m_loadStart).count();
+			skUploadContext::Stats uploadStats = m_uploadContext.stats();
+			std::cout << "Scene resident after " << loadTime << " ms (" << uploadStats.copies << " copies, "
+				<< uploadStats.bytes / 1024 << " KB in " << uploadStats.submits << " submits)" << std::endl;
+			printSceneMemory();
+		}
+	}
+
+	void AppManager::printSceneMemory()
+	{
+		// index memory of the scene, the registry keeps each model once however many objects share it
+		VkDeviceSize indexMemory = 0, indexMemorySaved = 0;
+		for (uint32_t i = 0; i < m_gameObjects.modelCount(); i++)
+		{
+			const skModel *sceneModel = m_gameObjects.model(i);
+			if (sceneModel == nullptr) // evicted
+				continue;
+			indexMemory += sceneModel->indexMemory();
+			indexMemorySaved += sceneModel->indexMemorySaved();
+		}
+		std::cout << "Index memory: " << indexMemory / 1024 << " KB (" << indexMemorySaved / 1024
+			<< " KB saved by 16-bit indices)" << std::endl;
+
+		skGeometryArena::Stats arenaStats = m_geometryArena.stats();
+		std::cout << "Geometry arena: " << arenaStats.allocations << " allocations in " << arenaStats.blocks << " blocks, "
+			<< arenaStats.used / 1024 << " KB used of " << arenaStats.capacity / 1024 << " KB" << std::endl;
+
+		m_Device.printMemoryStats();
+	}
+
+	void AppManager::onMemoryBudgetExceeded(uint32_t heapIndex, const skMemoryAllocator::Stats &stats)
+	{
+		const auto &heap = stats.heaps[heapIndex];
+		std::cerr << "Memory budget exceeded on heap " << heapIndex << ": " << heap.usage / (1024 * 1024) << " MB used of "
+			<< heap.budget / (1024 * 1024) << " MB" << (stats.driverBudget ? "" : " (estimated)") << std::endl;
+
+		// geometry is what the app can give back. nothing here waits on the device: the arena keeps freed ranges until the
+		//   frames drawing them retired, and trim() releases the blocks left empty without copying anything
+		if (heap.categoryBytes[static_cast<uint32_t>(skMemoryCategory::Geometry)] == 0)
+			return;
+		const VkDeviceSize target = static_cast<VkDeviceSize>(static_cast<double>(heap.budget) * MEMORY_BUDGET_TARGET);
+		const VkDeviceSize excess = heap.usage - std::min(heap.usage, target);
+
+		// models no object uses go first, then by how far their nearest object is from the viewer
+		std::vector<float> distances(m_gameObjects.modelCount(), std::numeric_limits<float>::max());
+		std::span<const skGameObjectRegistry::ModelHandle> modelHandles = m_gameObjects.modelHandles();
+		const skTransformSystem &transforms = m_gameObjects.transforms();
+		for (uint32_t i = 0; i < modelHandles.size(); i++)
+		{
+			const skGameObjectRegistry::ModelHandle handle = modelHandles[i];
+			if (handle != skGameObjectRegistry::NO_MODEL)
+				distances[handle] = std::min(distances[handle], glm::distance(transforms.translation(i), m_viewerPosition));
+		}
+		std::vector<skGameObjectRegistry::ModelHandle> candidates{};
+		for (skGameObjectRegistry::ModelHandle handle = 0; handle < m_gameObjects.modelCount(); handle++)
+		{
+			if (m_gameObjects.model(handle) != nullptr)
+				candidates.push_back(handle);
+		}
+		std::sort(candidates.begin(), candidates.end(),
+			[&distances](skGameObjectRegistry::ModelHandle a, skGameObjectRegistry::ModelHandle b) { return distances[a] > distances[b]; });
+
+		VkDeviceSize evicted = 0;
+		uint32_t evictedModels = 0;
+		for (skGameObjectRegistry::ModelHandle handle : candidates)
+		{
+			if (evicted >= excess)
+				break;
+			const skModel *model = m_gameObjects.model(handle);
+			evicted += model->vertexMemory() + model->indexMemory();
+			m_gameObjects.releaseModel(handle);
+			evictedModels++;
+		}
+
+		VkDeviceSize released = m_geometryArena.trim();
+		std::cerr << "Evicted " << evictedModels << " models (" << evicted / 1024 << " KB of geometry), " << released / 1024
+			<< " KB of arena blocks released now, the rest once the frames drawing them retired" << std::endl;
 	}
 
 } // namespace sk
\ No newline at end of file
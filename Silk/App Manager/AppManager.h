@@ -3,11 +3,21 @@
 #include "window/skWindow.h"
 #include "renderer/skRenderer.h"
 #include "core/skDevice.h"
+#include "core/skJobSystem.h"
+#include "core/skTelemetry.h"
+#include "core/skUploadContext.h"
+#include "model/skGeometryArena.h"
+#include "model/skModelLoader.h"
+#include "simulation/skSimulation.h"
 #include "skGameObject.h"
 #include "descriptor/skDescriptors.h"
+#include "camera/skCamera.h"
 
 // std
+#include <chrono>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 namespace sk
@@ -17,6 +27,16 @@ namespace sk
 	public:
 		static constexpr int WIDTH = 800;
 		static constexpr int HEIGHT = 600;
+		static constexpr float MEMORY_BUDGET_TARGET = .8f; // share of a heap's budget evictions bring its usage back under
+		static constexpr float MEMORY_LOG_INTERVAL = 30.f; // seconds between device memory logs, 0 disables them
+		static constexpr float RATE_LOG_INTERVAL = 5.f; // seconds between simulation and render rate logs, 0 disables them
+		static constexpr float SIMULATION_TICK_RATE = 120.f; // fixed simulation steps per second, rendering runs as fast as present allows
+		static constexpr uint32_t TELEMETRY_FRAMES = 4096; // frames kept for percentiles and export
+		static constexpr int TELEMETRY_EXPORT_KEY = GLFW_KEY_F9; // writes telemetry_<frame>.csv/.json, telemetry.csv/.json is written at exit
+		// threads of the job system running the per-frame work, the main thread included. 0 uses every hardware thread
+		static constexpr uint32_t JOB_THREADS = 0;
+		// secondary command buffers the scene is recorded into in parallel, 0 uses one per job thread, 1 records inline
+		static constexpr uint32_t RECORDING_SLICES = 0;
 
 		AppManager();
 		~AppManager();
@@ -29,14 +49,33 @@ namespace sk
 
 	private:
 		void loadGameObjects();
+		// hands finished background loads to their game objects, once per frame
+		void resolvePendingModels();
+		void printSceneMemory();
+		// the snapshot's camera and transforms onto the render side's copies
+		void applySnapshot(const SceneSnapshot &snapshot, skCamera &camera);
+		// <name>.csv and <name>.json in the working directory, plus a summary on stdout
+		void exportTelemetry(const std::string &name);
+		// budget breach on heapIndex: frees what can be freed without dropping assets the scene still draws
+		void onMemoryBudgetExceeded(uint32_t heapIndex, const skMemoryAllocator::Stats &stats);
 
 		skWindow m_skWindow{ WIDTH, HEIGHT, "Hello Silk!" };
 		skDevice m_Device{ m_skWindow };
-		skRenderer m_skRenderer{ m_skWindow, m_Device };
+		skJobSystem m_jobSystem{ JOB_THREADS }; // before everything scheduling jobs
+		skRenderer m_skRenderer{ m_skWindow, m_Device, m_jobSystem };
 
 		// note: order of declarations matters here
 		// memory is allocated for declared objects from top to bottom, memory is deallocated from bottom to top
 		std::unique_ptr<skDescriptorPool> m_globalPool{};
-		skGameObject::Map m_gameObjects;
+		skUploadContext m_uploadContext{ m_Device }; // created (and submitted) on the render thread
+		skGeometryArena m_geometryArena{ m_Device, m_uploadContext }; // must outlive every model
+		skModelLoader m_modelLoader{ m_geometryArena, m_uploadContext };
+		std::vector<std::pair<skEntity, skModelLoader::Handle>> m_pendingModels{};
+		std::chrono::steady_clock::time_point m_loadStart{};
+		skGameObjectRegistry m_gameObjects{}; // render side: models, plus the transforms of the latest snapshot
+		skSimulation m_simulation{ SIMULATION_TICK_RATE };
+		uint64_t m_appliedTransformsRevision = 0; // SceneSnapshot::transformsRevision last written to m_gameObjects
+		glm::vec3 m_viewerPosition{ 0.f }; // camera of the latest snapshot, evictions keep the models near it
+		skTelemetry m_telemetry{ TELEMETRY_FRAMES };
 	};
 } // namespace sk
\ No newline at end of file
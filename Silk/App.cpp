@@ -1,11 +1,17 @@
 #include "App Manager/AppManager.h"
+#include "bench/skBenchmark.h"
 
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
 
-int main() 
+int main(int argc, char **argv)
 {
+	// "Silk --bench <name> [args...]" runs a benchmark instead of the app, see bench/skBenchmark.cpp for the list
+	if (argc > 1 && std::string(argv[1]) == "--bench")
+		return sk::skBenchmark::run(argc - 2, argv + 2);
+
 	sk::AppManager app{};
 
 	try
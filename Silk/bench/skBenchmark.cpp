@@ -0,0 +1,107 @@
+#include "skBenchmark.h"
+
+// std
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+namespace sk
+{
+	namespace
+	{
+		struct BenchmarkEntry
+		{
+			const char *name;
+			const char *description;
+			int (*fn)(const std::vector<std::string>& args);
+		};
+
+		const BenchmarkEntry BENCHMARKS[] = {
+			{ "obj", "OBJ import throughput, skObjParser vs tinyobj, output checked with forced chunks [--size N] [--reps N] [--chunks N] [files...]", benchmarkObjReaders },
+			{ "weld", "vertex welding time and peak memory, unordered_map vs skVertexWelder [--size N] [--reps N] [files...]", benchmarkVertexWelding },
+			{ "vcache", "ACMR/ATVR before and after Builder::optimize, with and without overdraw [--size N] [--reps N] [files...]", benchmarkMeshOptimizer },
+			{ "lod", "LOD chain generation time, triangle counts and error per level [--size N] [--reps N] [files...]", benchmarkSimplifier },
+#ifndef SK_BENCHMARK_CPU_ONLY // the CPU only build (CMakeLists.txt) has no device to render with
+			{ "record", "CPU frame time against object count and recording slices [--objects N,N] [--slices N,N] [--frames N] [--model path]", benchmarkRecording },
+			{ "headless", "CPU and GPU frame time percentiles rendering a generated scene offscreen, no window or display needed [--frames N] [--warmup N] [--width N] [--height N] [--objects N] [--triangles N] [--unique R] [--seed N] [--flythrough] [--slices N] [--model path] [--out name]", benchmarkHeadless },
+			{ "scale", "headless frame time percentiles over generated scenes of every object count x triangles per object x unique model ratio, fails on a p95 regression against a baseline [--objects N,N] [--triangles N,N] [--unique R,R] [--frames N] [--seed N] [--flythrough] [--model path] [--out name] [--baseline csv] [--tolerance R]", benchmarkScalability },
+#endif
+			{ "jobs", "job system scaling from 1 to N threads: parallel for, dependency graph, scheduling overhead [--threads N,N] [--size N] [--reps N] [--profile]", benchmarkJobSystem },
+			{ "micro", "ns/op of CPU hot paths: hashCombine, TransformComponent, skCamera, skGameObjectRegistry iteration, skMemoryAllocator (SilkBench only), Builder::loadModel [--size N] [--reps N] [--warmup N] [--obj N] [--filter text] [--out name] [--baseline csv] [--tolerance R]", benchmarkMicro },
+			{ "ecs", "game object storage, skGameObjectRegistry vs the unordered_map it replaced: create, iterate, lookup, churn [--counts N,N] [--reps N]", benchmarkEntities },
+			{ "transforms", "ns/object of skTransformSystem::update per kernel against TransformComponent, with the difference to it checked [--count N] [--reps N] [--tolerance R]", benchmarkTransforms },
+		};
+
+		void printUsage()
+		{
+#ifdef SK_BENCHMARK_CPU_ONLY
+			std::cout << "usage: SilkBench <name> [args...]\n";
+#else
+			std::cout << "usage: Silk --bench <name> [args...]\n";
+#endif
+			for (const auto& entry : BENCHMARKS)
+				std::cout << "  " << entry.name << "\t" << entry.description << "\n";
+		}
+	} // namespace
+
+	void skBenchmark::print(const BenchmarkResult& result)
+	{
+		char line[256];
+		if (result.bytesPerRepetition > 0)
+			std::snprintf(line, sizeof(line), "%-48s %12.3f ms (min) %12.3f ms (mean) %10.1f MB/s", result.name.c_str(),
+				result.minNs * 1e-6, result.meanNs * 1e-6, result.megabytesPerSecond());
+		else
+			std::snprintf(line, sizeof(line), "%-48s %12.3f ms (min) %12.3f ms (mean)", result.name.c_str(),
+				result.minNs * 1e-6, result.meanNs * 1e-6);
+		std::cout << line << std::endl;
+	}
+
+	MeshBenchmarkOptions parseMeshBenchmarkArgs(const std::vector<std::string>& args)
+	{
+		MeshBenchmarkOptions options{};
+		for (size_t i = 0; i < args.size(); i++)
+		{
+			if (args[i] == "--size" && i + 1 < args.size())
+				options.syntheticSize = static_cast<uint32_t>(std::stoul(args[++i]));
+			else if (args[i] == "--reps" && i + 1 < args.size())
+				options.settings.repetitions = static_cast<uint32_t>(std::stoul(args[++i]));
+			else if (args[i] == "--chunks" && i + 1 < args.size())
+				options.chunks = static_cast<uint32_t>(std::stoul(args[++i]));
+			else
+				options.files.push_back(args[i]);
+		}
+
+		if (options.files.empty())
+		{
+			std::error_code ec;
+			for (const auto& entry : std::filesystem::directory_iterator("res/models", ec))
+			{
+				if (entry.path().extension() == ".obj")
+					options.files.push_back(entry.path().string());
+			}
+		}
+		return options;
+	}
+
+	int skBenchmark::run(int argc, char **argv)
+	{
+		if (argc < 1)
+		{
+			printUsage();
+			return EXIT_FAILURE;
+		}
+
+		const std::string name = argv[0];
+		std::vector<std::string> args(argv + 1, argv + argc);
+		for (const auto& entry : BENCHMARKS)
+		{
+			if (name == entry.name)
+				return entry.fn(args);
+		}
+
+		std::cerr << "unknown benchmark: " << name << std::endl;
+		printUsage();
+		return EXIT_FAILURE;
+	}
+} // namespace sk
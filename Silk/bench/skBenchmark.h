@@ -0,0 +1,92 @@
+#pragma once
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sk
+{
+	struct BenchmarkResult
+	{
+		std::string name{};
+		uint32_t repetitions = 0;
+		double meanNs = 0.0;		// per repetition
+		double minNs = 0.0;
+		uint64_t bytesPerRepetition = 0; // 0 when throughput does not apply
+
+		double megabytesPerSecond() const { return minNs > 0.0 ? bytesPerRepetition / (minNs * 1e-9) / (1024.0 * 1024.0) : 0.0; }
+	};
+
+	/* Tiny timing harness for the --bench command line mode.
+	 *   every benchmark is run warmup times untimed, then repetitions times timed. throughput is reported from the
+	 *   fastest repetition, which is the least disturbed by the OS and the most stable between runs. */
+	class skBenchmark
+	{
+	public:
+		struct Settings
+		{
+			uint32_t warmup = 1;
+			uint32_t repetitions = 5;
+		};
+
+		template <typename F>
+		static BenchmarkResult measure(const std::string& name, const Settings& settings, uint64_t bytesPerRepetition, F &&fn)
+		{
+			for (uint32_t i = 0; i < settings.warmup; i++)
+				fn();
+
+			BenchmarkResult result{};
+			result.name = name;
+			result.repetitions = std::max(1u, settings.repetitions);
+			result.bytesPerRepetition = bytesPerRepetition;
+
+			double total = 0.0;
+			for (uint32_t i = 0; i < result.repetitions; i++)
+			{
+				auto start = std::chrono::high_resolution_clock::now();
+				fn();
+				auto end = std::chrono::high_resolution_clock::now();
+				double ns = std::chrono::duration<double, std::chrono::nanoseconds::period>(end - start).count();
+				total += ns;
+				result.minNs = i == 0 ? ns : std::min(result.minNs, ns);
+			}
+			result.meanNs = total / result.repetitions;
+			return result;
+		}
+
+		static void print(const BenchmarkResult& result);
+
+		// entry point of "Silk --bench <name> [args...]", returns the process exit code
+		static int run(int argc, char **argv);
+	};
+
+	// command line shared by the mesh benchmarks: [--size N] [--reps N] [files...]
+	//   files default to res/models/*.obj, --size is the synthetic grid resolution (0 skips it)
+	struct MeshBenchmarkOptions
+	{
+		skBenchmark::Settings settings{};
+		uint32_t syntheticSize = 512;
+		uint32_t chunks = 0;	// skObjParser chunks forced by the obj benchmark's merge check, 0 uses its default
+		std::vector<std::string> files{};
+	};
+	MeshBenchmarkOptions parseMeshBenchmarkArgs(const std::vector<std::string>& args);
+
+	// writes a synthetic (size + 1)^2 vertex grid .obj to the temp folder and returns its path
+	std::string writeSyntheticObj(uint32_t size);
+
+	// individual benchmarks, args are whatever follows the benchmark name on the command line
+	int benchmarkObjReaders(const std::vector<std::string>& args);
+	int benchmarkVertexWelding(const std::vector<std::string>& args);
+	int benchmarkMeshOptimizer(const std::vector<std::string>& args);
+	int benchmarkSimplifier(const std::vector<std::string>& args);
+	int benchmarkRecording(const std::vector<std::string>& args);
+	int benchmarkJobSystem(const std::vector<std::string>& args);
+	int benchmarkHeadless(const std::vector<std::string>& args);
+	int benchmarkScalability(const std::vector<std::string>& args);
+	int benchmarkMicro(const std::vector<std::string>& args);
+	int benchmarkEntities(const std::vector<std::string>& args);
+	int benchmarkTransforms(const std::vector<std::string>& args);
+} // namespace sk
@@ -0,0 +1,8 @@
+#include "skBenchmark.h"
+
+// entry point of the CPU only benchmark build (CMakeLists.txt), "SilkBench <name> [args...]" runs as "Silk --bench"
+//   would. not part of Silk.vcxproj, App.cpp is the main there
+int main(int argc, char **argv)
+{
+	return sk::skBenchmark::run(argc - 1, argv + 1);
+}
\ No newline at end of file
@@ -0,0 +1,220 @@
+#include "skBenchmark.h"
+#include "scene/skSceneGenerator.h"
+#include "skGameObject.h"
+
+// std
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <unordered_map>
+#include <utility>
+
+namespace sk
+{
+	namespace
+	{
+		// share of the objects destroyed and created again per churn repetition
+		constexpr float CHURN_RATIO = .1f;
+
+		struct EntityBenchmarkOptions
+		{
+			skBenchmark::Settings settings{ 2, 10 };
+			std::vector<uint32_t> counts{ 10000, 100000, 1000000 };
+		};
+
+		EntityBenchmarkOptions parseArgs(const std::vector<std::string> &args)
+		{
+			EntityBenchmarkOptions options{};
+			for (size_t i = 0; i + 1 < args.size(); i++)
+			{
+				if (args[i] == "--counts")
+				{
+					options.counts.clear();
+					std::stringstream stream{ args[++i] };
+					for (std::string value; std::getline(stream, value, ',');)
+						options.counts.push_back(std::max(1u, static_cast<uint32_t>(std::stoul(value))));
+				}
+				else if (args[i] == "--reps")
+					options.settings.repetitions = static_cast<uint32_t>(std::stoul(args[++i]));
+			}
+			return options;
+		}
+
+		// the storage skGameObjectRegistry replaced, kept here as the baseline: an unordered_map of whole objects, each
+		//   holding its own reference to the model
+		struct ReferenceObject
+		{
+			std::shared_ptr<skModel> model{};
+			glm::vec3 color{};
+			TransformComponent transform{};
+		};
+		using ReferenceMap = std::unordered_map<uint32_t, ReferenceObject>;
+
+		volatile float g_sink = 0.f;
+
+		TransformComponent makeTransform(skRandom &random)
+		{
+			TransformComponent transform{};
+			transform.translation = { random.uniform(-50.f, 50.f), random.uniform(-50.f, 50.f), random.uniform(-50.f, 50.f) };
+			transform.rotation = { random.uniform(0.f, 6.f), random.uniform(0.f, 6.f), random.uniform(0.f, 6.f) };
+			transform.scale = glm::vec3{ random.uniform(.5f, 2.f) };
+			return transform;
+		}
+
+		void printRow(const char *name, const BenchmarkResult &reference, const BenchmarkResult &registry, uint32_t ops)
+		{
+			char line[256];
+			std::snprintf(line, sizeof(line), "  %-28s %14.2f %14.2f %9.2fx", name, reference.minNs / ops, registry.minNs / ops,
+				reference.minNs / registry.minNs);
+			std::cout << line << std::endl;
+		}
+	} // namespace
+
+	int benchmarkEntities(const std::vector<std::string> &args)
+	{
+		const EntityBenchmarkOptions options = parseArgs(args);
+
+		// ns per object should stay flat as the count grows: iteration is linear in both, but only the registry keeps
+		//   its objects contiguous once they no longer fit the caches
+		for (uint32_t count : options.counts)
+		{
+			skRandom random{ count };
+			std::vector<TransformComponent> transforms(count);
+			for (TransformComponent &transform : transforms)
+				transform = makeTransform(random);
+
+			ReferenceMap map{};
+			map.reserve(count);
+			skGameObjectRegistry registry{};
+			registry.reserve(count);
+			std::vector<skEntity> entities(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				map.emplace(i, ReferenceObject{ nullptr, glm::vec3{ 1.f }, transforms[i] });
+				entities[i] = registry.create(transforms[i]);
+			}
+
+			char line[256];
+			std::snprintf(line, sizeof(line), "\n%u objects %23s %14s %10s", count, "unordered_map ns", "registry ns", "speedup");
+			std::cout << line << std::endl;
+
+			BenchmarkResult reference = skBenchmark::measure("create", options.settings, 0, [&]()
+				{
+					ReferenceMap created{};
+					created.reserve(count);
+					for (uint32_t i = 0; i < count; i++)
+						created.emplace(i, ReferenceObject{ nullptr, glm::vec3{ 1.f }, transforms[i] });
+					g_sink = created.at(count - 1).transform.translation.x;
+				});
+			BenchmarkResult result = skBenchmark::measure("create", options.settings, 0, [&]()
+				{
+					skGameObjectRegistry created{};
+					created.reserve(count);
+					for (uint32_t i = 0; i < count; i++)
+						created.create(transforms[i]);
+					g_sink = created.transforms().translation(count - 1).x;
+				});
+			printRow("create", reference, result, count);
+
+			reference = skBenchmark::measure("iterate", options.settings, 0, [&]()
+				{
+					float sum = 0.f;
+					for (const auto &[id, obj] : map)
+						sum += obj.transform.translation.x;
+					g_sink = sum;
+				});
+			result = skBenchmark::measure("iterate", options.settings, 0, [&]()
+				{
+					float sum = 0.f;
+					const skTransformSystem &transforms = registry.transforms();
+					for (uint32_t i = 0; i < transforms.size(); i++)
+						sum += transforms.translation(i).x;
+					g_sink = sum;
+				});
+			printRow("iterate", reference, result, count);
+
+			// every object moved: the map rebuilds each matrix, the registry's transform system evaluates them all
+			reference = skBenchmark::measure("iterate + mat4", options.settings, 0, [&]()
+				{
+					float sum = 0.f;
+					for (auto &[id, obj] : map)
+						sum += obj.transform.mat4()[3][0];
+					g_sink = sum;
+				});
+			result = skBenchmark::measure("iterate + mat4", options.settings, 0, [&]()
+				{
+					float sum = 0.f;
+					skTransformSystem &transforms = registry.transforms();
+					transforms.markAllDirty();
+					transforms.update();
+					for (uint32_t i = 0; i < transforms.size(); i++)
+						sum += transforms.modelMatrix(i)[3][0];
+					g_sink = sum;
+				});
+			printRow("iterate + mat4", reference, result, count);
+
+			// by handle, in random order. one component (translation) reads and writes its own three arrays, the whole
+			//   transform gathers, compares and scatters all nine: both lose to the map, whose object sits in one node
+			std::vector<uint32_t> order(count);
+			for (uint32_t i = 0; i < count; i++)
+				order[i] = i;
+			for (uint32_t i = count - 1; i > 0; i--)
+				std::swap(order[i], order[random.below(i + 1)]);
+			reference = skBenchmark::measure("lookup", options.settings, 0, [&]()
+				{
+					for (uint32_t i : order)
+						map.find(i)->second.transform.translation.y += 1.f;
+				});
+			result = skBenchmark::measure("lookup", options.settings, 0, [&]()
+				{
+					for (uint32_t i : order)
+						registry.setTranslation(entities[i], registry.translation(entities[i]) + glm::vec3{ 0.f, 1.f, 0.f });
+				});
+			printRow("lookup by handle", reference, result, count);
+			result = skBenchmark::measure("lookup transform", options.settings, 0, [&]()
+				{
+					for (uint32_t i : order)
+					{
+						TransformComponent transform = registry.transform(entities[i]);
+						transform.translation.y += 1.f;
+						registry.setTransform(entities[i], transform);
+					}
+				});
+			printRow("lookup by handle, transform", reference, result, count);
+
+			// destroy a share of the objects at random and create as many again, the counts stay the same
+			const uint32_t churn = std::max(1u, static_cast<uint32_t>(count * CHURN_RATIO));
+			uint32_t nextId = count;
+			reference = skBenchmark::measure("churn", options.settings, 0, [&]()
+				{
+					for (uint32_t i = 0; i < churn; i++)
+					{
+						const uint32_t slot = random.below(count);
+						map.erase(order[slot]);
+						order[slot] = nextId++;
+						map.emplace(order[slot], ReferenceObject{ nullptr, glm::vec3{ 1.f }, transforms[slot] });
+					}
+				});
+			result = skBenchmark::measure("churn", options.settings, 0, [&]()
+				{
+					for (uint32_t i = 0; i < churn; i++)
+					{
+						const uint32_t slot = random.below(count);
+						registry.destroy(entities[slot]);
+						entities[slot] = registry.create(transforms[slot]);
+					}
+				});
+			printRow("destroy + create", reference, result, churn);
+
+			if (map.size() != count || registry.size() != count)
+			{
+				std::cerr << "object counts drifted: " << map.size() << " in the map, " << registry.size() << " in the registry" << std::endl;
+				return EXIT_FAILURE;
+			}
+		}
+		return EXIT_SUCCESS;
+	}
+} // namespace sk
@@ -0,0 +1,401 @@
+#include "skBenchmark.h"
+#include "core/skDevice.h"
+#include "core/skJobSystem.h"
+#include "core/skTelemetry.h"
+#include "core/skUploadContext.h"
+#include "model/skGeometryArena.h"
+#include "renderer/skRenderer.h"
+#include "renderer/SimpleRenderSystem.h"
+#include "descriptor/skDescriptors.h"
+#include "camera/skCamera.h"
+#include "scene/skCameraPath.h"
+#include "scene/skSceneGenerator.h"
+#include "skGameObject.h"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace sk
+{
+	namespace
+	{
+		// the camera path advances by a fixed step per frame, so every run renders the same views
+		constexpr float PATH_TIME_STEP = 1.f / 60.f;
+		constexpr float PATH_DURATION = 20.f;
+		// the matrix fails a cell whose p95 grew by more than this share of the baseline's
+		constexpr double DEFAULT_REGRESSION_TOLERANCE = .1;
+		constexpr uint32_t DEFAULT_MATRIX_FRAMES = 300;
+
+		struct HeadlessBenchmarkOptions
+		{
+			uint32_t frames = 1000;
+			uint32_t warmup = 30;		// frames rendered before the telemetry starts recording
+			VkExtent2D extent{ 1280, 720 };
+			uint32_t slices = 0;		// 0 records inline, otherwise into that many secondaries as jobs
+			bool flythrough = false;	// camera path through the scene instead of around it
+			skSceneGenerator::Settings scene{};
+			std::string output{};		// file name without extension, nothing is written when empty
+
+			// the headless run takes the first of each, the matrix every combination
+			std::vector<uint32_t> objectCounts{ 1000, 10000, 100000 };
+			std::vector<uint32_t> triangleCounts{ 500, 5000 };
+			std::vector<float> uniqueRatios{ .001f, .01f, .1f };
+			std::string baseline{};
+			double tolerance = DEFAULT_REGRESSION_TOLERANCE;
+		};
+
+		template <typename T>
+		std::vector<T> parseList(const std::string &list)
+		{
+			std::vector<T> values{};
+			std::stringstream stream{ list };
+			for (std::string value; std::getline(stream, value, ',');)
+				values.push_back(static_cast<T>(std::stod(value)));
+			return values;
+		}
+
+		HeadlessBenchmarkOptions parseArgs(const std::vector<std::string> &args)
+		{
+			HeadlessBenchmarkOptions options{};
+			for (size_t i = 0; i < args.size(); i++)
+			{
+				if (args[i] == "--flythrough")
+					options.flythrough = true;
+				else if (args[i] == "--lods")
+					options.scene.generateLods = true;
+				else if (i + 1 >= args.size())
+					break;
+				else if (args[i] == "--frames")
+					options.frames = static_cast<uint32_t>(std::stoul(args[++i]));
+				else if (args[i] == "--warmup")
+					options.warmup = static_cast<uint32_t>(std::stoul(args[++i]));
+				else if (args[i] == "--width")
+					options.extent.width = static_cast<uint32_t>(std::stoul(args[++i]));
+				else if (args[i] == "--height")
+					options.extent.height = static_cast<uint32_t>(std::stoul(args[++i]));
+				else if (args[i] == "--slices")
+					options.slices = static_cast<uint32_t>(std::stoul(args[++i]));
+				else if (args[i] == "--seed")
+					options.scene.seed = std::stoull(args[++i]);
+				else if (args[i] == "--model")
+					options.scene.modelFiles.push_back(args[++i]);
+				else if (args[i] == "--out")
+					options.output = args[++i];
+				else if (args[i] == "--objects")
+					options.objectCounts = parseList<uint32_t>(args[++i]);
+				else if (args[i] == "--triangles")
+					options.triangleCounts = parseList<uint32_t>(args[++i]);
+				else if (args[i] == "--unique")
+					options.uniqueRatios = parseList<float>(args[++i]);
+				else if (args[i] == "--baseline")
+					options.baseline = args[++i];
+				else if (args[i] == "--tolerance")
+					options.tolerance = std::stod(args[++i]);
+			}
+			return options;
+		}
+
+		// everything a frame needs besides the scene, set up as the windowed app does
+		struct HeadlessContext
+		{
+			explicit HeadlessContext(const HeadlessBenchmarkOptions &options)
+				: renderer{ device, jobSystem, options.extent }
+			{
+				if (options.slices > 0)
+					renderer.setRecordingSliceCount(options.slices);
+
+				globalPool = skDescriptorPool::Builder(device)
+					.setMaxSets(1)
+					.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
+					.build();
+				globalSetLayout = skDescriptorSetLayout::Builder(device)
+					.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+					.build();
+				VkDescriptorBufferInfo uboInfo{ renderer.getFrameAllocator().getBuffer(), 0, sizeof(GlobalUbo) };
+				skDescriptorWriter(*globalSetLayout, *globalPool)
+					.writeBuffer(0, &uboInfo)
+					.build(globalDescriptorSet);
+				renderSystem = std::make_unique<SimpleRenderSystem>(device, renderer.getSwapChainRenderPass(),
+					globalSetLayout->getDescriptorSetLayout());
+			}
+
+			skDevice device{};
+			skJobSystem jobSystem{};
+			skRenderer renderer;
+			skUploadContext uploadContext{ device };
+			skGeometryArena arena{ device, uploadContext };
+			std::unique_ptr<skDescriptorPool> globalPool{};
+			std::unique_ptr<skDescriptorSetLayout> globalSetLayout{};
+			VkDescriptorSet globalDescriptorSet = VK_NULL_HANDLE;
+			std::unique_ptr<SimpleRenderSystem> renderSystem{};
+		};
+
+		skCameraPath cameraPath(const HeadlessBenchmarkOptions &options, float sceneSize)
+		{
+			if (options.flythrough)
+				return skCameraPath::flythrough(options.scene.seed, sceneSize * .5f, PATH_DURATION);
+			return skCameraPath::orbit(glm::vec3{ 0.f }, sceneSize * .75f + 1.f, sceneSize * .25f, PATH_DURATION);
+		}
+
+		// renders warmup + frames frames of gameObjects along path, the telemetry records the last frames of them
+		void renderFrames(HeadlessContext &context, const HeadlessBenchmarkOptions &options, skGameObjectRegistry &gameObjects,
+			const skCameraPath &path, skTelemetry &telemetry)
+		{
+			skRenderer &renderer = context.renderer;
+			skGpuProfiler &gpuProfiler = renderer.getGpuProfiler();
+			skCamera camera{};
+			camera.setPerspectiveProjection(glm::radians(50.f), renderer.getAspectRatio(), .1f, 1000.f);
+
+			const uint32_t frameCount = options.warmup + options.frames;
+			for (uint32_t i = 0; i < frameCount; i++)
+			{
+				const bool measured = i >= options.warmup;
+				if (measured)
+					telemetry.beginFrame();
+				auto frameStart = std::chrono::steady_clock::now();
+				path.apply(camera, i * PATH_TIME_STEP);
+
+				auto commandBuffer = renderer.beginFrame();
+				if (!commandBuffer)
+					continue;
+				context.arena.beginFrame(static_cast<uint32_t>(renderer.getFrameIndex()));
+				if (measured)
+				{
+					for (const skGpuProfiler::ScopeTiming &timing : gpuProfiler.results())
+						telemetry.addGpuScope(timing.name, timing.ms);
+				}
+
+				skFrameAllocator &frameAllocator = renderer.getFrameAllocator();
+				GlobalUbo ubo{};
+				ubo.projectionView = camera.getProjection() * camera.getView();
+				auto uboSlice = frameAllocator.push(ubo);
+				FrameInfo frameInfo{ renderer.getFrameIndex(), PATH_TIME_STEP, commandBuffer, camera, context.globalDescriptorSet,
+					static_cast<uint32_t>(uboSlice.offset), gameObjects, renderer.getSwapChainExtent(), frameAllocator };
+				frameInfo.jobSystem = &context.jobSystem;
+				frameInfo.gpuProfiler = &gpuProfiler;
+
+				if (options.slices > 0)
+				{
+					renderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+					frameInfo.parallelRecorder = &renderer.getParallelRecorder();
+				}
+				else
+					renderer.beginSwapChainRenderPass(commandBuffer);
+				context.renderSystem->renderGameObjects(frameInfo);
+				renderer.endSwapChainRenderPass(commandBuffer);
+				renderer.endFrame();
+				context.jobSystem.waitFrame();
+
+				if (measured)
+				{
+					// the same split as the app: record is whatever the swap chain timings do not cover
+					const skSwapChain::Timings &timings = renderer.getFrameTimings();
+					telemetry.addPhase(skFramePhase::FenceWait, timings.fenceWait);
+					telemetry.addPhase(skFramePhase::Submit, timings.submit);
+					telemetry.addPhase(skFramePhase::Record, std::chrono::steady_clock::now() - frameStart - timings.fenceWait - timings.submit);
+				}
+			}
+			telemetry.beginFrame(); // publishes the last frame
+		}
+
+		// the models of a scene may only go once the GPU is done with them
+		void clearScene(HeadlessContext &context, skGameObjectRegistry &gameObjects)
+		{
+			vkDeviceWaitIdle(context.device.device());
+			gameObjects.clear();
+		}
+
+		const skTelemetry::Distribution *findGpuScope(const skTelemetry::Summary &summary, const std::string &name)
+		{
+			for (const auto &[scope, distribution] : summary.gpuScopes)
+			{
+				if (scope == name)
+					return &distribution;
+			}
+			return nullptr;
+		}
+
+		void printDistribution(const std::string &name, const skTelemetry::Distribution &distribution)
+		{
+			char line[256];
+			std::snprintf(line, sizeof(line), "  %-24s %10.3f ms (p50) %10.3f ms (p95) %10.3f ms (p99) %10.3f ms (max)",
+				name.c_str(), distribution.p50, distribution.p95, distribution.p99, distribution.max);
+			std::cout << line << std::endl;
+		}
+
+		std::string cellKey(uint32_t objects, uint32_t triangles, float uniqueRatio)
+		{
+			char key[64];
+			std::snprintf(key, sizeof(key), "%u,%u,%g", objects, triangles, uniqueRatio);
+			return key;
+		}
+
+		// cell key -> { cpu p95, gpu p95 } from the csv of an earlier matrix run
+		std::map<std::string, std::pair<double, double>> readBaseline(const std::string &filepath)
+		{
+			std::map<std::string, std::pair<double, double>> baseline{};
+			std::ifstream file{ filepath };
+			if (!file)
+			{
+				std::cerr << "Could not read baseline " << filepath << std::endl;
+				return baseline;
+			}
+
+			std::string line;
+			std::getline(file, line); // header
+			while (std::getline(file, line))
+			{
+				std::vector<std::string> fields{};
+				std::stringstream stream{ line };
+				for (std::string field; std::getline(stream, field, ',');)
+					fields.push_back(field);
+				// objects, triangles, unique, models, scene triangles, cpu p50, p95, p99, gpu p50, p95, p99, hitches
+				if (fields.size() < 12)
+					continue;
+				baseline[fields[0] + "," + fields[1] + "," + fields[2]] = { std::stod(fields[6]), std::stod(fields[9]) };
+			}
+			return baseline;
+		}
+	} // namespace
+
+	int benchmarkHeadless(const std::vector<std::string> &args)
+	{
+		HeadlessBenchmarkOptions options = parseArgs(args);
+		options.scene.objectCount = options.objectCounts.front();
+		options.scene.trianglesPerObject = options.triangleCounts.front();
+		options.scene.uniqueModelRatio = options.uniqueRatios.front();
+
+		HeadlessContext context{ options };
+		skGameObjectRegistry gameObjects{};
+		skSceneGenerator generator{ context.arena, options.scene };
+		generator.generate(gameObjects);
+		context.uploadContext.wait(context.uploadContext.submit());
+
+		std::cout << "Headless: " << options.frames << " frames at " << options.extent.width << "x" << options.extent.height
+			<< ", recording " << (options.slices > 0 ? std::to_string(context.renderer.getRecordingSliceCount()) + " slices"
+			: std::string{ "inline" }) << ", " << context.jobSystem.threadCount() << " job threads" << std::endl;
+
+		skTelemetry telemetry{ options.frames + 1 };
+		renderFrames(context, options, gameObjects, cameraPath(options, generator.sceneSize()), telemetry);
+		clearScene(context, gameObjects);
+
+		const skTelemetry::Summary summary = telemetry.summarize();
+		if (summary.frames == 0)
+			return EXIT_FAILURE;
+		std::cout << summary.frames << " frames, mean " << summary.frame.mean << " ms (" << 1000.0 / summary.frame.mean
+			<< " frames/s), " << summary.hitches << " hitches" << std::endl;
+		printDistribution("cpu frame", summary.frame);
+		for (skFramePhase phase : { skFramePhase::FenceWait, skFramePhase::Record, skFramePhase::Submit })
+			printDistribution(std::string{ "cpu " } + toString(phase), summary.phases[static_cast<uint32_t>(phase)]);
+		for (const auto &[scope, distribution] : summary.gpuScopes)
+			printDistribution("gpu " + scope, distribution);
+		if (summary.gpuScopes.empty())
+			std::cout << "  no GPU timings, the device has no timestamps on its graphics queue" << std::endl;
+
+		if (!options.output.empty() && !(telemetry.exportCsv(options.output + ".csv") && telemetry.exportJson(options.output + ".json")))
+			return EXIT_FAILURE;
+		return EXIT_SUCCESS;
+	}
+
+	int benchmarkScalability(const std::vector<std::string> &args)
+	{
+		HeadlessBenchmarkOptions options = parseArgs(args);
+		if (std::find(args.begin(), args.end(), "--frames") == args.end())
+			options.frames = DEFAULT_MATRIX_FRAMES;
+		const auto baseline = options.baseline.empty() ? std::map<std::string, std::pair<double, double>>{} : readBaseline(options.baseline);
+
+		HeadlessContext context{ options };
+		skGameObjectRegistry gameObjects{};
+
+		std::ofstream csv{};
+		if (!options.output.empty())
+		{
+			csv.open(options.output + ".csv", std::ios::trunc);
+			csv << "objects,triangles_per_object,unique_ratio,models,scene_triangles,cpu_p50_ms,cpu_p95_ms,cpu_p99_ms,"
+				"gpu_p50_ms,gpu_p95_ms,gpu_p99_ms,hitches\n";
+		}
+
+		char line[256];
+		std::snprintf(line, sizeof(line), "%9s %9s %7s %7s %12s %9s %9s %9s %9s %9s %9s %7s", "objects", "tris/obj", "unique",
+			"models", "scene tris", "cpu p50", "cpu p95", "cpu p99", "gpu p50", "gpu p95", "gpu p99", "hitches");
+		std::cout << "Frame time in ms over " << options.frames << " frames per cell, seed " << options.scene.seed << ", "
+			<< (options.flythrough ? "flythrough" : "orbit") << " camera, gpu is the frame scope (-1 without timestamps)\n"
+			<< line << std::endl;
+
+		bool regressed = false;
+		for (uint32_t objects : options.objectCounts)
+		{
+			for (uint32_t triangles : options.triangleCounts)
+			{
+				for (float uniqueRatio : options.uniqueRatios)
+				{
+					skSceneGenerator::Settings scene = options.scene;
+					scene.objectCount = objects;
+					scene.trianglesPerObject = triangles;
+					scene.uniqueModelRatio = uniqueRatio;
+					skSceneGenerator generator{ context.arena, scene };
+					const skSceneGenerator::Stats stats = generator.generate(gameObjects);
+					context.uploadContext.wait(context.uploadContext.submit());
+
+					skTelemetry telemetry{ options.frames + 1 };
+					renderFrames(context, options, gameObjects, cameraPath(options, generator.sceneSize()), telemetry);
+					clearScene(context, gameObjects);
+
+					const skTelemetry::Summary summary = telemetry.summarize();
+					const skTelemetry::Distribution none{ -1.0, 0.0, -1.0, -1.0, -1.0, -1.0 };
+					const skTelemetry::Distribution *gpu = findGpuScope(summary, "frame");
+					if (gpu == nullptr)
+						gpu = &none;
+
+					std::snprintf(line, sizeof(line), "%9u %9u %7g %7u %12llu %9.3f %9.3f %9.3f %9.3f %9.3f %9.3f %7u", objects,
+						triangles, uniqueRatio, stats.models, static_cast<unsigned long long>(stats.sceneTriangles), summary.frame.p50,
+						summary.frame.p95, summary.frame.p99, gpu->p50, gpu->p95, gpu->p99, summary.hitches);
+					std::cout << line << std::endl;
+					if (csv.is_open())
+					{
+						std::snprintf(line, sizeof(line), "%s,%u,%llu,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%u", cellKey(objects, triangles,
+							uniqueRatio).c_str(), stats.models, static_cast<unsigned long long>(stats.sceneTriangles), summary.frame.p50,
+							summary.frame.p95, summary.frame.p99, gpu->p50, gpu->p95, gpu->p99, summary.hitches);
+						csv << line << "\n";
+					}
+
+					auto previous = baseline.find(cellKey(objects, triangles, uniqueRatio));
+					if (previous == baseline.end())
+						continue;
+					const auto [cpuBaseline, gpuBaseline] = previous->second;
+					if (summary.frame.p95 > cpuBaseline * (1.0 + options.tolerance))
+					{
+						std::cout << "  regression: cpu p95 " << summary.frame.p95 << " ms, baseline " << cpuBaseline << " ms" << std::endl;
+						regressed = true;
+					}
+					if (gpuBaseline > 0.0 && gpu->p95 > gpuBaseline * (1.0 + options.tolerance))
+					{
+						std::cout << "  regression: gpu p95 " << gpu->p95 << " ms, baseline " << gpuBaseline << " ms" << std::endl;
+						regressed = true;
+					}
+				}
+			}
+		}
+
+		if (csv.is_open() && !csv)
+		{
+			std::cerr << "Failed to write " << options.output << ".csv" << std::endl;
+			return EXIT_FAILURE;
+		}
+		return regressed ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+} // namespace sk
@@ -0,0 +1,267 @@
+#include "skBenchmark.h"
+#include "core/skJobSystem.h"
+
+// libs
+#define GLM_FORCE_RADIANS
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace sk
+{
+	namespace
+	{
+		struct JobBenchmarkOptions
+		{
+			skBenchmark::Settings settings{};
+			std::vector<uint32_t> threadCounts{};
+			uint32_t size = 1 << 20;	// transforms of the parallel for, leaves * LEAF_SIZE of the graph
+			bool profile = false;		// per-thread busy time of the parallel for, through the profile hook
+		};
+
+		constexpr uint32_t TRANSFORMS_PER_JOB = 1024;
+		constexpr uint32_t LEAF_SIZE = 4096;		// elements summed by a leaf of the reduction graph
+		constexpr uint32_t EMPTY_JOBS = 100000;
+
+		JobBenchmarkOptions parseArgs(const std::vector<std::string> &args)
+		{
+			JobBenchmarkOptions options{};
+			for (size_t i = 0; i < args.size(); i++)
+			{
+				if (args[i] == "--threads" && i + 1 < args.size())
+				{
+					std::stringstream stream{ args[++i] };
+					for (std::string value; std::getline(stream, value, ',');)
+						options.threadCounts.push_back(std::max(1u, static_cast<uint32_t>(std::stoul(value))));
+				}
+				else if (args[i] == "--size" && i + 1 < args.size())
+					options.size = std::max(1u, static_cast<uint32_t>(std::stoul(args[++i])));
+				else if (args[i] == "--reps" && i + 1 < args.size())
+					options.settings.repetitions = static_cast<uint32_t>(std::stoul(args[++i]));
+				else if (args[i] == "--profile")
+					options.profile = true;
+			}
+
+			if (options.threadCounts.empty())
+			{
+				// powers of two up to the hardware threads
+				const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+				for (uint32_t threads = 1; threads < hardwareThreads; threads *= 2)
+					options.threadCounts.push_back(threads);
+				options.threadCounts.push_back(hardwareThreads);
+			}
+			return options;
+		}
+
+		// same math as TransformComponent::mat4, on plain arrays
+		struct TransformSet
+		{
+			std::vector<glm::vec3> translation{}, rotation{}, scale{};
+			std::vector<glm::mat4> matrices{};
+
+			explicit TransformSet(uint32_t count) : translation(count), rotation(count), scale(count), matrices(count)
+			{
+				for (uint32_t i = 0; i < count; i++)
+				{
+					float f = static_cast<float>(i);
+					translation[i] = { std::fmod(f * .37f, 50.f), std::fmod(f * .11f, 20.f), std::fmod(f * .23f, 50.f) };
+					rotation[i] = { f * .013f, f * .029f, f * .007f };
+					scale[i] = glm::vec3{ .5f + std::fmod(f * .01f, 2.f) };
+				}
+			}
+
+			void update(uint32_t begin, uint32_t end)
+			{
+				for (uint32_t i = begin; i < end; i++)
+				{
+					glm::mat4 m = glm::translate(glm::mat4{ 1.f }, translation[i]);
+					m = glm::rotate(m, rotation[i].y, { 0.f, 1.f, 0.f });
+					m = glm::rotate(m, rotation[i].x, { 1.f, 0.f, 0.f });
+					m = glm::rotate(m, rotation[i].z, { 0.f, 0.f, 1.f });
+					matrices[i] = glm::scale(m, scale[i]);
+				}
+			}
+
+			double checksum() const
+			{
+				double sum = 0.0;
+				for (const glm::mat4 &m : matrices)
+					sum += m[0][0] + m[1][1] + m[2][2] + m[3][0] + m[3][1] + m[3][2];
+				return sum;
+			}
+		};
+
+		uint64_t mix(uint64_t x)
+		{
+			x ^= x >> 33;
+			x *= 0xff51afd7ed558ccdull;
+			x ^= x >> 33;
+			return x;
+		}
+
+		// leaves hash their range, inner nodes add their two children once both finished: exercises dependencies
+		//   instead of a single join. wrapping integer sums, so the result does not depend on the order
+		uint64_t reduceGraph(skJobSystem &jobSystem, uint32_t leafCount)
+		{
+			std::vector<uint64_t> values(2 * leafCount - 1);
+			std::vector<skJobSystem::JobHandle> jobs(values.size());
+
+			// heap layout, node i has children 2i + 1 and 2i + 2, the leaves are the last leafCount nodes
+			const uint32_t firstLeaf = leafCount - 1;
+			for (uint32_t leaf = 0; leaf < leafCount; leaf++)
+			{
+				jobs[firstLeaf + leaf] = jobSystem.schedule("graph leaf", [&values, firstLeaf, leaf]
+					{
+						uint64_t sum = 0;
+						for (uint64_t i = uint64_t{ leaf } * LEAF_SIZE; i < uint64_t{ leaf + 1 } * LEAF_SIZE; i++)
+							sum += mix(i);
+						values[firstLeaf + leaf] = sum;
+					});
+			}
+			for (uint32_t node = firstLeaf; node-- > 0;)
+			{
+				jobs[node] = jobSystem.schedule("graph node", [&values, node] { values[node] = values[2 * node + 1] + values[2 * node + 2]; },
+					{ jobs[2 * node + 1], jobs[2 * node + 2] });
+			}
+			jobSystem.wait(jobs[0]);
+			uint64_t result = values[0];
+			jobSystem.waitFrame();
+			return result;
+		}
+
+		void printScaling(const BenchmarkResult &result, double singleThreadNs, uint32_t threads)
+		{
+			double speedup = singleThreadNs / result.minNs;
+			char line[256];
+			std::snprintf(line, sizeof(line), "%-48s %12.3f ms (min) %8.2fx speedup %7.1f%% efficiency", result.name.c_str(),
+				result.minNs * 1e-6, speedup, 100.0 * speedup / threads);
+			std::cout << line << std::endl;
+		}
+	} // namespace
+
+	int benchmarkJobSystem(const std::vector<std::string> &args)
+	{
+		const JobBenchmarkOptions options = parseArgs(args);
+		const uint32_t leafCount = std::max(1u, options.size / LEAF_SIZE);
+
+		// references every thread count is checked against
+		TransformSet transforms{ options.size };
+		transforms.update(0, options.size);
+		const double referenceChecksum = transforms.checksum();
+		uint64_t referenceSum = 0;
+		for (uint64_t i = 0; i < uint64_t{ leafCount } * LEAF_SIZE; i++)
+			referenceSum += mix(i);
+
+		std::cout << options.size << " transforms in jobs of " << TRANSFORMS_PER_JOB << ", a reduction graph of " << 2 * leafCount - 1
+			<< " jobs, " << EMPTY_JOBS << " empty jobs, " << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+
+		double parallelForBaseline = 0.0, graphBaseline = 0.0;
+		bool valid = true;
+		for (uint32_t threads : options.threadCounts)
+		{
+			skJobSystem jobSystem{ threads };
+			std::cout << "\n" << threads << (threads == 1 ? " thread" : " threads") << std::endl;
+
+			// each thread only ever writes its own slot
+			std::vector<double> busyNs(threads, 0.0);
+			if (options.profile)
+			{
+				jobSystem.setProfileHook([&busyNs](const skJobSystem::ProfileEvent &event)
+					{
+						busyNs[event.thread] += std::chrono::duration<double, std::chrono::nanoseconds::period>(event.end - event.start).count();
+					});
+			}
+
+			std::fill(transforms.matrices.begin(), transforms.matrices.end(), glm::mat4{ 0.f });
+			auto parallelForStart = std::chrono::steady_clock::now();
+			BenchmarkResult parallelFor = skBenchmark::measure("  parallel for, transforms", options.settings, 0, [&]
+				{
+					jobSystem.parallelFor("transforms", options.size, TRANSFORMS_PER_JOB,
+						[&transforms](uint32_t begin, uint32_t end) { transforms.update(begin, end); });
+					jobSystem.waitFrame();
+				});
+			auto parallelForEnd = std::chrono::steady_clock::now();
+			if (transforms.checksum() != referenceChecksum)
+			{
+				std::cerr << "parallel for with " << threads << " threads does not match the serial transforms" << std::endl;
+				valid = false;
+			}
+			if (options.profile)
+			{
+				// busy time over all the repetitions, warm up included
+				const double wallNs = std::chrono::duration<double, std::chrono::nanoseconds::period>(parallelForEnd - parallelForStart).count();
+				std::cout << "  busy:";
+				for (uint32_t i = 0; i < threads; i++)
+					std::cout << " " << static_cast<int>(100.0 * busyNs[i] / wallNs) << "%";
+				std::cout << std::endl;
+				jobSystem.setProfileHook({});
+			}
+
+			uint64_t graphSum = 0;
+			BenchmarkResult graph = skBenchmark::measure("  dependency graph, reduction", options.settings, 0, [&]
+				{
+					graphSum = reduceGraph(jobSystem, leafCount);
+				});
+			if (graphSum != referenceSum)
+			{
+				std::cerr << "reduction graph with " << threads << " threads does not match the serial sum" << std::endl;
+				valid = false;
+			}
+
+			BenchmarkResult empty = skBenchmark::measure("  empty jobs", options.settings, 0, [&]
+				{
+					for (uint32_t i = 0; i < EMPTY_JOBS; i++)
+						jobSystem.schedule("empty", [] {});
+					jobSystem.waitFrame();
+				});
+
+			if (threads == options.threadCounts.front())
+			{
+				parallelForBaseline = parallelFor.minNs * threads;
+				graphBaseline = graph.minNs * threads;
+			}
+			printScaling(parallelFor, parallelForBaseline, threads);
+			printScaling(graph, graphBaseline, threads);
+			char line[256];
+			std::snprintf(line, sizeof(line), "%-48s %12.3f ms (min) %8.1f ns per job", empty.name.c_str(), empty.minNs * 1e-6,
+				empty.minNs / EMPTY_JOBS);
+			std::cout << line << std::endl;
+
+			skJobSystem::Stats stats = jobSystem.stats();
+			std::cout << "  " << stats.jobs << " jobs run, " << stats.steals << " stolen" << std::endl;
+
+			// a throwing job finishes all the same: its dependent runs, waitFrame returns and rethrows, once
+			std::atomic<bool> dependentRan{ false };
+			skJobSystem::JobHandle failing = jobSystem.schedule("throws", [] { throw std::runtime_error{ "job failure" }; });
+			jobSystem.schedule("after throws", [&dependentRan] { dependentRan = true; }, { failing });
+			bool rethrown = false;
+			try
+			{
+				jobSystem.waitFrame();
+			}
+			catch (const std::runtime_error &)
+			{
+				rethrown = true;
+			}
+			jobSystem.waitFrame();
+			if (!rethrown || !dependentRan)
+			{
+				std::cerr << "a throwing job with " << threads << " threads was " << (rethrown ? "" : "not rethrown")
+					<< (!rethrown && !dependentRan ? " and " : "") << (dependentRan ? "" : "its dependent never ran") << std::endl;
+				valid = false;
+			}
+		}
+
+		return valid ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+} // namespace sk
@@ -0,0 +1,74 @@
+#include "skBenchmark.h"
+#include "model/skModel.h"
+#include "model/skMeshOptimizer.h"
+
+// std
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+namespace sk
+{
+	namespace
+	{
+		void printStats(const char *label, const VertexCacheStats& stats)
+		{
+			char line[128];
+			std::snprintf(line, sizeof(line), "  %-36s ACMR %.3f  ATVR %.3f", label, stats.acmr, stats.atvr);
+			std::cout << line << std::endl;
+		}
+
+		void benchmarkFile(const std::string& path, const skBenchmark::Settings& settings)
+		{
+			skModel::Builder source{};
+			source.loadModel(path);
+			std::cout << "\n" << std::filesystem::path(path).filename().string() << " (" << source.vertices.size() << " vertices, "
+				<< source.indices.size() / 3 << " triangles)" << std::endl;
+
+			skModel::Builder optimized{};
+			OptimizationReport report{};
+			skBenchmark::print(skBenchmark::measure("  optimize", settings, 0, [&]() {
+				optimized = source;
+				report = optimized.optimize();
+			}));
+
+			skModel::Builder overdraw{};
+			OptimizationReport overdrawReport{};
+			skBenchmark::print(skBenchmark::measure("  optimize + overdraw", settings, 0, [&]() {
+				overdraw = source;
+				overdrawReport = overdraw.optimize(true);
+			}));
+
+			printStats("obj face order", report.before);
+			printStats("vertex cache + fetch", report.after);
+			printStats("vertex cache + overdraw + fetch", overdrawReport.after);
+		}
+	} // namespace
+
+	int benchmarkMeshOptimizer(const std::vector<std::string>& args)
+	{
+		MeshBenchmarkOptions options = parseMeshBenchmarkArgs(args);
+
+		try
+		{
+			for (const auto& file : options.files)
+				benchmarkFile(file, options.settings);
+
+			if (options.syntheticSize > 0)
+			{
+				std::string synthetic = writeSyntheticObj(options.syntheticSize);
+				benchmarkFile(synthetic, options.settings);
+				std::error_code ec;
+				std::filesystem::remove(synthetic, ec);
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
+} // namespace sk
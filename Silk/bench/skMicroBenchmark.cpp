@@ -0,0 +1,388 @@
+#include "skBenchmark.h"
+#include "camera/skCamera.h"
+#include "core/skMemoryAllocator.h"
+#include "model/skModel.h"
+#include "skGameObject.h"
+#include "skUtils.h"
+
+// libs
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace sk
+{
+	namespace
+	{
+		// a case whose fastest ns/op grew by more than this share of the baseline's fails the run
+		constexpr double DEFAULT_REGRESSION_TOLERANCE = .1;
+
+		struct MicroBenchmarkOptions
+		{
+			skBenchmark::Settings settings{ 3, 15 };
+			uint32_t size = 1 << 16;		// elements per repetition of the per-element cases
+			uint32_t objSize = 128;			// writeSyntheticObj grid of the loadModel cases, 0 skips them
+			std::string filter{};			// only cases whose name contains it
+			std::string output{};			// file name without extension, nothing is written when empty
+			std::string baseline{};
+			double tolerance = DEFAULT_REGRESSION_TOLERANCE;
+		};
+
+		MicroBenchmarkOptions parseArgs(const std::vector<std::string> &args)
+		{
+			MicroBenchmarkOptions options{};
+			for (size_t i = 0; i + 1 < args.size(); i++)
+			{
+				if (args[i] == "--reps")
+					options.settings.repetitions = static_cast<uint32_t>(std::stoul(args[++i]));
+				else if (args[i] == "--warmup")
+					options.settings.warmup = static_cast<uint32_t>(std::stoul(args[++i]));
+				else if (args[i] == "--size")
+					options.size = std::max(1u, static_cast<uint32_t>(std::stoul(args[++i])));
+				else if (args[i] == "--obj")
+					options.objSize = static_cast<uint32_t>(std::stoul(args[++i]));
+				else if (args[i] == "--filter")
+					options.filter = args[++i];
+				else if (args[i] == "--out")
+					options.output = args[++i];
+				else if (args[i] == "--baseline")
+					options.baseline = args[++i];
+				else if (args[i] == "--tolerance")
+					options.tolerance = std::stod(args[++i]);
+			}
+			return options;
+		}
+
+		// one timed unit: a repetition runs fn once, which does ops operations on bytes bytes of input
+		struct MicroCase
+		{
+			std::string name;
+			uint64_t ops;
+			uint64_t bytes;
+			std::function<void()> fn;
+		};
+
+		struct MicroResult
+		{
+			BenchmarkResult result{};
+			uint64_t ops = 0;
+
+			double nsPerOp() const { return result.minNs / ops; }
+			double meanNsPerOp() const { return result.meanNs / ops; }
+			double opsPerSecond() const { return result.minNs > 0.0 ? ops / (result.minNs * 1e-9) : 0.0; }
+		};
+
+		// in ms for whole cases (one op per repetition), whose Mops/s would print as 0.000
+		void formatPerOp(char *text, size_t size, double ns)
+		{
+			if (ns >= 1e6)
+				std::snprintf(text, size, "%.3f ms", ns * 1e-6);
+			else
+				std::snprintf(text, size, "%.2f ns", ns);
+		}
+
+		// results of the cases end up here, so the optimizer cannot drop the work that produced them
+		volatile float g_floatSink = 0.f;
+		volatile size_t g_hashSink = 0;
+
+		// the same scattered transforms for every run
+		std::vector<TransformComponent> makeTransforms(uint32_t count)
+		{
+			std::vector<TransformComponent> transforms(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				float f = static_cast<float>(i);
+				transforms[i].translation = { std::fmod(f * .37f, 50.f), std::fmod(f * .11f, 20.f), std::fmod(f * .23f, 50.f) };
+				transforms[i].rotation = { f * .013f, f * .029f, f * .007f };
+				transforms[i].scale = glm::vec3{ .5f + std::fmod(f * .01f, 2.f) };
+			}
+			return transforms;
+		}
+
+		std::vector<MicroCase> makeCases(const MicroBenchmarkOptions &options)
+		{
+			const uint32_t size = options.size;
+			std::vector<MicroCase> cases{};
+
+			// shared inputs, captured by the cases and alive until the last of them ran
+			auto transforms = std::make_shared<std::vector<TransformComponent>>(makeTransforms(size));
+			auto matrices = std::make_shared<std::vector<glm::mat4>>(size);
+			auto normalMatrices = std::make_shared<std::vector<glm::mat3>>(size);
+			auto vertices = std::make_shared<std::vector<skModel::Vertex>>(size);
+			for (uint32_t i = 0; i < size; i++)
+			{
+				(*vertices)[i].position = (*transforms)[i].translation;
+				(*vertices)[i].color = glm::vec3{ 1.f };
+				(*vertices)[i].normal = glm::normalize((*transforms)[i].rotation + glm::vec3{ 0.f, 1.f, 0.f });
+				(*vertices)[i].uv = { (*transforms)[i].translation.x, (*transforms)[i].translation.z };
+			}
+
+			cases.push_back({ "hashCombine uint32", size, size * sizeof(uint32_t), [size]()
+				{
+					size_t seed = 0;
+					for (uint32_t i = 0; i < size; i++)
+						hashCombine(seed, i);
+					g_hashSink = seed;
+				} });
+			cases.push_back({ "hashCombine vertex", size, size * sizeof(skModel::Vertex), [vertices]()
+				{
+					size_t combined = 0;
+					for (const skModel::Vertex &vertex : *vertices)
+					{
+						size_t seed = 0;
+						hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+						combined ^= seed;
+					}
+					g_hashSink = combined;
+				} });
+
+			cases.push_back({ "TransformComponent::mat4", size, 0, [transforms, matrices]()
+				{
+					for (size_t i = 0; i < transforms->size(); i++)
+						(*matrices)[i] = (*transforms)[i].mat4();
+					g_floatSink = matrices->back()[3][0];
+				} });
+			cases.push_back({ "TransformComponent::normalMatrix", size, 0, [transforms, normalMatrices]()
+				{
+					for (size_t i = 0; i < transforms->size(); i++)
+						(*normalMatrices)[i] = (*transforms)[i].normalMatrix();
+					g_floatSink = normalMatrices->back()[2][2];
+				} });
+
+			cases.push_back({ "skCamera::setViewYXZ", size, 0, [transforms]()
+				{
+					skCamera camera{};
+					float sum = 0.f;
+					for (const TransformComponent &transform : *transforms)
+					{
+						camera.setViewYXZ(transform.translation, transform.rotation);
+						sum += camera.getView()[3][0];
+					}
+					g_floatSink = sum;
+				} });
+			cases.push_back({ "skCamera::setPerspectiveProjection", size, 0, [size]()
+				{
+					skCamera camera{};
+					float sum = 0.f;
+					for (uint32_t i = 0; i < size; i++)
+					{
+						camera.setPerspectiveProjection(glm::radians(50.f), 1.f + static_cast<float>(i & 1023) * (1.f / 1024.f), .1f, 100.f);
+						sum += camera.getProjection()[0][0];
+					}
+					g_floatSink = sum;
+				} });
+
+			// walks over every object: reading it, then building its model matrix through TransformComponent as before
+			auto gameObjects = std::make_shared<skGameObjectRegistry>();
+			gameObjects->reserve(size);
+			for (const TransformComponent &transform : *transforms)
+				gameObjects->create(transform);
+			cases.push_back({ "skGameObjectRegistry iteration", size, 0, [gameObjects]()
+				{
+					float sum = 0.f;
+					const skTransformSystem &transforms = std::as_const(*gameObjects).transforms();
+					for (uint32_t i = 0; i < transforms.size(); i++)
+						sum += transforms.translation(i).x;
+					g_floatSink = sum;
+				} });
+			cases.push_back({ "skGameObjectRegistry iteration + mat4", size, 0, [gameObjects]()
+				{
+					float sum = 0.f;
+					const skTransformSystem &transforms = std::as_const(*gameObjects).transforms();
+					for (uint32_t i = 0; i < transforms.size(); i++)
+						sum += transforms.get(i).mat4()[3][0];
+					g_floatSink = sum;
+				} });
+			// what the render systems run instead: every object dirty, both matrices through the SIMD kernel
+			cases.push_back({ "skTransformSystem markAllDirty + update", size, 0, [gameObjects]()
+				{
+					float sum = 0.f;
+					skTransformSystem &transforms = gameObjects->transforms();
+					transforms.markAllDirty();
+					transforms.update();
+					for (uint32_t i = 0; i < transforms.size(); i++)
+						sum += transforms.modelMatrix(i)[3][0];
+					g_floatSink = sum;
+				} });
+
+#ifdef SK_BENCHMARK_CPU_ONLY
+			// against skNullDevice.cpp, which only the CPU only build links. sizes off the TLSF list boundaries, suballocated
+			//   and (past half of the 64 MB block) dedicated: the dedicated path used to hand those out without memory
+			constexpr VkDeviceSize MB = 1024 * 1024;
+			const std::vector<VkDeviceSize> allocationSizes{ 4097, 65552, MB + 16, 3 * MB + 4080, 33 * MB + 4096, 40 * MB + 16,
+				64 * MB - 16, 64 * MB, 96 * MB + 272 };
+			auto allocator = std::make_shared<skMemoryAllocator>(VkDevice{ VK_NULL_HANDLE }, VkPhysicalDevice{ VK_NULL_HANDLE });
+			cases.push_back({ "skMemoryAllocator off-boundary sizes", allocationSizes.size(), 0, [allocator, allocationSizes]()
+				{
+					std::vector<skMemoryAllocation> allocations{};
+					for (VkDeviceSize size : allocationSizes)
+					{
+						VkMemoryRequirements requirements{ size, 256, 1 };
+						skMemoryAllocation allocation = allocator->allocate(requirements, 0, skMemoryAllocator::ResourceKind::Linear);
+						if (allocation.memory == VK_NULL_HANDLE || allocation.size < size || allocation.offset % 256 != 0)
+							throw std::runtime_error("skMemoryAllocator returned no memory for " + std::to_string(size) + " bytes");
+						allocations.push_back(allocation);
+					}
+					for (skMemoryAllocation &allocation : allocations)
+						allocator->free(allocation);
+				} });
+#endif
+
+			if (options.objSize > 0)
+			{
+				const std::string obj = writeSyntheticObj(options.objSize);
+				const uint64_t bytes = std::filesystem::file_size(obj);
+				for (auto [name, reader] : { std::pair{ "Builder::loadModel parallel", skModel::Builder::ObjReader::Parallel },
+					std::pair{ "Builder::loadModel tinyobj", skModel::Builder::ObjReader::TinyObj } })
+				{
+					cases.push_back({ name, 1, bytes, [obj, reader]()
+						{
+							skModel::Builder builder{};
+							builder.loadModel(obj, reader);
+							g_hashSink = builder.indices.size();
+						} });
+				}
+			}
+
+			if (!options.filter.empty())
+			{
+				cases.erase(std::remove_if(cases.begin(), cases.end(), [&](const MicroCase &microCase)
+					{ return microCase.name.find(options.filter) == std::string::npos; }), cases.end());
+			}
+			return cases;
+		}
+
+		// name -> fastest ns/op of an earlier run's csv
+		std::map<std::string, double> readBaseline(const std::string &filepath)
+		{
+			std::map<std::string, double> baseline{};
+			std::ifstream file{ filepath };
+			if (!file)
+			{
+				std::cerr << "Could not read baseline " << filepath << std::endl;
+				return baseline;
+			}
+
+			std::string line;
+			std::getline(file, line); // header
+			while (std::getline(file, line))
+			{
+				std::vector<std::string> fields{};
+				std::stringstream stream{ line };
+				for (std::string field; std::getline(stream, field, ',');)
+					fields.push_back(field);
+				// name, ops, repetitions, ns per op min, ns per op mean, ops per second, bytes per second
+				if (fields.size() < 7)
+					continue;
+				baseline[fields[0]] = std::stod(fields[3]);
+			}
+			return baseline;
+		}
+
+		bool writeCsv(const std::string &filepath, const std::vector<MicroResult> &results)
+		{
+			std::ofstream file{ filepath, std::ios::trunc };
+			file << "name,ops,repetitions,ns_per_op_min,ns_per_op_mean,ops_per_second,bytes_per_second\n";
+			char line[256];
+			for (const MicroResult &micro : results)
+			{
+				std::snprintf(line, sizeof(line), "%s,%llu,%u,%.4f,%.4f,%.1f,%.1f\n", micro.result.name.c_str(),
+					static_cast<unsigned long long>(micro.ops), micro.result.repetitions, micro.nsPerOp(), micro.meanNsPerOp(),
+					micro.opsPerSecond(), micro.result.megabytesPerSecond() * 1024.0 * 1024.0);
+				file << line;
+			}
+			if (!file)
+				std::cerr << "Failed to write " << filepath << std::endl;
+			return static_cast<bool>(file);
+		}
+
+		bool writeJson(const std::string &filepath, const MicroBenchmarkOptions &options, const std::vector<MicroResult> &results)
+		{
+			std::ofstream file{ filepath, std::ios::trunc };
+			file << "{\n  \"size\": " << options.size << ",\n  \"warmup\": " << options.settings.warmup << ",\n  \"repetitions\": "
+				<< options.settings.repetitions << ",\n  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n  \"results\": [";
+			char line[384];
+			for (size_t i = 0; i < results.size(); i++)
+			{
+				const MicroResult &micro = results[i];
+				std::snprintf(line, sizeof(line), "{ \"name\": \"%s\", \"ops\": %llu, \"ns_per_op_min\": %.4f, \"ns_per_op_mean\": %.4f, "
+					"\"ops_per_second\": %.1f, \"bytes_per_second\": %.1f }", micro.result.name.c_str(),
+					static_cast<unsigned long long>(micro.ops), micro.nsPerOp(), micro.meanNsPerOp(), micro.opsPerSecond(),
+					micro.result.megabytesPerSecond() * 1024.0 * 1024.0);
+				file << (i == 0 ? "\n    " : ",\n    ") << line;
+			}
+			file << (results.empty() ? "" : "\n  ") << "]\n}\n";
+			if (!file)
+				std::cerr << "Failed to write " << filepath << std::endl;
+			return static_cast<bool>(file);
+		}
+	} // namespace
+
+	int benchmarkMicro(const std::vector<std::string> &args)
+	{
+		const MicroBenchmarkOptions options = parseArgs(args);
+		const std::map<std::string, double> baseline = options.baseline.empty() ? std::map<std::string, double>{} : readBaseline(options.baseline);
+
+		char line[256];
+		std::snprintf(line, sizeof(line), "%-40s %14s %14s %12s %12s %10s", "case", "time/op (min)", "time/op (mean)", "Mops/s", "MB/s",
+			baseline.empty() ? "" : "baseline");
+		std::cout << options.size << " elements per repetition, " << options.settings.warmup << " warmup + "
+			<< options.settings.repetitions << " repetitions\n" << line << std::endl;
+
+		std::vector<MicroResult> results{};
+		bool regressed = false;
+		for (const MicroCase &microCase : makeCases(options))
+		{
+			MicroResult micro{};
+			micro.ops = microCase.ops;
+			micro.result = skBenchmark::measure(microCase.name, options.settings, microCase.bytes, microCase.fn);
+			results.push_back(micro);
+
+			std::string delta{};
+			auto previous = baseline.find(microCase.name);
+			if (previous != baseline.end() && previous->second > 0.0)
+			{
+				const double change = micro.nsPerOp() / previous->second - 1.0;
+				char text[32];
+				std::snprintf(text, sizeof(text), "%+.1f%%", change * 100.0);
+				delta = text;
+				if (change > options.tolerance)
+				{
+					delta += " REGRESSION";
+					regressed = true;
+				}
+			}
+
+			char minPerOp[32], meanPerOp[32];
+			formatPerOp(minPerOp, sizeof(minPerOp), micro.nsPerOp());
+			formatPerOp(meanPerOp, sizeof(meanPerOp), micro.meanNsPerOp());
+			char rate[32] = "-";
+			if (micro.nsPerOp() < 1e6)
+				std::snprintf(rate, sizeof(rate), "%.3f", micro.opsPerSecond() * 1e-6);
+			char throughput[32] = "-";
+			if (microCase.bytes > 0)
+				std::snprintf(throughput, sizeof(throughput), "%.1f", micro.result.megabytesPerSecond());
+			std::snprintf(line, sizeof(line), "%-40s %14s %14s %12s %12s %10s", microCase.name.c_str(), minPerOp, meanPerOp, rate,
+				throughput, delta.c_str());
+			std::cout << line << std::endl;
+		}
+
+		if (!options.output.empty() && !(writeCsv(options.output + ".csv", results) && writeJson(options.output + ".json", options, results)))
+			return EXIT_FAILURE;
+		return regressed ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+} // namespace sk
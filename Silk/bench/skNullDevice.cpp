@@ -0,0 +1,53 @@
+// the few Vulkan entry points skMemoryAllocator calls, for the CPU only build (CMakeLists.txt) which links no Vulkan
+//   loader. a device with one 4 GB device local heap whose memory has a handle but nothing behind it, enough to run
+//   the allocator's bookkeeping in the micro benchmark. not part of Silk.vcxproj, the engine links vulkan-1.lib
+#include <vulkan/vulkan.h>
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+	std::atomic<uint64_t> g_nextMemory{ 1 };
+} // namespace
+
+extern "C"
+{
+	VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceProperties(VkPhysicalDevice, VkPhysicalDeviceProperties *properties)
+	{
+		*properties = VkPhysicalDeviceProperties{};
+		properties->limits.bufferImageGranularity = 1;
+		properties->limits.nonCoherentAtomSize = 64;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkGetPhysicalDeviceMemoryProperties(VkPhysicalDevice, VkPhysicalDeviceMemoryProperties *properties)
+	{
+		*properties = VkPhysicalDeviceMemoryProperties{};
+		properties->memoryHeapCount = 1;
+		properties->memoryHeaps[0].size = VkDeviceSize{ 4 } << 30;
+		properties->memoryHeaps[0].flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+		properties->memoryTypeCount = 1;
+		properties->memoryTypes[0].propertyFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+		properties->memoryTypes[0].heapIndex = 0;
+	}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkAllocateMemory(VkDevice, const VkMemoryAllocateInfo *, const VkAllocationCallbacks *, VkDeviceMemory *memory)
+	{
+		// a distinct non null handle per call, pointer or uint64_t depending on the platform
+		const uint64_t handle = g_nextMemory.fetch_add(1, std::memory_order_relaxed);
+		*memory = VkDeviceMemory{};
+		std::memcpy(memory, &handle, sizeof(*memory));
+		return VK_SUCCESS;
+	}
+
+	VKAPI_ATTR void VKAPI_CALL vkFreeMemory(VkDevice, VkDeviceMemory, const VkAllocationCallbacks *) {}
+
+	VKAPI_ATTR VkResult VKAPI_CALL vkMapMemory(VkDevice, VkDeviceMemory, VkDeviceSize, VkDeviceSize, VkMemoryMapFlags, void **data)
+	{
+		// no host visible memory type is reported
+		*data = nullptr;
+		return VK_ERROR_MEMORY_MAP_FAILED;
+	}
+} // extern "C"
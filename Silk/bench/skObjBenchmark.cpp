@@ -0,0 +1,191 @@
+#include "skBenchmark.h"
+#include "model/skModel.h"
+#include "model/skObjParser.h"
+
+// std
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <thread>
+
+namespace sk
+{
+	namespace
+	{
+		// chunks forced on every file when --chunks is not given
+		constexpr uint32_t DEFAULT_FORCED_CHUNKS = 16;
+
+		bool sameOutput(const skModel::Builder& a, const skModel::Builder& b)
+		{
+			return a.vertices == b.vertices && a.indices == b.indices;
+		}
+
+		// a (size + 1)^2 grid written a row at a time, each row's faces right after its attributes and referring back
+		//   with negative indices, half of them into the previous row. forced chunk boundaries then fall between faces
+		//   and the attributes they reference, which the relative index fixups of the merge have to resolve
+		std::string writeRelativeObj(uint32_t size)
+		{
+			const std::string path = (std::filesystem::temp_directory_path() / ("silk_relative_" + std::to_string(size) + ".obj")).string();
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+				throw std::runtime_error("failed to create " + path);
+
+			char line[256]; // 18 ints of up to 11 characters, plus separators
+			const int side = static_cast<int>(size) + 1;
+			for (int z = 0; z < side; z++)
+			{
+				for (int x = 0; x < side; x++)
+				{
+					float fx = static_cast<float>(x) / size, fz = static_cast<float>(z) / size;
+					std::snprintf(line, sizeof(line), "v %f %f %f\nvn 0 1 0\nvt %f %f\n", fx - 0.5f, 0.1f * std::sin(fx * 12.f), fz - 0.5f, fx, fz);
+					file << line;
+				}
+				if (z == 0)
+					continue;
+
+				// vertex (row, x) is this far back from the end of the attributes read so far
+				auto back = [&](int row, int x) { return (row - z) * side + x - side; };
+				for (int x = 0; x < static_cast<int>(size); x++)
+				{
+					int a = back(z - 1, x), b = back(z - 1, x + 1), c = back(z, x + 1), d = back(z, x);
+					if ((x + z) % 2 == 0)
+						std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c, d, d, d);
+					else
+						std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d\nf %d/%d/%d %d/%d/%d %d/%d/%d\n",
+							a, a, a, b, b, b, c, c, c, a, a, a, c, c, c, d, d, d);
+					file << line;
+				}
+			}
+			return path;
+		}
+
+		// false if skObjParser's output differs from tinyobj's, with the automatic or the forced chunks
+		bool benchmarkFile(const std::string& path, const MeshBenchmarkOptions& options)
+		{
+			const skBenchmark::Settings& settings = options.settings;
+			const uint64_t bytes = std::filesystem::file_size(path);
+			const std::string label = std::filesystem::path(path).filename().string();
+			std::cout << "\n" << label << " (" << bytes / 1024 << " KB)" << std::endl;
+
+			skModel::Builder tinyobj{}, parallel{};
+			skBenchmark::print(skBenchmark::measure("  loadModel tinyobj", settings, bytes, [&]() {
+				tinyobj.loadModel(path, skModel::Builder::ObjReader::TinyObj);
+			}));
+			skBenchmark::print(skBenchmark::measure("  loadModel skObjParser", settings, bytes, [&]() {
+				parallel.loadModel(path, skModel::Builder::ObjReader::Parallel);
+			}));
+
+			// the parse alone, without the vertex welding both paths share
+			ObjMesh mesh{};
+			skBenchmark::print(skBenchmark::measure("  skObjParser parse, 1 thread", settings, bytes, [&]() {
+				skObjParser::parse(path, mesh, 1);
+			}));
+			const unsigned threads = std::thread::hardware_concurrency();
+			if (threads > 1) // parse() runs on one thread otherwise, the row above
+			{
+				skBenchmark::print(skBenchmark::measure("  skObjParser parse, " + std::to_string(threads) + " threads", settings, bytes, [&]() {
+					skObjParser::parse(path, mesh);
+				}));
+			}
+
+			const bool matches = sameOutput(tinyobj, parallel);
+			std::cout << "  " << parallel.vertices.size() << " vertices, " << parallel.indices.size() << " indices, output "
+				<< (matches ? "matches tinyobj" : "DIFFERS FROM TINYOBJ") << std::endl;
+
+			// files under a few MB get a single chunk on their own, so the merge would only ever run on large files and
+			//   machines with several threads. one thread, many chunks: the merge runs regardless of either
+			const uint32_t chunks = options.chunks > 0 ? options.chunks : DEFAULT_FORCED_CHUNKS;
+			if (!skObjParser::parse(path, mesh, 1, chunks))
+			{
+				std::cout << "  " << chunks << " chunks: polygons past quads, tinyobj reads this file" << std::endl;
+				return matches;
+			}
+			skModel::Builder chunked{};
+			chunked.loadMesh(mesh);
+			const bool chunkedMatches = sameOutput(tinyobj, chunked);
+			std::cout << "  " << chunks << " chunks, output " << (chunkedMatches ? "matches tinyobj" : "DIFFERS FROM TINYOBJ") << std::endl;
+			return matches && chunkedMatches;
+		}
+	} // namespace
+
+	// (size + 1)^2 vertices with normals and texcoords, faces alternate between quads and triangle pairs so both
+	//   triangulation paths get exercised. size = 1024 is roughly 150 MB.
+	std::string writeSyntheticObj(uint32_t size)
+	{
+		const std::string path = (std::filesystem::temp_directory_path() / ("silk_synthetic_" + std::to_string(size) + ".obj")).string();
+		std::ofstream file(path, std::ios::binary | std::ios::trunc);
+		if (!file.is_open())
+			throw std::runtime_error("failed to create " + path);
+
+		char line[160];
+		const uint32_t side = size + 1;
+		for (uint32_t z = 0; z < side; z++)
+		{
+			for (uint32_t x = 0; x < side; x++)
+			{
+				float fx = static_cast<float>(x) / size, fz = static_cast<float>(z) / size;
+				float height = 0.1f * std::sin(fx * 12.f) * std::cos(fz * 9.f);
+				std::snprintf(line, sizeof(line), "v %f %f %f %f %f %f\n", fx - 0.5f, height, fz - 0.5f, fx, 0.5f, fz);
+				file << line;
+			}
+		}
+		for (uint32_t i = 0; i < side * side; i++)
+			file << "vn 0.000000 1.000000 0.000000\n";
+		for (uint32_t z = 0; z < side; z++)
+		{
+			for (uint32_t x = 0; x < side; x++)
+			{
+				std::snprintf(line, sizeof(line), "vt %f %f\n", static_cast<float>(x) / size, static_cast<float>(z) / size);
+				file << line;
+			}
+		}
+
+		file << "o grid\n";
+		for (uint32_t z = 0; z < size; z++)
+		{
+			for (uint32_t x = 0; x < size; x++)
+			{
+				uint32_t a = z * side + x + 1, b = a + 1, c = a + side + 1, d = a + side;
+				if ((x + z) % 2 == 0)
+					std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c, d, d, d);
+				else
+					std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\nf %u/%u/%u %u/%u/%u %u/%u/%u\n",
+						a, a, a, b, b, b, c, c, c, a, a, a, c, c, c, d, d, d);
+				file << line;
+			}
+		}
+		return path;
+	}
+
+	int benchmarkObjReaders(const std::vector<std::string>& args)
+	{
+		MeshBenchmarkOptions options = parseMeshBenchmarkArgs(args);
+
+		bool matches = true;
+		try
+		{
+			for (const auto& file : options.files)
+				matches &= benchmarkFile(file, options);
+
+			if (options.syntheticSize > 0)
+			{
+				for (const std::string& synthetic : { writeSyntheticObj(options.syntheticSize), writeRelativeObj(options.syntheticSize) })
+				{
+					matches &= benchmarkFile(synthetic, options);
+					std::error_code ec;
+					std::filesystem::remove(synthetic, ec);
+				}
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		return matches ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+} // namespace sk
@@ -0,0 +1,229 @@
+#include "skBenchmark.h"
+#include "window/skWindow.h"
+#include "core/skDevice.h"
+#include "core/skJobSystem.h"
+#include "core/skUploadContext.h"
+#include "model/skGeometryArena.h"
+#include "renderer/skRenderer.h"
+#include "renderer/SimpleRenderSystem.h"
+#include "descriptor/skDescriptors.h"
+#include "camera/skCamera.h"
+#include "skGameObject.h"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+namespace sk
+{
+	namespace
+	{
+		struct RecordingBenchmarkOptions
+		{
+			std::vector<uint32_t> objectCounts{ 1000, 5000, 20000 };
+			std::vector<uint32_t> sliceCounts{};	// 0 records inline, the rest into that many secondaries as jobs
+			uint32_t frames = 200;
+			std::string model = "res\\models\\smooth_vase.obj";
+		};
+
+		std::vector<uint32_t> parseList(const std::string &list)
+		{
+			std::vector<uint32_t> values{};
+			std::stringstream stream{ list };
+			for (std::string value; std::getline(stream, value, ',');)
+				values.push_back(static_cast<uint32_t>(std::stoul(value)));
+			return values;
+		}
+
+		RecordingBenchmarkOptions parseArgs(const std::vector<std::string> &args)
+		{
+			RecordingBenchmarkOptions options{};
+			for (size_t i = 0; i + 1 < args.size(); i++)
+			{
+				if (args[i] == "--objects")
+					options.objectCounts = parseList(args[++i]);
+				else if (args[i] == "--slices")
+					options.sliceCounts = parseList(args[++i]);
+				else if (args[i] == "--frames")
+					options.frames = static_cast<uint32_t>(std::stoul(args[++i]));
+				else if (args[i] == "--model")
+					options.model = args[++i];
+			}
+
+			if (options.sliceCounts.empty())
+			{
+				// inline, then powers of two up to the hardware threads
+				const uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+				options.sliceCounts.push_back(0);
+				for (uint32_t slices = 1; slices < hardwareThreads; slices *= 2)
+					options.sliceCounts.push_back(slices);
+				options.sliceCounts.push_back(hardwareThreads);
+			}
+			return options;
+		}
+
+		// objectCount copies of model on a jittered grid filling the camera's view, so culling keeps most of them
+		void buildScene(skGameObjectRegistry &gameObjects, const std::shared_ptr<skModel> &model, uint32_t objectCount)
+		{
+			gameObjects.clear();
+			gameObjects.reserve(objectCount);
+			const skGameObjectRegistry::ModelHandle modelHandle = gameObjects.addModel(model);
+			const uint32_t side = static_cast<uint32_t>(std::ceil(std::cbrt(static_cast<double>(objectCount))));
+			for (uint32_t i = 0; i < objectCount; i++)
+			{
+				TransformComponent transform{};
+				float x = static_cast<float>(i % side), y = static_cast<float>(i / side % side), z = static_cast<float>(i / (side * side));
+				transform.translation = { (x - side * .5f) * .4f, (y - side * .5f) * .4f, 2.f + z * .4f };
+				transform.rotation.y = static_cast<float>(i) * .37f;
+				transform.scale = glm::vec3{ .5f };
+				gameObjects.setModel(gameObjects.create(transform), modelHandle);
+			}
+		}
+	} // namespace
+
+	int benchmarkRecording(const std::vector<std::string> &args)
+	{
+		const RecordingBenchmarkOptions options = parseArgs(args);
+
+		skWindow window{ 1280, 720, "Silk recording benchmark" };
+		skDevice device{ window };
+		skJobSystem jobSystem{};
+		skRenderer renderer{ window, device, jobSystem };
+		skUploadContext uploadContext{ device };
+		skGeometryArena arena{ device, uploadContext };
+
+		std::shared_ptr<skModel> model = skModel::createModelFromFile(arena, options.model);
+		uploadContext.wait(uploadContext.submit());
+
+		auto globalPool = skDescriptorPool::Builder(device)
+			.setMaxSets(1)
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1)
+			.build();
+		auto globalSetLayout = skDescriptorSetLayout::Builder(device)
+			.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, VK_SHADER_STAGE_ALL_GRAPHICS)
+			.build();
+		VkDescriptorSet globalDescriptorSet;
+		VkDescriptorBufferInfo uboInfo{ renderer.getFrameAllocator().getBuffer(), 0, sizeof(GlobalUbo) };
+		skDescriptorWriter(*globalSetLayout, *globalPool)
+			.writeBuffer(0, &uboInfo)
+			.build(globalDescriptorSet);
+
+		SimpleRenderSystem renderSystem{ device, renderer.getSwapChainRenderPass(), globalSetLayout->getDescriptorSetLayout() };
+		skCamera camera{};
+		camera.setViewTarget(glm::vec3{ 0.f }, glm::vec3{ 0.f, 0.f, 1.f });
+
+		std::cout << "CPU time to record the scene pass (render pass begin to end) and the whole frame, " << options.frames
+			<< " frames per row, " << jobSystem.threadCount() << " job threads, " << options.model << std::endl;
+
+		skGameObjectRegistry gameObjects{};
+		for (uint32_t objectCount : options.objectCounts)
+		{
+			buildScene(gameObjects, model, objectCount);
+			std::cout << "\n" << objectCount << " objects" << std::endl;
+
+			for (uint32_t slices : options.sliceCounts)
+			{
+				renderer.setRecordingSliceCount(std::max(1u, slices));
+				const bool parallel = slices > 0;
+
+				BenchmarkResult record{}, frame{}, gpuPass{};
+				record.name = parallel ? "  record, " + std::to_string(slices) + " slices" : "  record, inline";
+				frame.name = "  frame";
+				gpuPass.name = "  gpu scene pass";
+				record.minNs = frame.minNs = gpuPass.minNs = 1e300;
+				uint32_t measured = 0;
+				const uint32_t warmup = std::min(10u, options.frames / 10);
+
+				for (uint32_t i = 0; i < options.frames + warmup && !window.shouldClose(); i++)
+				{
+					glfwPollEvents();
+					auto frameStart = std::chrono::high_resolution_clock::now();
+					camera.setPerspectiveProjection(glm::radians(50.f), renderer.getAspectRatio(), .1f, 100.f);
+
+					auto commandBuffer = renderer.beginFrame();
+					if (!commandBuffer)
+						continue;
+					arena.beginFrame(static_cast<uint32_t>(renderer.getFrameIndex()));
+
+					skFrameAllocator &frameAllocator = renderer.getFrameAllocator();
+					GlobalUbo ubo{};
+					ubo.projectionView = camera.getProjection() * camera.getView();
+					auto uboSlice = frameAllocator.push(ubo);
+					FrameInfo frameInfo{ renderer.getFrameIndex(), 0.f, commandBuffer, camera, globalDescriptorSet,
+						static_cast<uint32_t>(uboSlice.offset), gameObjects, renderer.getSwapChainExtent(), frameAllocator };
+					if (parallel)
+						frameInfo.jobSystem = &jobSystem;
+					frameInfo.gpuProfiler = &renderer.getGpuProfiler();
+
+					auto recordStart = std::chrono::high_resolution_clock::now();
+					if (parallel)
+					{
+						renderer.beginSwapChainRenderPass(commandBuffer, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+						frameInfo.parallelRecorder = &renderer.getParallelRecorder();
+					}
+					else
+						renderer.beginSwapChainRenderPass(commandBuffer);
+					renderSystem.renderGameObjects(frameInfo);
+					renderer.endSwapChainRenderPass(commandBuffer);
+					auto recordEnd = std::chrono::high_resolution_clock::now();
+
+					renderer.endFrame();
+					jobSystem.waitFrame();
+					auto frameEnd = std::chrono::high_resolution_clock::now();
+
+					if (i < warmup)
+						continue;
+					double recordNs = std::chrono::duration<double, std::chrono::nanoseconds::period>(recordEnd - recordStart).count();
+					double frameNs = std::chrono::duration<double, std::chrono::nanoseconds::period>(frameEnd - frameStart).count();
+					record.meanNs += recordNs;
+					frame.meanNs += frameNs;
+					record.minNs = std::min(record.minNs, recordNs);
+					frame.minNs = std::min(frame.minNs, frameNs);
+					measured++;
+
+					// a few frames behind, the first ones of a row may still belong to the previous row
+					for (const skGpuProfiler::ScopeTiming &timing : renderer.getGpuProfiler().results())
+					{
+						if (std::strcmp(timing.name, "scene_pass") != 0)
+							continue;
+						gpuPass.meanNs += timing.ms * 1e6;
+						gpuPass.minNs = std::min(gpuPass.minNs, timing.ms * 1e6);
+						gpuPass.repetitions++;
+					}
+				}
+
+				if (measured == 0)
+					return EXIT_FAILURE; // window closed
+				record.repetitions = frame.repetitions = measured;
+				record.meanNs /= measured;
+				frame.meanNs /= measured;
+				skBenchmark::print(record);
+				skBenchmark::print(frame);
+				if (gpuPass.repetitions > 0)
+				{
+					gpuPass.meanNs /= gpuPass.repetitions;
+					skBenchmark::print(gpuPass);
+				}
+			}
+
+			const auto &culling = renderSystem.cullingStats();
+			std::cout << "  " << culling.objectsCulled << " objects and " << culling.trianglesCulled << " triangles culled per frame"
+				<< std::endl;
+		}
+
+		vkDeviceWaitIdle(device.device());
+		gameObjects.clear();
+		return EXIT_SUCCESS;
+	}
+} // namespace sk
@@ -0,0 +1,64 @@
+#include "skBenchmark.h"
+#include "model/skModel.h"
+
+// std
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+
+namespace sk
+{
+	namespace
+	{
+		void benchmarkFile(const std::string& path, const skBenchmark::Settings& settings)
+		{
+			skModel::Builder source{};
+			source.loadModel(path);
+			source.optimize();
+			std::cout << "\n" << std::filesystem::path(path).filename().string() << " (" << source.vertices.size() << " vertices, "
+				<< source.indices.size() / 3 << " triangles)" << std::endl;
+
+			skModel::Builder lods{};
+			skBenchmark::print(skBenchmark::measure("  generateLods", settings, 0, [&]() {
+				lods = source;
+				lods.generateLods();
+			}));
+
+			for (size_t i = 0; i < lods.lods.size(); i++)
+			{
+				const auto& lod = lods.lods[i];
+				char line[128];
+				std::snprintf(line, sizeof(line), "  LOD %zu %12u triangles (%5.1f%%)  error %.6f", i, lod.indexCount / 3,
+					100.0 * lod.indexCount / lods.lods[0].indexCount, lod.error);
+				std::cout << line << std::endl;
+			}
+		}
+	} // namespace
+
+	int benchmarkSimplifier(const std::vector<std::string>& args)
+	{
+		MeshBenchmarkOptions options = parseMeshBenchmarkArgs(args);
+
+		try
+		{
+			for (const auto& file : options.files)
+				benchmarkFile(file, options.settings);
+
+			if (options.syntheticSize > 0)
+			{
+				std::string synthetic = writeSyntheticObj(options.syntheticSize);
+				benchmarkFile(synthetic, options.settings);
+				std::error_code ec;
+				std::filesystem::remove(synthetic, ec);
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
+} // namespace sk
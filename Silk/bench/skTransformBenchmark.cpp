@@ -0,0 +1,166 @@
+#include "skBenchmark.h"
+#include "scene/skSceneGenerator.h"
+#include "skTransformSystem.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+namespace sk
+{
+	namespace
+	{
+		// one object in this many gets angles past TRANSFORM_KERNEL_MAX_ANGLE, their blocks take the scalar fallback
+		constexpr uint32_t LARGE_ANGLE_INTERVAL = 4096;
+
+		struct TransformBenchmarkOptions
+		{
+			skBenchmark::Settings settings{ 2, 20 };
+			uint32_t count = 100000;
+			std::vector<float> dirtyRatios{ .1f, .01f, 0.f };
+			// largest difference to the scalar path, relative to max(1, |scalar element|)
+			float tolerance = 1e-5f;
+		};
+
+		TransformBenchmarkOptions parseArgs(const std::vector<std::string> &args)
+		{
+			TransformBenchmarkOptions options{};
+			for (size_t i = 0; i + 1 < args.size(); i++)
+			{
+				if (args[i] == "--count")
+					options.count = std::max(1u, static_cast<uint32_t>(std::stoul(args[++i])));
+				else if (args[i] == "--reps")
+					options.settings.repetitions = static_cast<uint32_t>(std::stoul(args[++i]));
+				else if (args[i] == "--tolerance")
+					options.tolerance = std::stof(args[++i]);
+			}
+			return options;
+		}
+
+		volatile float g_sink = 0.f;
+
+		float maxDifference(const glm::mat4 &a, const glm::mat4 &b)
+		{
+			float difference = 0.f;
+			for (int column = 0; column < 4; column++)
+			{
+				for (int row = 0; row < 4; row++)
+					difference = std::max(difference, std::abs(a[column][row] - b[column][row]) / std::max(1.f, std::abs(b[column][row])));
+			}
+			return difference;
+		}
+
+		void printRow(const char *name, double ns, uint32_t count, double baselineNs)
+		{
+			char line[256];
+			std::snprintf(line, sizeof(line), "  %-34s %12.2f %9.2fx", name, ns / count, baselineNs / ns);
+			std::cout << line << std::endl;
+		}
+	} // namespace
+
+	int benchmarkTransforms(const std::vector<std::string> &args)
+	{
+		const TransformBenchmarkOptions options = parseArgs(args);
+		const uint32_t count = options.count;
+
+		skRandom random{ count };
+		std::vector<TransformComponent> transforms(count);
+		for (uint32_t i = 0; i < count; i++)
+		{
+			TransformComponent &transform = transforms[i];
+			const float maxAngle = i % LARGE_ANGLE_INTERVAL == LARGE_ANGLE_INTERVAL - 1 ? 2.f * TRANSFORM_KERNEL_MAX_ANGLE : 100.f;
+			transform.translation = { random.uniform(-50.f, 50.f), random.uniform(-50.f, 50.f), random.uniform(-50.f, 50.f) };
+			transform.rotation = { random.uniform(-maxAngle, maxAngle), random.uniform(-maxAngle, maxAngle), random.uniform(-maxAngle, maxAngle) };
+			transform.scale = { random.uniform(.1f, 4.f), random.uniform(.1f, 4.f), random.uniform(.1f, 4.f) };
+		}
+
+		// the per-frame work before: both matrices through TransformComponent, for every object
+		std::vector<glm::mat4> modelMatrices(count);
+		std::vector<glm::mat4> normalMatrices(count);
+		const BenchmarkResult baseline = skBenchmark::measure("scalar", options.settings, 0, [&]()
+			{
+				for (uint32_t i = 0; i < count; i++)
+				{
+					modelMatrices[i] = transforms[i].mat4();
+					normalMatrices[i] = glm::mat4{ transforms[i].normalMatrix() };
+				}
+				g_sink = modelMatrices.back()[3][0];
+			});
+
+		std::cout << "\n" << count << " objects" << std::string(24, ' ') << "ns/object   speedup" << std::endl;
+		printRow("TransformComponent, every object", baseline.minNs, count, baseline.minNs);
+
+		skTransformSystem system{};
+		system.reserve(count);
+		for (const TransformComponent &transform : transforms)
+			system.push(transform);
+		const skTransformSystem::Kernel best = system.kernel();
+
+		bool withinTolerance = true;
+		for (skTransformSystem::Kernel kernel : { skTransformSystem::Kernel::Scalar, skTransformSystem::Kernel::Sse2, skTransformSystem::Kernel::Avx2 })
+		{
+			if (system.setKernel(kernel) != kernel)
+				continue;
+
+			const std::string name = std::string{ "update " } + skTransformSystem::toString(kernel) + ", all dirty";
+			const BenchmarkResult result = skBenchmark::measure(name, options.settings, 0, [&]()
+				{
+					system.markAllDirty();
+					system.update();
+					g_sink = system.modelMatrix(count - 1)[3][0];
+				});
+			printRow(name.c_str(), result.minNs, count, baseline.minNs);
+
+			float modelError = 0.f;
+			float normalError = 0.f;
+			for (uint32_t i = 0; i < count; i++)
+			{
+				modelError = std::max(modelError, maxDifference(system.modelMatrix(i), modelMatrices[i]));
+				normalError = std::max(normalError, maxDifference(system.normalMatrix(i), normalMatrices[i]));
+			}
+			char line[256];
+			std::snprintf(line, sizeof(line), "    difference to TransformComponent: %.3g model, %.3g normal", modelError, normalError);
+			std::cout << line << std::endl;
+			if (modelError > options.tolerance || normalError > options.tolerance)
+			{
+				std::cerr << skTransformSystem::toString(kernel) << " differs from TransformComponent by " << modelError << " (model), "
+					<< normalError << " (normal), tolerance " << options.tolerance << std::endl;
+				withinTolerance = false;
+			}
+		}
+
+		// a frame where only some objects moved: set() on those, then the update skipping clean blocks
+		system.setKernel(best);
+		for (float ratio : options.dirtyRatios)
+		{
+			const uint32_t moved = static_cast<uint32_t>(count * ratio);
+			std::vector<uint32_t> indices(moved);
+			for (uint32_t &index : indices)
+				index = random.below(count);
+			std::sort(indices.begin(), indices.end());
+
+			float offset = 0.f;
+			const std::string name = std::string{ "set + update " } + skTransformSystem::toString(best) + ", " +
+				std::to_string(static_cast<int>(ratio * 100.f)) + "% moved";
+			const BenchmarkResult result = skBenchmark::measure(name, options.settings, 0, [&]()
+				{
+					offset += 1e-3f;
+					for (uint32_t index : indices)
+					{
+						TransformComponent transform = transforms[index];
+						transform.rotation.y += offset;
+						system.set(index, transform);
+					}
+					system.update();
+					g_sink = system.modelMatrix(count - 1)[3][0];
+				});
+			printRow(name.c_str(), result.minNs, count, baseline.minNs);
+		}
+
+		return withinTolerance ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+} // namespace sk
@@ -0,0 +1,177 @@
+#include "skBenchmark.h"
+#include "model/skModel.h"
+#include "model/skObjParser.h"
+#include "model/skVertexWelder.h"
+#include "skUtils.h"
+
+// libs
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/gtx/hash.hpp>
+
+// std
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <unordered_map>
+
+namespace sk
+{
+	namespace
+	{
+		struct AllocationCounter
+		{
+			size_t current = 0;
+			size_t peak = 0;
+		};
+
+		// forwards to std::allocator, only keeps track of the bytes in flight
+		template <typename T>
+		struct CountingAllocator
+		{
+			using value_type = T;
+
+			AllocationCounter *counter;
+
+			explicit CountingAllocator(AllocationCounter *counter) : counter(counter) {}
+			template <typename U>
+			CountingAllocator(const CountingAllocator<U>& other) : counter(other.counter) {}
+
+			T *allocate(size_t n)
+			{
+				counter->current += n * sizeof(T);
+				counter->peak = std::max(counter->peak, counter->current);
+				return std::allocator<T>{}.allocate(n);
+			}
+
+			void deallocate(T *p, size_t n)
+			{
+				counter->current -= n * sizeof(T);
+				std::allocator<T>{}.deallocate(p, n);
+			}
+
+			template <typename U>
+			bool operator==(const CountingAllocator<U>& other) const { return counter == other.counter; }
+		};
+
+		// the welding Builder::loadMesh did before skVertexWelder, kept here as the baseline
+		struct ReferenceVertexHash
+		{
+			size_t operator()(const skModel::Vertex& vertex) const
+			{
+				size_t seed = 0;
+				hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+				return seed;
+			}
+		};
+
+		using ReferenceMap = std::unordered_map<skModel::Vertex, uint32_t, ReferenceVertexHash, std::equal_to<skModel::Vertex>,
+			CountingAllocator<std::pair<const skModel::Vertex, uint32_t>>>;
+
+		skModel::Vertex assembleVertex(const ObjMesh& mesh, const ObjCorner& corner)
+		{
+			skModel::Vertex vertex{};
+			if (corner.vertex >= 0)
+			{
+				vertex.position = { mesh.positions[3 * corner.vertex + 0], mesh.positions[3 * corner.vertex + 1], mesh.positions[3 * corner.vertex + 2] };
+				vertex.color = { mesh.colors[3 * corner.vertex + 0], mesh.colors[3 * corner.vertex + 1], mesh.colors[3 * corner.vertex + 2] };
+			}
+			if (corner.normal >= 0)
+				vertex.normal = { mesh.normals[3 * corner.normal + 0], mesh.normals[3 * corner.normal + 1], mesh.normals[3 * corner.normal + 2] };
+			if (corner.texcoord >= 0)
+				vertex.uv = { mesh.texcoords[2 * corner.texcoord + 0], mesh.texcoords[2 * corner.texcoord + 1] };
+			return vertex;
+		}
+
+		void referenceWeld(const ObjMesh& mesh, skModel::Builder& builder, AllocationCounter& counter)
+		{
+			builder.vertices.clear();
+			builder.indices.clear();
+
+			ReferenceMap uniqueVertices{ 0, ReferenceVertexHash{}, std::equal_to<skModel::Vertex>{},
+				CountingAllocator<std::pair<const skModel::Vertex, uint32_t>>{ &counter } };
+			for (const auto& corner : mesh.corners)
+			{
+				skModel::Vertex vertex = assembleVertex(mesh, corner);
+				if (uniqueVertices.count(vertex) == 0)
+				{
+					uniqueVertices[vertex] = static_cast<uint32_t>(builder.vertices.size());
+					builder.vertices.push_back(vertex);
+				}
+				builder.indices.push_back(uniqueVertices[vertex]);
+			}
+		}
+
+		double megabytes(size_t bytes) { return bytes / (1024.0 * 1024.0); }
+
+		size_t outputBytes(const skModel::Builder& builder)
+		{
+			return builder.vertices.capacity() * sizeof(skModel::Vertex) + builder.indices.capacity() * sizeof(uint32_t);
+		}
+
+		void benchmarkFile(const std::string& path, const skBenchmark::Settings& settings)
+		{
+			ObjMesh mesh{};
+			skObjParser::parse(path, mesh);
+			std::cout << "\n" << std::filesystem::path(path).filename().string() << " (" << mesh.corners.size() << " corners)" << std::endl;
+
+			skModel::Builder before{};
+			AllocationCounter counter{};
+			skBenchmark::print(skBenchmark::measure("  weld unordered_map", settings, 0, [&]() {
+				counter = {};
+				referenceWeld(mesh, before, counter);
+			}));
+
+			skModel::Builder after{};
+			skBenchmark::print(skBenchmark::measure("  weld skVertexWelder", settings, 0, [&]() {
+				after.loadMesh(mesh);
+			}));
+
+			skModel::Builder epsilon{};
+			epsilon.positionWeldEpsilon = 1e-4f;
+			skBenchmark::print(skBenchmark::measure("  weld skVertexWelder, epsilon 1e-4", settings, 0, [&]() {
+				epsilon.loadMesh(mesh);
+			}));
+
+			// the welder's table is allocated once up front, so its size is its peak
+			std::vector<skModel::Vertex> scratch{};
+			const size_t tableBytes = skVertexWelder{ scratch, mesh.corners.size() }.memoryUsage();
+
+			char line[256];
+			std::snprintf(line, sizeof(line), "  peak memory: unordered_map %.2f MB + output %.2f MB, skVertexWelder %.2f MB + output %.2f MB",
+				megabytes(counter.peak), megabytes(outputBytes(before)), megabytes(tableBytes), megabytes(outputBytes(after)));
+			std::cout << line << std::endl;
+			std::cout << "  " << after.vertices.size() << " vertices (" << epsilon.vertices.size() << " with epsilon), output "
+				<< (before.vertices == after.vertices && before.indices == after.indices ? "matches unordered_map" : "DIFFERS FROM UNORDERED_MAP")
+				<< std::endl;
+		}
+	} // namespace
+
+	int benchmarkVertexWelding(const std::vector<std::string>& args)
+	{
+		MeshBenchmarkOptions options = parseMeshBenchmarkArgs(args);
+
+		try
+		{
+			for (const auto& file : options.files)
+				benchmarkFile(file, options.settings);
+
+			if (options.syntheticSize > 0)
+			{
+				std::string synthetic = writeSyntheticObj(options.syntheticSize);
+				benchmarkFile(synthetic, options.settings);
+				std::error_code ec;
+				std::filesystem::remove(synthetic, ec);
+			}
+		}
+		catch (const std::exception& e)
+		{
+			std::cerr << e.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+
+		return EXIT_SUCCESS;
+	}
+} // namespace sk
@@ -3,40 +3,57 @@
 namespace sk
 {
 
-	void KeyboardMovementController::moveInPlaneXZ(GLFWwindow* window, float dt, skGameObject& gameObject)
+	uint32_t KeyboardMovementController::readActions(GLFWwindow* window) const
+	{
+		uint32_t actions = 0;
+		auto read = [&](int key, Action action) { if (glfwGetKey(window, key) == GLFW_PRESS) actions |= action; };
+		read(keys.moveLeft, MoveLeft);
+		read(keys.moveRight, MoveRight);
+		read(keys.moveForward, MoveForward);
+		read(keys.moveBackward, MoveBackward);
+		read(keys.moveUp, MoveUp);
+		read(keys.moveDown, MoveDown);
+		read(keys.lookLeft, LookLeft);
+		read(keys.lookRight, LookRight);
+		read(keys.lookUp, LookUp);
+		read(keys.lookDown, LookDown);
+		return actions;
+	}
+
+	void KeyboardMovementController::moveInPlaneXZ(uint32_t actions, float dt, TransformComponent& transform) const
 	{
 		glm::vec3 rotate{ 0 };
 		// rotation about the y axis simulates looking "left" or "right"
-		if (glfwGetKey(window, keys.lookRight) == GLFW_PRESS) rotate.y += 1.f;
-		if (glfwGetKey(window, keys.lookLeft) == GLFW_PRESS) rotate.y -= 1.f;
+		if (actions & LookRight) rotate.y += 1.f;
+		if (actions & LookLeft) rotate.y -= 1.f;
 		// rotation about the x axis simulates looking "up" or "down"
-		if (glfwGetKey(window, keys.lookUp) == GLFW_PRESS) rotate.x += 1.f;
-		if (glfwGetKey(window, keys.lookDown) == GLFW_PRESS) rotate.x -= 1.f;
+		if (actions & LookUp) rotate.x += 1.f;
+		if (actions & LookDown) rotate.x -= 1.f;
 
 		// glm::normalize breaks when rotate is (0, 0, 0), so to avoid that, we check this condition
 		// one way to do it is to use dot product.
 		if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon())
-			gameObject.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
+			transform.rotation += lookSpeed * dt * glm::normalize(rotate);
 
 		// limit pitch values between about +/- 85ish degrees
-		gameObject.transform.rotation.x = glm::clamp(gameObject.transform.rotation.x, -1.5f, 1.5f); // prevents object from going upside down
-		gameObject.transform.rotation.y = glm::mod(gameObject.transform.rotation.y, glm::two_pi<float>()); // prevents overflow caused by multiple revolutions in the same direction
+		transform.rotation.x = glm::clamp(transform.rotation.x, -1.5f, 1.5f); // prevents object from going upside down
+		transform.rotation.y = glm::mod(transform.rotation.y, glm::two_pi<float>()); // prevents overflow caused by multiple revolutions in the same direction
 
-		float yaw = gameObject.transform.rotation.y; // facing orientation in XZ plane (angle in radians).
+		float yaw = transform.rotation.y; // facing orientation in XZ plane (angle in radians).
 		const glm::vec3 forwardDir{ sin(yaw), 0.f, cos(yaw) };
 		const glm::vec3 rightDir{ forwardDir.z, 0.f, -forwardDir.x };
 		const glm::vec3 upDir{ 0.f, -1.f, 0.f };
 
 		glm::vec3 moveDir{ 0.f };
-		if (glfwGetKey(window, keys.moveForward) == GLFW_PRESS) moveDir += forwardDir;
-		if (glfwGetKey(window, keys.moveBackward) == GLFW_PRESS) moveDir -= forwardDir;
-		if (glfwGetKey(window, keys.moveRight) == GLFW_PRESS) moveDir += rightDir;
-		if (glfwGetKey(window, keys.moveLeft) == GLFW_PRESS) moveDir -= rightDir;
-		if (glfwGetKey(window, keys.moveUp) == GLFW_PRESS) moveDir += upDir;
-		if (glfwGetKey(window, keys.moveDown) == GLFW_PRESS) moveDir -= upDir;
+		if (actions & MoveForward) moveDir += forwardDir;
+		if (actions & MoveBackward) moveDir -= forwardDir;
+		if (actions & MoveRight) moveDir += rightDir;
+		if (actions & MoveLeft) moveDir -= rightDir;
+		if (actions & MoveUp) moveDir += upDir;
+		if (actions & MoveDown) moveDir -= upDir;
 
 		if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon())
-			gameObject.transform.translation += lookSpeed * dt * glm::normalize(moveDir);
+			transform.translation += lookSpeed * dt * glm::normalize(moveDir);
 	}
 
 } // namespace sk
\ No newline at end of file
@@ -22,7 +22,25 @@ namespace sk
 			int lookDown = GLFW_KEY_DOWN;
 		};
 
-		void moveInPlaneXZ(GLFWwindow *window, float dt, skGameObject &gameObject);
+		// bit per mapped key, set while it is held
+		enum Action : uint32_t
+		{
+			MoveLeft = 1 << 0,
+			MoveRight = 1 << 1,
+			MoveForward = 1 << 2,
+			MoveBackward = 1 << 3,
+			MoveUp = 1 << 4,
+			MoveDown = 1 << 5,
+			LookLeft = 1 << 6,
+			LookRight = 1 << 7,
+			LookUp = 1 << 8,
+			LookDown = 1 << 9,
+		};
+
+		// glfw only reads keys on the main thread: sample there, move wherever the simulation runs
+		uint32_t readActions(GLFWwindow *window) const;
+		void moveInPlaneXZ(uint32_t actions, float dt, TransformComponent &transform) const;
+		void moveInPlaneXZ(GLFWwindow *window, float dt, TransformComponent &transform) const { moveInPlaneXZ(readActions(window), dt, transform); }
 
 		KeyMappings keys{};
 		float moveSpeed{ 3.f };
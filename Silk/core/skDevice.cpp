@@ -47,24 +47,32 @@ void DestroyDebugUtilsMessengerEXT(
 }
 
 // class member functions
-skDevice::skDevice(skWindow &window) : window{window} {
+skDevice::skDevice(skWindow &window) : window{&window} { init(); }
+
+skDevice::skDevice() { init(); }
+
+void skDevice::init() {
   createInstance();
   setupDebugMessenger();
   createSurface();
   pickPhysicalDevice();
   createLogicalDevice();
+  allocator_ = std::make_unique<skMemoryAllocator>(device_, physicalDevice);
   createCommandPool();
 }
 
 skDevice::~skDevice() {
   vkDestroyCommandPool(device_, commandPool, nullptr);
+  allocator_.reset();
   vkDestroyDevice(device_, nullptr);
 
   if (enableValidationLayers) {
     DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
   }
 
-  vkDestroySurfaceKHR(instance, surface_, nullptr);
+  if (!isHeadless()) {
+    vkDestroySurfaceKHR(instance, surface_, nullptr);
+  }
   vkDestroyInstance(instance, nullptr);
 }
 
@@ -79,7 +87,8 @@ void skDevice::createInstance() {
   appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
   appInfo.pEngineName = "No Engine";
   appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-  appInfo.apiVersion = VK_API_VERSION_1_0;
+  // 1.1 for vkGetPhysicalDeviceMemoryProperties2, which VK_EXT_memory_budget reports through
+  appInfo.apiVersion = VK_API_VERSION_1_1;
 
   VkInstanceCreateInfo createInfo = {};
   createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -137,7 +146,8 @@ void skDevice::createLogicalDevice() {
   QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
   std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-  std::set<uint32_t> uniqueQueueFamilies = {indices.graphicsFamily, indices.presentFamily};
+  std::set<uint32_t> uniqueQueueFamilies = {
+      indices.graphicsFamily, indices.presentFamily, indices.transferFamily};
 
   float queuePriority = 1.0f;
   for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -158,9 +168,21 @@ void skDevice::createLogicalDevice() {
   createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
   createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
+  // optional extensions are enabled when present, the device works without them
+  std::vector<const char *> enabledExtensions = requiredDeviceExtensions();
+  getPhysicalDeviceMemoryProperties2_ = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2>(
+      vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2"));
+  if (properties.apiVersion >= VK_API_VERSION_1_1 && getPhysicalDeviceMemoryProperties2_ != nullptr &&
+      isDeviceExtensionSupported(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME)) {
+    enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    memoryBudgetSupported_ = true;
+  }
+  std::cout << "VK_EXT_memory_budget: " << (memoryBudgetSupported_ ? "enabled" : "unavailable, budgets are estimated")
+            << std::endl;
+
   createInfo.pEnabledFeatures = &deviceFeatures;
-  createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-  createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+  createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+  createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
   // might not really be necessary anymore because device specific validation layers
   // have been deprecated
@@ -177,6 +199,7 @@ void skDevice::createLogicalDevice() {
 
   vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
   vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+  vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
 }
 
 void skDevice::createCommandPool() {
@@ -193,15 +216,19 @@ void skDevice::createCommandPool() {
   }
 }
 
-void skDevice::createSurface() { window.createWindowSurface(instance, &surface_); }
+void skDevice::createSurface() {
+  if (!isHeadless()) {
+    window->createWindowSurface(instance, &surface_);
+  }
+}
 
 bool skDevice::isDeviceSuitable(VkPhysicalDevice device) {
   QueueFamilyIndices indices = findQueueFamilies(device);
 
   bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-  bool swapChainAdequate = false;
-  if (extensionsSupported) {
+  bool swapChainAdequate = isHeadless();
+  if (extensionsSupported && !isHeadless()) {
     SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
     swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
   }
@@ -261,11 +288,14 @@ bool skDevice::checkValidationLayerSupport() {
 }
 
 std::vector<const char *> skDevice::getRequiredExtensions() {
-  uint32_t glfwExtensionCount = 0;
-  const char **glfwExtensions;
-  glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-  std::vector<const char *> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  // glfw is never initialized without a window, and nothing needs the surface extensions
+  std::vector<const char *> extensions{};
+  if (!isHeadless()) {
+    uint32_t glfwExtensionCount = 0;
+    const char **glfwExtensions;
+    glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+    extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+  }
 
   if (enableValidationLayers) {
     extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -308,7 +338,8 @@ bool skDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
       &extensionCount,
       availableExtensions.data());
 
-  std::set<std::string> requiredExtensions(deviceExtensions.begin(), deviceExtensions.end());
+  std::vector<const char *> required = requiredDeviceExtensions();
+  std::set<std::string> requiredExtensions(required.begin(), required.end());
 
   for (const auto &extension : availableExtensions) {
     requiredExtensions.erase(extension.extensionName);
@@ -317,6 +348,29 @@ bool skDevice::checkDeviceExtensionSupport(VkPhysicalDevice device) {
   return requiredExtensions.empty();
 }
 
+std::vector<const char *> skDevice::requiredDeviceExtensions() const {
+  return isHeadless() ? std::vector<const char *>{} : deviceExtensions;
+}
+
+bool skDevice::isDeviceExtensionSupported(VkPhysicalDevice device, const char *extensionName) {
+  uint32_t extensionCount;
+  vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+  std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+  vkEnumerateDeviceExtensionProperties(
+      device,
+      nullptr,
+      &extensionCount,
+      availableExtensions.data());
+
+  for (const auto &extension : availableExtensions) {
+    if (strcmp(extension.extensionName, extensionName) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
 QueueFamilyIndices skDevice::findQueueFamilies(VkPhysicalDevice device) {
   QueueFamilyIndices indices;
 
@@ -326,30 +380,53 @@ QueueFamilyIndices skDevice::findQueueFamilies(VkPhysicalDevice device) {
   std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
   vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilies.data());
 
+  // every family is visited, the transfer family may come after graphics and present were found
+  bool transferOnly = false;
   int i = 0;
   for (const auto &queueFamily : queueFamilies) {
-    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT) {
+    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT &&
+        !indices.graphicsFamilyHasValue) {
       indices.graphicsFamily = i;
       indices.graphicsFamilyHasValue = true;
     }
+    // nothing is presented headless, the graphics family stands in
     VkBool32 presentSupport = false;
-    vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-    if (queueFamily.queueCount > 0 && presentSupport) {
+    if (isHeadless()) {
+      presentSupport = queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT ? VK_TRUE : VK_FALSE;
+    } else {
+      vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+    }
+    if (queueFamily.queueCount > 0 && presentSupport && !indices.presentFamilyHasValue) {
       indices.presentFamily = i;
       indices.presentFamilyHasValue = true;
     }
-    if (indices.isComplete()) {
-      break;
+    // graphics and compute families support transfers implicitly, a family advertising only transfer is usually
+    // backed by a copy engine
+    bool noGraphics = !(queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT);
+    bool noCompute = !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT);
+    if (queueFamily.queueCount > 0 && queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT && noGraphics &&
+        (!indices.transferFamilyHasValue || (noCompute && !transferOnly))) {
+      indices.transferFamily = i;
+      indices.transferFamilyHasValue = true;
+      transferOnly = noCompute;
     }
 
     i++;
   }
 
+  if (!indices.transferFamilyHasValue && indices.graphicsFamilyHasValue) {
+    indices.transferFamily = indices.graphicsFamily;
+    indices.transferFamilyHasValue = true;
+  }
+
   return indices;
 }
 
 SwapChainSupportDetails skDevice::querySwapChainSupport(VkPhysicalDevice device) {
-  SwapChainSupportDetails details;
+  SwapChainSupportDetails details{};
+  if (isHeadless()) {
+    return details;
+  }
   vkGetPhysicalDeviceSurfaceCapabilitiesKHR(device, surface_, &details.capabilities);
 
   uint32_t formatCount;
@@ -403,12 +480,21 @@ uint32_t skDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags pro
   throw std::runtime_error("failed to find suitable memory type!");
 }
 
+uint32_t skDevice::graphicsTimestampValidBits() {
+  uint32_t queueFamilyCount = 0;
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, nullptr);
+  std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+  vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &queueFamilyCount, queueFamilies.data());
+  return queueFamilies[findPhysicalQueueFamilies().graphicsFamily].timestampValidBits;
+}
+
 void skDevice::createBuffer(
     VkDeviceSize size,
     VkBufferUsageFlags usage,
     VkMemoryPropertyFlags properties,
     VkBuffer &buffer,
-    VkDeviceMemory &bufferMemory) {
+    skMemoryAllocation &bufferMemory,
+    skMemoryCategory category) {
   VkBufferCreateInfo bufferInfo{};
   bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
   bufferInfo.size = size;
@@ -422,16 +508,14 @@ void skDevice::createBuffer(
   VkMemoryRequirements memRequirements;
   vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
-
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate vertex buffer memory!");
-  }
+  bufferMemory = allocator_->allocate(
+      memRequirements,
+      findMemoryType(memRequirements.memoryTypeBits, properties),
+      skMemoryAllocator::ResourceKind::Linear,
+      category);
+  budgetCheckPending_.store(true, std::memory_order_relaxed);
 
-  vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+  vkBindBufferMemory(device_, buffer, bufferMemory.memory, bufferMemory.offset);
 }
 
 VkCommandBuffer skDevice::beginSingleTimeCommands() {
@@ -460,18 +544,26 @@ void skDevice::endSingleTimeCommands(VkCommandBuffer commandBuffer) {
   submitInfo.commandBufferCount = 1;
   submitInfo.pCommandBuffers = &commandBuffer;
 
-  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
-  vkQueueWaitIdle(graphicsQueue_);
+  // waits for this submission only, not for whatever else the queue is running
+  VkFenceCreateInfo fenceInfo{};
+  fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+  VkFence fence;
+  vkCreateFence(device_, &fenceInfo, nullptr, &fence);
+
+  vkQueueSubmit(graphicsQueue_, 1, &submitInfo, fence);
+  vkWaitForFences(device_, 1, &fence, VK_TRUE, UINT64_MAX);
 
+  vkDestroyFence(device_, fence, nullptr);
   vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
 }
 
-void skDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
+void skDevice::copyBuffer(
+    VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset, VkDeviceSize dstOffset) {
   VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
   VkBufferCopy copyRegion{};
-  copyRegion.srcOffset = 0;  // Optional
-  copyRegion.dstOffset = 0;  // Optional
+  copyRegion.srcOffset = srcOffset;
+  copyRegion.dstOffset = dstOffset;
   copyRegion.size = size;
   vkCmdCopyBuffer(commandBuffer, srcBuffer, dstBuffer, 1, &copyRegion);
 
@@ -509,7 +601,8 @@ void skDevice::createImageWithInfo(
     const VkImageCreateInfo &imageInfo,
     VkMemoryPropertyFlags properties,
     VkImage &image,
-    VkDeviceMemory &imageMemory) {
+    skMemoryAllocation &imageMemory,
+    skMemoryCategory category) {
   if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
     throw std::runtime_error("failed to create image!");
   }
@@ -517,17 +610,91 @@ void skDevice::createImageWithInfo(
   VkMemoryRequirements memRequirements;
   vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-  VkMemoryAllocateInfo allocInfo{};
-  allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-  allocInfo.allocationSize = memRequirements.size;
-  allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties);
+  imageMemory = allocator_->allocate(
+      memRequirements,
+      findMemoryType(memRequirements.memoryTypeBits, properties),
+      imageInfo.tiling == VK_IMAGE_TILING_OPTIMAL ? skMemoryAllocator::ResourceKind::Optimal
+                                                  : skMemoryAllocator::ResourceKind::Linear,
+      category);
+  budgetCheckPending_.store(true, std::memory_order_relaxed);
 
-  if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-    throw std::runtime_error("failed to allocate image memory!");
+  if (vkBindImageMemory(device_, image, imageMemory.memory, imageMemory.offset) != VK_SUCCESS) {
+    throw std::runtime_error("failed to bind image memory!");
   }
+}
 
-  if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
-    throw std::runtime_error("failed to bind image memory!");
+skMemoryAllocator::Stats skDevice::memoryStats() const {
+  skMemoryAllocator::Stats stats = allocator_->stats();
+
+  if (memoryBudgetSupported_) {
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget{};
+    budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+    VkPhysicalDeviceMemoryProperties2 memProperties{};
+    memProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+    memProperties.pNext = &budget;
+    getPhysicalDeviceMemoryProperties2_(physicalDevice, &memProperties);
+
+    for (size_t i = 0; i < stats.heaps.size(); i++) {
+      stats.heaps[i].budget = budget.heapBudget[i];
+      stats.heaps[i].usage = budget.heapUsage[i];
+    }
+    stats.driverBudget = true;
+  } else {
+    // the usual estimate without the extension: most of the heap, minus nothing for other processes
+    for (auto &heap : stats.heaps) {
+      heap.budget = heap.heapSize / 10 * 8;
+      heap.usage = heap.blockBytes;
+    }
+  }
+  return stats;
+}
+
+void skDevice::setMemoryBudgetCallback(MemoryBudgetCallback callback, float threshold) {
+  budgetCallback_ = std::move(callback);
+  budgetThreshold_ = threshold;
+  budgetCheckPending_.store(true, std::memory_order_relaxed);
+}
+
+bool skDevice::checkMemoryBudget() {
+  if (!budgetCheckPending_.exchange(false, std::memory_order_relaxed)) {
+    return false;
+  }
+
+  skMemoryAllocator::Stats stats = memoryStats();
+  bool breached = false;
+  for (uint32_t i = 0; i < stats.heaps.size(); i++) {
+    const auto &heap = stats.heaps[i];
+    if (heap.budget == 0 || static_cast<double>(heap.usage) <= heap.budget * static_cast<double>(budgetThreshold_)) {
+      continue;
+    }
+    breached = true;
+    if (budgetCallback_) {
+      budgetCallback_(i, stats);
+    }
+  }
+  return breached;
+}
+
+void skDevice::printMemoryStats() {
+  skMemoryAllocator::Stats stats = memoryStats();
+  std::cout << "Device memory: " << stats.allocations << " allocations in " << stats.blocks << " blocks, "
+            << stats.usedBytes / 1024 << " KB used of " << stats.blockBytes / 1024 << " KB, fragmentation "
+            << static_cast<int>(stats.fragmentation * 100.f) << "%" << std::endl;
+
+  std::cout << " ";
+  for (uint32_t category = 0; category < MEMORY_CATEGORY_COUNT; category++) {
+    std::cout << " " << toString(static_cast<skMemoryCategory>(category)) << " "
+              << stats.categories[category].bytes / 1024 << " KB (" << stats.categories[category].allocations << ")";
+  }
+  std::cout << std::endl;
+
+  for (size_t i = 0; i < stats.heaps.size(); i++) {
+    const auto &heap = stats.heaps[i];
+    if (heap.blocks == 0) continue;
+    std::cout << "  heap " << i << ": " << heap.usedBytes / 1024 << " KB used of " << heap.blockBytes / 1024
+              << " KB allocated, " << (stats.driverBudget ? "" : "estimated ") << "usage " << heap.usage / (1024 * 1024)
+              << " MB of " << heap.budget / (1024 * 1024) << " MB budget (heap " << heap.heapSize / (1024 * 1024)
+              << " MB)" << std::endl;
   }
 }
 
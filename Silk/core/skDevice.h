@@ -1,8 +1,12 @@
 #pragma once
 
-#include "window\skWindow.h"
+#include "window/skWindow.h"
+#include "skMemoryAllocator.h"
 
 // std lib headers
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -17,9 +21,14 @@ struct SwapChainSupportDetails {
 struct QueueFamilyIndices {
   uint32_t graphicsFamily;
   uint32_t presentFamily;
+  // a family without graphics (ideally without compute too) that uploads can run on alongside rendering. falls back to
+  // the graphics family on devices exposing a single family, e.g. lavapipe
+  uint32_t transferFamily;
   bool graphicsFamilyHasValue = false;
   bool presentFamilyHasValue = false;
+  bool transferFamilyHasValue = false;
   bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
+  bool hasDedicatedTransfer() { return transferFamilyHasValue && transferFamily != graphicsFamily; }
 };
 
 class skDevice {
@@ -31,6 +40,9 @@ class skDevice {
 #endif
 
   skDevice(skWindow &window);
+  // headless: no surface and no swapchain extension, for offscreen rendering on machines without a display (render
+  // farm nodes, CI on lavapipe)
+  skDevice();
   ~skDevice();
 
   // Not copyable or movable
@@ -41,26 +53,37 @@ class skDevice {
 
   VkCommandPool getCommandPool() { return commandPool; }
   VkDevice device() { return device_; }
+  bool isHeadless() const { return window == nullptr; }
+  // VK_NULL_HANDLE when headless
   VkSurfaceKHR surface() { return surface_; }
   VkQueue graphicsQueue() { return graphicsQueue_; }
+  // the graphics queue when headless
   VkQueue presentQueue() { return presentQueue_; }
+  // the graphics queue itself when there is no dedicated transfer family
+  VkQueue transferQueue() { return transferQueue_; }
 
   SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
   uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+  // meaningful bits of timestamps written on the graphics queue, 0 when it does not support them
+  uint32_t graphicsTimestampValidBits();
   QueueFamilyIndices findPhysicalQueueFamilies() { return findQueueFamilies(physicalDevice); }
   VkFormat findSupportedFormat(
       const std::vector<VkFormat> &candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
   // Buffer Helper Functions
+  // memory comes out of the device's skMemoryAllocator, release it with freeMemory after destroying the resource
   void createBuffer(
       VkDeviceSize size,
       VkBufferUsageFlags usage,
       VkMemoryPropertyFlags properties,
       VkBuffer &buffer,
-      VkDeviceMemory &bufferMemory);
+      skMemoryAllocation &bufferMemory,
+      skMemoryCategory category = skMemoryCategory::Other);
   VkCommandBuffer beginSingleTimeCommands();
   void endSingleTimeCommands(VkCommandBuffer commandBuffer);
-  void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
+  // one-off copies that block until done, bulk uploads belong in skUploadContext
+  void copyBuffer(
+      VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size, VkDeviceSize srcOffset = 0, VkDeviceSize dstOffset = 0);
   void copyBufferToImage(
       VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount);
 
@@ -68,11 +91,28 @@ class skDevice {
       const VkImageCreateInfo &imageInfo,
       VkMemoryPropertyFlags properties,
       VkImage &image,
-      VkDeviceMemory &imageMemory);
+      skMemoryAllocation &imageMemory,
+      skMemoryCategory category = skMemoryCategory::Other);
+  void freeMemory(skMemoryAllocation &allocation) { allocator_->free(allocation); }
+
+  // Memory Budget
+  // called once per heap whose usage exceeds threshold * budget, with the stats that showed it. evict from here
+  using MemoryBudgetCallback = std::function<void(uint32_t heapIndex, const skMemoryAllocator::Stats &stats)>;
+
+  // allocator stats with each heap's budget and usage, exact with VK_EXT_memory_budget and estimated without
+  skMemoryAllocator::Stats memoryStats() const;
+  bool hasMemoryBudget() const { return memoryBudgetSupported_; }
+  void setMemoryBudgetCallback(MemoryBudgetCallback callback, float threshold = .9f);
+  // compares the heaps against their budget if anything was allocated since the last check, and calls the budget
+  //   callback for each breach. cheap otherwise, call it once per frame from the thread that may evict
+  bool checkMemoryBudget();
+  void printMemoryStats();
+  VkDeviceSize memoryAtomSize() const { return allocator_->nonCoherentAtomSize(); }
 
   VkPhysicalDeviceProperties properties;
 
  private:
+  void init();
   void createInstance();
   void setupDebugMessenger();
   void createSurface();
@@ -88,18 +128,28 @@ class skDevice {
   void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT &createInfo);
   void hasGflwRequiredInstanceExtensions();
   bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+  std::vector<const char *> requiredDeviceExtensions() const;
+  bool isDeviceExtensionSupported(VkPhysicalDevice device, const char *extensionName);
   SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
   VkInstance instance;
   VkDebugUtilsMessengerEXT debugMessenger;
   VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-  skWindow &window;
+  skWindow *window = nullptr;  // null when headless
   VkCommandPool commandPool;
 
   VkDevice device_;
-  VkSurfaceKHR surface_;
+  VkSurfaceKHR surface_ = VK_NULL_HANDLE;
   VkQueue graphicsQueue_;
   VkQueue presentQueue_;
+  VkQueue transferQueue_;
+  std::unique_ptr<skMemoryAllocator> allocator_;
+
+  bool memoryBudgetSupported_ = false;
+  PFN_vkGetPhysicalDeviceMemoryProperties2 getPhysicalDeviceMemoryProperties2_ = nullptr;
+  MemoryBudgetCallback budgetCallback_;
+  float budgetThreshold_ = .9f;
+  std::atomic<bool> budgetCheckPending_{false};
 
   const std::vector<const char *> validationLayers = {"VK_LAYER_KHRONOS_validation"};
   const std::vector<const char *> deviceExtensions = {VK_KHR_SWAPCHAIN_EXTENSION_NAME};
@@ -0,0 +1,59 @@
+#include "skFrameAllocator.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace sk
+{
+	skFrameAllocator::skFrameAllocator(skDevice &device, uint32_t frameCount, VkDeviceSize regionSize, VkBufferUsageFlags usage)
+	{
+		// all power of two limits, the largest satisfies the rest. regions start on it too
+		const VkPhysicalDeviceLimits &limits = device.properties.limits;
+		m_defaultAlignment = std::max({ limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment,
+			device.memoryAtomSize(), VkDeviceSize{ 16 } });
+		m_regionSize = (regionSize + m_defaultAlignment - 1) / m_defaultAlignment * m_defaultAlignment;
+
+		m_buffer = std::make_unique<skBuffer>(device, m_regionSize, frameCount, usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+			m_defaultAlignment, skMemoryCategory::Uniforms);
+		m_buffer->map();
+	}
+
+	void skFrameAllocator::beginFrame(uint32_t frameIndex)
+	{
+		assert(frameIndex < m_buffer->getInstanceCount() && "Frame index out of range");
+		m_frameIndex = frameIndex;
+		m_head.store(0, std::memory_order_relaxed);
+	}
+
+	void skFrameAllocator::flush()
+	{
+		VkDeviceSize used = m_head.load(std::memory_order_relaxed);
+		m_highWaterMark = std::max(m_highWaterMark, used);
+		if (used > 0)
+			m_buffer->flush(used, m_frameIndex * m_regionSize);
+	}
+
+	skFrameAllocator::Slice skFrameAllocator::allocate(VkDeviceSize size, VkDeviceSize alignment)
+	{
+		if (alignment == 0)
+			alignment = m_defaultAlignment;
+
+		VkDeviceSize head = m_head.load(std::memory_order_relaxed);
+		VkDeviceSize offset;
+		do
+		{
+			offset = (head + alignment - 1) / alignment * alignment;
+			if (offset + size > m_regionSize)
+				throw std::runtime_error("Frame allocator region exhausted!");
+		} while (!m_head.compare_exchange_weak(head, offset + size, std::memory_order_relaxed));
+
+		Slice slice{};
+		slice.buffer = m_buffer->getBuffer();
+		slice.offset = m_frameIndex * m_regionSize + offset;
+		slice.size = size;
+		slice.data = static_cast<char*>(m_buffer->getMappedMemory()) + slice.offset;
+		return slice;
+	}
+} // namespace sk
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "core/skDevice.h"
+#include "model/skBuffer.h"
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+namespace sk
+{
+	/* Linear allocator for data that lives for one frame: uniforms, per-draw payloads, dynamic vertices.
+	 *   one persistently mapped host visible buffer split into a region per frame in flight. beginFrame() rewinds the
+	 *   region of the frame being recorded, which the renderer only does once that frame's fence signaled, so whatever
+	 *   the GPU may still read belongs to the other regions. slices are bound by buffer + offset (e.g. as dynamic
+	 *   offsets) and need no cleanup. allocate may be called from several recording threads at once. */
+	class skFrameAllocator
+	{
+	public:
+		static constexpr VkDeviceSize DEFAULT_REGION_SIZE = 4 * 1024 * 1024;
+		static constexpr VkBufferUsageFlags DEFAULT_USAGE = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT |
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+
+		struct Slice
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			VkDeviceSize offset = 0;	// from the start of buffer, not of the region
+			VkDeviceSize size = 0;
+			void *data = nullptr;		// mapped, write only
+
+			VkDescriptorBufferInfo descriptorInfo() const { return VkDescriptorBufferInfo{ buffer, offset, size }; }
+		};
+
+		skFrameAllocator(skDevice &device, uint32_t frameCount, VkDeviceSize regionSize = DEFAULT_REGION_SIZE,
+			VkBufferUsageFlags usage = DEFAULT_USAGE);
+
+		skFrameAllocator(const skFrameAllocator&) = delete;
+		skFrameAllocator &operator=(const skFrameAllocator&) = delete;
+
+		// rewinds frameIndex's region, its previous contents must no longer be in use by the GPU
+		void beginFrame(uint32_t frameIndex);
+		// makes this frame's writes visible to the device, call before submitting
+		void flush();
+
+		// alignment 0 picks one valid for uniform and storage buffer offsets. throws when the region is exhausted
+		Slice allocate(VkDeviceSize size, VkDeviceSize alignment = 0);
+		template<typename T>
+		Slice push(const T &value, VkDeviceSize alignment = 0)
+		{
+			Slice slice = allocate(sizeof(T), alignment);
+			std::memcpy(slice.data, &value, sizeof(T));
+			return slice;
+		}
+
+		VkBuffer getBuffer() const { return m_buffer->getBuffer(); }
+		VkDeviceSize regionSize() const { return m_regionSize; }
+		// bytes handed out from the current region, and the most any frame has used so far
+		VkDeviceSize used() const { return m_head.load(std::memory_order_relaxed); }
+		VkDeviceSize highWaterMark() const { return m_highWaterMark; }
+
+	private:
+		std::unique_ptr<skBuffer> m_buffer;
+		VkDeviceSize m_regionSize;
+		VkDeviceSize m_defaultAlignment;
+		uint32_t m_frameIndex = 0;
+		std::atomic<VkDeviceSize> m_head{ 0 };
+		VkDeviceSize m_highWaterMark = 0;
+	};
+} // namespace sk
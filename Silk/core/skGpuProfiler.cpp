@@ -0,0 +1,104 @@
+#include "skGpuProfiler.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+
+namespace sk
+{
+	skGpuProfiler::skGpuProfiler(skDevice &device, uint32_t frameCount, uint32_t maxScopes)
+		: m_Device{ device }, m_maxScopes{ maxScopes }
+	{
+		const uint32_t validBits = m_Device.graphicsTimestampValidBits();
+		const float timestampPeriod = m_Device.properties.limits.timestampPeriod;
+		if (validBits == 0 || timestampPeriod <= 0.f)
+		{
+			std::cout << "GPU timestamps not supported on the graphics queue, GPU profiling disabled" << std::endl;
+			return;
+		}
+		m_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+		m_msPerTick = timestampPeriod * 1e-6; // timestampPeriod is in nanoseconds per tick
+
+		VkQueryPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+		poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		poolInfo.queryCount = 2 * m_maxScopes;
+
+		m_frames = std::make_unique<Frame[]>(frameCount);
+		for (uint32_t i = 0; i < frameCount; i++)
+		{
+			Frame &frame = m_frames[i];
+			frame.names.resize(m_maxScopes);
+			if (vkCreateQueryPool(m_Device.device(), &poolInfo, nullptr, &frame.pool) != VK_SUCCESS)
+				throw std::runtime_error("Failed to create timestamp query pool!");
+			m_frameCount++;
+		}
+		m_queryResults.resize(2 * 2 * m_maxScopes);
+		m_results.reserve(m_maxScopes);
+	}
+
+	skGpuProfiler::~skGpuProfiler()
+	{
+		for (uint32_t i = 0; i < m_frameCount; i++)
+			vkDestroyQueryPool(m_Device.device(), m_frames[i].pool, nullptr);
+	}
+
+	void skGpuProfiler::beginFrame(uint32_t frameIndex, VkCommandBuffer commandBuffer)
+	{
+		if (!isSupported())
+			return;
+		assert(frameIndex < m_frameCount && "Frame index out of range");
+		m_frameIndex = frameIndex;
+		Frame &frame = m_frames[frameIndex];
+
+		// the slot's last submission finished (its fence was waited on), no result is pending anymore. queries left
+		//   unwritten, e.g. by a pass that was skipped, report themselves unavailable instead of blocking
+		// reserve() keeps counting past the pool, the extra scopes were never written
+		const uint32_t scopeCount = std::min(frame.scopeCount.load(std::memory_order_relaxed), m_maxScopes);
+		m_results.clear();
+		if (scopeCount > 0)
+		{
+			vkGetQueryPoolResults(m_Device.device(), frame.pool, 0, 2 * scopeCount, 2 * scopeCount * 2 * sizeof(uint64_t),
+				m_queryResults.data(), 2 * sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+			for (uint32_t scope = 0; scope < scopeCount; scope++)
+			{
+				const uint64_t *begin = &m_queryResults[4 * scope];
+				const uint64_t *end = begin + 2;
+				if (begin[1] == 0 || end[1] == 0)
+					continue;
+				uint64_t ticks = (end[0] - begin[0]) & m_timestampMask;
+				m_results.push_back({ frame.names[scope], ticks * m_msPerTick });
+			}
+		}
+
+		vkCmdResetQueryPool(commandBuffer, frame.pool, 0, 2 * m_maxScopes);
+		frame.scopeCount.store(0, std::memory_order_relaxed);
+	}
+
+	skGpuProfiler::Scope skGpuProfiler::reserve(const char *name)
+	{
+		if (!isSupported())
+			return INVALID_SCOPE;
+		Frame &frame = m_frames[m_frameIndex];
+		Scope scope = frame.scopeCount.fetch_add(1, std::memory_order_relaxed);
+		if (scope >= m_maxScopes)
+			return INVALID_SCOPE;
+		frame.names[scope] = name;
+		return scope;
+	}
+
+	void skGpuProfiler::writeBegin(VkCommandBuffer commandBuffer, Scope scope)
+	{
+		if (scope != INVALID_SCOPE)
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_frames[m_frameIndex].pool, 2 * scope);
+	}
+
+	void skGpuProfiler::writeEnd(VkCommandBuffer commandBuffer, Scope scope)
+	{
+		if (scope != INVALID_SCOPE)
+			vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_frames[m_frameIndex].pool, 2 * scope + 1);
+	}
+} // namespace sk
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "core/skDevice.h"
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace sk
+{
+	/* GPU time of command buffer scopes, from timestamp queries.
+	 *   a scope is a pair of vkCmdWriteTimestamp (top of pipe at the begin, bottom of pipe at the end) into the query
+	 *   pool of the frame in flight. the pool is read back when its frame slot comes around again, after the slot's
+	 *   fence signaled, so reading never waits on the GPU: results are MAX_FRAMES_IN_FLIGHT frames old. ticks are
+	 *   masked to the queue's timestampValidBits and scaled by timestampPeriod. where the graphics queue has no
+	 *   timestamps every call is a no-op and results() stays empty. */
+	class skGpuProfiler
+	{
+	public:
+		using Scope = uint32_t;
+		static constexpr Scope INVALID_SCOPE = ~0u;
+
+		struct ScopeTiming
+		{
+			const char *name;
+			double ms;
+		};
+
+		skGpuProfiler(skDevice &device, uint32_t frameCount, uint32_t maxScopes = 64);
+		~skGpuProfiler();
+
+		skGpuProfiler(const skGpuProfiler&) = delete;
+		skGpuProfiler &operator=(const skGpuProfiler&) = delete;
+
+		bool isSupported() const { return m_frameCount > 0; }
+
+		// with the frame's command buffer begun, after its fence signaled and before any scope of the frame: reads what
+		//   the slot recorded last time and resets its queries
+		void beginFrame(uint32_t frameIndex, VkCommandBuffer commandBuffer);
+
+		// takes a query pair of the current frame, from any thread. INVALID_SCOPE when unsupported or out of pairs, the
+		//   write calls ignore it. begin and end may be written to different command buffers, e.g. the first and last of
+		//   a pass's secondaries, as long as they execute in that order
+		Scope reserve(const char *name);
+		void writeBegin(VkCommandBuffer commandBuffer, Scope scope);
+		void writeEnd(VkCommandBuffer commandBuffer, Scope scope);
+		Scope begin(VkCommandBuffer commandBuffer, const char *name)
+		{
+			Scope scope = reserve(name);
+			writeBegin(commandBuffer, scope);
+			return scope;
+		}
+		void end(VkCommandBuffer commandBuffer, Scope scope) { writeEnd(commandBuffer, scope); }
+
+		// scopes of the newest frame read back, in reservation order. scopes whose queries were never written are left out
+		const std::vector<ScopeTiming> &results() const { return m_results; }
+
+	private:
+		struct Frame
+		{
+			VkQueryPool pool = VK_NULL_HANDLE;
+			std::vector<const char*> names{};	// per scope
+			std::atomic<uint32_t> scopeCount{ 0 };
+		};
+
+		skDevice &m_Device;
+		uint32_t m_maxScopes;
+		uint64_t m_timestampMask = 0;
+		double m_msPerTick = 0.0;
+		std::unique_ptr<Frame[]> m_frames{};
+		uint32_t m_frameCount = 0;				// 0 when timestamps are unsupported
+		uint32_t m_frameIndex = 0;
+		std::vector<uint64_t> m_queryResults{};	// value and availability per query, reused
+		std::vector<ScopeTiming> m_results{};
+	};
+} // namespace sk
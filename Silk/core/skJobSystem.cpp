@@ -0,0 +1,288 @@
+#include "skJobSystem.h"
+
+// std
+#include <algorithm>
+
+namespace sk
+{
+	namespace
+	{
+		thread_local const skJobSystem *t_system = nullptr;
+		thread_local uint32_t t_thread = 0;
+	} // namespace
+
+	skJobSystem::skJobSystem(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		m_queues.resize(threadCount);
+		for (auto &queue : m_queues)
+			queue = std::make_unique<Queue>();
+
+		t_system = this;
+		t_thread = 0;
+		m_workers.reserve(threadCount - 1);
+		for (uint32_t i = 1; i < threadCount; i++)
+			m_workers.emplace_back(&skJobSystem::workerLoop, this, i);
+	}
+
+	skJobSystem::~skJobSystem()
+	{
+		try
+		{
+			waitFrame();
+		}
+		catch (...)
+		{
+			// a job's exception nobody waited for any more, there is no one left to hand it to
+		}
+		{
+			std::lock_guard<std::mutex> lock{ m_sleepMutex };
+			m_stop = true;
+		}
+		m_wake.notify_all();
+		for (auto &worker : m_workers)
+			worker.join();
+		if (t_system == this)
+			t_system = nullptr;
+	}
+
+	skJobSystem::JobHandle skJobSystem::create(const char *name, JobFn fn)
+	{
+		Job *job;
+		{
+			std::lock_guard<std::mutex> lock{ m_jobsMutex };
+			job = &m_jobs.emplace_back();
+		}
+		job->fn = std::move(fn);
+		job->name = name;
+		m_outstanding.fetch_add(1, std::memory_order_relaxed);
+		return job;
+	}
+
+	void skJobSystem::addDependency(JobHandle job, JobHandle dependency)
+	{
+		std::lock_guard<std::mutex> lock{ dependency->mutex };
+		if (dependency->finished)
+			return;
+		job->unfinished.fetch_add(1, std::memory_order_relaxed);
+		dependency->continuations.push_back(job);
+	}
+
+	void skJobSystem::submit(JobHandle job)
+	{
+		if (job->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+			push(job);
+	}
+
+	skJobSystem::JobHandle skJobSystem::schedule(const char *name, JobFn fn, std::initializer_list<JobHandle> dependencies)
+	{
+		JobHandle job = create(name, std::move(fn));
+		for (JobHandle dependency : dependencies)
+			addDependency(job, dependency);
+		submit(job);
+		return job;
+	}
+
+	skJobSystem::JobHandle skJobSystem::parallelForAsync(const char *name, uint32_t count, uint32_t grain, RangeFn fn,
+		std::initializer_list<JobHandle> dependencies)
+	{
+		grain = std::max(1u, grain);
+		// the ranges share one copy of fn, which lives as long as the job that joins them
+		auto shared = std::make_shared<RangeFn>(std::move(fn));
+		JobHandle join = create(name, [shared] {});
+
+		for (uint32_t begin = 0; begin < count; begin += grain)
+		{
+			uint32_t end = std::min(count, begin + grain);
+			JobHandle range = create(name, [shared, begin, end] { (*shared)(begin, end); });
+			for (JobHandle dependency : dependencies)
+				addDependency(range, dependency);
+			addDependency(join, range);
+			submit(range);
+		}
+		for (JobHandle dependency : dependencies)
+			addDependency(join, dependency);
+		submit(join);
+		return join;
+	}
+
+	bool skJobSystem::isDone(JobHandle job) const
+	{
+		return job->done.load(std::memory_order_acquire);
+	}
+
+	void skJobSystem::wait(JobHandle job)
+	{
+		const uint32_t thread = currentThread();
+		while (!isDone(job))
+		{
+			if (Job *next = pop(thread))
+				execute(next, thread);
+			else
+				std::this_thread::yield();
+		}
+		rethrowFailure();
+	}
+
+	void skJobSystem::waitFrame()
+	{
+		const uint32_t thread = currentThread();
+		while (m_outstanding.load(std::memory_order_acquire) > 0)
+		{
+			if (Job *next = pop(thread))
+				execute(next, thread);
+			else
+				std::this_thread::yield();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock{ m_jobsMutex };
+			m_jobs.clear();
+		}
+		rethrowFailure();
+	}
+
+	skJobSystem::Stats skJobSystem::stats() const
+	{
+		Stats stats{};
+		stats.jobs = m_executed.load(std::memory_order_relaxed);
+		stats.steals = m_steals.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	void skJobSystem::workerLoop(uint32_t thread)
+	{
+		t_system = this;
+		t_thread = thread;
+		for (;;)
+		{
+			if (Job *job = pop(thread))
+			{
+				execute(job, thread);
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock{ m_sleepMutex };
+			m_wake.wait(lock, [this] { return m_stop || m_queued.load(std::memory_order_acquire) > 0; });
+			if (m_stop)
+				return;
+		}
+	}
+
+	void skJobSystem::push(Job *job)
+	{
+		Queue &queue = *m_queues[currentThread()];
+		{
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			queue.jobs.push_back(job);
+		}
+		m_queued.fetch_add(1, std::memory_order_release);
+
+		// taking the lock orders this with a worker checking m_queued before it sleeps, so the wake up is never lost
+		{
+			std::lock_guard<std::mutex> lock{ m_sleepMutex };
+		}
+		m_wake.notify_one();
+	}
+
+	skJobSystem::Job *skJobSystem::pop(uint32_t thread)
+	{
+		if (m_queued.load(std::memory_order_acquire) == 0)
+			return nullptr;
+
+		// newest own job first, its data is the most likely to still be in cache
+		{
+			Queue &queue = *m_queues[thread];
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			if (!queue.jobs.empty())
+			{
+				Job *job = queue.jobs.back();
+				queue.jobs.pop_back();
+				m_queued.fetch_sub(1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+
+		// oldest job of the others, which tends to be the largest piece of work left
+		const uint32_t count = threadCount();
+		for (uint32_t i = 1; i < count; i++)
+		{
+			Queue &queue = *m_queues[(thread + i) % count];
+			std::lock_guard<std::mutex> lock{ queue.mutex };
+			if (!queue.jobs.empty())
+			{
+				Job *job = queue.jobs.front();
+				queue.jobs.pop_front();
+				m_queued.fetch_sub(1, std::memory_order_relaxed);
+				m_steals.fetch_add(1, std::memory_order_relaxed);
+				return job;
+			}
+		}
+		return nullptr;
+	}
+
+	void skJobSystem::execute(Job *job, uint32_t thread)
+	{
+		// a throwing job still finishes, or m_outstanding never drains and waitFrame spins forever. the exception waits
+		//   for the next wait or waitFrame, on whichever thread calls it
+		try
+		{
+			if (m_profileHook)
+			{
+				ProfileEvent event{ job->name, thread, std::chrono::steady_clock::now(), {} };
+				job->fn();
+				event.end = std::chrono::steady_clock::now();
+				m_profileHook(event);
+			}
+			else
+				job->fn();
+		}
+		catch (...)
+		{
+			std::lock_guard<std::mutex> lock{ m_failureMutex };
+			if (!m_failure)
+				m_failure = std::current_exception();
+		}
+
+		m_executed.fetch_add(1, std::memory_order_relaxed);
+		finish(job);
+	}
+
+	void skJobSystem::rethrowFailure()
+	{
+		std::exception_ptr failure{};
+		{
+			std::lock_guard<std::mutex> lock{ m_failureMutex };
+			failure.swap(m_failure);
+		}
+		if (failure)
+			std::rethrow_exception(failure);
+	}
+
+	void skJobSystem::finish(Job *job)
+	{
+		std::vector<Job*> continuations{};
+		{
+			std::lock_guard<std::mutex> lock{ job->mutex };
+			job->finished = true;
+			continuations.swap(job->continuations);
+		}
+		// the captures may own resources (e.g. parallelFor's shared range function), release them now
+		job->fn = nullptr;
+		job->done.store(true, std::memory_order_release);
+
+		for (Job *continuation : continuations)
+		{
+			if (continuation->unfinished.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				push(continuation);
+		}
+		m_outstanding.fetch_sub(1, std::memory_order_acq_rel);
+	}
+
+	uint32_t skJobSystem::currentThread() const
+	{
+		return t_system == this ? t_thread : 0;
+	}
+} // namespace sk
@@ -0,0 +1,138 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sk
+{
+	/* Work-stealing scheduler for the engine's per-frame work (transforms, culling, command recording).
+	 *   every thread owns a deque: it pushes and pops its own jobs at the back, idle threads steal the oldest job from
+	 *   the front of another's. the thread that creates the system is thread 0 and only runs jobs while it waits, the
+	 *   others are workers. jobs may depend on other jobs and run once all of them finished, a job may schedule more
+	 *   jobs. waiting (wait, parallelFor, waitFrame) never blocks a thread that could run jobs, it runs them instead.
+	 *   job storage lives until waitFrame(), which finishes everything scheduled since the last one, so handles must
+	 *   not be kept across it. any thread may schedule, e.g. asset loading, but only jobs that do not block for long:
+	 *   a job waiting on I/O or another thread holds a worker the frame may need.
+	 *   a job that throws counts as finished (jobs depending on it still run), the first exception thrown is rethrown
+	 *   by the next wait or waitFrame, later ones until then are dropped. */
+	class skJobSystem
+	{
+	public:
+		using JobFn = std::function<void()>;
+		// [begin, end) of the index range
+		using RangeFn = std::function<void(uint32_t begin, uint32_t end)>;
+
+		// only handled through JobHandle, the members belong to the scheduler
+		struct Job
+		{
+			JobFn fn;
+			const char *name;
+			// dependencies not finished yet, plus one until submitted
+			std::atomic<uint32_t> unfinished{ 1 };
+			std::atomic<bool> done{ false };
+
+			std::mutex mutex;					// guards finished and continuations
+			bool finished = false;
+			std::vector<Job*> continuations{};	// jobs depending on this one
+		};
+		using JobHandle = Job*;
+
+		// one per executed job, reported on the thread that ran it right after the job returned
+		struct ProfileEvent
+		{
+			const char *name;
+			uint32_t thread;
+			std::chrono::steady_clock::time_point start;
+			std::chrono::steady_clock::time_point end;
+		};
+		using ProfileHook = std::function<void(const ProfileEvent &event)>;
+
+		struct Stats
+		{
+			uint64_t jobs = 0;		// executed
+			uint64_t steals = 0;	// of them taken from another thread's deque
+		};
+
+		// threadCount includes the creating thread, 0 picks the hardware thread count
+		explicit skJobSystem(uint32_t threadCount = 0);
+		// waits for the jobs scheduled so far
+		~skJobSystem();
+
+		skJobSystem(const skJobSystem&) = delete;
+		skJobSystem &operator=(const skJobSystem&) = delete;
+
+		// a job that does not run before submit(). every created job must be submitted, waitFrame waits for it
+		JobHandle create(const char *name, JobFn fn);
+		// job runs after dependency finished, call before submitting job
+		void addDependency(JobHandle job, JobHandle dependency);
+		void submit(JobHandle job);
+		// create, addDependency and submit in one
+		JobHandle schedule(const char *name, JobFn fn, std::initializer_list<JobHandle> dependencies = {});
+
+		// splits [0, count) into ranges of grain elements run as separate jobs. the returned job finishes after all of them
+		JobHandle parallelForAsync(const char *name, uint32_t count, uint32_t grain, RangeFn fn,
+			std::initializer_list<JobHandle> dependencies = {});
+		void parallelFor(const char *name, uint32_t count, uint32_t grain, RangeFn fn) { wait(parallelForAsync(name, count, grain, std::move(fn))); }
+
+		bool isDone(JobHandle job) const;
+		// runs other jobs until job finished. rethrows the first exception a job threw since the last wait or waitFrame,
+		//   not necessarily one of job's
+		void wait(JobHandle job);
+		// runs jobs until everything scheduled so far finished, then recycles the job storage. call once per frame, from
+		//   outside any job, while no other thread schedules. rethrows like wait, after the storage is recycled
+		void waitFrame();
+
+		// set while no job runs, an empty hook turns profiling off
+		void setProfileHook(ProfileHook hook) { m_profileHook = std::move(hook); }
+		uint32_t threadCount() const { return static_cast<uint32_t>(m_queues.size()); }
+		Stats stats() const;
+
+	private:
+		struct alignas(64) Queue
+		{
+			std::mutex mutex;
+			std::deque<Job*> jobs{};
+		};
+
+		void workerLoop(uint32_t thread);
+		void push(Job *job);
+		// own deque first, then steals. null when every deque is empty
+		Job *pop(uint32_t thread);
+		void execute(Job *job, uint32_t thread);
+		void finish(Job *job);
+		void rethrowFailure();
+		// index of the calling thread's deque, thread 0's for threads outside the system
+		uint32_t currentThread() const;
+
+		std::vector<std::unique_ptr<Queue>> m_queues{};
+		std::vector<std::thread> m_workers{};
+
+		std::mutex m_jobsMutex;
+		std::deque<Job> m_jobs{};					// stable addresses, cleared by waitFrame
+		std::atomic<uint64_t> m_outstanding{ 0 };	// created and not finished
+
+		std::mutex m_failureMutex;
+		std::exception_ptr m_failure{};				// first exception out of a job, until wait or waitFrame rethrows it
+
+		// sleeping workers wake up when m_queued becomes non zero
+		std::mutex m_sleepMutex;
+		std::condition_variable m_wake;
+		std::atomic<uint32_t> m_queued{ 0 };
+		bool m_stop = false;
+
+		ProfileHook m_profileHook{};
+		std::atomic<uint64_t> m_executed{ 0 };
+		std::atomic<uint64_t> m_steals{ 0 };
+	};
+} // namespace sk
@@ -0,0 +1,358 @@
+#include "skMemoryAllocator.h"
+
+// std
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <stdexcept>
+
+namespace sk
+{
+	namespace
+	{
+		VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) { return (value + alignment - 1) / alignment * alignment; }
+	} // namespace
+
+	skMemoryAllocator::skMemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice) : m_device{ device }
+	{
+		vkGetPhysicalDeviceMemoryProperties(physicalDevice, &m_memoryProperties);
+
+		VkPhysicalDeviceProperties properties{};
+		vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+		m_atomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+		m_separateKinds = properties.limits.bufferImageGranularity > 1;
+
+		// small heaps (e.g. the 256 MB device local + host visible window) get proportionally smaller blocks
+		for (uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; i++)
+			m_blockSizes[i] = alignUp(std::min(DEFAULT_BLOCK_SIZE, m_memoryProperties.memoryHeaps[i].size / 8), SMALL_SIZE);
+	}
+
+	skMemoryAllocator::~skMemoryAllocator()
+	{
+		for (auto &kinds : m_pools)
+		{
+			for (auto &pool : kinds)
+			{
+				for (auto &block : pool)
+					destroyBlock(block.get());
+			}
+		}
+	}
+
+	skMemoryAllocation skMemoryAllocator::allocate(const VkMemoryRequirements &requirements, uint32_t memoryType, ResourceKind kind,
+		skMemoryCategory category)
+	{
+		VkDeviceSize size = alignUp(requirements.size, GRANULARITY);
+		VkDeviceSize alignment = std::max(requirements.alignment, GRANULARITY);
+		if (m_memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		{
+			alignment = std::max(alignment, alignUp(m_atomSize, GRANULARITY));
+			size = alignUp(size, alignment);
+		}
+
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		auto &pool = poolFor(memoryType, kind);
+		skMemoryAllocation allocation{};
+		allocation.category = category;
+
+		VkDeviceSize blockSize = m_blockSizes[m_memoryProperties.memoryTypes[memoryType].heapIndex];
+		if (size > blockSize / 2)
+		{
+			// offset 0 satisfies any alignment. the block's only node is taken as is: findFree rounds up to the next
+			//   list boundary, past a node of exactly size whenever size is not on one
+			Block *block = createBlock(memoryType, size, true);
+			block->kind = kind;
+			pool.emplace_back(block);
+			removeFree(*block, block->head);
+			allocateNode(*block, block->head, size, GRANULARITY, allocation);
+			return allocation;
+		}
+
+		for (auto &block : pool)
+		{
+			if (!block->dedicated && allocateFromBlock(*block, size, alignment, allocation))
+				return allocation;
+		}
+
+		Block *block = createBlock(memoryType, blockSize, false);
+		block->kind = kind;
+		pool.emplace_back(block);
+		if (!allocateFromBlock(*block, size, alignment, allocation))
+			throw std::runtime_error("Failed to suballocate device memory!");
+		return allocation;
+	}
+
+	void skMemoryAllocator::free(skMemoryAllocation &allocation)
+	{
+		if (allocation.node == nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		Node *node = static_cast<Node*>(allocation.node);
+		Block &block = *node->block;
+		assert(!node->free && "Device memory freed twice");
+
+		block.used -= node->size;
+		block.allocations--;
+		node->free = true;
+
+		uint32_t category = static_cast<uint32_t>(allocation.category);
+		m_categoryBytes[m_memoryProperties.memoryTypes[block.memoryType].heapIndex][category] -= node->size;
+		m_categoryAllocations[category]--;
+
+		// coalesce, free neighbours are never adjacent to each other
+		if (Node *next = node->nextPhysical; next && next->free)
+		{
+			removeFree(block, next);
+			node->size += next->size;
+			node->nextPhysical = next->nextPhysical;
+			if (node->nextPhysical)
+				node->nextPhysical->prevPhysical = node;
+			delete next;
+		}
+		if (Node *previous = node->prevPhysical; previous && previous->free)
+		{
+			removeFree(block, previous);
+			previous->size += node->size;
+			previous->nextPhysical = node->nextPhysical;
+			if (previous->nextPhysical)
+				previous->nextPhysical->prevPhysical = previous;
+			delete node;
+			node = previous;
+		}
+		insertFree(block, node);
+		allocation = skMemoryAllocation{};
+
+		// empty blocks go back to the driver, except for one per pool that absorbs alloc / free churn
+		if (block.allocations == 0)
+		{
+			auto &pool = poolFor(block.memoryType, block.kind);
+			bool otherEmpty = std::any_of(pool.begin(), pool.end(), [&block](const std::unique_ptr<Block> &other)
+				{
+					return other.get() != &block && !other->dedicated && other->allocations == 0;
+				});
+			if (block.dedicated || otherEmpty)
+			{
+				destroyBlock(&block);
+				std::erase_if(pool, [&block](const std::unique_ptr<Block> &other) { return other.get() == &block; });
+			}
+		}
+	}
+
+	skMemoryAllocator::Stats skMemoryAllocator::stats() const
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		Stats stats{};
+		stats.heaps.resize(m_memoryProperties.memoryHeapCount);
+		for (uint32_t i = 0; i < m_memoryProperties.memoryHeapCount; i++)
+		{
+			stats.heaps[i].heapSize = m_memoryProperties.memoryHeaps[i].size;
+			stats.heaps[i].categoryBytes = m_categoryBytes[i];
+			for (uint32_t category = 0; category < MEMORY_CATEGORY_COUNT; category++)
+				stats.categories[category].bytes += m_categoryBytes[i][category];
+		}
+		for (uint32_t category = 0; category < MEMORY_CATEGORY_COUNT; category++)
+			stats.categories[category].allocations = m_categoryAllocations[category];
+
+		VkDeviceSize freeBytes = 0;
+		for (const auto &kinds : m_pools)
+		{
+			for (const auto &pool : kinds)
+			{
+				for (const auto &block : pool)
+				{
+					HeapStats &heap = stats.heaps[m_memoryProperties.memoryTypes[block->memoryType].heapIndex];
+					heap.blocks++;
+					heap.allocations += block->allocations;
+					heap.blockBytes += block->size;
+					heap.usedBytes += block->used;
+
+					for (Node *node = block->head; node; node = node->nextPhysical)
+					{
+						if (!node->free) continue;
+						freeBytes += node->size;
+						stats.largestFreeRange = std::max(stats.largestFreeRange, node->size);
+					}
+				}
+			}
+		}
+		for (const auto &heap : stats.heaps)
+		{
+			stats.blocks += heap.blocks;
+			stats.allocations += heap.allocations;
+			stats.blockBytes += heap.blockBytes;
+			stats.usedBytes += heap.usedBytes;
+		}
+		if (freeBytes > 0)
+			stats.fragmentation = 1.f - static_cast<float>(stats.largestFreeRange) / static_cast<float>(freeBytes);
+		return stats;
+	}
+
+	void skMemoryAllocator::mapping(VkDeviceSize size, uint32_t &fl, uint32_t &sl)
+	{
+		if (size < SMALL_SIZE)
+		{
+			fl = 0;
+			sl = static_cast<uint32_t>(size / GRANULARITY);
+			return;
+		}
+		uint32_t msb = static_cast<uint32_t>(std::bit_width(size)) - 1;
+		sl = static_cast<uint32_t>(size >> (msb - SL_LOG2)) - SL_COUNT;
+		fl = msb - SMALL_LOG2 + 1;
+	}
+
+	void skMemoryAllocator::insertFree(Block &block, Node *node)
+	{
+		uint32_t fl, sl;
+		mapping(node->size, fl, sl);
+
+		node->free = true;
+		node->prevFree = nullptr;
+		node->nextFree = block.freeLists[fl][sl];
+		if (node->nextFree)
+			node->nextFree->prevFree = node;
+		block.freeLists[fl][sl] = node;
+		block.flBitmap |= uint64_t{ 1 } << fl;
+		block.slBitmap[fl] |= 1u << sl;
+	}
+
+	void skMemoryAllocator::removeFree(Block &block, Node *node)
+	{
+		uint32_t fl, sl;
+		mapping(node->size, fl, sl);
+
+		if (node->prevFree)
+			node->prevFree->nextFree = node->nextFree;
+		else
+			block.freeLists[fl][sl] = node->nextFree;
+		if (node->nextFree)
+			node->nextFree->prevFree = node->prevFree;
+		node->prevFree = node->nextFree = nullptr;
+
+		if (block.freeLists[fl][sl] == nullptr)
+		{
+			block.slBitmap[fl] &= ~(1u << sl);
+			if (block.slBitmap[fl] == 0)
+				block.flBitmap &= ~(uint64_t{ 1 } << fl);
+		}
+	}
+
+	skMemoryAllocator::Node *skMemoryAllocator::findFree(Block &block, VkDeviceSize size)
+	{
+		// round up to the next list boundary, any node found from there on fits without walking a list
+		if (size >= SMALL_SIZE)
+			size += (VkDeviceSize{ 1 } << (std::bit_width(size) - 1 - SL_LOG2)) - 1;
+
+		uint32_t fl, sl;
+		mapping(size, fl, sl);
+		if (fl >= FL_COUNT)
+			return nullptr;
+
+		uint32_t slMap = block.slBitmap[fl] & (~0u << sl);
+		if (slMap == 0)
+		{
+			uint64_t flMap = fl + 1 < FL_COUNT ? block.flBitmap & (~uint64_t{ 0 } << (fl + 1)) : 0;
+			if (flMap == 0)
+				return nullptr;
+			fl = static_cast<uint32_t>(std::countr_zero(flMap));
+			slMap = block.slBitmap[fl];
+		}
+		sl = static_cast<uint32_t>(std::countr_zero(slMap));
+		return block.freeLists[fl][sl];
+	}
+
+	bool skMemoryAllocator::allocateFromBlock(Block &block, VkDeviceSize size, VkDeviceSize alignment, skMemoryAllocation &allocation)
+	{
+		// free offsets are multiples of GRANULARITY, so larger alignments cost at most alignment - GRANULARITY of padding
+		Node *node = findFree(block, size + alignment - GRANULARITY);
+		if (node == nullptr)
+			return false;
+		removeFree(block, node);
+		allocateNode(block, node, size, alignment, allocation);
+		return true;
+	}
+
+	void skMemoryAllocator::allocateNode(Block &block, Node *node, VkDeviceSize size, VkDeviceSize alignment, skMemoryAllocation &allocation)
+	{
+		assert(node->size >= alignUp(node->offset, alignment) - node->offset + size && "Node too small for the allocation");
+
+		VkDeviceSize padding = alignUp(node->offset, alignment) - node->offset;
+		if (padding > 0)
+		{
+			Node *front = new Node{ node->offset, padding, &block, node->prevPhysical, node };
+			if (front->prevPhysical)
+				front->prevPhysical->nextPhysical = front;
+			else
+				block.head = front;
+			node->prevPhysical = front;
+			node->offset += padding;
+			node->size -= padding;
+			insertFree(block, front);
+		}
+		if (node->size > size)
+		{
+			Node *back = new Node{ node->offset + size, node->size - size, &block, node, node->nextPhysical };
+			if (back->nextPhysical)
+				back->nextPhysical->prevPhysical = back;
+			node->nextPhysical = back;
+			node->size = size;
+			insertFree(block, back);
+		}
+
+		node->free = false;
+		block.used += node->size;
+		block.allocations++;
+
+		allocation.memory = block.memory;
+		allocation.offset = node->offset;
+		allocation.size = node->size;
+		allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + node->offset : nullptr;
+		allocation.memoryType = block.memoryType;
+		allocation.node = node;
+
+		uint32_t category = static_cast<uint32_t>(allocation.category);
+		m_categoryBytes[m_memoryProperties.memoryTypes[block.memoryType].heapIndex][category] += node->size;
+		m_categoryAllocations[category]++;
+	}
+
+	skMemoryAllocator::Block *skMemoryAllocator::createBlock(uint32_t memoryType, VkDeviceSize size, bool dedicated)
+	{
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		auto block = std::make_unique<Block>();
+		if (vkAllocateMemory(m_device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate device memory block!");
+		if (m_memoryProperties.memoryTypes[memoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+			vkMapMemory(m_device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped);
+
+		block->size = size;
+		block->memoryType = memoryType;
+		block->dedicated = dedicated;
+		block->head = new Node{ 0, size, block.get() };
+		insertFree(*block, block->head);
+		return block.release();
+	}
+
+	void skMemoryAllocator::destroyBlock(Block *block)
+	{
+		for (Node *node = block->head; node;)
+		{
+			Node *next = node->nextPhysical;
+			delete node;
+			node = next;
+		}
+		block->head = nullptr;
+
+		// freeing implicitly unmaps
+		vkFreeMemory(m_device, block->memory, nullptr);
+		block->memory = VK_NULL_HANDLE;
+	}
+
+	std::vector<std::unique_ptr<skMemoryAllocator::Block>> &skMemoryAllocator::poolFor(uint32_t memoryType, ResourceKind kind)
+	{
+		return m_pools[memoryType][m_separateKinds && kind == ResourceKind::Optimal ? 1 : 0];
+	}
+} // namespace sk
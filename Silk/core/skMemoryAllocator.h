@@ -0,0 +1,162 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace sk
+{
+	// what an allocation is for, tracked so memory can be attributed and budgeted
+	enum class skMemoryCategory : uint32_t { Geometry, Uniforms, Staging, Attachments, Other };
+	inline constexpr uint32_t MEMORY_CATEGORY_COUNT = 5;
+
+	inline const char *toString(skMemoryCategory category)
+	{
+		constexpr const char *names[MEMORY_CATEGORY_COUNT] = { "geometry", "uniforms", "staging", "attachments", "other" };
+		return names[static_cast<uint32_t>(category)];
+	}
+
+	// a range of device memory handed out by skMemoryAllocator. bind the resource at memory + offset
+	struct skMemoryAllocation
+	{
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VkDeviceSize offset = 0;
+		VkDeviceSize size = 0;			// may exceed the requested size, see nonCoherentAtomSize
+		void *mapped = nullptr;			// host visible memory stays mapped, this points at offset
+		uint32_t memoryType = 0;
+		skMemoryCategory category = skMemoryCategory::Other;
+		void *node = nullptr;			// allocator bookkeeping
+	};
+
+	/* Suballocates device memory out of large blocks so that resources stop costing one vkAllocateMemory each
+	 *   (maxMemoryAllocationCount can be as low as 4096).
+	 *   blocks are pooled per memory type, and per resource kind as well when the device has a bufferImageGranularity
+	 *   above 1: buffers and optimal images then never share a page, which is all the granularity rule asks for.
+	 *   inside a block free ranges are kept TLSF style, segregated lists indexed by a two level bitmap, so allocating
+	 *   and freeing take constant time and neighbouring free ranges coalesce immediately.
+	 *   host visible blocks are mapped once for their lifetime, allocations from them are aligned to
+	 *   nonCoherentAtomSize so flushing one never touches its neighbours. requests larger than half a block get a
+	 *   block of their own. thread safe. */
+	class skMemoryAllocator
+	{
+	public:
+		enum class ResourceKind { Linear, Optimal }; // buffers and linear images / optimally tiled images
+
+		static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64 * 1024 * 1024;
+
+		struct HeapStats
+		{
+			uint32_t blocks = 0;			// vkAllocateMemory calls alive
+			uint32_t allocations = 0;
+			VkDeviceSize blockBytes = 0;
+			VkDeviceSize usedBytes = 0;
+			VkDeviceSize heapSize = 0;
+			std::array<VkDeviceSize, MEMORY_CATEGORY_COUNT> categoryBytes{};
+			// left 0 by the allocator, skDevice::memoryStats fills them from VK_EXT_memory_budget (process wide usage) or,
+			//   without it, estimates them from heapSize and blockBytes
+			VkDeviceSize budget = 0;
+			VkDeviceSize usage = 0;
+		};
+
+		struct CategoryStats
+		{
+			uint32_t allocations = 0;
+			VkDeviceSize bytes = 0;
+		};
+
+		struct Stats
+		{
+			uint32_t blocks = 0;
+			uint32_t allocations = 0;
+			VkDeviceSize blockBytes = 0;
+			VkDeviceSize usedBytes = 0;
+			VkDeviceSize largestFreeRange = 0;
+			// 1 - largest free range / all free bytes: 0 when the free space is one range, towards 1 when it is scattered
+			float fragmentation = 0.f;
+			std::vector<HeapStats> heaps{};
+			std::array<CategoryStats, MEMORY_CATEGORY_COUNT> categories{};
+			bool driverBudget = false;	// budget and usage come from VK_EXT_memory_budget
+		};
+
+		skMemoryAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+		~skMemoryAllocator();
+
+		skMemoryAllocator(const skMemoryAllocator&) = delete;
+		skMemoryAllocator &operator=(const skMemoryAllocator&) = delete;
+
+		skMemoryAllocation allocate(const VkMemoryRequirements &requirements, uint32_t memoryType, ResourceKind kind,
+			skMemoryCategory category = skMemoryCategory::Other);
+		void free(skMemoryAllocation &allocation);
+
+		Stats stats() const;
+		VkDeviceSize nonCoherentAtomSize() const { return m_atomSize; }
+
+	private:
+		// second level: 16 lists per power of two. sizes below SMALL_SIZE share the first level in 16 byte steps
+		static constexpr uint32_t SL_LOG2 = 4;
+		static constexpr uint32_t SL_COUNT = 1u << SL_LOG2;
+		static constexpr uint32_t SMALL_LOG2 = 8;
+		static constexpr VkDeviceSize SMALL_SIZE = VkDeviceSize{ 1 } << SMALL_LOG2;
+		static constexpr uint32_t FL_COUNT = 64 - SMALL_LOG2 + 1;
+		static constexpr VkDeviceSize GRANULARITY = SMALL_SIZE / SL_COUNT; // every offset and size is a multiple
+
+		struct Block;
+
+		struct Node
+		{
+			VkDeviceSize offset = 0;
+			VkDeviceSize size = 0;
+			Block *block = nullptr;
+			Node *prevPhysical = nullptr;
+			Node *nextPhysical = nullptr;
+			Node *prevFree = nullptr;
+			Node *nextFree = nullptr;
+			bool free = false;
+		};
+
+		struct Block
+		{
+			VkDeviceMemory memory = VK_NULL_HANDLE;
+			VkDeviceSize size = 0;
+			void *mapped = nullptr;
+			uint32_t memoryType = 0;
+			ResourceKind kind = ResourceKind::Linear;
+			uint32_t allocations = 0;
+			VkDeviceSize used = 0;
+			bool dedicated = false;
+			Node *head = nullptr;		// lowest offset, nodes are chained by physical neighbour from here
+			uint64_t flBitmap = 0;
+			std::array<uint32_t, FL_COUNT> slBitmap{};
+			std::array<std::array<Node*, SL_COUNT>, FL_COUNT> freeLists{};
+		};
+
+		static void mapping(VkDeviceSize size, uint32_t &fl, uint32_t &sl);
+		void insertFree(Block &block, Node *node);
+		void removeFree(Block &block, Node *node);
+		// a node of at least size bytes whose offset can be aligned within it, or null
+		Node *findFree(Block &block, VkDeviceSize size);
+		bool allocateFromBlock(Block &block, VkDeviceSize size, VkDeviceSize alignment, skMemoryAllocation &allocation);
+		// node, already off its free list, becomes the allocation. what alignment and size leave of it goes back as free nodes
+		void allocateNode(Block &block, Node *node, VkDeviceSize size, VkDeviceSize alignment, skMemoryAllocation &allocation);
+		Block *createBlock(uint32_t memoryType, VkDeviceSize size, bool dedicated);
+		void destroyBlock(Block *block);
+		std::vector<std::unique_ptr<Block>> &poolFor(uint32_t memoryType, ResourceKind kind);
+
+		VkDevice m_device;
+		VkPhysicalDeviceMemoryProperties m_memoryProperties{};
+		VkDeviceSize m_atomSize = 1;
+		bool m_separateKinds = false;	// bufferImageGranularity > 1
+		std::array<VkDeviceSize, VK_MAX_MEMORY_HEAPS> m_blockSizes{};
+		std::array<std::array<VkDeviceSize, MEMORY_CATEGORY_COUNT>, VK_MAX_MEMORY_HEAPS> m_categoryBytes{};
+		std::array<uint32_t, MEMORY_CATEGORY_COUNT> m_categoryAllocations{};
+
+		// [memory type][kind]
+		std::array<std::array<std::vector<std::unique_ptr<Block>>, 2>, VK_MAX_MEMORY_TYPES> m_pools{};
+		mutable std::mutex m_mutex;
+	};
+} // namespace sk
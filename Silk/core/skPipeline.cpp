@@ -125,6 +125,10 @@ namespace sk
 		configInfo.dynamicStateInfo.pDynamicStates = configInfo.dynamicStateEnables.data();
 		configInfo.dynamicStateInfo.dynamicStateCount = static_cast<uint32_t>(configInfo.dynamicStateEnables.size());
 		configInfo.dynamicStateInfo.flags = 0;
+
+		// full skModel::Vertex layout, override for packed meshes (see skModel::VertexLayout)
+		configInfo.bindingDescriptions = skModel::Vertex::getBindingDescriptions();
+		configInfo.attributeDescriptions = skModel::Vertex::getAttributeDescriptions();
 	}
 
 	void skPipeline::createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilePath, const PipelineConfigInfo& configInfo)
@@ -159,8 +163,8 @@ namespace sk
 		shaderStages[1].pNext = nullptr;
 		shaderStages[1].pSpecializationInfo = nullptr;
 
-		auto bindingDescriptions = skModel::Vertex::getBindingDescriptions();
-		auto attributeDescriptions = skModel::Vertex::getAttributeDescriptions();
+		auto& bindingDescriptions = configInfo.bindingDescriptions;
+		auto& attributeDescriptions = configInfo.attributeDescriptions;
 		VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 		vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 		vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
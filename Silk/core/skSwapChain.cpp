@@ -27,7 +27,10 @@ skSwapChain::skSwapChain(skDevice& deviceRef, VkExtent2D extent, std::shared_ptr
 
 void skSwapChain::Init()
 {
-	createSwapChain();
+	if (isOffscreen())
+		createOffscreenImages();
+	else
+		createSwapChain();
 	createImageViews();
 	createRenderPass();
 	createDepthResources();
@@ -46,10 +49,15 @@ skSwapChain::~skSwapChain() {
     swapChain = nullptr;
   }
 
+  for (size_t i = 0; i < offscreenImageMemorys.size(); i++) {
+    vkDestroyImage(device.device(), swapChainImages[i], nullptr);
+    device.freeMemory(offscreenImageMemorys[i]);
+  }
+
   for (int i = 0; i < depthImages.size(); i++) {
     vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
     vkDestroyImage(device.device(), depthImages[i], nullptr);
-    vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+    device.freeMemory(depthImageMemorys[i]);
   }
 
   for (auto framebuffer : swapChainFramebuffers) {
@@ -67,12 +75,22 @@ skSwapChain::~skSwapChain() {
 }
 
 VkResult skSwapChain::acquireNextImage(uint32_t *imageIndex) {
+  auto start = std::chrono::steady_clock::now();
   vkWaitForFences(
       device.device(),
       1,
       &inFlightFences[currentFrame],
       VK_TRUE,
       std::numeric_limits<uint64_t>::max());
+  auto waited = std::chrono::steady_clock::now();
+
+  // one target per frame in flight, free once its fence signaled
+  if (isOffscreen()) {
+    *imageIndex = static_cast<uint32_t>(currentFrame);
+    timings.fenceWait = waited - start;
+    timings.acquire = {};
+    return VK_SUCCESS;
+  }
 
   VkResult result = vkAcquireNextImageKHR(
       device.device(),
@@ -82,14 +100,19 @@ VkResult skSwapChain::acquireNextImage(uint32_t *imageIndex) {
       VK_NULL_HANDLE,
       imageIndex);
 
+  timings.fenceWait = waited - start;
+  timings.acquire = std::chrono::steady_clock::now() - waited;
   return result;
 }
 
 VkResult skSwapChain::submitCommandBuffers(
     const VkCommandBuffer *buffers, uint32_t *imageIndex) {
+  auto start = std::chrono::steady_clock::now();
   if (imagesInFlight[*imageIndex] != VK_NULL_HANDLE) {
     vkWaitForFences(device.device(), 1, &imagesInFlight[*imageIndex], VK_TRUE, UINT64_MAX);
   }
+  auto waited = std::chrono::steady_clock::now();
+  timings.fenceWait += waited - start;
   imagesInFlight[*imageIndex] = inFlightFences[currentFrame];
 
   VkSubmitInfo submitInfo = {};
@@ -97,7 +120,7 @@ VkResult skSwapChain::submitCommandBuffers(
 
   VkSemaphore waitSemaphores[] = {imageAvailableSemaphores[currentFrame]};
   VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-  submitInfo.waitSemaphoreCount = 1;
+  submitInfo.waitSemaphoreCount = isOffscreen() ? 0 : 1;
   submitInfo.pWaitSemaphores = waitSemaphores;
   submitInfo.pWaitDstStageMask = waitStages;
 
@@ -105,7 +128,7 @@ VkResult skSwapChain::submitCommandBuffers(
   submitInfo.pCommandBuffers = buffers;
 
   VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
-  submitInfo.signalSemaphoreCount = 1;
+  submitInfo.signalSemaphoreCount = isOffscreen() ? 0 : 1;
   submitInfo.pSignalSemaphores = signalSemaphores;
 
   vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
@@ -113,6 +136,14 @@ VkResult skSwapChain::submitCommandBuffers(
       VK_SUCCESS) {
     throw std::runtime_error("failed to submit draw command buffer!");
   }
+  auto submitted = std::chrono::steady_clock::now();
+  timings.submit = submitted - waited;
+
+  if (isOffscreen()) {
+    timings.present = {};
+    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+    return VK_SUCCESS;
+  }
 
   VkPresentInfoKHR presentInfo = {};
   presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -127,6 +158,7 @@ VkResult skSwapChain::submitCommandBuffers(
   presentInfo.pImageIndices = imageIndex;
 
   auto result = vkQueuePresentKHR(device.presentQueue(), &presentInfo);
+  timings.present = std::chrono::steady_clock::now() - submitted;
 
   currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
 
@@ -194,6 +226,41 @@ void skSwapChain::createSwapChain() {
   swapChainExtent = extent;
 }
 
+void skSwapChain::createOffscreenImages() {
+  swapChainImageFormat = device.findSupportedFormat(
+      {VK_FORMAT_B8G8R8A8_SRGB, VK_FORMAT_R8G8B8A8_SRGB},
+      VK_IMAGE_TILING_OPTIMAL,
+      VK_FORMAT_FEATURE_COLOR_ATTACHMENT_BIT);
+  swapChainExtent = windowExtent;
+
+  swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+  offscreenImageMemorys.resize(MAX_FRAMES_IN_FLIGHT);
+  for (size_t i = 0; i < swapChainImages.size(); i++) {
+    VkImageCreateInfo imageInfo{};
+    imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.extent.width = swapChainExtent.width;
+    imageInfo.extent.height = swapChainExtent.height;
+    imageInfo.extent.depth = 1;
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.format = swapChainImageFormat;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    device.createImageWithInfo(
+        imageInfo,
+        VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        swapChainImages[i],
+        offscreenImageMemorys[i],
+        skMemoryCategory::Attachments);
+  }
+  std::cout << "Offscreen targets: " << swapChainExtent.width << "x" << swapChainExtent.height << std::endl;
+}
+
 void skSwapChain::createImageViews() {
   swapChainImageViews.resize(swapChainImages.size());
   for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -238,7 +305,8 @@ void skSwapChain::createRenderPass() {
   colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
   colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
   colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-  colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+  colorAttachment.finalLayout =
+      isOffscreen() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
   VkAttachmentReference colorAttachmentRef = {};
   colorAttachmentRef.attachment = 0;
@@ -331,7 +399,8 @@ void skSwapChain::createDepthResources() {
         imageInfo,
         VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
         depthImages[i],
-        depthImageMemorys[i]);
+        depthImageMemorys[i],
+        skMemoryCategory::Attachments);
 
     VkImageViewCreateInfo viewInfo{};
     viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -5,12 +5,16 @@
 #include <vulkan/vulkan.h>
 
 // std lib headers
+#include <chrono>
 #include <string>
 #include <vector>
 #include <memory>
 
 namespace sk {
 
+// on a headless device the swap chain is offscreen: MAX_FRAMES_IN_FLIGHT color and depth targets of the given extent,
+// cycled in frame order, left in VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL for readback. acquiring only waits for the
+// frame's fence and nothing is presented, the same render pass and framebuffers are used either way
 class skSwapChain {
  public:
   static constexpr int MAX_FRAMES_IN_FLIGHT = 2;
@@ -26,6 +30,8 @@ class skSwapChain {
   VkFramebuffer getFrameBuffer(int index) { return swapChainFramebuffers[index]; }
   VkRenderPass getRenderPass() { return renderPass; }
   VkImageView getImageView(int index) { return swapChainImageViews[index]; }
+  VkImage getImage(int index) { return swapChainImages[index]; }
+  bool isOffscreen() const { return device.isHeadless(); }
   size_t imageCount() { return swapChainImages.size(); }
   VkFormat getSwapChainImageFormat() { return swapChainImageFormat; }
   VkExtent2D getSwapChainExtent() { return swapChainExtent; }
@@ -40,6 +46,15 @@ class skSwapChain {
   VkResult acquireNextImage(uint32_t *imageIndex);
   VkResult submitCommandBuffers(const VkCommandBuffer *buffers, uint32_t *imageIndex);
 
+  // CPU time spent blocked in the last acquireNextImage / submitCommandBuffers
+  struct Timings {
+    std::chrono::steady_clock::duration fenceWait{};  // frame fence, plus the image's fence before submitting
+    std::chrono::steady_clock::duration acquire{};
+    std::chrono::steady_clock::duration submit{};
+    std::chrono::steady_clock::duration present{};
+  };
+  const Timings &lastTimings() const { return timings; }
+
   inline bool compareSwapChainFormats(const skSwapChain& swapChain) const 
   {
       // If image and depth formats are the same for swapchains, then their renderpasses must be compatible
@@ -50,6 +65,7 @@ class skSwapChain {
  private:
   void Init();
   void createSwapChain();
+  void createOffscreenImages();
   void createImageViews();
   void createDepthResources();
   void createRenderPass();
@@ -71,15 +87,17 @@ class skSwapChain {
   VkRenderPass renderPass;
 
   std::vector<VkImage> depthImages;
-  std::vector<VkDeviceMemory> depthImageMemorys;
+  std::vector<skMemoryAllocation> depthImageMemorys;
   std::vector<VkImageView> depthImageViews;
   std::vector<VkImage> swapChainImages;
   std::vector<VkImageView> swapChainImageViews;
+  std::vector<skMemoryAllocation> offscreenImageMemorys;  // offscreen only, swap chain images belong to the swap chain
 
   skDevice &device;
   VkExtent2D windowExtent;
+  Timings timings{};
 
-  VkSwapchainKHR swapChain;
+  VkSwapchainKHR swapChain = VK_NULL_HANDLE;
   std::shared_ptr<skSwapChain> oldSwapChain;
 
   std::vector<VkSemaphore> imageAvailableSemaphores;
@@ -0,0 +1,307 @@
+#include "skTelemetry.h"
+
+// std
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace sk
+{
+	namespace
+	{
+		double toMs(std::chrono::steady_clock::duration duration)
+		{
+			return std::chrono::duration<double, std::chrono::milliseconds::period>(duration).count();
+		}
+
+		// nearest rank on sorted values
+		double percentile(const std::vector<double> &sorted, double p)
+		{
+			size_t rank = static_cast<size_t>(std::ceil(p * sorted.size()));
+			return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+		}
+
+		skTelemetry::Distribution distribution(std::vector<double> &values)
+		{
+			skTelemetry::Distribution result{};
+			if (values.empty())
+				return result;
+
+			double sum = 0.0;
+			for (double value : values)
+				sum += value;
+			result.mean = sum / values.size();
+			for (double value : values)
+				result.variance += (value - result.mean) * (value - result.mean);
+			result.variance /= values.size();
+
+			std::sort(values.begin(), values.end());
+			result.p50 = percentile(values, .50);
+			result.p95 = percentile(values, .95);
+			result.p99 = percentile(values, .99);
+			result.max = values.back();
+			return result;
+		}
+
+		void writeJson(std::ostream &out, const skTelemetry::Distribution &distribution)
+		{
+			char text[256];
+			std::snprintf(text, sizeof(text), "{ \"mean\": %.4f, \"variance\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f }",
+				distribution.mean, distribution.variance, distribution.p50, distribution.p95, distribution.p99, distribution.max);
+			out << text;
+		}
+	} // namespace
+
+	const char *toString(skFramePhase phase)
+	{
+		switch (phase)
+		{
+		case skFramePhase::Poll: return "poll";
+		case skFramePhase::Update: return "update";
+		case skFramePhase::FenceWait: return "fence_wait";
+		case skFramePhase::Acquire: return "acquire";
+		case skFramePhase::Record: return "record";
+		case skFramePhase::Submit: return "submit";
+		case skFramePhase::Present: return "present";
+		}
+		return "unknown";
+	}
+
+	skTelemetry::skTelemetry(uint32_t capacity)
+	{
+		capacity = std::bit_ceil(std::max(capacity, 2u));
+		m_slots = std::make_unique<Slot[]>(capacity);
+		m_mask = capacity - 1;
+	}
+
+	void skTelemetry::beginFrame()
+	{
+		auto now = std::chrono::steady_clock::now();
+		if (m_inFrame)
+			publish(now);
+		m_frameStart = now;
+		m_phases.fill(std::chrono::steady_clock::duration::zero());
+		m_gpuMs.fill(-1.0);
+		m_inFrame = true;
+	}
+
+	void skTelemetry::addPhase(skFramePhase phase, std::chrono::steady_clock::duration duration)
+	{
+		m_phases[static_cast<uint32_t>(phase)] += duration;
+	}
+
+	void skTelemetry::addGpuScope(const char *name, double ms)
+	{
+		uint32_t count = m_gpuScopeCount.load(std::memory_order_relaxed);
+		uint32_t index = 0;
+		while (index < count && std::strcmp(m_gpuScopeNames[index], name) != 0)
+			index++;
+		if (index == count)
+		{
+			if (count == MAX_GPU_SCOPES)
+				return;
+			m_gpuScopeNames[index] = name;
+			m_gpuScopeCount.store(count + 1, std::memory_order_release);
+		}
+		m_gpuMs[index] = std::max(m_gpuMs[index], 0.0) + ms;
+	}
+
+	std::vector<const char*> skTelemetry::gpuScopeNames() const
+	{
+		const uint32_t count = m_gpuScopeCount.load(std::memory_order_acquire);
+		return std::vector<const char*>(m_gpuScopeNames.begin(), m_gpuScopeNames.begin() + count);
+	}
+
+	void skTelemetry::publish(std::chrono::steady_clock::time_point end)
+	{
+		const uint64_t frame = m_published.load(std::memory_order_relaxed);
+		Slot &slot = m_slots[frame & m_mask];
+
+		// odd while the fields are inconsistent, readers drop the slot if they see it change
+		slot.sequence.store(2 * frame + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+		slot.timeMs.store(toMs(m_frameStart - m_origin), std::memory_order_relaxed);
+		slot.frameMs.store(static_cast<float>(toMs(end - m_frameStart)), std::memory_order_relaxed);
+		for (uint32_t i = 0; i < FRAME_PHASE_COUNT; i++)
+			slot.phaseMs[i].store(static_cast<float>(toMs(m_phases[i])), std::memory_order_relaxed);
+		for (uint32_t i = 0; i < MAX_GPU_SCOPES; i++)
+			slot.gpuMs[i].store(static_cast<float>(m_gpuMs[i]), std::memory_order_relaxed);
+		slot.sequence.store(2 * frame + 2, std::memory_order_release);
+
+		m_published.store(frame + 1, std::memory_order_release);
+	}
+
+	std::vector<skTelemetry::FrameSample> skTelemetry::samples() const
+	{
+		const uint64_t published = m_published.load(std::memory_order_acquire);
+		const uint64_t first = published > capacity() ? published - capacity() : 0;
+
+		std::vector<FrameSample> result{};
+		result.reserve(published - first);
+		for (uint64_t frame = first; frame < published; frame++)
+		{
+			const Slot &slot = m_slots[frame & m_mask];
+			const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+			if (sequence != 2 * frame + 2)
+				continue; // already overwritten by a newer frame
+
+			FrameSample sample{};
+			sample.frame = frame;
+			sample.timeMs = slot.timeMs.load(std::memory_order_relaxed);
+			sample.frameMs = slot.frameMs.load(std::memory_order_relaxed);
+			for (uint32_t i = 0; i < FRAME_PHASE_COUNT; i++)
+				sample.phaseMs[i] = slot.phaseMs[i].load(std::memory_order_relaxed);
+			for (uint32_t i = 0; i < MAX_GPU_SCOPES; i++)
+				sample.gpuMs[i] = slot.gpuMs[i].load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+				result.push_back(sample);
+		}
+		return result;
+	}
+
+	skTelemetry::Summary skTelemetry::summarize() const
+	{
+		return summarize(samples());
+	}
+
+	skTelemetry::Summary skTelemetry::summarize(const std::vector<FrameSample> &samples) const
+	{
+		Summary summary{};
+		summary.frames = static_cast<uint32_t>(samples.size());
+
+		std::vector<double> values(samples.size());
+		for (uint32_t phase = 0; phase < FRAME_PHASE_COUNT; phase++)
+		{
+			for (size_t i = 0; i < samples.size(); i++)
+				values[i] = samples[i].phaseMs[phase];
+			summary.phases[phase] = distribution(values);
+		}
+
+		for (size_t i = 0; i < samples.size(); i++)
+			values[i] = samples[i].frameMs;
+		summary.frame = distribution(values);
+		for (const FrameSample &sample : samples)
+		{
+			if (sample.frameMs > HITCH_FACTOR * summary.frame.p50)
+				summary.hitches++;
+		}
+
+		const std::vector<const char*> gpuScopes = gpuScopeNames();
+		for (uint32_t scope = 0; scope < gpuScopes.size(); scope++)
+		{
+			values.clear();
+			for (const FrameSample &sample : samples)
+			{
+				if (sample.gpuMs[scope] >= 0.f)
+					values.push_back(sample.gpuMs[scope]);
+			}
+			summary.gpuScopes.emplace_back(gpuScopes[scope], distribution(values));
+		}
+		return summary;
+	}
+
+	bool skTelemetry::exportCsv(const std::string &filepath) const
+	{
+		std::ofstream file{ filepath, std::ios::trunc };
+		if (!file)
+		{
+			std::cerr << "Failed to write telemetry to " << filepath << std::endl;
+			return false;
+		}
+
+		const std::vector<const char*> gpuScopes = gpuScopeNames();
+		file << "frame,time_ms,frame_ms";
+		for (uint32_t phase = 0; phase < FRAME_PHASE_COUNT; phase++)
+			file << "," << toString(static_cast<skFramePhase>(phase)) << "_ms";
+		for (const char *scope : gpuScopes)
+			file << ",gpu_" << scope << "_ms";
+		file << "\n";
+
+		char text[64];
+		for (const FrameSample &sample : samples())
+		{
+			std::snprintf(text, sizeof(text), "%llu,%.3f,%.4f", static_cast<unsigned long long>(sample.frame), sample.timeMs, sample.frameMs);
+			file << text;
+			for (float ms : sample.phaseMs)
+			{
+				std::snprintf(text, sizeof(text), ",%.4f", ms);
+				file << text;
+			}
+			// empty cells for frames that did not read the scope back
+			for (size_t scope = 0; scope < gpuScopes.size(); scope++)
+			{
+				if (sample.gpuMs[scope] >= 0.f)
+					std::snprintf(text, sizeof(text), ",%.4f", sample.gpuMs[scope]);
+				else
+					std::snprintf(text, sizeof(text), ",");
+				file << text;
+			}
+			file << "\n";
+		}
+		return static_cast<bool>(file);
+	}
+
+	bool skTelemetry::exportJson(const std::string &filepath) const
+	{
+		std::ofstream file{ filepath, std::ios::trunc };
+		if (!file)
+		{
+			std::cerr << "Failed to write telemetry to " << filepath << std::endl;
+			return false;
+		}
+
+		// one copy of the ring, so the summary and the frames agree
+		const std::vector<FrameSample> frames = samples();
+		const Summary summary = summarize(frames);
+
+		file << "{\n  \"frames\": " << summary.frames << ",\n  \"hitches\": " << summary.hitches << ",\n  \"frame_ms\": ";
+		writeJson(file, summary.frame);
+		file << ",\n  \"phases_ms\": {";
+		for (uint32_t phase = 0; phase < FRAME_PHASE_COUNT; phase++)
+		{
+			file << (phase == 0 ? "\n" : ",\n") << "    \"" << toString(static_cast<skFramePhase>(phase)) << "\": ";
+			writeJson(file, summary.phases[phase]);
+		}
+
+		file << "\n  },\n  \"gpu_scopes_ms\": {";
+		for (size_t scope = 0; scope < summary.gpuScopes.size(); scope++)
+		{
+			file << (scope == 0 ? "\n" : ",\n") << "    \"" << summary.gpuScopes[scope].first << "\": ";
+			writeJson(file, summary.gpuScopes[scope].second);
+		}
+		file << (summary.gpuScopes.empty() ? "" : "\n  ");
+
+		// [frame, time_ms, frame_ms, phases_ms..., gpu_scopes_ms...], in the column order of the csv, null for scopes
+		//   not read back that frame
+		file << "},\n  \"samples\": [";
+		char text[64];
+		for (size_t i = 0; i < frames.size(); i++)
+		{
+			const FrameSample &sample = frames[i];
+			std::snprintf(text, sizeof(text), "[%llu, %.3f, %.4f", static_cast<unsigned long long>(sample.frame), sample.timeMs, sample.frameMs);
+			file << (i == 0 ? "\n    " : ",\n    ") << text;
+			for (float ms : sample.phaseMs)
+			{
+				std::snprintf(text, sizeof(text), ", %.4f", ms);
+				file << text;
+			}
+			for (size_t scope = 0; scope < summary.gpuScopes.size(); scope++)
+			{
+				if (sample.gpuMs[scope] >= 0.f)
+					std::snprintf(text, sizeof(text), ", %.4f", sample.gpuMs[scope]);
+				else
+					std::snprintf(text, sizeof(text), ", null");
+				file << text;
+			}
+			file << "]";
+		}
+		file << "\n  ]\n}\n";
+		return static_cast<bool>(file);
+	}
+} // namespace sk
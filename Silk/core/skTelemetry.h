@@ -0,0 +1,138 @@
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace sk
+{
+	// where a frame's CPU time goes, in the order the render loop runs them
+	enum class skFramePhase : uint32_t
+	{
+		Poll,		// window events and input
+		Update,		// loads, snapshot, camera, everything before beginFrame
+		FenceWait,	// for the frame (and its image) to be free again
+		Acquire,	// vkAcquireNextImageKHR
+		Record,		// command buffers, from beginFrame to endFrame
+		Submit,
+		Present,
+	};
+	inline constexpr uint32_t FRAME_PHASE_COUNT = 7;
+	// distinct GPU scope names the telemetry keeps columns for, later ones are dropped
+	inline constexpr uint32_t MAX_GPU_SCOPES = 8;
+	const char *toString(skFramePhase phase);
+
+	/* Per-frame CPU timings, kept in a fixed ring for percentile reports and export.
+	 *   the render thread times the phases of a frame between two beginFrame() calls, the second publishes the frame
+	 *   to the ring without locking or allocating, so it can stay on in production builds. each slot is guarded by a
+	 *   sequence number (seqlock): summaries and exports may run on any thread and skip a slot that is being rewritten
+	 *   while they copy it. statistics cover the frames still in the ring, the last capacity() ones.
+	 *   GPU scopes (skGpuProfiler) are reported the same way, as named columns next to the phases. they arrive a few
+	 *   frames late and are filed under the frame that read them back. */
+	class skTelemetry
+	{
+	public:
+		struct FrameSample
+		{
+			uint64_t frame = 0;
+			double timeMs = 0.0;	// frame start since the telemetry was created
+			float frameMs = 0.f;	// start of this frame to start of the next
+			std::array<float, FRAME_PHASE_COUNT> phaseMs{};
+			std::array<float, MAX_GPU_SCOPES> gpuMs{};	// by gpuScopeNames() index, negative when the scope was not read back
+		};
+
+		struct Distribution
+		{
+			double mean = 0.0;
+			double variance = 0.0;
+			double p50 = 0.0;
+			double p95 = 0.0;
+			double p99 = 0.0;
+			double max = 0.0;
+		};
+
+		struct Summary
+		{
+			uint32_t frames = 0;
+			Distribution frame{};
+			std::array<Distribution, FRAME_PHASE_COUNT> phases{};
+			std::vector<std::pair<std::string, Distribution>> gpuScopes{};	// over the frames that read the scope back
+			uint32_t hitches = 0;	// frames longer than HITCH_FACTOR times the median
+		};
+
+		static constexpr double HITCH_FACTOR = 2.0;
+
+		// capacity is rounded up to a power of two
+		explicit skTelemetry(uint32_t capacity = 4096);
+
+		skTelemetry(const skTelemetry&) = delete;
+		skTelemetry &operator=(const skTelemetry&) = delete;
+
+		// producer, one thread. the previous frame, if any, ends where this one begins
+		void beginFrame();
+		void addPhase(skFramePhase phase, std::chrono::steady_clock::duration duration);
+		// name must outlive the telemetry (a literal), scopes of the same name in one frame add up
+		void addGpuScope(const char *name, double ms);
+		// times the phase from construction to destruction
+		class ScopedPhase
+		{
+		public:
+			ScopedPhase(skTelemetry &telemetry, skFramePhase phase) : m_telemetry{ telemetry }, m_phase{ phase } {}
+			~ScopedPhase() { m_telemetry.addPhase(m_phase, std::chrono::steady_clock::now() - m_start); }
+			ScopedPhase(const ScopedPhase&) = delete;
+			ScopedPhase &operator=(const ScopedPhase&) = delete;
+		private:
+			skTelemetry &m_telemetry;
+			skFramePhase m_phase;
+			std::chrono::steady_clock::time_point m_start = std::chrono::steady_clock::now();
+		};
+		ScopedPhase scopedPhase(skFramePhase phase) { return ScopedPhase{ *this, phase }; }
+
+		// any thread: the frames in the ring, oldest first
+		std::vector<FrameSample> samples() const;
+		// any thread: names of the gpuMs columns, in order
+		std::vector<const char*> gpuScopeNames() const;
+		Summary summarize() const;
+		Summary summarize(const std::vector<FrameSample> &samples) const;
+
+		// one row per frame. false (and an error on stderr) when the file cannot be written
+		bool exportCsv(const std::string &filepath) const;
+		// the summary plus every frame
+		bool exportJson(const std::string &filepath) const;
+
+		uint32_t capacity() const { return m_mask + 1; }
+		uint64_t frameCount() const { return m_published.load(std::memory_order_acquire); }
+
+	private:
+		struct Slot
+		{
+			std::atomic<uint64_t> sequence{ 0 };	// 2 * frame + 2 once written, odd while being written
+			std::atomic<double> timeMs{ 0.0 };
+			std::atomic<float> frameMs{ 0.f };
+			std::array<std::atomic<float>, FRAME_PHASE_COUNT> phaseMs{};
+			std::array<std::atomic<float>, MAX_GPU_SCOPES> gpuMs{};
+		};
+
+		void publish(std::chrono::steady_clock::time_point end);
+
+		std::unique_ptr<Slot[]> m_slots;
+		uint32_t m_mask;
+		std::atomic<uint64_t> m_published{ 0 };	// frames written to the ring
+		// a name is written before the count is raised past it and never changes after
+		std::array<const char*, MAX_GPU_SCOPES> m_gpuScopeNames{};
+		std::atomic<uint32_t> m_gpuScopeCount{ 0 };
+
+		// producer only
+		std::chrono::steady_clock::time_point m_origin = std::chrono::steady_clock::now();
+		std::chrono::steady_clock::time_point m_frameStart{};
+		bool m_inFrame = false;
+		std::array<std::chrono::steady_clock::duration, FRAME_PHASE_COUNT> m_phases{};
+		std::array<double, MAX_GPU_SCOPES> m_gpuMs{};
+	};
+} // namespace sk
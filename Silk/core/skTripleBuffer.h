@@ -0,0 +1,50 @@
+#pragma once
+
+// std
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace sk
+{
+	/* Lock-free handoff of the latest value from one producer thread to one consumer thread.
+	 *   three slots: the producer owns one to write, the consumer owns one to read and the third sits in the middle
+	 *   holding the newest published value. publish() and acquire() each swap their own slot with the middle one in a
+	 *   single atomic exchange, so neither side ever waits for the other. values the consumer did not get to in time are
+	 *   overwritten, it always sees the newest one. the slots are reused, a producer can keep the capacity of whatever
+	 *   it wrote into the slot before (e.g. vectors). */
+	template <typename T>
+	class skTripleBuffer
+	{
+	public:
+		// producer: the slot to fill, owned by the producer until publish()
+		T &writeSlot() { return m_slots[m_write]; }
+		// producer: makes the write slot the newest value and takes the previous middle slot to write next
+		void publish()
+		{
+			uint8_t previous = m_middle.exchange(static_cast<uint8_t>(m_write | FRESH), std::memory_order_acq_rel);
+			m_write = previous & INDEX;
+		}
+
+		// consumer: swaps in the newest published value, false (and the read slot unchanged) when nothing new was published
+		bool acquire()
+		{
+			if ((m_middle.load(std::memory_order_relaxed) & FRESH) == 0)
+				return false;
+			uint8_t previous = m_middle.exchange(m_read, std::memory_order_acq_rel);
+			m_read = previous & INDEX;
+			return true;
+		}
+		// consumer: the value taken by the last successful acquire(), default constructed before the first
+		const T &readSlot() const { return m_slots[m_read]; }
+
+	private:
+		static constexpr uint8_t INDEX = 0x3;
+		static constexpr uint8_t FRESH = 0x4; // set in m_middle while its slot was published and not acquired yet
+
+		std::array<T, 3> m_slots{};
+		alignas(64) std::atomic<uint8_t> m_middle{ 1 };
+		alignas(64) uint8_t m_write = 0;	// producer only
+		alignas(64) uint8_t m_read = 2;		// consumer only
+	};
+} // namespace sk
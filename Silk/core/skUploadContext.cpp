@@ -0,0 +1,439 @@
+#include "skUploadContext.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace sk
+{
+	namespace
+	{
+		constexpr VkDeviceSize STAGING_ALIGNMENT = 16;
+		// where the graphics queue first touches uploaded data, the acquire and the semaphore wait both sit there
+		constexpr VkPipelineStageFlags CONSUMER_STAGES = VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+		VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+	} // namespace
+
+	skUploadContext::skUploadContext(skDevice &device, VkDeviceSize stagingSize)
+		: m_Device{ device }, m_stagingSize{ alignUp(stagingSize, STAGING_ALIGNMENT) }, m_ownerThread{ std::this_thread::get_id() }
+	{
+		QueueFamilyIndices families = m_Device.findPhysicalQueueFamilies();
+		m_graphicsFamily = families.graphicsFamily;
+		m_transferFamily = families.transferFamily;
+		m_dedicatedTransfer = families.hasDedicatedTransfer();
+
+		m_commandPool = createCommandPool(m_transferFamily);
+		if (m_dedicatedTransfer)
+			m_graphicsCommandPool = createCommandPool(m_graphicsFamily);
+		createBatches();
+
+		m_staging = std::make_unique<skBuffer>(
+			m_Device,
+			m_stagingSize,
+			1,
+			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			1,
+			skMemoryCategory::Staging
+		);
+		m_staging->map(); // stays mapped for the lifetime of the context
+	}
+
+	skUploadContext::~skUploadContext()
+	{
+		// an open batch is dropped rather than submitted, its destinations may already be gone
+		waitIdle();
+		for (auto &batch : m_batches)
+		{
+			vkDestroyFence(m_Device.device(), batch.fence, nullptr);
+			vkDestroySemaphore(m_Device.device(), batch.transferDone, nullptr);
+		}
+		vkDestroyCommandPool(m_Device.device(), m_commandPool, nullptr);
+		vkDestroyCommandPool(m_Device.device(), m_graphicsCommandPool, nullptr);
+	}
+
+	VkCommandPool skUploadContext::createCommandPool(uint32_t queueFamily)
+	{
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = queueFamily;
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+		VkCommandPool commandPool;
+		if (vkCreateCommandPool(m_Device.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS)
+			throw std::runtime_error("Failed to create upload command pool!");
+		return commandPool;
+	}
+
+	void skUploadContext::createBatches()
+	{
+		std::array<VkCommandBuffer, MAX_BATCHES + 1> commandBuffers{};
+		std::array<VkCommandBuffer, MAX_BATCHES + 1> graphicsCommandBuffers{};
+
+		VkCommandBufferAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+		allocInfo.commandPool = m_commandPool;
+		allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+
+		if (vkAllocateCommandBuffers(m_Device.device(), &allocInfo, commandBuffers.data()) != VK_SUCCESS)
+			throw std::runtime_error("Failed to allocate upload command buffers!");
+		if (m_dedicatedTransfer)
+		{
+			allocInfo.commandPool = m_graphicsCommandPool;
+			if (vkAllocateCommandBuffers(m_Device.device(), &allocInfo, graphicsCommandBuffers.data()) != VK_SUCCESS)
+				throw std::runtime_error("Failed to allocate upload command buffers!");
+		}
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VkSemaphoreCreateInfo semaphoreInfo{};
+		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+
+		for (size_t i = 0; i < m_batches.size(); i++)
+		{
+			Batch &batch = m_batches[i];
+			batch.commandBuffer = commandBuffers[i];
+			batch.graphicsCommandBuffer = m_dedicatedTransfer ? graphicsCommandBuffers[i] : commandBuffers[i];
+			if (vkCreateFence(m_Device.device(), &fenceInfo, nullptr, &batch.fence) != VK_SUCCESS)
+				throw std::runtime_error("Failed to create upload fence!");
+			if (m_dedicatedTransfer && vkCreateSemaphore(m_Device.device(), &semaphoreInfo, nullptr, &batch.transferDone) != VK_SUCCESS)
+				throw std::runtime_error("Failed to create upload semaphore!");
+		}
+	}
+
+	skUploadContext::Ticket skUploadContext::uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size)
+	{
+		std::unique_lock<std::mutex> lock{ m_mutex };
+		if (size == 0)
+			return m_completedTicket.load(std::memory_order_relaxed);
+
+		// bounded chunks keep a single upload from needing the whole ring, they may land in consecutive batches
+		const VkDeviceSize maxChunk = m_stagingSize / 4;
+		const auto *bytes = static_cast<const unsigned char*>(data);
+		Ticket ticket = 0;
+		for (VkDeviceSize done = 0; done < size;)
+		{
+			VkDeviceSize chunk = std::min(size - done, maxChunk);
+			VkDeviceSize stagingOffset = 0;
+			Batch &batch = reserve(lock, chunk, stagingOffset);
+
+			std::memcpy(static_cast<unsigned char*>(m_staging->getMappedMemory()) + stagingOffset, bytes + done, chunk);
+
+			VkBufferCopy copyRegion{};
+			copyRegion.srcOffset = stagingOffset;
+			copyRegion.dstOffset = dstOffset + done;
+			copyRegion.size = chunk;
+			vkCmdCopyBuffer(batch.commandBuffer, m_staging->getBuffer(), dstBuffer, 1, &copyRegion);
+			if (m_dedicatedTransfer)
+				transferOwnership(batch, dstBuffer, copyRegion.dstOffset, chunk);
+
+			ticket = batch.ticket;
+			done += chunk;
+			m_stats.copies++;
+			m_stats.bytes += chunk;
+		}
+		return ticket;
+	}
+
+	skUploadContext::Ticket skUploadContext::uploadImage(VkImage image, uint32_t width, uint32_t height, uint32_t layerCount, const void *data, VkDeviceSize size)
+	{
+		// not split like uploadBuffer, a copy region needs the whole image contiguous in the ring
+		if (size > m_stagingSize / 4)
+			throw std::runtime_error("Image too large for the staging ring!");
+
+		std::unique_lock<std::mutex> lock{ m_mutex };
+		VkDeviceSize stagingOffset = 0;
+		Batch &batch = reserve(lock, size, stagingOffset);
+		std::memcpy(static_cast<unsigned char*>(m_staging->getMappedMemory()) + stagingOffset, data, size);
+
+		VkImageMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.image = image;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.levelCount = 1;
+		barrier.subresourceRange.layerCount = layerCount;
+
+		barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+			0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		VkBufferImageCopy region{};
+		region.bufferOffset = stagingOffset;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.layerCount = layerCount;
+		region.imageExtent = { width, height, 1 };
+		vkCmdCopyBufferToImage(batch.commandBuffer, m_staging->getBuffer(), image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+
+		// the transition to the shader layout doubles as the ownership handoff when there is one
+		barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+		barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		if (m_dedicatedTransfer)
+		{
+			barrier.srcQueueFamilyIndex = m_transferFamily;
+			barrier.dstQueueFamilyIndex = m_graphicsFamily;
+			batch.imageTransfers.push_back(barrier);
+		}
+		else
+			vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+				0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+		m_stats.copies++;
+		m_stats.bytes += size;
+		return batch.ticket;
+	}
+
+	skUploadContext::Ticket skUploadContext::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy *regions)
+	{
+		std::unique_lock<std::mutex> lock{ m_mutex };
+		VkDeviceSize stagingOffset = 0;
+		Batch &batch = reserve(lock, 0, stagingOffset);
+		vkCmdCopyBuffer(batch.graphicsCommandBuffer, srcBuffer, dstBuffer, regionCount, regions);
+		m_stats.copies++;
+		return batch.ticket;
+	}
+
+	void skUploadContext::transferOwnership(Batch &batch, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size)
+	{
+		// arena allocations are mostly carved front to back, so consecutive uploads tend to merge into one barrier
+		if (!batch.bufferTransfers.empty())
+		{
+			VkBufferMemoryBarrier &last = batch.bufferTransfers.back();
+			if (last.buffer == buffer && last.offset + last.size == offset)
+			{
+				last.size += size;
+				return;
+			}
+		}
+
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+		barrier.srcQueueFamilyIndex = m_transferFamily;
+		barrier.dstQueueFamilyIndex = m_graphicsFamily;
+		barrier.buffer = buffer;
+		barrier.offset = offset;
+		barrier.size = size;
+		batch.bufferTransfers.push_back(barrier);
+	}
+
+	skUploadContext::Ticket skUploadContext::submit()
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		return submitLocked();
+	}
+
+	void skUploadContext::retire()
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		while (retireOldest(false)) {}
+	}
+
+	void skUploadContext::wait(Ticket ticket)
+	{
+		assert(std::this_thread::get_id() == m_ownerThread && "Only the thread owning the upload context may wait on it");
+
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		if (m_openBatch != NO_BATCH && m_batches[m_openBatch].ticket <= ticket)
+			submitLocked();
+		while (!isComplete(ticket) && retireOldest(true)) {}
+	}
+
+	skUploadContext::Stats skUploadContext::stats() const
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		return m_stats;
+	}
+
+	void skUploadContext::waitIdle()
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		while (retireOldest(true)) {}
+	}
+
+	skUploadContext::Batch &skUploadContext::reserve(std::unique_lock<std::mutex> &lock, VkDeviceSize size, VkDeviceSize &stagingOffset)
+	{
+		// the batch is settled before the staging space and both are taken without releasing the lock in between, so
+		//   staging space always belongs to the batch whose retirement frees it
+		VkDeviceSize aligned = alignUp(size, STAGING_ALIGNMENT);
+		if (aligned > m_stagingSize)
+			throw std::runtime_error("Upload larger than the staging ring!"); // waiting would never free enough space
+		for (;;)
+		{
+			if (m_openBatch == NO_BATCH)
+			{
+				auto free = std::find_if(m_batches.begin(), m_batches.end(), [](const Batch &batch) { return !batch.inFlight; });
+				if (free != m_batches.end())
+				{
+					VkCommandBufferBeginInfo beginInfo{};
+					beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+					beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+					vkBeginCommandBuffer(free->commandBuffer, &beginInfo);
+					if (m_dedicatedTransfer)
+						vkBeginCommandBuffer(free->graphicsCommandBuffer, &beginInfo);
+
+					free->ticket = m_nextTicket++;
+					free->stagingBytes = 0;
+					m_openBatch = static_cast<uint32_t>(free - m_batches.begin());
+				}
+			}
+
+			VkDeviceSize wasted = 0;
+			if (m_openBatch != NO_BATCH && (aligned == 0 || allocateStaging(aligned, stagingOffset, wasted)))
+			{
+				Batch &batch = m_batches[m_openBatch];
+				batch.stagingBytes += aligned + wasted;
+				return batch;
+			}
+
+			// out of batches or staging space: the owner frees some itself, everyone else waits for it to retire()
+			m_stats.stalls++;
+			if (std::this_thread::get_id() == m_ownerThread)
+			{
+				submitLocked();
+				retireOldest(true);
+			}
+			else
+			{
+				m_waiters++;
+				m_spaceAvailable.wait(lock);
+				m_waiters--;
+			}
+		}
+	}
+
+	bool skUploadContext::allocateStaging(VkDeviceSize size, VkDeviceSize &offset, VkDeviceSize &wasted)
+	{
+		if (m_used == 0)
+			m_head = m_tail = 0;
+
+		wasted = 0;
+		if (m_head >= m_tail && m_used < m_stagingSize)
+		{
+			// free space is [head, end) plus [0, tail)
+			if (m_head + size <= m_stagingSize)
+				offset = m_head;
+			else if (size <= m_tail)
+			{
+				wasted = m_stagingSize - m_head; // skip the tail end, the copy needs contiguous bytes
+				offset = 0;
+			}
+			else
+				return false;
+		}
+		else if (m_head < m_tail && m_head + size <= m_tail)
+			offset = m_head;
+		else
+			return false;
+
+		m_head = offset + size;
+		m_used += size + wasted;
+		return true;
+	}
+
+	skUploadContext::Ticket skUploadContext::submitLocked()
+	{
+		if (m_openBatch == NO_BATCH)
+			return m_nextTicket - 1;
+
+		assert(std::this_thread::get_id() == m_ownerThread && "Only the thread owning the upload context may submit");
+
+		Batch &batch = m_batches[m_openBatch];
+		m_openBatch = NO_BATCH;
+
+		if (m_dedicatedTransfer)
+		{
+			// release on the transfer queue. the matching acquire must repeat every field, only the stages and accesses
+			//   of the other queue are ignored
+			vkCmdPipelineBarrier(batch.commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+				0, nullptr,
+				static_cast<uint32_t>(batch.bufferTransfers.size()), batch.bufferTransfers.data(),
+				static_cast<uint32_t>(batch.imageTransfers.size()), batch.imageTransfers.data());
+			vkEndCommandBuffer(batch.commandBuffer);
+
+			VkSubmitInfo transferSubmit{};
+			transferSubmit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+			transferSubmit.commandBufferCount = 1;
+			transferSubmit.pCommandBuffers = &batch.commandBuffer;
+			transferSubmit.signalSemaphoreCount = 1;
+			transferSubmit.pSignalSemaphores = &batch.transferDone;
+			if (vkQueueSubmit(m_Device.transferQueue(), 1, &transferSubmit, VK_NULL_HANDLE) != VK_SUCCESS)
+				throw std::runtime_error("Failed to submit upload batch!");
+
+			// acquire on the graphics queue, after the copies recorded straight into it (copyBuffer)
+			vkCmdPipelineBarrier(batch.graphicsCommandBuffer, CONSUMER_STAGES, CONSUMER_STAGES, 0,
+				0, nullptr,
+				static_cast<uint32_t>(batch.bufferTransfers.size()), batch.bufferTransfers.data(),
+				static_cast<uint32_t>(batch.imageTransfers.size()), batch.imageTransfers.data());
+		}
+
+		// make the copies visible to vertex input of everything submitted after this batch
+		VkMemoryBarrier barrier{};
+		barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+		barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+		vkCmdPipelineBarrier(batch.graphicsCommandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+			0, 1, &barrier, 0, nullptr, 0, nullptr);
+		vkEndCommandBuffer(batch.graphicsCommandBuffer);
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &batch.graphicsCommandBuffer;
+		if (m_dedicatedTransfer)
+		{
+			submitInfo.waitSemaphoreCount = 1;
+			submitInfo.pWaitSemaphores = &batch.transferDone;
+			submitInfo.pWaitDstStageMask = &CONSUMER_STAGES;
+		}
+		if (vkQueueSubmit(m_Device.graphicsQueue(), 1, &submitInfo, batch.fence) != VK_SUCCESS)
+			throw std::runtime_error("Failed to submit upload batch!");
+
+		batch.inFlight = true;
+		m_stats.submits++;
+		return batch.ticket;
+	}
+
+	bool skUploadContext::retireOldest(bool block)
+	{
+		// batches finish in submission order on the one queue, so the oldest is the only candidate
+		Batch *oldest = nullptr;
+		for (auto &batch : m_batches)
+		{
+			if (batch.inFlight && (oldest == nullptr || batch.ticket < oldest->ticket))
+				oldest = &batch;
+		}
+		if (oldest == nullptr)
+			return false;
+
+		if (block)
+			vkWaitForFences(m_Device.device(), 1, &oldest->fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+		else if (vkGetFenceStatus(m_Device.device(), oldest->fence) != VK_SUCCESS)
+			return false;
+
+		vkResetFences(m_Device.device(), 1, &oldest->fence);
+		vkResetCommandBuffer(oldest->commandBuffer, 0);
+		if (m_dedicatedTransfer)
+			vkResetCommandBuffer(oldest->graphicsCommandBuffer, 0);
+		oldest->bufferTransfers.clear();
+		oldest->imageTransfers.clear();
+		oldest->inFlight = false;
+
+		m_used -= oldest->stagingBytes;
+		m_tail = (m_tail + oldest->stagingBytes) % m_stagingSize;
+		m_completedTicket.store(oldest->ticket, std::memory_order_release);
+		m_spaceAvailable.notify_all();
+		return true;
+	}
+} // namespace sk
@@ -0,0 +1,131 @@
+#pragma once
+
+#include "core/skDevice.h"
+#include "model/skBuffer.h"
+
+// std
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sk
+{
+	/* Batched, non-blocking uploads through a persistently mapped staging ring.
+	 *   copies are recorded into the open batch's command buffer, submit() sends the batch off with its own fence and
+	 *   returns immediately, so any number of uploads cost one submit. staging space is handed back once that fence
+	 *   signals, which retire() polls, and callers wait on the tickets of the uploads they need rather than on a queue.
+	 *   with a dedicated transfer family the copies run on the transfer queue, next to rendering instead of between its
+	 *   frames. each written range is released to the graphics family at the end of the batch and acquired by a short
+	 *   graphics submission waiting on the batch's semaphore, which also carries the fence. without one (single family
+	 *   devices such as lavapipe) everything goes to the graphics queue and a memory barrier replaces the handoff.
+	 *   either way later graphics submissions may draw from the uploaded ranges without further synchronization.
+	 *   uploadBuffer may be called from any thread (e.g. model loader workers). submit, retire and wait touch the queue
+	 *   and belong to the thread that created the context, which also renders. */
+	class skUploadContext
+	{
+	public:
+		// identifies a batch, increases with every submit. a ticket is complete once its batch finished executing
+		using Ticket = uint64_t;
+
+		static constexpr VkDeviceSize DEFAULT_STAGING_SIZE = 32 * 1024 * 1024;
+		static constexpr uint32_t MAX_BATCHES = 4; // submitted and not yet retired
+
+		struct Stats
+		{
+			uint64_t submits = 0;
+			uint64_t copies = 0;		// copy commands recorded, chunks of a split upload count separately
+			uint64_t bytes = 0;			// staged through the ring
+			uint64_t stalls = 0;		// reservations that had to wait for a batch to retire
+		};
+
+		explicit skUploadContext(skDevice &device, VkDeviceSize stagingSize = DEFAULT_STAGING_SIZE);
+		~skUploadContext();
+
+		skUploadContext(const skUploadContext&) = delete;
+		skUploadContext &operator=(const skUploadContext&) = delete;
+
+		// copies size bytes from data to dstBuffer at dstOffset and returns the ticket of the batch that carries the copy.
+		//   uploads larger than a quarter of the ring are split. when the ring is full other threads block until the owner
+		//   retires a batch, the owner itself submits and waits
+		Ticket uploadBuffer(VkBuffer dstBuffer, VkDeviceSize dstOffset, const void *data, VkDeviceSize size);
+		// fills mip 0 of a color image and leaves it in SHADER_READ_ONLY_OPTIMAL for fragment shaders. the image's previous
+		//   contents are discarded, throws if size exceeds a quarter of the ring
+		Ticket uploadImage(VkImage image, uint32_t width, uint32_t height, uint32_t layerCount, const void *data, VkDeviceSize size);
+		// device to device copy, e.g. to move allocations around. both buffers must stay alive until the ticket completes.
+		//   runs on the graphics queue, which owns both
+		Ticket copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, uint32_t regionCount, const VkBufferCopy *regions);
+
+		// submits the open batch (if it recorded anything) and returns its ticket
+		Ticket submit();
+		// recycles the staging space and command buffers of finished batches, never blocks
+		void retire();
+		bool isComplete(Ticket ticket) const { return ticket <= m_completedTicket.load(std::memory_order_acquire); }
+		// submits the ticket's batch if it is still open, then blocks until it completed
+		void wait(Ticket ticket);
+		// blocks until every submitted batch completed, the open one stays open
+		void waitIdle();
+
+		// a thread is blocked on ring space or batches, only submit() and retire() let it continue
+		bool stalled() const { return m_waiters.load(std::memory_order_relaxed) > 0; }
+		Stats stats() const;
+		VkDeviceSize stagingSize() const { return m_stagingSize; }
+		bool usesTransferQueue() const { return m_dedicatedTransfer; }
+
+	private:
+		struct Batch
+		{
+			VkCommandBuffer commandBuffer = VK_NULL_HANDLE;			// staging copies, on the transfer family
+			VkCommandBuffer graphicsCommandBuffer = VK_NULL_HANDLE;	// acquires and device copies, same as commandBuffer without a dedicated family
+			VkSemaphore transferDone = VK_NULL_HANDLE;				// dedicated family only
+			VkFence fence = VK_NULL_HANDLE;
+			Ticket ticket = 0;
+			VkDeviceSize stagingBytes = 0;	// ring space to hand back on retirement, wrap padding included
+			std::vector<VkBufferMemoryBarrier> bufferTransfers{};	// ownership handoffs, recorded as release and as acquire
+			std::vector<VkImageMemoryBarrier> imageTransfers{};
+			bool inFlight = false;
+		};
+
+		static constexpr uint32_t NO_BATCH = ~0u;
+
+		VkCommandPool createCommandPool(uint32_t queueFamily);
+		void createBatches();
+		// queues the handoff of a written range to the graphics family, merging it with the previous one when adjacent
+		void transferOwnership(Batch &batch, VkBuffer buffer, VkDeviceSize offset, VkDeviceSize size);
+		// the open batch (opened on demand) plus size bytes of staging space for it, waits while either is exhausted and
+		//   throws if size exceeds the whole ring. the remaining functions expect m_mutex held as well
+		Batch &reserve(std::unique_lock<std::mutex> &lock, VkDeviceSize size, VkDeviceSize &stagingOffset);
+		bool allocateStaging(VkDeviceSize size, VkDeviceSize &offset, VkDeviceSize &wasted);
+		Ticket submitLocked();
+		// false if nothing was in flight or (without block) the oldest batch is still executing
+		bool retireOldest(bool block);
+
+		skDevice &m_Device;
+		uint32_t m_graphicsFamily;
+		uint32_t m_transferFamily;
+		bool m_dedicatedTransfer;
+		VkCommandPool m_commandPool = VK_NULL_HANDLE;			// on the transfer family
+		VkCommandPool m_graphicsCommandPool = VK_NULL_HANDLE;	// dedicated family only
+
+		VkDeviceSize m_stagingSize;
+		std::unique_ptr<skBuffer> m_staging;
+		VkDeviceSize m_head = 0;		// next free byte
+		VkDeviceSize m_tail = 0;		// oldest byte still in use
+		VkDeviceSize m_used = 0;		// head - tail modulo the ring, disambiguates head == tail
+
+		std::array<Batch, MAX_BATCHES + 1> m_batches{}; // + 1: the open one
+		uint32_t m_openBatch = NO_BATCH;
+		Ticket m_nextTicket = 1;
+		std::atomic<Ticket> m_completedTicket{ 0 };
+
+		std::thread::id m_ownerThread;	// the constructing thread, the only one allowed to touch the queue
+		std::atomic<uint32_t> m_waiters{ 0 };
+		Stats m_stats{};
+		mutable std::mutex m_mutex;
+		std::condition_variable m_spaceAvailable;
+	};
+} // namespace sk
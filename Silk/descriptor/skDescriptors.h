@@ -1,6 +1,6 @@
 #pragma once
 
-#include "core\skDevice.h"
+#include "core/skDevice.h"
 
 // std
 #include <memory>
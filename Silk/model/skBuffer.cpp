@@ -8,6 +8,7 @@
 #include "skBuffer.h"
 
  // std
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 
@@ -35,7 +36,8 @@ namespace sk {
         uint32_t instanceCount,
         VkBufferUsageFlags usageFlags,
         VkMemoryPropertyFlags memoryPropertyFlags,
-        VkDeviceSize minOffsetAlignment)
+        VkDeviceSize minOffsetAlignment,
+        skMemoryCategory category)
         : m_Device{ device },
         instanceSize{ instanceSize },
         instanceCount{ instanceCount },
@@ -43,18 +45,45 @@ namespace sk {
         memoryPropertyFlags{ memoryPropertyFlags } {
         alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
         bufferSize = alignmentSize * instanceCount;
-        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation, category);
     }
 
     skBuffer::~skBuffer() {
         unmap();
         vkDestroyBuffer(m_Device.device(), buffer, nullptr);
-        vkFreeMemory(m_Device.device(), memory, nullptr);
+        m_Device.freeMemory(allocation);
+    }
+
+    /**
+     * Translates a range of this buffer into a range of the memory block it was suballocated from
+     *
+     * @note Widened to nonCoherentAtomSize, which the allocator aligns host visible allocations to, so the
+     * range never reaches into a neighbouring allocation
+     *
+     * @param size Size of the range. VK_WHOLE_SIZE covers the rest of the buffer
+     * @param offset Byte offset from beginning
+     *
+     * @return VkMappedMemoryRange for flush and invalidate calls
+     */
+    VkMappedMemoryRange skBuffer::getMappedRange(VkDeviceSize size, VkDeviceSize offset) const {
+        VkDeviceSize atomSize = m_Device.memoryAtomSize();
+        VkDeviceSize end = size == VK_WHOLE_SIZE ? allocation.size : offset + size;
+        end = std::min((end + atomSize - 1) / atomSize * atomSize, allocation.size);
+        offset = offset / atomSize * atomSize;
+
+        VkMappedMemoryRange mappedRange = {};
+        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        mappedRange.memory = allocation.memory;
+        mappedRange.offset = allocation.offset + offset;
+        mappedRange.size = end - offset;
+        return mappedRange;
     }
 
     /**
      * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
      *
+     * @note Host visible memory stays mapped for its lifetime, this only hands out the pointer
+     *
      * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
      * buffer range.
      * @param offset (Optional) Byte offset from beginning
@@ -62,20 +91,21 @@ namespace sk {
      * @return VkResult of the buffer mapping call
      */
     VkResult skBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-        assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(m_Device.device(), memory, offset, size, 0, &mapped);
+        assert(buffer && allocation.memory && "Called map on buffer before create");
+        if (allocation.mapped == nullptr) {
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        mapped = static_cast<char*>(allocation.mapped) + offset;
+        return VK_SUCCESS;
     }
 
     /**
      * Unmap a mapped memory range
      *
-     * @note Does not return a result as vkUnmapMemory can't fail
+     * @note The block stays mapped for the other allocations in it, only the pointer is dropped
      */
     void skBuffer::unmap() {
-        if (mapped) {
-            vkUnmapMemory(m_Device.device(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
     }
 
     /**
@@ -112,11 +142,7 @@ namespace sk {
      * @return VkResult of the flush call
      */
     VkResult skBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        VkMappedMemoryRange mappedRange = getMappedRange(size, offset);
         return vkFlushMappedMemoryRanges(m_Device.device(), 1, &mappedRange);
     }
 
@@ -132,11 +158,7 @@ namespace sk {
      * @return VkResult of the invalidate call
      */
     VkResult skBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
+        VkMappedMemoryRange mappedRange = getMappedRange(size, offset);
         return vkInvalidateMappedMemoryRanges(m_Device.device(), 1, &mappedRange);
     }
 
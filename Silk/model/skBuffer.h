@@ -12,7 +12,8 @@ namespace sk {
 			uint32_t instanceCount,
 			VkBufferUsageFlags usageFlags,
 			VkMemoryPropertyFlags memoryPropertyFlags,
-			VkDeviceSize minOffsetAlignment = 1);
+			VkDeviceSize minOffsetAlignment = 1,
+			skMemoryCategory category = skMemoryCategory::Other);
 		~skBuffer();
 
 		skBuffer(const skBuffer&) = delete;
@@ -42,11 +43,12 @@ namespace sk {
 
 	private:
 		static VkDeviceSize getAlignment(VkDeviceSize instanceSize, VkDeviceSize minOffsetAlignment);
+		VkMappedMemoryRange getMappedRange(VkDeviceSize size, VkDeviceSize offset) const;
 
 		skDevice& m_Device;
 		void* mapped = nullptr;
 		VkBuffer buffer = VK_NULL_HANDLE;
-		VkDeviceMemory memory = VK_NULL_HANDLE;
+		skMemoryAllocation allocation{};
 
 		VkDeviceSize bufferSize;
 		uint32_t instanceCount;
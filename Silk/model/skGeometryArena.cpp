@@ -0,0 +1,386 @@
+#include "skGeometryArena.h"
+#include "skUtils.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <iterator>
+
+namespace sk
+{
+	skGeometryArena::skGeometryArena(skDevice &device, skUploadContext &uploader) : m_Device{ device }, m_uploader{ uploader } {}
+
+	skGeometryArena::~skGeometryArena()
+	{
+		// submitted copies may still target the blocks
+		m_uploader.waitIdle();
+	}
+
+	skGeometryArena::Handle skGeometryArena::allocateVertices(uint32_t stride, uint32_t count, const void *data)
+	{
+		return allocate(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, stride, count, data);
+	}
+
+	skGeometryArena::Handle skGeometryArena::allocateIndices(VkIndexType indexType, uint32_t count, const void *data)
+	{
+		return allocate(VK_BUFFER_USAGE_INDEX_BUFFER_BIT, indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t), count, data);
+	}
+
+	skGeometryArena::Handle skGeometryArena::allocateShared(const void *data, uint32_t size)
+	{
+		uint64_t key = hashBytes(data, size, size);
+		Handle handle;
+		Allocation allocation;
+		{
+			std::lock_guard<std::shared_mutex> lock{ m_mutex };
+			// the hash only narrows the search, contents that collide get allocations of their own
+			auto [first, last] = m_shared.equal_range(key);
+			for (auto it = first; it != last; ++it)
+			{
+				const SharedAllocation &shared = it->second;
+				if (shared.bytes.size() == size && std::memcmp(shared.bytes.data(), data, size) == 0)
+					return shared.handle; // possibly still uploading, the caller's isResident covers it
+			}
+
+			handle = reserve(VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, size, 1, true);
+			allocation = m_allocations[handle].allocation;
+			const auto *bytes = static_cast<const unsigned char*>(data);
+			m_shared.emplace(key, SharedAllocation{ handle, std::vector<unsigned char>(bytes, bytes + size) });
+		}
+		upload(handle, allocation, data);
+		return handle;
+	}
+
+	skGeometryArena::Handle skGeometryArena::allocate(VkBufferUsageFlags usage, uint32_t elementSize, uint32_t count, const void *data)
+	{
+		Handle handle;
+		Allocation allocation;
+		{
+			std::lock_guard<std::shared_mutex> lock{ m_mutex };
+			handle = reserve(usage, elementSize, count, data != nullptr);
+			allocation = m_allocations[handle].allocation;
+		}
+		if (data)
+			upload(handle, allocation, data);
+		return handle;
+	}
+
+	skGeometryArena::Handle skGeometryArena::reserve(VkBufferUsageFlags usage, uint32_t elementSize, uint32_t count, bool pendingUpload)
+	{
+		assert(count > 0 && elementSize > 0 && "Cannot allocate an empty range");
+
+		uint32_t poolIndex = poolFor(usage, elementSize);
+		Pool &pool = m_pools[poolIndex];
+
+		uint32_t blockIndex = 0, offset = 0;
+		for (; blockIndex < pool.blocks.size(); blockIndex++)
+		{
+			if (pool.blocks[blockIndex].buffer && allocateFromBlock(pool.blocks[blockIndex], count, offset))
+				break;
+		}
+		if (blockIndex == pool.blocks.size())
+		{
+			blockIndex = createBlock(pool, count);
+			allocateFromBlock(pool.blocks[blockIndex], count, offset);
+		}
+
+		Handle handle;
+		if (!m_freeHandles.empty())
+		{
+			handle = m_freeHandles.back();
+			m_freeHandles.pop_back();
+		}
+		else
+		{
+			handle = static_cast<Handle>(m_allocations.size());
+			m_allocations.emplace_back();
+		}
+
+		Record &record = m_allocations[handle];
+		record.allocation = Allocation{ pool.blocks[blockIndex].buffer->getBuffer(), offset, count, elementSize };
+		record.pool = poolIndex;
+		record.block = blockIndex;
+		record.uploadTicket = pendingUpload ? PENDING_UPLOAD : 0;
+		record.live = true;
+		return handle;
+	}
+
+	void skGeometryArena::free(Handle handle)
+	{
+		if (handle == INVALID_HANDLE)
+			return;
+		std::lock_guard<std::shared_mutex> lock{ m_mutex };
+		Record &record = m_allocations[handle];
+		assert(record.live && !record.freed && "Geometry arena allocation freed twice");
+		record.freed = true;
+		if (m_deferredFrees.size() <= m_frameIndex)
+			m_deferredFrees.resize(m_frameIndex + 1);
+		m_deferredFrees[m_frameIndex].push_back(handle);
+	}
+
+	void skGeometryArena::beginFrame(uint32_t frameIndex)
+	{
+		std::lock_guard<std::shared_mutex> lock{ m_mutex };
+		m_frameIndex = frameIndex;
+		if (m_deferredFrees.size() <= frameIndex)
+			m_deferredFrees.resize(frameIndex + 1);
+
+		// a range whose upload has not finished stays queued, the copy could otherwise land on its next owner
+		std::erase_if(m_deferredFrees[frameIndex], [this](Handle handle)
+			{
+				if (!m_uploader.isComplete(m_allocations[handle].uploadTicket))
+					return false;
+				release(handle);
+				return true;
+			});
+
+		if (m_trimPending)
+		{
+			releaseEmptyBlocks();
+			m_trimPending = hasDeferredFrees();
+		}
+	}
+
+	VkDeviceSize skGeometryArena::trim()
+	{
+		std::lock_guard<std::shared_mutex> lock{ m_mutex };
+		m_trimPending = hasDeferredFrees();
+		return releaseEmptyBlocks();
+	}
+
+	void skGeometryArena::release(Handle handle)
+	{
+		Record &record = m_allocations[handle];
+		assert(record.live && record.freed && "Only queued frees are released");
+
+		Block &block = m_pools[record.pool].blocks[record.block];
+		uint32_t offset = record.allocation.offset, count = record.allocation.count;
+		block.used -= count;
+
+		// merge with the free neighbours on both sides
+		auto next = block.freeRanges.lower_bound(offset);
+		if (next != block.freeRanges.end() && offset + count == next->first)
+		{
+			count += next->second;
+			next = block.freeRanges.erase(next);
+		}
+		if (next != block.freeRanges.begin())
+		{
+			auto previous = std::prev(next);
+			if (previous->first + previous->second == offset)
+			{
+				previous->second += count;
+				count = 0;
+			}
+		}
+		if (count > 0)
+			block.freeRanges.emplace(offset, count);
+
+		record = Record{};
+		m_freeHandles.push_back(handle);
+	}
+
+	void skGeometryArena::releaseDeferred()
+	{
+		for (std::vector<Handle> &frees : m_deferredFrees)
+		{
+			for (Handle handle : frees)
+				release(handle);
+			frees.clear();
+		}
+		m_trimPending = false;
+	}
+
+	bool skGeometryArena::hasDeferredFrees() const
+	{
+		return std::any_of(m_deferredFrees.begin(), m_deferredFrees.end(), [](const std::vector<Handle> &frees) { return !frees.empty(); });
+	}
+
+	VkDeviceSize skGeometryArena::releaseEmptyBlocks()
+	{
+		// nothing in flight can refer to an empty block: its last ranges came back only once their frames retired
+		VkDeviceSize released = 0;
+		for (Pool &pool : m_pools)
+		{
+			for (Block &block : pool.blocks)
+			{
+				if (!block.buffer || block.used > 0)
+					continue;
+				released += static_cast<VkDeviceSize>(block.capacity) * pool.elementSize;
+				block = Block{}; // the slot is reused by the next createBlock
+			}
+		}
+		return released;
+	}
+
+	skGeometryArena::Allocation skGeometryArena::allocation(Handle handle) const
+	{
+		// shared: model loaders read theirs while the render thread updates the placements of resident models
+		std::shared_lock<std::shared_mutex> lock{ m_mutex };
+		return m_allocations[handle].allocation;
+	}
+
+	bool skGeometryArena::isResident(Handle handle) const
+	{
+		if (handle == INVALID_HANDLE)
+			return true;
+		std::shared_lock<std::shared_mutex> lock{ m_mutex };
+		return m_uploader.isComplete(m_allocations[handle].uploadTicket);
+	}
+
+	void skGeometryArena::compact()
+	{
+		std::lock_guard<std::shared_mutex> lock{ m_mutex };
+		// the device is idle, no frame can read the queued ranges anymore
+		releaseDeferred();
+		releaseEmptyBlocks();
+
+		bool moved = false;
+		for (uint32_t poolIndex = 0; poolIndex < m_pools.size(); poolIndex++)
+		{
+			Pool &pool = m_pools[poolIndex];
+			for (uint32_t blockIndex = 0; blockIndex < pool.blocks.size(); blockIndex++)
+			{
+				Block &block = pool.blocks[blockIndex];
+				if (!block.buffer || block.used == block.capacity)
+					continue;
+
+				// live allocations of this block in offset order
+				std::vector<Record*> records{};
+				for (auto &record : m_allocations)
+				{
+					if (record.live && record.pool == poolIndex && record.block == blockIndex)
+						records.push_back(&record);
+				}
+				std::sort(records.begin(), records.end(), [](const Record *a, const Record *b) { return a->allocation.offset < b->allocation.offset; });
+
+				// vkCmdCopyBuffer forbids overlapping source and destination ranges, so the block is rewritten into a fresh
+				//   buffer rather than shifted in place. sized to what is live, slack would only keep the memory taken
+				auto compacted = std::make_unique<skBuffer>(
+					m_Device,
+					pool.elementSize,
+					block.used,
+					pool.usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+					VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+					1,
+					skMemoryCategory::Geometry
+				);
+
+				std::vector<VkBufferCopy> regions{};
+				uint32_t cursor = 0;
+				for (Record *record : records)
+				{
+					Allocation &allocation = record->allocation;
+					regions.push_back({ allocation.byteOffset(), static_cast<VkDeviceSize>(cursor) * pool.elementSize,
+						static_cast<VkDeviceSize>(allocation.count) * pool.elementSize });
+					allocation.buffer = compacted->getBuffer();
+					allocation.offset = cursor;
+					cursor += allocation.count;
+				}
+
+				// the old buffer is released right below, so this one upload is waited for
+				m_uploader.wait(m_uploader.copyBuffer(block.buffer->getBuffer(), compacted->getBuffer(), static_cast<uint32_t>(regions.size()), regions.data()));
+
+				block.buffer = std::move(compacted);
+				block.capacity = block.used;
+				block.freeRanges.clear();
+				moved = true;
+			}
+		}
+		if (moved)
+			m_generation.fetch_add(1, std::memory_order_release);
+	}
+
+	skGeometryArena::Stats skGeometryArena::stats() const
+	{
+		std::lock_guard<std::shared_mutex> lock{ m_mutex };
+		Stats stats{};
+		for (const auto &pool : m_pools)
+		{
+			for (const auto &block : pool.blocks)
+			{
+				if (!block.buffer) continue;
+				stats.blocks++;
+				stats.freeRanges += static_cast<uint32_t>(block.freeRanges.size());
+				stats.capacity += static_cast<VkDeviceSize>(block.capacity) * pool.elementSize;
+				stats.used += static_cast<VkDeviceSize>(block.used) * pool.elementSize;
+			}
+		}
+		stats.allocations = static_cast<uint32_t>(m_allocations.size() - m_freeHandles.size());
+		return stats;
+	}
+
+	uint32_t skGeometryArena::poolFor(VkBufferUsageFlags usage, uint32_t elementSize)
+	{
+		for (uint32_t i = 0; i < m_pools.size(); i++)
+		{
+			if (m_pools[i].usage == usage && m_pools[i].elementSize == elementSize)
+				return i;
+		}
+		Pool pool{};
+		pool.usage = usage;
+		pool.elementSize = elementSize;
+		m_pools.push_back(std::move(pool));
+		return static_cast<uint32_t>(m_pools.size() - 1);
+	}
+
+	uint32_t skGeometryArena::createBlock(Pool &pool, uint32_t minCount)
+	{
+		VkDeviceSize size = std::max(pool.nextBlockSize, static_cast<VkDeviceSize>(minCount) * pool.elementSize);
+		pool.nextBlockSize = std::min(pool.nextBlockSize * 2, MAX_BLOCK_SIZE);
+
+		Block block{};
+		block.capacity = static_cast<uint32_t>(std::min<VkDeviceSize>(size / pool.elementSize, UINT32_MAX));
+		// transfer source as well, compact() copies out of it
+		block.buffer = std::make_unique<skBuffer>(
+			m_Device,
+			pool.elementSize,
+			block.capacity,
+			pool.usage | VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			1,
+			skMemoryCategory::Geometry
+		);
+		block.freeRanges.emplace(0, block.capacity);
+
+		// reuse a slot released by trim() or compact(), records refer to blocks by index
+		for (uint32_t i = 0; i < pool.blocks.size(); i++)
+		{
+			if (!pool.blocks[i].buffer)
+			{
+				pool.blocks[i] = std::move(block);
+				return i;
+			}
+		}
+		pool.blocks.push_back(std::move(block));
+		return static_cast<uint32_t>(pool.blocks.size() - 1);
+	}
+
+	bool skGeometryArena::allocateFromBlock(Block &block, uint32_t count, uint32_t &offset)
+	{
+		for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it)
+		{
+			if (it->second < count)
+				continue;
+
+			offset = it->first;
+			uint32_t remaining = it->second - count;
+			block.freeRanges.erase(it);
+			if (remaining > 0)
+				block.freeRanges.emplace(offset + count, remaining);
+			block.used += count;
+			return true;
+		}
+		return false;
+	}
+
+	void skGeometryArena::upload(Handle handle, const Allocation &allocation, const void *data)
+	{
+		VkDeviceSize size = static_cast<VkDeviceSize>(allocation.count) * allocation.elementSize;
+		skUploadContext::Ticket ticket = m_uploader.uploadBuffer(allocation.buffer, allocation.byteOffset(), data, size);
+
+		std::lock_guard<std::shared_mutex> lock{ m_mutex };
+		m_allocations[handle].uploadTicket = ticket;
+	}
+} // namespace sk
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "core/skDevice.h"
+#include "core/skUploadContext.h"
+#include "skBuffer.h"
+
+// std
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace sk
+{
+	/* Device local vertex and index memory shared by every skModel.
+	 *   memory is split into pools, one per vertex stride and one per index type, so that an allocation's offset in
+	 *   elements is directly the vertexOffset / firstIndex to draw it with. every pool is a short list of large blocks
+	 *   (one VkBuffer and one vkAllocateMemory each), models drawn back to back from the same block share one bind.
+	 *   free space is tracked per block as offset sorted ranges that coalesce on free, allocation is first fit.
+	 *   models hold handles rather than offsets because compact() moves allocations.
+	 *   contents are recorded into the upload context, so allocating never waits on the queue and may happen on any
+	 *   thread. isResident tells when an allocation's contents reached the device.
+	 *   frames in flight may still draw from a freed range, so free only queues it under the frame being recorded.
+	 *   beginFrame hands the ranges of a frame back to their blocks once its fence signaled, the way the upload context
+	 *   recycles staging space once a batch retired. */
+	class skGeometryArena
+	{
+	public:
+		using Handle = uint32_t;
+		static constexpr Handle INVALID_HANDLE = ~0u;
+
+		// blocks start small and double per pool up to the maximum, a request larger than that gets a block of its own
+		static constexpr VkDeviceSize MIN_BLOCK_SIZE = 4 * 1024 * 1024;
+		static constexpr VkDeviceSize MAX_BLOCK_SIZE = 64 * 1024 * 1024;
+
+		struct Allocation
+		{
+			VkBuffer buffer = VK_NULL_HANDLE;
+			uint32_t offset = 0;		// in elements of the pool
+			uint32_t count = 0;
+			uint32_t elementSize = 0;
+
+			VkDeviceSize byteOffset() const { return static_cast<VkDeviceSize>(offset) * elementSize; }
+		};
+
+		// what a command buffer currently has bound, lets skModel::bind skip redundant binds. start a fresh one per
+		//   command buffer
+		struct BindState
+		{
+			VkBuffer vertexBuffer = VK_NULL_HANDLE;
+			VkBuffer defaultsBuffer = VK_NULL_HANDLE;
+			VkDeviceSize defaultsOffset = 0;
+			VkBuffer indexBuffer = VK_NULL_HANDLE;
+			VkIndexType indexType = VK_INDEX_TYPE_MAX_ENUM;
+		};
+
+		struct Stats
+		{
+			uint32_t blocks = 0;
+			uint32_t allocations = 0;
+			uint32_t freeRanges = 0;	// > blocks means fragmentation that compact() would fold
+			VkDeviceSize capacity = 0;	// bytes
+			VkDeviceSize used = 0;
+		};
+
+		// uploader must outlive the arena
+		skGeometryArena(skDevice &device, skUploadContext &uploader);
+		~skGeometryArena();
+
+		skGeometryArena(const skGeometryArena&) = delete;
+		skGeometryArena &operator=(const skGeometryArena&) = delete;
+
+		// reserve count elements and upload them from data (may be null to leave the range uninitialized)
+		Handle allocateVertices(uint32_t stride, uint32_t count, const void *data);
+		Handle allocateIndices(VkIndexType indexType, uint32_t count, const void *data);
+		// small constant vertex streams (e.g. the packed format's defaults). identical contents share one allocation
+		//   that lives as long as the arena, so every model using it keeps the same bind
+		Handle allocateShared(const void *data, uint32_t size);
+		// frames recorded after this must no longer draw from handle. the range is reused once the current frame
+		//   retired (see beginFrame), or by compact() which runs on an idle device anyway
+		void free(Handle handle);
+		// call once frameIndex's fence signaled (after skRenderer::beginFrame): returns the ranges freed while that
+		//   frame was last recorded, frees until the next call are queued under frameIndex
+		void beginFrame(uint32_t frameIndex);
+		// releases the blocks without live allocations, nothing is copied and the device may keep running. blocks whose
+		//   last ranges still wait for their frame follow in beginFrame as those come back. returns the bytes released now
+		VkDeviceSize trim();
+
+		Allocation allocation(Handle handle) const;
+		// whether the upload into handle's range completed and it may be drawn from
+		bool isResident(Handle handle) const;
+
+		// rewrites every fragmented block into one just large enough for its live allocations and releases blocks left
+		//   empty, queued frees included. allocation offsets and buffers change (handles stay valid, see generation), so it
+		//   must run while the device is idle and no model is being loaded, e.g. after vkDeviceWaitIdle between levels.
+		//   the copies go through the upload context, on the thread owning it
+		void compact();
+		// changes whenever compact() moved allocations, lets models keep their placement between frames
+		uint64_t generation() const { return m_generation.load(std::memory_order_acquire); }
+
+		Stats stats() const;
+		skDevice &device() { return m_Device; }
+
+	private:
+		struct Block
+		{
+			std::unique_ptr<skBuffer> buffer{};
+			uint32_t capacity = 0;						// elements
+			uint32_t used = 0;
+			std::map<uint32_t, uint32_t> freeRanges{};	// offset -> count
+		};
+
+		struct Pool
+		{
+			VkBufferUsageFlags usage = 0;
+			uint32_t elementSize = 0;
+			VkDeviceSize nextBlockSize = MIN_BLOCK_SIZE;
+			std::vector<Block> blocks{};
+		};
+
+		struct Record
+		{
+			Allocation allocation{};
+			uint32_t pool = 0;
+			uint32_t block = 0;
+			skUploadContext::Ticket uploadTicket = 0;
+			bool live = false;
+			bool freed = false;	// queued for release, the range stays taken until then
+		};
+
+		struct SharedAllocation
+		{
+			Handle handle = INVALID_HANDLE;
+			std::vector<unsigned char> bytes{};	// compared on a hash hit, shared streams are a few bytes each
+		};
+
+		// stands in for the ticket between reserving a range and recording its upload
+		static constexpr skUploadContext::Ticket PENDING_UPLOAD = ~0ull;
+
+		Handle allocate(VkBufferUsageFlags usage, uint32_t elementSize, uint32_t count, const void *data);
+		// the bookkeeping half of allocate, requires m_mutex
+		Handle reserve(VkBufferUsageFlags usage, uint32_t elementSize, uint32_t count, bool pendingUpload);
+		uint32_t poolFor(VkBufferUsageFlags usage, uint32_t elementSize);
+		uint32_t createBlock(Pool &pool, uint32_t minCount);
+		bool allocateFromBlock(Block &block, uint32_t count, uint32_t &offset);
+		// the range back to its block and the handle back to the free list, requires m_mutex as do the three below
+		void release(Handle handle);
+		void releaseDeferred();
+		bool hasDeferredFrees() const;
+		VkDeviceSize releaseEmptyBlocks();
+		// runs without m_mutex, a full staging ring may block it until the render thread retires uploads
+		void upload(Handle handle, const Allocation &allocation, const void *data);
+
+		skDevice &m_Device;
+		skUploadContext &m_uploader;
+		mutable std::shared_mutex m_mutex;
+		std::vector<Pool> m_pools{};
+		std::vector<Record> m_allocations{};
+		std::vector<Handle> m_freeHandles{};
+		std::vector<std::vector<Handle>> m_deferredFrees{};	// by frame index, grows to the frames seen
+		uint32_t m_frameIndex = 0;
+		bool m_trimPending = false;	// trim() ran while frees were queued, beginFrame releases the blocks they empty
+		std::atomic<uint64_t> m_generation{ 0 };
+		std::unordered_multimap<uint64_t, SharedAllocation> m_shared{}; // content hash -> allocations
+	};
+} // namespace sk
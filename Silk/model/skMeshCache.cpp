@@ -0,0 +1,213 @@
+#include "skMeshCache.h"
+#include "skUtils.h"
+
+// std
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+namespace sk
+{
+	namespace
+	{
+		constexpr uint64_t STREAM_ALIGNMENT = 16;
+
+		uint64_t alignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+		struct SourceStamp
+		{
+			bool exists = false;
+			uint64_t size = 0;
+			int64_t time = 0;
+		};
+
+		SourceStamp stampSource(const std::string& sourcePath)
+		{
+			std::error_code ec;
+			SourceStamp stamp{};
+			stamp.size = static_cast<uint64_t>(std::filesystem::file_size(sourcePath, ec));
+			if (ec) return stamp;
+			auto time = std::filesystem::last_write_time(sourcePath, ec);
+			if (ec) return stamp;
+			stamp.time = static_cast<int64_t>(time.time_since_epoch().count());
+			stamp.exists = true;
+			return stamp;
+		}
+
+		// hashing the source is only needed when the timestamp moved (fresh checkout, copied assets...), so it is done lazily
+		uint64_t hashSource(const std::string& sourcePath)
+		{
+			skMappedFile source{};
+			if (!source.open(sourcePath))
+				return 0;
+			return hashBytes(source.data(), source.size());
+		}
+	} // namespace
+
+	std::string skMeshCache::cachePathFor(const std::string& sourcePath)
+	{
+		return std::filesystem::path(sourcePath).replace_extension(".skmesh").string();
+	}
+
+	bool skMeshCache::open(const std::string& sourcePath)
+	{
+		const std::string cachePath = cachePathFor(sourcePath);
+		if (!m_file.open(cachePath))
+			return false;
+
+		bool refreshTimestamp = false;
+		if (!validate(sourcePath, refreshTimestamp))
+		{
+			m_file.close();
+			return false;
+		}
+
+		if (refreshTimestamp)
+		{
+			// content is unchanged but the timestamp moved: patch the stamp so the next launch takes the fast path again.
+			//   the file has to be unmapped first, windows refuses writes to a file with an open view.
+			SourceStamp stamp = stampSource(sourcePath);
+			m_file.close();
+			{
+				std::fstream file(cachePath, std::ios::in | std::ios::out | std::ios::binary);
+				if (file.is_open())
+				{
+					file.seekp(offsetof(Header, sourceTime));
+					file.write(reinterpret_cast<const char*>(&stamp.time), sizeof(stamp.time));
+				}
+			}
+			if (!m_file.open(cachePath) || !validate(sourcePath, refreshTimestamp))
+			{
+				m_file.close();
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool skMeshCache::validate(const std::string& sourcePath, bool &refreshTimestamp)
+	{
+		refreshTimestamp = false;
+		if (m_file.size() < sizeof(Header))
+			return false;
+
+		const auto *bytes = static_cast<const unsigned char*>(m_file.data());
+		const Header *header = reinterpret_cast<const Header*>(bytes);
+
+		if (header->magic != MAGIC || header->version != VERSION || header->vertexStride != sizeof(skModel::Vertex))
+			return false;
+
+		// bounds check every stream against the mapped size, a truncated file must never be read past its end
+		const uint64_t vertexBytes = static_cast<uint64_t>(header->vertexCount) * sizeof(skModel::Vertex);
+		const uint64_t indexBytes = static_cast<uint64_t>(header->indexCount) * sizeof(uint32_t);
+		const uint64_t lodBytes = static_cast<uint64_t>(header->lodCount) * sizeof(skModel::Lod);
+		if (header->vertexOffset % STREAM_ALIGNMENT != 0 || header->indexOffset % STREAM_ALIGNMENT != 0 ||
+			header->lodOffset % STREAM_ALIGNMENT != 0 ||
+			header->vertexOffset < sizeof(Header) || header->vertexOffset + vertexBytes > m_file.size() ||
+			header->indexOffset < sizeof(Header) || header->indexOffset + indexBytes > m_file.size() ||
+			header->lodOffset < sizeof(Header) || header->lodOffset + lodBytes > m_file.size())
+			return false;
+
+		// and every LOD against the index stream
+		const auto *lods = reinterpret_cast<const skModel::Lod*>(bytes + header->lodOffset);
+		for (uint32_t i = 0; i < header->lodCount; i++)
+		{
+			if (static_cast<uint64_t>(lods[i].firstIndex) + lods[i].indexCount > header->indexCount)
+				return false;
+		}
+
+		// without the source there is nothing to be stale against (e.g. only baked meshes were shipped)
+		SourceStamp stamp = stampSource(sourcePath);
+		if (stamp.exists)
+		{
+			if (stamp.size != header->sourceSize)
+				return false;
+			if (stamp.time != header->sourceTime)
+			{
+				if (hashSource(sourcePath) != header->sourceHash)
+					return false;
+				refreshTimestamp = true;
+			}
+		}
+
+		m_header = header;
+		m_vertices = reinterpret_cast<const skModel::Vertex*>(bytes + header->vertexOffset);
+		m_indices = reinterpret_cast<const uint32_t*>(bytes + header->indexOffset);
+		m_lods = lods;
+		return true;
+	}
+
+	skModel::Bounds skMeshCache::bounds() const
+	{
+		skModel::Bounds bounds{};
+		bounds.min = { m_header->boundsMin[0], m_header->boundsMin[1], m_header->boundsMin[2] };
+		bounds.max = { m_header->boundsMax[0], m_header->boundsMax[1], m_header->boundsMax[2] };
+		bounds.radius = m_header->boundsRadius;
+		return bounds;
+	}
+
+	bool skMeshCache::write(const std::string& sourcePath, const skModel::Builder& builder)
+	{
+		SourceStamp stamp = stampSource(sourcePath);
+		if (!stamp.exists)
+			return false;
+
+		Header header{};
+		header.magic = MAGIC;
+		header.version = VERSION;
+		header.vertexStride = sizeof(skModel::Vertex);
+		header.vertexCount = static_cast<uint32_t>(builder.vertices.size());
+		header.indexCount = static_cast<uint32_t>(builder.indices.size());
+		header.attributes = builder.attributes;
+		header.lodCount = static_cast<uint32_t>(builder.lods.size());
+		header.sourceSize = stamp.size;
+		header.sourceTime = stamp.time;
+		header.sourceHash = hashSource(sourcePath);
+
+		const skModel::Bounds bounds = skModel::computeBounds(builder.vertices.data(), header.vertexCount);
+		std::copy_n(&bounds.min.x, 3, header.boundsMin);
+		std::copy_n(&bounds.max.x, 3, header.boundsMax);
+		header.boundsRadius = bounds.radius;
+
+		const uint64_t vertexBytes = builder.vertices.size() * sizeof(skModel::Vertex);
+		const uint64_t indexBytes = builder.indices.size() * sizeof(uint32_t);
+		const uint64_t lodBytes = builder.lods.size() * sizeof(skModel::Lod);
+		header.vertexOffset = alignUp(sizeof(Header), STREAM_ALIGNMENT);
+		header.indexOffset = alignUp(header.vertexOffset + vertexBytes, STREAM_ALIGNMENT);
+		header.lodOffset = alignUp(header.indexOffset + indexBytes, STREAM_ALIGNMENT);
+
+		// write to a temporary and rename it into place so a crash mid-write never leaves a torn cache behind
+		const std::string cachePath = cachePathFor(sourcePath);
+		const std::string tempPath = cachePath + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+				return false;
+
+			const char padding[STREAM_ALIGNMENT]{};
+			file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+			file.write(padding, header.vertexOffset - sizeof(Header));
+			file.write(reinterpret_cast<const char*>(builder.vertices.data()), vertexBytes);
+			file.write(padding, header.indexOffset - (header.vertexOffset + vertexBytes));
+			file.write(reinterpret_cast<const char*>(builder.indices.data()), indexBytes);
+			file.write(padding, header.lodOffset - (header.indexOffset + indexBytes));
+			file.write(reinterpret_cast<const char*>(builder.lods.data()), lodBytes);
+			if (!file.good())
+				return false;
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(tempPath, cachePath, ec);
+		if (ec)
+		{
+			std::filesystem::remove(tempPath, ec);
+			return false;
+		}
+		return true;
+	}
+
+} // namespace sk
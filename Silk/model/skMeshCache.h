@@ -0,0 +1,74 @@
+#pragma once
+
+#include "skModel.h"
+#include "skMappedFile.h"
+
+// std
+#include <cstdint>
+#include <string>
+
+namespace sk
+{
+	/* Pre-baked binary mesh (.skmesh) written next to the source .obj after the first import.
+	 *   layout: [Header][vertex stream][index stream][lod table], every stream 16-byte aligned.
+	 *   later runs memory-map the file and hand the streams straight to the staging buffers, skipping
+	 *   the obj parse and the vertex dedup pass entirely. */
+	class skMeshCache
+	{
+	public:
+		static constexpr uint32_t MAGIC = 0x534d4b53; // "SKMS" in little endian
+		// 2: streams are vertex cache / fetch optimized, 3: attribute mask, 4: LODs, 5: bounding radius
+		static constexpr uint32_t VERSION = 5;
+
+		struct Header
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t vertexStride;	// sizeof(skModel::Vertex) at bake time, guards against layout changes
+			uint32_t vertexCount;
+			uint32_t indexCount;
+			uint32_t attributes;	// skModel::VertexAttributeFlagBits present in the source
+			uint32_t lodCount;		// entries in the lod table, their ranges index into the index stream
+			float boundsRadius;		// with boundsMin / boundsMax, skModel::Bounds of the vertex stream
+			uint64_t sourceSize;	// size, modification time and content hash of the .obj it was baked from
+			int64_t sourceTime;
+			uint64_t sourceHash;
+			float boundsMin[3];
+			float boundsMax[3];
+			uint64_t vertexOffset;	// byte offsets from the start of the file
+			uint64_t indexOffset;
+			uint64_t lodOffset;
+		};
+
+		skMeshCache() = default;
+
+		skMeshCache(const skMeshCache&) = delete;
+		skMeshCache &operator=(const skMeshCache&) = delete;
+
+		// maps the cache for sourcePath. returns false if there is no cache, it is malformed or it is stale.
+		bool open(const std::string& sourcePath);
+
+		// bakes builder's streams for sourcePath. failure is not fatal (e.g. read-only resource folder), it only returns false.
+		static bool write(const std::string& sourcePath, const skModel::Builder& builder);
+
+		static std::string cachePathFor(const std::string& sourcePath);
+
+		inline const Header &header() const { return *m_header; }
+		inline const skModel::Vertex *vertices() const { return m_vertices; }
+		inline const uint32_t *indices() const { return m_indices; }
+		inline uint32_t vertexCount() const { return m_header->vertexCount; }
+		inline uint32_t indexCount() const { return m_header->indexCount; }
+		inline const skModel::Lod *lods() const { return m_lods; }
+		inline uint32_t lodCount() const { return m_header->lodCount; }
+		skModel::Bounds bounds() const;
+
+	private:
+		bool validate(const std::string& sourcePath, bool &refreshTimestamp);
+
+		skMappedFile m_file;
+		const Header *m_header = nullptr;
+		const skModel::Vertex *m_vertices = nullptr;
+		const uint32_t *m_indices = nullptr;
+		const skModel::Lod *m_lods = nullptr;
+	};
+} // namespace sk
@@ -0,0 +1,260 @@
+#include "skMeshOptimizer.h"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+namespace sk
+{
+	namespace
+	{
+		constexpr uint32_t INVALID_VERTEX = std::numeric_limits<uint32_t>::max();
+
+		// vertex -> triangles using it, as one flat array
+		struct TriangleAdjacency
+		{
+			std::vector<uint32_t> offsets{};
+			std::vector<uint32_t> triangles{};
+			std::vector<uint32_t> counts{};
+
+			TriangleAdjacency(const uint32_t *indices, size_t indexCount, size_t vertexCount)
+				: offsets(vertexCount + 1, 0), triangles(indexCount), counts(vertexCount, 0)
+			{
+				for (size_t i = 0; i < indexCount; i++)
+					counts[indices[i]]++;
+				for (size_t v = 0; v < vertexCount; v++)
+					offsets[v + 1] = offsets[v] + counts[v];
+
+				std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+				for (size_t i = 0; i < indexCount; i++)
+					triangles[cursor[indices[i]]++] = static_cast<uint32_t>(i / 3);
+			}
+		};
+
+		inline glm::vec3 positionOf(const unsigned char *positions, size_t stride, uint32_t vertex)
+		{
+			glm::vec3 position;
+			std::memcpy(&position, positions + vertex * stride, sizeof(position));
+			return position;
+		}
+	} // namespace
+
+	VertexCacheStats skMeshOptimizer::analyzeVertexCache(const uint32_t *indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize)
+	{
+		VertexCacheStats stats{};
+		if (indexCount < 3 || vertexCount == 0)
+			return stats;
+
+		// a vertex is in the FIFO if it was inserted less than cacheSize insertions ago
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<bool> referenced(vertexCount, false);
+		uint32_t time = cacheSize + 1;
+		size_t misses = 0, uniqueVertices = 0;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			uint32_t v = indices[i];
+			if (time - cacheTime[v] > cacheSize)
+			{
+				cacheTime[v] = time++;
+				misses++;
+			}
+			if (!referenced[v])
+			{
+				referenced[v] = true;
+				uniqueVertices++;
+			}
+		}
+
+		stats.acmr = static_cast<float>(misses) / static_cast<float>(indexCount / 3);
+		stats.atvr = static_cast<float>(misses) / static_cast<float>(uniqueVertices);
+		return stats;
+	}
+
+	void skMeshOptimizer::optimizeVertexCache(uint32_t *indices, size_t indexCount, size_t vertexCount, uint32_t cacheSize,
+		std::vector<uint32_t> *clusterOffsets)
+	{
+		if (clusterOffsets) clusterOffsets->clear();
+		// a partial triangle at the end stays where it is, reordering it into the others would make up a triangle
+		assert(indexCount % 3 == 0 && "Index count is not a multiple of 3");
+		indexCount -= indexCount % 3;
+		if (indexCount < 3 || vertexCount == 0)
+			return;
+
+		TriangleAdjacency adjacency{ indices, indexCount, vertexCount };
+		std::vector<uint32_t> &liveTriangles = adjacency.counts; // no longer needed as counts, reused as live counters
+		std::vector<uint32_t> cacheTime(vertexCount, 0);
+		std::vector<bool> emitted(indexCount / 3, false);
+		std::vector<uint32_t> deadEnd{};
+		std::vector<uint32_t> candidates{};
+		std::vector<uint32_t> output{};
+		output.reserve(indexCount);
+
+		uint32_t time = cacheSize + 1;
+		size_t cursor = 0;
+
+		// vertices of recently emitted triangles that still have work left, most recent first
+		auto skipDeadEnd = [&]() -> uint32_t {
+			while (!deadEnd.empty())
+			{
+				uint32_t vertex = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveTriangles[vertex] > 0)
+					return vertex;
+			}
+			for (; cursor < vertexCount; cursor++)
+			{
+				if (liveTriangles[cursor] > 0)
+					return static_cast<uint32_t>(cursor);
+			}
+			return INVALID_VERTEX;
+		};
+
+		uint32_t fanning = skipDeadEnd();
+		if (clusterOffsets) clusterOffsets->push_back(0);
+		while (fanning != INVALID_VERTEX)
+		{
+			// emit every remaining triangle around the fanning vertex
+			candidates.clear();
+			for (uint32_t a = adjacency.offsets[fanning]; a < adjacency.offsets[fanning + 1]; a++)
+			{
+				uint32_t triangle = adjacency.triangles[a];
+				if (emitted[triangle])
+					continue;
+
+				for (uint32_t k = 0; k < 3; k++)
+				{
+					uint32_t v = indices[3 * triangle + k];
+					output.push_back(v);
+					deadEnd.push_back(v);
+					candidates.push_back(v);
+					liveTriangles[v]--;
+					if (time - cacheTime[v] > cacheSize)
+						cacheTime[v] = time++;
+				}
+				emitted[triangle] = true;
+			}
+
+			// continue with the candidate that will still be in the cache once its remaining triangles are emitted,
+			//   preferring the oldest one (it is the closest to being evicted)
+			uint32_t next = INVALID_VERTEX;
+			int64_t bestPriority = -1;
+			for (uint32_t v : candidates)
+			{
+				if (liveTriangles[v] == 0)
+					continue;
+				int64_t priority = 0;
+				if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+					priority = time - cacheTime[v];
+				if (priority > bestPriority)
+				{
+					bestPriority = priority;
+					next = v;
+				}
+			}
+
+			if (next == INVALID_VERTEX)
+			{
+				next = skipDeadEnd();
+				if (clusterOffsets && next != INVALID_VERTEX)
+					clusterOffsets->push_back(static_cast<uint32_t>(output.size()));
+			}
+			fanning = next;
+		}
+
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	void skMeshOptimizer::optimizeOverdraw(uint32_t *indices, size_t indexCount, const std::vector<uint32_t>& clusterOffsets,
+		const void *positions, size_t positionStride)
+	{
+		if (clusterOffsets.size() < 2)
+			return;
+
+		const auto *bytes = static_cast<const unsigned char*>(positions);
+		struct Cluster
+		{
+			uint32_t begin;
+			uint32_t end;
+			glm::vec3 centroid;
+			glm::vec3 normal;
+			float sortKey;
+		};
+
+		// area weighted centroid and normal per cluster, and of the whole mesh
+		std::vector<Cluster> clusters(clusterOffsets.size());
+		glm::vec3 meshCentroid{ 0.f };
+		float meshArea = 0.f;
+		for (size_t c = 0; c < clusters.size(); c++)
+		{
+			Cluster &cluster = clusters[c];
+			cluster.begin = clusterOffsets[c];
+			cluster.end = c + 1 < clusterOffsets.size() ? clusterOffsets[c + 1] : static_cast<uint32_t>(indexCount);
+			cluster.centroid = glm::vec3{ 0.f };
+			cluster.normal = glm::vec3{ 0.f };
+
+			float clusterArea = 0.f;
+			for (uint32_t i = cluster.begin; i < cluster.end; i += 3)
+			{
+				glm::vec3 p0 = positionOf(bytes, positionStride, indices[i + 0]);
+				glm::vec3 p1 = positionOf(bytes, positionStride, indices[i + 1]);
+				glm::vec3 p2 = positionOf(bytes, positionStride, indices[i + 2]);
+				glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+				float area = glm::length(normal);
+
+				cluster.centroid += (p0 + p1 + p2) * (area / 3.f);
+				cluster.normal += normal;
+				clusterArea += area;
+			}
+
+			meshCentroid += cluster.centroid;
+			meshArea += clusterArea;
+			if (clusterArea > 0.f) cluster.centroid /= clusterArea;
+		}
+		if (meshArea > 0.f) meshCentroid /= meshArea;
+
+		// clusters that face away from the center are on the outside, draw those first
+		for (auto& cluster : clusters)
+		{
+			float length = glm::length(cluster.normal);
+			cluster.sortKey = length > 0.f ? glm::dot(cluster.centroid - meshCentroid, cluster.normal / length) : 0.f;
+		}
+		std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster &a, const Cluster &b) { return a.sortKey > b.sortKey; });
+
+		std::vector<uint32_t> output{};
+		output.reserve(indexCount);
+		for (const auto& cluster : clusters)
+			output.insert(output.end(), indices + cluster.begin, indices + cluster.end);
+		std::copy(output.begin(), output.end(), indices);
+	}
+
+	size_t skMeshOptimizer::optimizeVertexFetch(void *vertices, size_t vertexCount, size_t vertexSize, uint32_t *indices, size_t indexCount)
+	{
+		std::vector<uint32_t> remap(vertexCount, INVALID_VERTEX);
+		uint32_t nextVertex = 0;
+		for (size_t i = 0; i < indexCount; i++)
+		{
+			uint32_t &slot = remap[indices[i]];
+			if (slot == INVALID_VERTEX)
+				slot = nextVertex++;
+			indices[i] = slot;
+		}
+
+		auto *bytes = static_cast<unsigned char*>(vertices);
+		std::vector<unsigned char> reordered(static_cast<size_t>(nextVertex) * vertexSize);
+		for (size_t v = 0; v < vertexCount; v++)
+		{
+			if (remap[v] != INVALID_VERTEX)
+				std::memcpy(reordered.data() + remap[v] * vertexSize, bytes + v * vertexSize, vertexSize);
+		}
+		if (!reordered.empty())
+			std::memcpy(bytes, reordered.data(), reordered.size());
+		return nextVertex;
+	}
+} // namespace sk
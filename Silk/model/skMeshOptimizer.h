@@ -0,0 +1,52 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sk
+{
+	// post-transform vertex cache efficiency of an index buffer, simulated on a FIFO cache
+	struct VertexCacheStats
+	{
+		float acmr = 0.f; // average cache miss ratio: vertex shader invocations per triangle, 0.5 is the ideal for big meshes
+		float atvr = 0.f; // average transform to vertex ratio: invocations per unique vertex, 1.0 is the ideal
+	};
+
+	struct OptimizationReport
+	{
+		VertexCacheStats before{};
+		VertexCacheStats after{};
+	};
+
+	/* Index and vertex reordering done once at import, after the vertices are welded and before they are uploaded.
+	 *   optimizeVertexCache: Tipsify (Sander, Nehab, Barczak 2007), a linear time triangle order that keeps fanning
+	 *     around vertices that are still in the post-transform cache.
+	 *   optimizeOverdraw: moves whole Tipsify clusters so the ones facing away from the mesh center come first, which
+	 *     tends to draw the outer shell before what it hides. triangles inside a cluster are not touched, so the cache
+	 *     efficiency only degrades at cluster seams.
+	 *   optimizeVertexFetch: renumbers vertices in order of first use so fetches walk the vertex buffer forward. */
+	class skMeshOptimizer
+	{
+	public:
+		static constexpr uint32_t DEFAULT_CACHE_SIZE = 16;
+
+		static VertexCacheStats analyzeVertexCache(const uint32_t *indices, size_t indexCount, size_t vertexCount,
+			uint32_t cacheSize = DEFAULT_CACHE_SIZE);
+
+		// reorders triangles in place, indices past the last whole triangle stay put. clusterOffsets (optional) receives
+		//   the first index of every cluster, i.e. every spot where Tipsify had to restart away from the cache, which is
+		//   what optimizeOverdraw works with
+		static void optimizeVertexCache(uint32_t *indices, size_t indexCount, size_t vertexCount,
+			uint32_t cacheSize = DEFAULT_CACHE_SIZE, std::vector<uint32_t> *clusterOffsets = nullptr);
+
+		// reorders the clusters of a cache optimized index buffer. positions are 3 floats every positionStride bytes
+		static void optimizeOverdraw(uint32_t *indices, size_t indexCount, const std::vector<uint32_t>& clusterOffsets,
+			const void *positions, size_t positionStride);
+
+		// reorders vertices (vertexSize bytes each) in place into first-use order and rewrites indices to match.
+		//   vertices that no index references are dropped, returns the new vertex count
+		static size_t optimizeVertexFetch(void *vertices, size_t vertexCount, size_t vertexSize, uint32_t *indices, size_t indexCount);
+	};
+} // namespace sk
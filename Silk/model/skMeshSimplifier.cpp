@@ -0,0 +1,396 @@
+#include "skMeshSimplifier.h"
+#include "skUtils.h"
+
+// std
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+
+namespace sk
+{
+	namespace
+	{
+		constexpr uint32_t INVALID = std::numeric_limits<uint32_t>::max();
+
+		// symmetric 4x4 plane quadric, weighted by triangle area. error() divides the weight back out so that the
+		//   result is a mean squared distance in object space units
+		struct Quadric
+		{
+			double a2 = 0, ab = 0, ac = 0, ad = 0;
+			double b2 = 0, bc = 0, bd = 0;
+			double c2 = 0, cd = 0;
+			double d2 = 0;
+			double weight = 0;
+
+			void addPlane(const glm::dvec3 &n, double d, double w)
+			{
+				a2 += w * n.x * n.x; ab += w * n.x * n.y; ac += w * n.x * n.z; ad += w * n.x * d;
+				b2 += w * n.y * n.y; bc += w * n.y * n.z; bd += w * n.y * d;
+				c2 += w * n.z * n.z; cd += w * n.z * d;
+				d2 += w * d * d;
+				weight += w;
+			}
+
+			Quadric &operator+=(const Quadric &q)
+			{
+				a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+				b2 += q.b2; bc += q.bc; bd += q.bd;
+				c2 += q.c2; cd += q.cd;
+				d2 += q.d2;
+				weight += q.weight;
+				return *this;
+			}
+
+			double error(const glm::dvec3 &p) const
+			{
+				double e = a2 * p.x * p.x + 2 * ab * p.x * p.y + 2 * ac * p.x * p.z + 2 * ad * p.x
+					+ b2 * p.y * p.y + 2 * bc * p.y * p.z + 2 * bd * p.y
+					+ c2 * p.z * p.z + 2 * cd * p.z
+					+ d2;
+				return weight > 0 ? std::max(0.0, e / weight) : 0.0;
+			}
+		};
+
+		struct Collapse
+		{
+			double cost; // squared distance
+			uint32_t from;
+			uint32_t to;
+			uint32_t fromVersion;
+			uint32_t toVersion;
+
+			bool operator>(const Collapse &other) const { return cost > other.cost; }
+		};
+
+		float attributeDistance(const skModel::Vertex &a, const skModel::Vertex &b)
+		{
+			glm::vec3 dn = a.normal - b.normal, dc = a.color - b.color;
+			glm::vec2 du = a.uv - b.uv;
+			return glm::dot(dn, dn) + glm::dot(dc, dc) + glm::dot(du, du);
+		}
+
+		class Simplifier
+		{
+		public:
+			Simplifier(const skModel::Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount)
+				: m_vertices(vertices), m_vertexCount(vertexCount)
+			{
+				buildGroups();
+				buildTriangles(indices, indexCount);
+				buildQuadrics();
+				lockBorders();
+			}
+
+			double run(size_t targetTriangles, double targetErrorSquared)
+			{
+				std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> queue{};
+				for (const auto &triangle : m_triangles)
+				{
+					for (int k = 0; k < 3; k++)
+						pushCandidate(queue, triangle[k], triangle[(k + 1) % 3]);
+				}
+
+				double maxError = 0.0;
+				while (m_liveTriangles > targetTriangles && !queue.empty())
+				{
+					Collapse collapse = queue.top();
+					queue.pop();
+
+					if (m_remap[collapse.from] != collapse.from || m_remap[collapse.to] != collapse.to ||
+						m_version[collapse.from] != collapse.fromVersion || m_version[collapse.to] != collapse.toVersion)
+						continue; // stale, a newer candidate was pushed when either end changed
+					if (collapse.cost > targetErrorSquared)
+						break;
+					if (!canCollapse(collapse.from, collapse.to))
+						continue;
+
+					applyCollapse(collapse.from, collapse.to);
+					maxError = std::max(maxError, collapse.cost);
+
+					// re-evaluate every edge around the merged position
+					for (uint32_t triangle : m_groupTriangles[collapse.to])
+					{
+						if (!m_triangleAlive[triangle]) continue;
+						for (int k = 0; k < 3; k++)
+						{
+							uint32_t g = m_triangles[triangle][k];
+							if (g != collapse.to)
+								pushCandidate(queue, collapse.to, g);
+						}
+					}
+				}
+				return maxError;
+			}
+
+			std::vector<uint32_t> output() const
+			{
+				std::vector<uint32_t> result{};
+				result.reserve(m_liveTriangles * 3);
+				for (size_t t = 0; t < m_triangles.size(); t++)
+				{
+					if (!m_triangleAlive[t]) continue;
+					for (int k = 0; k < 3; k++)
+						result.push_back(pickVertex(m_corners[t][k], m_triangles[t][k]));
+				}
+				return result;
+			}
+
+		private:
+			// vertices with bit-identical positions form one group
+			void buildGroups()
+			{
+				m_groupOf.resize(m_vertexCount);
+				std::unordered_map<uint64_t, std::vector<uint32_t>> buckets{};
+				for (uint32_t v = 0; v < m_vertexCount; v++)
+				{
+					const glm::vec3 &p = m_vertices[v].position;
+					auto &bucket = buckets[hashBytes(&p, sizeof(p))];
+					uint32_t group = INVALID;
+					for (uint32_t g : bucket)
+					{
+						if (glm::vec3(m_positions[g]) == p) { group = g; break; }
+					}
+					if (group == INVALID)
+					{
+						group = static_cast<uint32_t>(m_positions.size());
+						m_positions.push_back(glm::dvec3(p));
+						bucket.push_back(group);
+					}
+					m_groupOf[v] = group;
+				}
+
+				const size_t groupCount = m_positions.size();
+				m_groupVertexOffsets.assign(groupCount + 1, 0);
+				for (uint32_t v = 0; v < m_vertexCount; v++)
+					m_groupVertexOffsets[m_groupOf[v] + 1]++;
+				for (size_t g = 0; g < groupCount; g++)
+					m_groupVertexOffsets[g + 1] += m_groupVertexOffsets[g];
+				m_groupVertices.resize(m_vertexCount);
+				std::vector<uint32_t> cursor(m_groupVertexOffsets.begin(), m_groupVertexOffsets.end() - 1);
+				for (uint32_t v = 0; v < m_vertexCount; v++)
+					m_groupVertices[cursor[m_groupOf[v]]++] = v;
+
+				m_remap.resize(groupCount);
+				for (uint32_t g = 0; g < groupCount; g++)
+					m_remap[g] = g;
+				m_version.assign(groupCount, 0);
+				m_locked.assign(groupCount, false);
+				m_quadrics.assign(groupCount, Quadric{});
+				m_groupTriangles.resize(groupCount);
+			}
+
+			void buildTriangles(const uint32_t *indices, size_t indexCount)
+			{
+				for (size_t i = 0; i + 3 <= indexCount; i += 3)
+				{
+					std::array<uint32_t, 3> corners{ indices[i], indices[i + 1], indices[i + 2] };
+					std::array<uint32_t, 3> groups{ m_groupOf[corners[0]], m_groupOf[corners[1]], m_groupOf[corners[2]] };
+					if (groups[0] == groups[1] || groups[1] == groups[2] || groups[0] == groups[2])
+						continue; // already degenerate in position space
+
+					uint32_t t = static_cast<uint32_t>(m_triangles.size());
+					m_triangles.push_back(groups);
+					m_corners.push_back(corners);
+					for (uint32_t g : groups)
+						m_groupTriangles[g].push_back(t);
+				}
+				m_triangleAlive.assign(m_triangles.size(), true);
+				m_liveTriangles = m_triangles.size();
+			}
+
+			void buildQuadrics()
+			{
+				for (const auto &triangle : m_triangles)
+				{
+					const glm::dvec3 &p0 = m_positions[triangle[0]], &p1 = m_positions[triangle[1]], &p2 = m_positions[triangle[2]];
+					glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+					double length = glm::length(normal);
+					if (length == 0.0) continue;
+					normal /= length;
+
+					Quadric quadric{};
+					quadric.addPlane(normal, -glm::dot(normal, p0), length * 0.5);
+					for (uint32_t g : triangle)
+						m_quadrics[g] += quadric;
+				}
+			}
+
+			// an edge used by one triangle is an open border, by more than two a non-manifold junction. both ends of
+			//   such edges stay in place, which keeps silhouettes and holes intact
+			void lockBorders()
+			{
+				std::unordered_map<uint64_t, uint32_t> edgeUse{};
+				for (const auto &triangle : m_triangles)
+				{
+					for (int k = 0; k < 3; k++)
+						edgeUse[edgeKey(triangle[k], triangle[(k + 1) % 3])]++;
+				}
+				for (const auto &[key, uses] : edgeUse)
+				{
+					if (uses == 2) continue;
+					m_locked[static_cast<uint32_t>(key >> 32)] = true;
+					m_locked[static_cast<uint32_t>(key)] = true;
+				}
+			}
+
+			static uint64_t edgeKey(uint32_t a, uint32_t b)
+			{
+				if (a > b) std::swap(a, b);
+				return (static_cast<uint64_t>(a) << 32) | b;
+			}
+
+			template <typename Queue>
+			void pushCandidate(Queue &queue, uint32_t a, uint32_t b)
+			{
+				Quadric merged = m_quadrics[a];
+				merged += m_quadrics[b];
+				double costAB = m_locked[a] ? INFINITY : merged.error(m_positions[b]);
+				double costBA = m_locked[b] ? INFINITY : merged.error(m_positions[a]);
+				if (std::isinf(costAB) && std::isinf(costBA))
+					return;
+
+				if (costAB <= costBA)
+					queue.push({ costAB, a, b, m_version[a], m_version[b] });
+				else
+					queue.push({ costBA, b, a, m_version[b], m_version[a] });
+			}
+
+			bool canCollapse(uint32_t from, uint32_t to) const
+			{
+				// link condition: the two ends may only share the neighbours of the triangles on the edge itself,
+				//   anything more would pinch the surface into a non-manifold edge
+				std::vector<uint32_t> fromNeighbours{}, toNeighbours{};
+				size_t sharedTriangles = 0;
+				for (uint32_t t : m_groupTriangles[from])
+				{
+					if (!m_triangleAlive[t]) continue;
+					bool shared = false;
+					for (uint32_t g : m_triangles[t])
+					{
+						if (g == to) shared = true;
+						if (g != from) fromNeighbours.push_back(g);
+					}
+					if (shared) sharedTriangles++;
+				}
+				if (sharedTriangles == 0)
+					return false; // the edge no longer exists
+				for (uint32_t t : m_groupTriangles[to])
+				{
+					if (!m_triangleAlive[t]) continue;
+					for (uint32_t g : m_triangles[t])
+						if (g != to) toNeighbours.push_back(g);
+				}
+				std::sort(fromNeighbours.begin(), fromNeighbours.end());
+				fromNeighbours.erase(std::unique(fromNeighbours.begin(), fromNeighbours.end()), fromNeighbours.end());
+				std::sort(toNeighbours.begin(), toNeighbours.end());
+				toNeighbours.erase(std::unique(toNeighbours.begin(), toNeighbours.end()), toNeighbours.end());
+				size_t common = 0;
+				for (uint32_t g : fromNeighbours)
+					common += std::binary_search(toNeighbours.begin(), toNeighbours.end(), g) ? 1 : 0;
+				if (common > sharedTriangles)
+					return false;
+
+				// no remaining triangle around from may flip or collapse to zero area
+				for (uint32_t t : m_groupTriangles[from])
+				{
+					if (!m_triangleAlive[t]) continue;
+					const auto &triangle = m_triangles[t];
+					if (triangle[0] == to || triangle[1] == to || triangle[2] == to) continue;
+
+					glm::dvec3 before[3], after[3];
+					for (int k = 0; k < 3; k++)
+					{
+						before[k] = m_positions[triangle[k]];
+						after[k] = triangle[k] == from ? m_positions[to] : before[k];
+					}
+					glm::dvec3 normalBefore = glm::cross(before[1] - before[0], before[2] - before[0]);
+					glm::dvec3 normalAfter = glm::cross(after[1] - after[0], after[2] - after[0]);
+					if (glm::dot(normalBefore, normalAfter) <= 0.0)
+						return false;
+				}
+				return true;
+			}
+
+			void applyCollapse(uint32_t from, uint32_t to)
+			{
+				for (uint32_t t : m_groupTriangles[from])
+				{
+					if (!m_triangleAlive[t]) continue;
+					auto &triangle = m_triangles[t];
+					if (triangle[0] == to || triangle[1] == to || triangle[2] == to)
+					{
+						m_triangleAlive[t] = false;
+						m_liveTriangles--;
+						continue;
+					}
+					for (auto &g : triangle)
+						if (g == from) g = to;
+					m_groupTriangles[to].push_back(t);
+				}
+				m_groupTriangles[from].clear();
+				m_quadrics[to] += m_quadrics[from];
+				m_remap[from] = to;
+				m_version[to]++;
+			}
+
+			// the corner's own vertex if its position did not move, else the closest match at the new position. ties go to
+			//   the candidate nearest in the vertex buffer, which keeps the LOD's index ranges as tight as the source's
+			uint32_t pickVertex(uint32_t vertex, uint32_t group) const
+			{
+				if (m_groupOf[vertex] == group)
+					return vertex;
+
+				uint32_t best = m_groupVertices[m_groupVertexOffsets[group]];
+				float bestDistance = std::numeric_limits<float>::max();
+				uint32_t bestGap = std::numeric_limits<uint32_t>::max();
+				for (uint32_t i = m_groupVertexOffsets[group]; i < m_groupVertexOffsets[group + 1]; i++)
+				{
+					uint32_t candidate = m_groupVertices[i];
+					float distance = attributeDistance(m_vertices[vertex], m_vertices[candidate]);
+					uint32_t gap = candidate > vertex ? candidate - vertex : vertex - candidate;
+					if (distance < bestDistance || (distance == bestDistance && gap < bestGap))
+					{
+						bestDistance = distance;
+						bestGap = gap;
+						best = candidate;
+					}
+				}
+				return best;
+			}
+
+			const skModel::Vertex *m_vertices;
+			size_t m_vertexCount;
+
+			std::vector<uint32_t> m_groupOf{};
+			std::vector<glm::dvec3> m_positions{};
+			std::vector<uint32_t> m_groupVertexOffsets{};
+			std::vector<uint32_t> m_groupVertices{};
+			std::vector<uint32_t> m_remap{};
+			std::vector<uint32_t> m_version{};
+			std::vector<bool> m_locked{};
+			std::vector<Quadric> m_quadrics{};
+			std::vector<std::vector<uint32_t>> m_groupTriangles{};
+
+			std::vector<std::array<uint32_t, 3>> m_triangles{}; // groups
+			std::vector<std::array<uint32_t, 3>> m_corners{};   // original vertices
+			std::vector<bool> m_triangleAlive{};
+			size_t m_liveTriangles = 0;
+		};
+	} // namespace
+
+	std::vector<uint32_t> skMeshSimplifier::simplify(
+		const skModel::Vertex *vertices, size_t vertexCount,
+		const uint32_t *indices, size_t indexCount,
+		size_t targetIndexCount, float targetError, float *resultError)
+	{
+		Simplifier simplifier{ vertices, vertexCount, indices, indexCount };
+		double targetErrorSquared = static_cast<double>(targetError) * targetError;
+		double error = simplifier.run(targetIndexCount / 3, targetErrorSquared);
+		if (resultError)
+			*resultError = static_cast<float>(std::sqrt(error));
+		return simplifier.output();
+	}
+} // namespace sk
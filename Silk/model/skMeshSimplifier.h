@@ -0,0 +1,31 @@
+#pragma once
+
+#include "skModel.h"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace sk
+{
+	/* Quadric error metric simplification (Garland & Heckbert 1997) used to build LOD chains at import.
+	 *   collapses run in position space, so vertices split only by their normal/uv (flat shading, uv seams) move
+	 *   together. every collapse moves a position onto one of its neighbours (half-edge collapse), so the result is an
+	 *   index buffer into the *same* vertices and every LOD can share one vertex buffer. corners that end up on a
+	 *   different position pick the vertex there whose attributes are closest to their own.
+	 *   open borders and non-manifold edges are locked, and collapses that would flip a triangle are rejected. */
+	class skMeshSimplifier
+	{
+	public:
+		// simplifies until at most targetIndexCount indices remain or the next collapse would exceed targetError.
+		//   resultError receives the largest error introduced, as an object space distance
+		static std::vector<uint32_t> simplify(
+			const skModel::Vertex *vertices, size_t vertexCount,
+			const uint32_t *indices, size_t indexCount,
+			size_t targetIndexCount,
+			float targetError = std::numeric_limits<float>::max(),
+			float *resultError = nullptr);
+	};
+} // namespace sk
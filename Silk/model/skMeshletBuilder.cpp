@@ -0,0 +1,163 @@
+#include "skMeshletBuilder.h"
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <tuple>
+
+namespace sk
+{
+	namespace
+	{
+		glm::vec3 triangleNormal(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2)
+		{
+			return glm::cross(p1 - p0, p2 - p0);
+		}
+
+		void computeBounds(const skModel::Vertex *vertices, const uint32_t *indices, int orientation, skModel::Meshlet &meshlet)
+		{
+			// sphere around the AABB center, cheap and within a few percent of the minimal one for meshlet sized clusters
+			glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+			glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+			for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i++)
+			{
+				boundsMin = glm::min(boundsMin, vertices[indices[i]].position);
+				boundsMax = glm::max(boundsMax, vertices[indices[i]].position);
+			}
+			meshlet.center = (boundsMin + boundsMax) * .5f;
+			float radiusSquared = 0.f;
+			for (uint32_t i = meshlet.firstIndex; i < meshlet.firstIndex + meshlet.indexCount; i++)
+			{
+				glm::vec3 d = vertices[indices[i]].position - meshlet.center;
+				radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+			}
+			meshlet.radius = std::sqrt(radiusSquared);
+
+			meshlet.coneAxis = glm::vec3{ 0.f, 0.f, 1.f };
+			meshlet.coneCutoff = 1.f;
+			if (orientation == 0)
+				return;
+
+			// axis = average face normal, cutoff = sin of the widest angle between it and any face normal
+			glm::vec3 normalSum{ 0.f };
+			for (uint32_t i = meshlet.firstIndex; i + 3 <= meshlet.firstIndex + meshlet.indexCount; i += 3)
+			{
+				glm::vec3 n = triangleNormal(vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position);
+				float length = glm::length(n);
+				if (length > 0.f)
+					normalSum += n / length;
+			}
+			float sumLength = glm::length(normalSum);
+			if (sumLength == 0.f)
+				return;
+			glm::vec3 axis = normalSum / sumLength;
+
+			float minDot = 1.f;
+			for (uint32_t i = meshlet.firstIndex; i + 3 <= meshlet.firstIndex + meshlet.indexCount; i += 3)
+			{
+				glm::vec3 n = triangleNormal(vertices[indices[i]].position, vertices[indices[i + 1]].position, vertices[indices[i + 2]].position);
+				float length = glm::length(n);
+				if (length > 0.f)
+					minDot = std::min(minDot, glm::dot(n / length, axis));
+			}
+			if (minDot <= 0.f)
+				return; // normals spread over more than a hemisphere, some face is always visible
+
+			meshlet.coneAxis = axis * static_cast<float>(orientation);
+			meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+		}
+	} // namespace
+
+	int skMeshletBuilder::closedOrientation(const skModel::Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount)
+	{
+		if (indexCount < 12)
+			return 0;
+
+		// position ids: vertices sorted by position, equal positions share the id of the first
+		std::vector<uint32_t> order(vertexCount);
+		std::iota(order.begin(), order.end(), 0u);
+		auto positionLess = [&](uint32_t a, uint32_t b) {
+			const glm::vec3 &pa = vertices[a].position, &pb = vertices[b].position;
+			return std::tie(pa.x, pa.y, pa.z) < std::tie(pb.x, pb.y, pb.z);
+		};
+		std::sort(order.begin(), order.end(), positionLess);
+		std::vector<uint32_t> positionId(vertexCount);
+		for (size_t i = 0; i < vertexCount; i++)
+		{
+			bool same = i > 0 && vertices[order[i]].position == vertices[order[i - 1]].position;
+			positionId[order[i]] = same ? positionId[order[i - 1]] : order[i];
+		}
+
+		// closed and consistently wound <=> every directed edge occurs exactly once and so does its reverse
+		std::vector<uint64_t> edges{};
+		edges.reserve(indexCount);
+		double volume = 0.0;
+		for (size_t i = 0; i + 3 <= indexCount; i += 3)
+		{
+			uint32_t ids[3] = { positionId[indices[i]], positionId[indices[i + 1]], positionId[indices[i + 2]] };
+			for (int k = 0; k < 3; k++)
+				edges.push_back((static_cast<uint64_t>(ids[k]) << 32) | ids[(k + 1) % 3]);
+
+			const glm::vec3 &p0 = vertices[indices[i]].position, &p1 = vertices[indices[i + 1]].position, &p2 = vertices[indices[i + 2]].position;
+			volume += glm::dot(glm::dvec3(p0), glm::cross(glm::dvec3(p1), glm::dvec3(p2)));
+		}
+		std::sort(edges.begin(), edges.end());
+		if (std::adjacent_find(edges.begin(), edges.end()) != edges.end())
+			return 0;
+		for (uint64_t edge : edges)
+		{
+			uint64_t reverse = (edge << 32) | (edge >> 32);
+			if (!std::binary_search(edges.begin(), edges.end(), reverse))
+				return 0;
+		}
+
+		if (volume == 0.0)
+			return 0;
+		return volume > 0.0 ? 1 : -1;
+	}
+
+	void skMeshletBuilder::build(const skModel::Vertex *vertices, const uint32_t *indices, uint32_t firstIndex,
+		uint32_t indexCount, int32_t vertexOffset, int orientation, std::vector<skModel::Meshlet> &meshlets)
+	{
+		// a linear scan over at most MAX_VERTICES entries beats any lookup structure at this size
+		uint32_t unique[MAX_VERTICES];
+		size_t uniqueCount = 0;
+		auto contains = [&](uint32_t vertex) { return std::find(unique, unique + uniqueCount, vertex) != unique + uniqueCount; };
+
+		skModel::Meshlet meshlet{};
+		meshlet.firstIndex = firstIndex;
+		meshlet.indexCount = 0;
+		meshlet.vertexOffset = vertexOffset;
+
+		for (uint32_t i = firstIndex; i + 3 <= firstIndex + indexCount; i += 3)
+		{
+			const uint32_t a = indices[i], b = indices[i + 1], c = indices[i + 2];
+			size_t newVertices = (contains(a) ? 0 : 1) + (b == a || contains(b) ? 0 : 1) + (c == a || c == b || contains(c) ? 0 : 1);
+
+			if (meshlet.indexCount > 0 &&
+				(uniqueCount + newVertices > MAX_VERTICES || meshlet.indexCount / 3 + 1 > MAX_TRIANGLES))
+			{
+				computeBounds(vertices, indices, orientation, meshlet);
+				meshlets.push_back(meshlet);
+				meshlet.firstIndex = i;
+				meshlet.indexCount = 0;
+				uniqueCount = 0;
+			}
+
+			for (uint32_t vertex : { a, b, c })
+			{
+				if (!contains(vertex))
+					unique[uniqueCount++] = vertex;
+			}
+			meshlet.indexCount += 3;
+		}
+
+		if (meshlet.indexCount > 0)
+		{
+			computeBounds(vertices, indices, orientation, meshlet);
+			meshlets.push_back(meshlet);
+		}
+	}
+} // namespace sk
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "skModel.h"
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace sk
+{
+	/* Splits index ranges into meshlets (clusters) for per-cluster culling with plain indexed draws.
+	 *   triangles are taken in index buffer order, which is already vertex cache (so also spatially) coherent after
+	 *   Builder::optimize, and a new meshlet starts whenever the next triangle would exceed either limit. every meshlet is
+	 *   therefore a contiguous index range and neighbouring visible meshlets can be merged into one draw.
+	 *   the normal cone follows meshoptimizer's convention: a meshlet faces away from a camera at c when
+	 *     dot(center - c, coneAxis) >= coneCutoff * length(center - c) + radius
+	 *   cones are only emitted for closed meshes, whose back faces are always hidden behind their front faces, so the
+	 *   test holds even with back face culling disabled in the pipeline. open meshes get coneCutoff = 1, which never culls. */
+	class skMeshletBuilder
+	{
+	public:
+		static constexpr size_t MAX_VERTICES = 64;
+		static constexpr size_t MAX_TRIANGLES = 124;
+
+		// +1 if the mesh is closed and its triangles wind counter-clockwise seen from outside (cross(p1 - p0, p2 - p0)
+		//   points out), -1 if closed and wound the other way, 0 if it has open or non-manifold edges. positions are compared
+		//   rather than vertex indices, so uv seams and hard edges do not count as borders
+		static int closedOrientation(const skModel::Vertex *vertices, size_t vertexCount, const uint32_t *indices, size_t indexCount);
+
+		// appends the meshlets of [firstIndex, firstIndex + indexCount) to meshlets. indices are absolute into vertices,
+		//   vertexOffset is only recorded for drawing. orientation comes from closedOrientation
+		static void build(const skModel::Vertex *vertices, const uint32_t *indices, uint32_t firstIndex,
+			uint32_t indexCount, int32_t vertexOffset, int orientation, std::vector<skModel::Meshlet> &meshlets);
+	};
+} // namespace sk
@@ -1,152 +1,449 @@
 #include "skModel.h"
-#include "skUtils.h"
+#include "skMeshCache.h"
+#include "skMeshletBuilder.h"
 
 // libs
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/hash.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/packing.hpp>
 
 // std
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstring>
 #include <iostream>
-#include <unordered_map>
+#include <limits>
 
-namespace std
+namespace sk
 {
-	template<>
-	struct hash<sk::skModel::Vertex>
+	namespace
 	{
-		size_t operator()(sk::skModel::Vertex const &vertex) const {
-			size_t seed = 0;
-			sk::hashCombine(seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-			return seed;
+		// packed attribute sizes, see skModel::VertexFormat
+		constexpr uint32_t PACKED_POSITION_SIZE = 8;
+		constexpr uint32_t PACKED_COLOR_SIZE = 4;
+		constexpr uint32_t PACKED_NORMAL_SIZE = 4;
+		constexpr uint32_t PACKED_UV_SIZE = 4;
+
+		// past this many submeshes the extra draws cost more than the halved index buffer saves, keep 32-bit indices
+		constexpr size_t MAX_SUBMESHES = 32;
+
+		// greedy split of [firstIndex, firstIndex + indexCount) in index buffer order: a triangle joins the current submesh
+		//   as long as the submesh's vertex range stays within SHORT_INDEX_RANGE. vertices are in first-use order after
+		//   Builder::optimize, so ranges stay tight and no vertex has to be duplicated
+		std::vector<skModel::Submesh> splitForShortIndices(const uint32_t *indices, uint32_t firstIndex, uint32_t indexCount)
+		{
+			std::vector<skModel::Submesh> submeshes{};
+			skModel::Submesh current{ firstIndex, 0, 0 };
+			uint32_t low = std::numeric_limits<uint32_t>::max(), high = 0;
+			for (uint32_t i = firstIndex; i + 3 <= firstIndex + indexCount; i += 3)
+			{
+				uint32_t triangleLow = std::min({ indices[i], indices[i + 1], indices[i + 2] });
+				uint32_t triangleHigh = std::max({ indices[i], indices[i + 1], indices[i + 2] });
+				uint32_t newLow = std::min(low, triangleLow), newHigh = std::max(high, triangleHigh);
+				if (current.indexCount > 0 && newHigh - newLow >= skModel::SHORT_INDEX_RANGE)
+				{
+					current.vertexOffset = static_cast<int32_t>(low);
+					submeshes.push_back(current);
+					current = { i, 0, 0 };
+					newLow = triangleLow;
+					newHigh = triangleHigh;
+				}
+				low = newLow;
+				high = newHigh;
+				current.indexCount += 3;
+			}
+			current.vertexOffset = static_cast<int32_t>(low);
+			submeshes.push_back(current);
+			return submeshes;
 		}
-	};
-}
 
-namespace sk
-{
-	skModel::skModel(skDevice& device, const skModel::Builder &builder)
-		: m_Device(device)
+		// contents of the stride 0 defaults binding: white, +z (octahedral 0,0) and a zero uv
+		struct PackedDefaults
+		{
+			uint32_t color;
+			uint32_t normal;
+			uint32_t uv;
+		};
+
+		// octahedral mapping of a unit vector onto [-1, 1]^2, a zero vector maps to +z
+		glm::vec2 octahedralEncode(const glm::vec3& n)
+		{
+			float sum = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+			if (sum == 0.f)
+				return glm::vec2{ 0.f };
+
+			glm::vec2 e = glm::vec2{ n.x, n.y } / sum;
+			if (n.z < 0.f)
+			{
+				glm::vec2 s{ e.x >= 0.f ? 1.f : -1.f, e.y >= 0.f ? 1.f : -1.f };
+				e = (1.f - glm::abs(glm::vec2{ e.y, e.x })) * s;
+			}
+			return e;
+		}
+	} // namespace
+
+	skModel::skModel(skGeometryArena& arena, const skModel::Builder &builder, VertexFormat format)
+		: skModel(
+			arena,
+			builder.vertices.data(), static_cast<uint32_t>(builder.vertices.size()),
+			builder.indices.data(), static_cast<uint32_t>(builder.indices.size()),
+			VertexLayout{ format, builder.attributes },
+			builder.lods)
 	{
-		createVertexBuffers(builder.vertices);
-		createIndexBuffers(builder.indices);
 	}
 
-	skModel::~skModel() {}
+	skModel::skModel(skGeometryArena& arena, const Vertex *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount,
+		const VertexLayout &layout, const std::vector<Lod> &lods, const Bounds *bounds)
+		: m_arena(arena), m_layout(layout), m_lods(lods)
+	{
+		if (m_layout.format == VertexFormat::Full)
+			m_layout.attributes = VERTEX_ATTRIBUTE_ALL;
+		if (m_lods.empty())
+			m_lods = { Lod{ 0, indexCount, 0.f } };
+
+		m_bounds = bounds ? *bounds : computeBounds(vertices, vertexCount);
+		m_boundsCenter = m_bounds.center();
+		createVertexBuffers(vertices, vertexCount);
+		createIndexBuffers(indices, indexCount);
+		createMeshlets(vertices, indices);
+		if (m_layout.needsDefaults())
+			createDefaultsBuffer();
+		updatePlacement();
+	}
 
-	void skModel::bind(VkCommandBuffer commandBuffer)
+	skModel::~skModel()
 	{
-		VkBuffer buffers[] = { m_vertexBuffer->getBuffer() };
-		VkDeviceSize offsets[] = { 0 };
-		vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+		m_arena.free(m_vertexAllocation);
+		m_arena.free(m_indexAllocation);
+	}
+
+	bool skModel::isResident() const
+	{
+		if (!m_resident)
+			m_resident = m_arena.isResident(m_vertexAllocation) && m_arena.isResident(m_indexAllocation) && m_arena.isResident(m_defaultsAllocation);
+		return m_resident;
+	}
+
+	void skModel::updatePlacement()
+	{
+		const uint64_t generation = m_arena.generation();
+		if (m_placement.generation == generation)
+			return;
+
+		m_placement.generation = generation;
+		const skGeometryArena::Allocation vertices = m_arena.allocation(m_vertexAllocation);
+		m_placement.vertexBuffer = vertices.buffer;
+		m_placement.baseVertex = static_cast<int32_t>(vertices.offset);
+		if (m_defaultsAllocation != skGeometryArena::INVALID_HANDLE)
+		{
+			const skGeometryArena::Allocation defaults = m_arena.allocation(m_defaultsAllocation);
+			m_placement.defaultsBuffer = defaults.buffer;
+			m_placement.defaultsOffset = defaults.byteOffset();
+		}
+		if (m_hasIndexBuffer)
+		{
+			const skGeometryArena::Allocation indices = m_arena.allocation(m_indexAllocation);
+			m_placement.indexBuffer = indices.buffer;
+			m_placement.baseIndex = indices.offset;
+		}
+	}
+
+	void skModel::bind(VkCommandBuffer commandBuffer, skGeometryArena::BindState *bound)
+	{
+		skGeometryArena::BindState unbound{};
+		if (bound == nullptr)
+			bound = &unbound;
+
+		// the arena blocks are bound at offset 0, draws address the model through the placement's base vertex / index
+		const Placement &placement = this->placement();
+		VkBuffer vertexBuffer = placement.vertexBuffer;
+		if (vertexBuffer != bound->vertexBuffer)
+		{
+			VkDeviceSize offset = 0;
+			vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+			bound->vertexBuffer = vertexBuffer;
+		}
+
+		if (m_defaultsAllocation != skGeometryArena::INVALID_HANDLE)
+		{
+			VkBuffer defaultsBuffer = placement.defaultsBuffer;
+			VkDeviceSize offset = placement.defaultsOffset;
+			if (defaultsBuffer != bound->defaultsBuffer || offset != bound->defaultsOffset)
+			{
+				vkCmdBindVertexBuffers(commandBuffer, 1, 1, &defaultsBuffer, &offset);
+				bound->defaultsBuffer = defaultsBuffer;
+				bound->defaultsOffset = offset;
+			}
+		}
 
 		if (m_hasIndexBuffer)
 		{
 			// args: command buffer, index buffer(vkbuffer type), initial offset, vk type enum ---> this MUST match the type 
-			//    of the indices in the idx buffer VECTOR (not to be confused with the vkbuffer m_indexBuffer object, in this case uint32_t) 
-			vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+			//    of the indices uploaded into the arena (16 or 32 bit, see createIndexBuffers)
+			VkBuffer indexBuffer = placement.indexBuffer;
+			if (indexBuffer != bound->indexBuffer || m_indexType != bound->indexType)
+			{
+				vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, m_indexType);
+				bound->indexBuffer = indexBuffer;
+				bound->indexType = m_indexType;
+			}
 		}
 	}
 
-	void skModel::draw(VkCommandBuffer commandBuffer)
+	void skModel::draw(VkCommandBuffer commandBuffer, uint32_t lod)
 	{
 		if (m_hasIndexBuffer)
 		{
+			lod = std::min(lod, lodCount() - 1);
+			const uint32_t firstIndex = placement().baseIndex;
+			const int32_t vertexOffset = placement().baseVertex;
 			// args: command buffer, index count, instance count, first index, vertex offset, first instance
-			vkCmdDrawIndexed(commandBuffer, m_indexCount, 1, 0, 0, 0);
+			for (uint32_t i = m_lodSubmeshes[lod]; i < m_lodSubmeshes[lod + 1]; i++)
+			{
+				const Submesh &submesh = m_submeshes[i];
+				vkCmdDrawIndexed(commandBuffer, submesh.indexCount, 1, firstIndex + submesh.firstIndex, vertexOffset + submesh.vertexOffset, 0);
+			}
 		}
 		else
 		{
 			// args: vkCmdDraw(command buffer, vertex count, instance count, first vertex, first instance)
-			vkCmdDraw(commandBuffer, m_vertexCount, 1, 0, 0);
+			vkCmdDraw(commandBuffer, m_vertexCount, 1, static_cast<uint32_t>(placement().baseVertex), 0);
+		}
+	}
+
+	void skModel::drawMeshlets(VkCommandBuffer commandBuffer, uint32_t lod, const uint8_t *visible)
+	{
+		lod = std::min(lod, lodCount() - 1);
+		std::span<const Meshlet> lodMeshlets = meshlets(lod);
+		const uint32_t firstIndex = placement().baseIndex;
+		const int32_t vertexOffset = placement().baseVertex;
+
+		// runs of visible meshlets are contiguous in the index buffer, so each run is a single draw
+		for (size_t i = 0; i < lodMeshlets.size();)
+		{
+			if (!visible[i])
+			{
+				i++;
+				continue;
+			}
+
+			const Meshlet &first = lodMeshlets[i];
+			uint32_t indexCount = first.indexCount;
+			for (i++; i < lodMeshlets.size() && visible[i] && lodMeshlets[i].vertexOffset == first.vertexOffset &&
+				lodMeshlets[i].firstIndex == first.firstIndex + indexCount; i++)
+				indexCount += lodMeshlets[i].indexCount;
+			vkCmdDrawIndexed(commandBuffer, indexCount, 1, firstIndex + first.firstIndex, vertexOffset + first.vertexOffset, 0);
 		}
 	}
 
-	std::unique_ptr<skModel> skModel::createModelFromFile(skDevice& device, const std::string& filepath)
+	std::unique_ptr<skModel> skModel::createModelFromFile(skGeometryArena& arena, const std::string& filepath, VertexFormat format)
 	{
+		// fast path: a fresh .skmesh is mapped and uploaded as-is, no parsing and no vertex dedup
+		skMeshCache cache{};
+		if (cache.open(filepath))
+		{
+			VertexLayout layout{ format, cache.header().attributes };
+			std::cout << "Vertex count for " << filepath << " : " << cache.vertexCount() << " (mesh cache, "
+				<< layout.stride() << " bytes per vertex, " << cache.lodCount() << " LODs)" << std::endl;
+			std::vector<Lod> lods(cache.lods(), cache.lods() + cache.lodCount());
+			const Bounds bounds = cache.bounds();
+			return std::make_unique<skModel>(arena, cache.vertices(), cache.vertexCount(), cache.indices(), cache.indexCount(), layout, lods,
+				&bounds);
+		}
+
 		Builder builder{};
 		builder.loadModel(filepath);
-		std::cout << "Vertex count for " << filepath << " : " << builder.vertices.size() << std::endl;
-		return std::make_unique<skModel>(device, builder);
+		OptimizationReport report = builder.optimize();
+		builder.generateLods();
+		std::cout << "Vertex count for " << filepath << " : " << builder.vertices.size()
+			<< " (ACMR " << report.before.acmr << " -> " << report.after.acmr
+			<< ", ATVR " << report.before.atvr << " -> " << report.after.atvr
+			<< ", " << VertexLayout{ format, builder.attributes }.stride() << " bytes per vertex)" << std::endl;
+		for (size_t i = 0; i < builder.lods.size(); i++)
+			std::cout << "  LOD " << i << " : " << builder.lods[i].indexCount / 3 << " triangles, error " << builder.lods[i].error << std::endl;
+
+		if (!skMeshCache::write(filepath, builder))
+			std::cerr << "Could not write mesh cache " << skMeshCache::cachePathFor(filepath) << std::endl;
+
+		return std::make_unique<skModel>(arena, builder, format);
 	}
 
-	/* the createVertexBuffers and createIndexBuffers functions' purpose is to write data to the device's (GPU's) memory
-	      the data is also "linked" between the host (CPU) and the device via the vkMapMemory function call, such that when we use
-		  memcpy to write to the CPU memory, the same information will also be flushed to the corresponding (linked) gpu memory. */
-	void skModel::createVertexBuffers(const std::vector<Vertex>& vertices)
+	/* the createVertexBuffers and createIndexBuffers functions' purpose is to write data to the device's (GPU's) memory.
+	      both suballocate from the geometry arena, which records the copies into its device local blocks through the
+		  upload context's staging ring. */
+	void skModel::createVertexBuffers(const Vertex *vertices, uint32_t vertexCount)
 	{
-		m_vertexCount = static_cast<uint32_t>(vertices.size());
+		m_vertexCount = vertexCount;
 		assert(m_vertexCount >= 3 && "Vertex count must be at least 3");
-		VkDeviceSize bufferSize = sizeof(vertices[0]) * m_vertexCount;
-		uint32_t vertexSize = sizeof(vertices[0]);
-
-		// staging (temp) buffer that will be used to 1) receive data from CPU and 2) transfer data to a more optimized gpu memory type
-		//  that can't normally receive data directly from CPU.
-		skBuffer stagingBuffer{
-			m_Device,
-			vertexSize,
-			m_vertexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
 
-		// Copy data from CPU to staging buffer in GPU
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)vertices.data());
-
-		// Create vertex buffer (smart ptr)
-		m_vertexBuffer = std::make_unique<skBuffer>(
-			m_Device,
-			vertexSize,
-			m_vertexCount,
-			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT // this gpu memory type is more optimized and efficient than used in previous tutorials
-			);
-		
-		// Copy contents from staging buffer to optimized device buffer
-		m_Device.copyBuffer(stagingBuffer.getBuffer(), m_vertexBuffer->getBuffer(), bufferSize);
+		// the packed format is encoded on the host first, the full one is uploaded straight from the caller's memory
+		std::vector<unsigned char> packed{};
+		const void *vertexData = vertices;
+		if (m_layout.format == VertexFormat::Packed)
+		{
+			packed = packVertices(vertices, vertexCount);
+			vertexData = packed.data();
+		}
+
+		m_vertexAllocation = m_arena.allocateVertices(m_layout.stride(), m_vertexCount, vertexData);
+	}
+
+	skModel::Bounds skModel::computeBounds(const Vertex *vertices, uint32_t vertexCount)
+	{
+		Bounds bounds{};
+		if (vertexCount == 0)
+			return bounds;
+
+		// centered on the AABB, not minimal but within a few percent for typical meshes and a single pass over the vertices
+		bounds.min = glm::vec3{ std::numeric_limits<float>::max() };
+		bounds.max = glm::vec3{ std::numeric_limits<float>::lowest() };
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			bounds.min = glm::min(bounds.min, vertices[i].position);
+			bounds.max = glm::max(bounds.max, vertices[i].position);
+		}
+		const glm::vec3 center = bounds.center();
+
+		float radiusSquared = 0.f;
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			glm::vec3 d = vertices[i].position - center;
+			radiusSquared = std::max(radiusSquared, glm::dot(d, d));
+		}
+		bounds.radius = std::sqrt(radiusSquared);
+		return bounds;
+	}
+
+	std::vector<unsigned char> skModel::packVertices(const Vertex *vertices, uint32_t vertexCount)
+	{
+		// quantized against the AABB computeBounds (or the mesh cache) already found
+		const glm::vec3 boundsMin = m_bounds.min;
+		glm::vec3 extent = m_bounds.max - boundsMin;
+		for (int axis = 0; axis < 3; axis++)
+			if (extent[axis] <= 0.f) extent[axis] = 1.f; // flat along this axis (e.g. quad.obj), any scale works
+
+		// p = boundsMin + quantized * extent
+		m_positionDequantize = glm::mat4{ 1.f };
+		m_positionDequantize[0][0] = extent.x;
+		m_positionDequantize[1][1] = extent.y;
+		m_positionDequantize[2][2] = extent.z;
+		m_positionDequantize[3] = glm::vec4{ boundsMin, 1.f };
+
+		const uint32_t stride = m_layout.stride();
+		std::vector<unsigned char> packed(static_cast<size_t>(stride) * vertexCount);
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			const Vertex &vertex = vertices[i];
+			unsigned char *out = packed.data() + static_cast<size_t>(i) * stride;
+
+			uint64_t position = glm::packUnorm4x16(glm::vec4{ (vertex.position - boundsMin) / extent, 0.f });
+			std::memcpy(out, &position, PACKED_POSITION_SIZE);
+			out += PACKED_POSITION_SIZE;
+
+			if (m_layout.attributes & VERTEX_ATTRIBUTE_COLOR)
+			{
+				uint32_t color = glm::packUnorm4x8(glm::vec4{ vertex.color, 1.f });
+				std::memcpy(out, &color, PACKED_COLOR_SIZE);
+				out += PACKED_COLOR_SIZE;
+			}
+			if (m_layout.attributes & VERTEX_ATTRIBUTE_NORMAL)
+			{
+				uint32_t normal = glm::packSnorm2x16(octahedralEncode(vertex.normal));
+				std::memcpy(out, &normal, PACKED_NORMAL_SIZE);
+				out += PACKED_NORMAL_SIZE;
+			}
+			if (m_layout.attributes & VERTEX_ATTRIBUTE_UV)
+			{
+				uint32_t uv = glm::packHalf2x16(vertex.uv);
+				std::memcpy(out, &uv, PACKED_UV_SIZE);
+			}
+		}
+		return packed;
+	}
+
+	void skModel::createDefaultsBuffer()
+	{
+		PackedDefaults defaults{};
+		defaults.color = glm::packUnorm4x8(glm::vec4{ 1.f });
+		defaults.normal = glm::packSnorm2x16(glm::vec2{ 0.f });
+		defaults.uv = glm::packHalf2x16(glm::vec2{ 0.f });
+
+		// 12 bytes read with stride 0. identical for every packed model, so the arena keeps a single copy
+		m_defaultsAllocation = m_arena.allocateShared(&defaults, sizeof(PackedDefaults));
 	}
 
 	/* see comment on createVertexBuffers function */
-	void skModel::createIndexBuffers(const std::vector<uint32_t>& indices)
+	void skModel::createIndexBuffers(const uint32_t *indices, uint32_t indexCount)
 	{
-		m_indexCount = static_cast<uint32_t>(indices.size());
+		m_indexCount = indexCount;
 		m_hasIndexBuffer = m_indexCount > 0;
 
+		// one submesh per LOD by default, i.e. the LOD ranges themselves with 32-bit indices
+		m_submeshes.clear();
+		m_lodSubmeshes = { 0 };
+		for (const auto& lod : m_lods)
+		{
+			m_submeshes.push_back(Submesh{ lod.firstIndex, lod.indexCount, 0 });
+			m_lodSubmeshes.push_back(static_cast<uint32_t>(m_submeshes.size()));
+		}
+
 		if (!m_hasIndexBuffer)
 			return;
 
 		assert(m_indexCount >= 3 && "Vertex count must be at least 3");
-		VkDeviceSize bufferSize = sizeof(indices[0]) * m_indexCount;
-		uint32_t indexSize = sizeof(indices[0]);
-
-		// staging (temp) buffer that will be used to 1) receive data from CPU and 2) transfer data to a more optimized gpu memory type
-		//  that can't normally receive data directly from CPU
-		skBuffer stagingBuffer{
-			m_Device,
-			indexSize,
-			m_indexCount,
-			VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT
-		};
-		
-		// Copy data from CPU to staging buffer in GPU
-		stagingBuffer.map();
-		stagingBuffer.writeToBuffer((void*)indices.data());
 
-		// Create index buffer (smart ptr)
-		m_indexBuffer = std::make_unique<skBuffer>(
-			m_Device,
-			indexSize,
-			m_indexCount,
-			VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT // this gpu memory type is more optimized and efficient than used in previous tutorials
-		);
+		// 16-bit indices whenever every LOD splits into few enough submeshes, rebased on the submesh's vertex offset
+		m_indexType = VK_INDEX_TYPE_UINT32;
+		std::vector<uint16_t> shortIndices{};
+		std::vector<Submesh> submeshes{};
+		std::vector<uint32_t> lodSubmeshes{ 0 };
+		bool fitsShortIndices = true;
+		for (const auto& lod : m_lods)
+		{
+			auto split = m_vertexCount <= SHORT_INDEX_RANGE ? std::vector<Submesh>{ Submesh{ lod.firstIndex, lod.indexCount, 0 } }
+				: splitForShortIndices(indices, lod.firstIndex, lod.indexCount);
+			fitsShortIndices = fitsShortIndices && split.size() <= MAX_SUBMESHES;
+			submeshes.insert(submeshes.end(), split.begin(), split.end());
+			lodSubmeshes.push_back(static_cast<uint32_t>(submeshes.size()));
+		}
+		if (fitsShortIndices)
+		{
+			m_submeshes = std::move(submeshes);
+			m_lodSubmeshes = std::move(lodSubmeshes);
+			m_indexType = VK_INDEX_TYPE_UINT16;
+			shortIndices.resize(m_indexCount);
+			for (const auto& submesh : m_submeshes)
+			{
+				for (uint32_t i = submesh.firstIndex; i < submesh.firstIndex + submesh.indexCount; i++)
+					shortIndices[i] = static_cast<uint16_t>(indices[i] - submesh.vertexOffset);
+			}
+		}
 
-		// copy staging buffer into optimized device buffer
-		m_Device.copyBuffer(stagingBuffer.getBuffer(), m_indexBuffer->getBuffer(), bufferSize);
+		const void *indexData = m_indexType == VK_INDEX_TYPE_UINT16 ? static_cast<const void*>(shortIndices.data()) : indices;
+		m_indexAllocation = m_arena.allocateIndices(m_indexType, m_indexCount, indexData);
+	}
+
+	void skModel::createMeshlets(const Vertex *vertices, const uint32_t *indices)
+	{
+		m_meshlets.clear();
+		m_lodMeshlets = { 0 };
+		if (!m_hasIndexBuffer)
+		{
+			m_lodMeshlets.resize(m_lods.size() + 1, 0);
+			return;
+		}
+
+		for (size_t lod = 0; lod < m_lods.size(); lod++)
+		{
+			// per level, a coarse LOD may have collapsed into something that is no longer closed
+			int orientation = skMeshletBuilder::closedOrientation(vertices, m_vertexCount, indices + m_lods[lod].firstIndex, m_lods[lod].indexCount);
+			for (uint32_t i = m_lodSubmeshes[lod]; i < m_lodSubmeshes[lod + 1]; i++)
+			{
+				const Submesh &submesh = m_submeshes[i];
+				skMeshletBuilder::build(vertices, indices, submesh.firstIndex, submesh.indexCount, submesh.vertexOffset, orientation, m_meshlets);
+			}
+			m_lodMeshlets.push_back(static_cast<uint32_t>(m_meshlets.size()));
+		}
 	}
 
 	std::vector<VkVertexInputBindingDescription> skModel::Vertex::getBindingDescriptions()
@@ -181,64 +478,63 @@ namespace sk
 		return attributeDescriptions;
 	}
 
-	void skModel::Builder::loadModel(const std::string& filepath)
+	uint32_t skModel::VertexLayout::stride() const
 	{
-		tinyobj::attrib_t attrib;					// stores positions, colors, normals & texture coordinates
-		std::vector<tinyobj::shape_t> shapes;		// stores indices
-		std::vector<tinyobj::material_t> materials;
-		std::string warn, err;
-
-		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str())) {
-			throw std::runtime_error(warn + err);
-		}
+		if (format == VertexFormat::Full)
+			return sizeof(Vertex);
+
+		uint32_t size = PACKED_POSITION_SIZE;
+		if (attributes & VERTEX_ATTRIBUTE_COLOR) size += PACKED_COLOR_SIZE;
+		if (attributes & VERTEX_ATTRIBUTE_NORMAL) size += PACKED_NORMAL_SIZE;
+		if (attributes & VERTEX_ATTRIBUTE_UV) size += PACKED_UV_SIZE;
+		return size;
+	}
 
-		vertices.clear();
-		indices.clear();
+	std::vector<VkVertexInputBindingDescription> skModel::VertexLayout::getBindingDescriptions() const
+	{
+		if (format == VertexFormat::Full)
+			return Vertex::getBindingDescriptions();
 
-		std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-		for (const auto& shape : shapes) {
-			for (const auto& index : shape.mesh.indices) {
-				Vertex vertex{};
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
+		bindingDescriptions.push_back({ 0, stride(), VK_VERTEX_INPUT_RATE_VERTEX });
+		if (needsDefaults())
+			bindingDescriptions.push_back({ 1, 0, VK_VERTEX_INPUT_RATE_VERTEX }); // stride 0: every vertex reads the same defaults
+		return bindingDescriptions;
+	}
 
-				if (index.vertex_index >= 0)
-				{
-					vertex.position = {
-						attrib.vertices[3 * index.vertex_index + 0],
-						attrib.vertices[3 * index.vertex_index + 1],
-						attrib.vertices[3 * index.vertex_index + 2]
-					};
-
-					vertex.color = {
-						attrib.colors[3 * index.vertex_index + 0],
-						attrib.colors[3 * index.vertex_index + 1],
-						attrib.colors[3 * index.vertex_index + 2]
-					};
-				}
+	std::vector<VkVertexInputAttributeDescription> skModel::VertexLayout::getAttributeDescriptions() const
+	{
+		if (format == VertexFormat::Full)
+			return Vertex::getAttributeDescriptions();
 
-				if (index.normal_index >= 0)
-				{
-					vertex.normal = {
-						attrib.normals[3 * index.normal_index + 0],
-						attrib.normals[3 * index.normal_index + 1],
-						attrib.normals[3 * index.normal_index + 2]
-					};
-				}
+		// same locations as the full format, present attributes are packed back to back in binding 0,
+		//   absent ones point into the defaults binding
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+		uint32_t offset = 0;
+		attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R16G16B16A16_UNORM, offset });
+		offset += PACKED_POSITION_SIZE;
 
-				if (index.texcoord_index >= 0)
-				{
-					vertex.uv = {
-						attrib.texcoords[2 * index.texcoord_index + 0],
-						attrib.texcoords[2 * index.texcoord_index + 1]
-					};
-				}
+		if (attributes & VERTEX_ATTRIBUTE_COLOR)
+		{
+			attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R8G8B8A8_UNORM, offset });
+			offset += PACKED_COLOR_SIZE;
+		}
+		else
+			attributeDescriptions.push_back({ 1, 1, VK_FORMAT_R8G8B8A8_UNORM, offsetof(PackedDefaults, color) });
 
-				if (uniqueVertices.count(vertex) == 0) {
-					uniqueVertices[vertex] = static_cast<uint32_t>(vertices.size()); // clever way of determining index, size of vertices per iteration corresponds to unique index
-					vertices.push_back(vertex);
-				}
-				indices.push_back(uniqueVertices[vertex]);
-			}
+		if (attributes & VERTEX_ATTRIBUTE_NORMAL)
+		{
+			attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R16G16_SNORM, offset });
+			offset += PACKED_NORMAL_SIZE;
 		}
-	}
+		else
+			attributeDescriptions.push_back({ 2, 1, VK_FORMAT_R16G16_SNORM, offsetof(PackedDefaults, normal) });
 
+		if (attributes & VERTEX_ATTRIBUTE_UV)
+			attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R16G16_SFLOAT, offset });
+		else
+			attributeDescriptions.push_back({ 3, 1, VK_FORMAT_R16G16_SFLOAT, offsetof(PackedDefaults, uv) });
+
+		return attributeDescriptions;
+	}
 } // namespace sk
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 
 #include "core/skDevice.h"
-#include "skBuffer.h"
+#include "skGeometryArena.h"
+#include "skMeshOptimizer.h"
+#include "skObjParser.h"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -9,7 +11,9 @@
 #include <glm/glm.hpp>
 
 // std
+#include <cassert>
 #include <memory>
+#include <span>
 #include <vector>
 
 namespace sk
@@ -32,37 +36,199 @@ namespace sk
 			}
 		};
 
+		// attributes a mesh actually carries. positions are always present
+		enum VertexAttributeFlagBits : uint32_t {
+			VERTEX_ATTRIBUTE_COLOR = 1 << 0,
+			VERTEX_ATTRIBUTE_NORMAL = 1 << 1,
+			VERTEX_ATTRIBUTE_UV = 1 << 2,
+			VERTEX_ATTRIBUTE_ALL = VERTEX_ATTRIBUTE_COLOR | VERTEX_ATTRIBUTE_NORMAL | VERTEX_ATTRIBUTE_UV
+		};
+
+		// Full uploads Vertex as-is (44 bytes). Packed quantizes per mesh and leaves absent attributes out of the stream:
+		//   position	R16G16B16A16_UNORM, relative to the mesh AABB (undone by the matrix from positionDequantize())
+		//   color		R8G8B8A8_UNORM
+		//   normal		R16G16_SNORM, octahedral encoding (decoded in simple_shader_packed.vert)
+		//   uv			R16G16_SFLOAT
+		//   i.e. 8 to 20 bytes per vertex. absent attributes are read from a stride 0 binding holding their defaults.
+		enum class VertexFormat { Full, Packed };
+
+		struct VertexLayout {
+			VertexFormat format = VertexFormat::Full;
+			uint32_t attributes = VERTEX_ATTRIBUTE_ALL; // ignored by the full format, which always carries everything
+
+			uint32_t stride() const;
+			// meshes with equal keys can share a pipeline
+			uint32_t key() const { return format == VertexFormat::Full ? VERTEX_ATTRIBUTE_ALL + 1 : attributes; }
+			bool needsDefaults() const { return format == VertexFormat::Packed && attributes != VERTEX_ATTRIBUTE_ALL; }
+
+			std::vector<VkVertexInputBindingDescription> getBindingDescriptions() const;
+			std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions() const;
+		};
+
+		// one level of detail, a range of the shared index buffer over the shared vertex buffer. error is the simplifier's
+		//   deviation from the full mesh in object space units (0 for LOD 0), never smaller than the previous level's
+		struct Lod {
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			float error;
+		};
+
+		// the AABB of the vertex positions plus the radius of the sphere around its center that holds them all
+		struct Bounds {
+			glm::vec3 min{ 0.f };
+			glm::vec3 max{ 0.f };
+			float radius = 0.f;
+
+			glm::vec3 center() const { return (min + max) * .5f; }
+		};
+
 		// temporary helper object to hold vertices and indices of models
 		struct Builder {
 			std::vector<Vertex> vertices{};
 			std::vector<uint32_t> indices{};
+			// empty until generateLods, which appends every coarser level to indices
+			std::vector<Lod> lods{};
+			// what the source file provided (set by loadMesh), the packed format drops the rest
+			uint32_t attributes = VERTEX_ATTRIBUTE_ALL;
+			// 0 welds bit-identical vertices only, see skVertexWelder for what a positive epsilon does
+			float positionWeldEpsilon = 0.f;
+
+			// Parallel is the native multi-threaded reader (skObjParser), TinyObj the original single-threaded path.
+			//   both produce identical vertices/indices, Parallel falls back to tinyobj for polygons with more than 4 corners
+			enum class ObjReader { Parallel, TinyObj };
+
+			void loadModel(const std::string& filepath, ObjReader reader = ObjReader::Parallel);
+			// welds the triangle corners of mesh into unique vertices + indices
+			void loadMesh(const ObjMesh& mesh);
+			// reorders triangles for the post-transform cache (and optionally overdraw), then vertices into first-use
+			//   order. run after loading, before the builder is handed to skModel. throws if indices holds a partial triangle
+			OptimizationReport optimize(bool optimizeOverdraw = false);
+			// simplifies the mesh to each ratio of its triangle count (skMeshSimplifier) and appends the results as LODs.
+			//   run after optimize. stops early once a level no longer gets meaningfully smaller (e.g. mostly locked borders)
+			void generateLods(const std::vector<float>& ratios = { .5f, .25f, .125f });
+		};
+
+		// 16-bit indices address 65536 vertices relative to a submesh's base vertex
+		static constexpr uint32_t SHORT_INDEX_RANGE = 1u << 16;
+
+		// a range of the index buffer drawn with its own base vertex. meshes with more than SHORT_INDEX_RANGE vertices are
+		//   split into several so every submesh still fits 16-bit indices
+		struct Submesh {
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			int32_t vertexOffset;
+		};
 
-			void loadModel(const std::string& filepath);
+		// a cluster of at most skMeshletBuilder::MAX_VERTICES vertices and MAX_TRIANGLES triangles, contiguous in the index
+		//   buffer and never straddling a submesh. bounds and normal cone are in model space, see skMeshletBuilder
+		struct Meshlet {
+			glm::vec3 center;
+			float radius;
+			glm::vec3 coneAxis;
+			float coneCutoff;
+			uint32_t firstIndex;
+			uint32_t indexCount;
+			int32_t vertexOffset;
 		};
 
-		skModel(skDevice &device, const skModel::Builder &builder);
+		// vertices and indices are suballocated from arena, which must outlive the model
+		skModel(skGeometryArena &arena, const skModel::Builder &builder, VertexFormat format = VertexFormat::Full);
+		// uploads straight from caller owned memory (e.g. a memory mapped .skmesh). the full format copies nothing on the
+		//   host side, the packed one only its (smaller) encoded stream
+		//   no lods means a single level covering every index, no bounds means they are computed from the vertices
+		skModel(skGeometryArena &arena, const Vertex *vertices, uint32_t vertexCount, const uint32_t *indices, uint32_t indexCount,
+			const VertexLayout &layout, const std::vector<Lod> &lods = {}, const Bounds *bounds = nullptr);
 		~skModel();
 
 		// delete copy constructors to avoid dangling pointers
 		skModel(const skModel&) = delete;
 		skModel &operator=(const skModel&) = delete;
 
-		void bind(VkCommandBuffer commandBuffer);
-		void draw(VkCommandBuffer commandBuffer);
-
-		static std::unique_ptr<skModel> createModelFromFile(skDevice& device, const std::string& filepath);
+		// pass the command buffer's BindState to skip binds it already has, models in the same arena blocks share them
+		void bind(VkCommandBuffer commandBuffer, skGeometryArena::BindState *bound = nullptr);
+		void draw(VkCommandBuffer commandBuffer, uint32_t lod = 0);
+		// draws the meshlets of lod whose visible[i] is set (i relative to meshlets(lod)), merging adjacent ones into one draw
+		void drawMeshlets(VkCommandBuffer commandBuffer, uint32_t lod, const uint8_t *visible);
+
+		// false while the arena's upload context is still copying the model in, such a model must not be drawn yet
+		bool isResident() const;
+		// re-reads where the arena keeps the model if compact() moved allocations since. bind and draw use what it read,
+		//   so call it once per frame on one thread before recording (SimpleRenderSystem does)
+		void updatePlacement();
+		const VertexLayout &layout() const { return m_layout; }
+		// maps the packed [0, 1] positions back onto the mesh AABB, fold it into the model matrix. identity for the full format
+		const glm::mat4 &positionDequantize() const { return m_positionDequantize; }
+		VkDeviceSize vertexMemory() const { return static_cast<VkDeviceSize>(m_vertexCount) * m_layout.stride(); }
+		VkDeviceSize indexMemory() const { return static_cast<VkDeviceSize>(m_indexCount) * indexStride(); }
+		// compared to always storing 32-bit indices
+		VkDeviceSize indexMemorySaved() const { return static_cast<VkDeviceSize>(m_indexCount) * sizeof(uint32_t) - indexMemory(); }
+		VkIndexType indexType() const { return m_indexType; }
+		const std::vector<Submesh> &submeshes() const { return m_submeshes; }
+
+		uint32_t lodCount() const { return static_cast<uint32_t>(m_lods.size()); }
+		const Lod &lod(uint32_t index) const { return m_lods[index]; }
+		std::span<const Meshlet> meshlets(uint32_t lod) const
+		{
+			return { m_meshlets.data() + m_lodMeshlets[lod], m_lodMeshlets[lod + 1] - m_lodMeshlets[lod] };
+		}
+		// bounding sphere of the vertices in model space (before positionDequantize), for LOD selection and culling
+		const glm::vec3 &boundsCenter() const { return m_boundsCenter; }
+		float boundsRadius() const { return m_bounds.radius; }
+
+		// two passes over the positions, the .skmesh cache stores the result so cached loads skip them
+		static Bounds computeBounds(const Vertex *vertices, uint32_t vertexCount);
+
+		static std::unique_ptr<skModel> createModelFromFile(skGeometryArena& arena, const std::string& filepath, VertexFormat format = VertexFormat::Full);
 
 	private:
-		void createVertexBuffers(const std::vector<Vertex>& vertices);
-		void createIndexBuffers(const std::vector<uint32_t>& indices);
+		void createVertexBuffers(const Vertex *vertices, uint32_t vertexCount);
+		void createDefaultsBuffer();
+		std::vector<unsigned char> packVertices(const Vertex *vertices, uint32_t vertexCount);
+		void createIndexBuffers(const uint32_t *indices, uint32_t indexCount);
+		void createMeshlets(const Vertex *vertices, const uint32_t *indices);
+		uint32_t indexStride() const { return m_indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t); }
+
+		// where the arena kept this model as of the last updatePlacement, compaction may move it between frames. read by
+		//   every draw on the recording threads, which therefore never take the arena's lock
+		struct Placement
+		{
+			VkBuffer vertexBuffer = VK_NULL_HANDLE;
+			VkBuffer defaultsBuffer = VK_NULL_HANDLE;
+			VkDeviceSize defaultsOffset = 0;
+			VkBuffer indexBuffer = VK_NULL_HANDLE;
+			int32_t baseVertex = 0;
+			uint32_t baseIndex = 0;
+			uint64_t generation = ~0ull;	// skGeometryArena::generation it was read at
+		};
+
+		const Placement &placement() const
+		{
+			assert(m_placement.generation == m_arena.generation() && "Geometry arena compacted since, call updatePlacement first");
+			return m_placement;
+		}
+
+		skGeometryArena &m_arena;
 
-		skDevice &m_Device;
+		VertexLayout m_layout{};
+		glm::mat4 m_positionDequantize{ 1.f };
 
-		std::unique_ptr<skBuffer> m_vertexBuffer;
+		skGeometryArena::Handle m_vertexAllocation = skGeometryArena::INVALID_HANDLE;
 		uint32_t m_vertexCount;
+		skGeometryArena::Handle m_defaultsAllocation = skGeometryArena::INVALID_HANDLE; // backs the attributes a packed layout leaves out, shared
 
 		bool m_hasIndexBuffer = false;
-		std::unique_ptr<skBuffer> m_indexBuffer;
+		skGeometryArena::Handle m_indexAllocation = skGeometryArena::INVALID_HANDLE;
 		uint32_t m_indexCount;
+		VkIndexType m_indexType = VK_INDEX_TYPE_UINT32;
+		std::vector<Submesh> m_submeshes{};
+
+		std::vector<Lod> m_lods{};
+		std::vector<uint32_t> m_lodSubmeshes{}; // lod i draws m_submeshes [m_lodSubmeshes[i], m_lodSubmeshes[i + 1])
+		std::vector<Meshlet> m_meshlets{};
+		std::vector<uint32_t> m_lodMeshlets{}; // same scheme as m_lodSubmeshes
+		Bounds m_bounds{};
+		glm::vec3 m_boundsCenter{ 0.f };
+		mutable bool m_resident = false; // once resident a model stays so, caches the arena queries
+		Placement m_placement{};
 	};
 } // namespace sk
@@ -0,0 +1,164 @@
+#include "skModel.h"
+#include "skMeshSimplifier.h"
+#include "skVertexWelder.h"
+
+// libs
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+// skModel::Builder lives apart from the GPU side of skModel so the CPU only benchmarks (CMakeLists.txt) link without
+//   the Vulkan loader
+namespace sk
+{
+	namespace
+	{
+		// LOD N + 1 must cut at least this share of LOD N's triangles to be worth keeping
+		constexpr float MIN_LOD_REDUCTION = .1f;
+	} // namespace
+
+	void skModel::Builder::loadModel(const std::string& filepath, ObjReader reader)
+	{
+		ObjMesh mesh{};
+		if (reader == ObjReader::Parallel && skObjParser::parse(filepath, mesh))
+		{
+			loadMesh(mesh);
+			return;
+		}
+
+		tinyobj::attrib_t attrib;					// stores positions, colors, normals & texture coordinates
+		std::vector<tinyobj::shape_t> shapes;		// stores indices
+		std::vector<tinyobj::material_t> materials;
+		std::string warn, err;
+
+		if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, filepath.c_str())) {
+			throw std::runtime_error(warn + err);
+		}
+
+		// same flat layout as skObjParser's output, so both readers share the welding below
+		mesh = ObjMesh{};
+		mesh.positions = std::move(attrib.vertices);
+		mesh.colors = std::move(attrib.colors);
+		mesh.normals = std::move(attrib.normals);
+		mesh.texcoords = std::move(attrib.texcoords);
+		for (const auto& shape : shapes) {
+			for (const auto& index : shape.mesh.indices) {
+				mesh.corners.push_back({ index.vertex_index, index.normal_index, index.texcoord_index });
+			}
+		}
+
+		loadMesh(mesh);
+	}
+
+	void skModel::Builder::loadMesh(const ObjMesh& mesh)
+	{
+		vertices.clear();
+		indices.clear();
+		indices.reserve(mesh.corners.size());
+
+		// colors count as present only if the file set one that is not the default white
+		attributes = 0;
+		if (std::any_of(mesh.colors.begin(), mesh.colors.end(), [](float c) { return c != 1.f; }))
+			attributes |= VERTEX_ATTRIBUTE_COLOR;
+		if (std::any_of(mesh.corners.begin(), mesh.corners.end(), [](const ObjCorner& c) { return c.normal >= 0; }))
+			attributes |= VERTEX_ATTRIBUTE_NORMAL;
+		if (std::any_of(mesh.corners.begin(), mesh.corners.end(), [](const ObjCorner& c) { return c.texcoord >= 0; }))
+			attributes |= VERTEX_ATTRIBUTE_UV;
+
+		skVertexWelder welder{ vertices, mesh.corners.size(), positionWeldEpsilon };
+		for (const auto& corner : mesh.corners) {
+			Vertex vertex{};
+
+			if (corner.vertex >= 0)
+			{
+				vertex.position = {
+					mesh.positions[3 * corner.vertex + 0],
+					mesh.positions[3 * corner.vertex + 1],
+					mesh.positions[3 * corner.vertex + 2]
+				};
+
+				vertex.color = {
+					mesh.colors[3 * corner.vertex + 0],
+					mesh.colors[3 * corner.vertex + 1],
+					mesh.colors[3 * corner.vertex + 2]
+				};
+			}
+
+			if (corner.normal >= 0)
+			{
+				vertex.normal = {
+					mesh.normals[3 * corner.normal + 0],
+					mesh.normals[3 * corner.normal + 1],
+					mesh.normals[3 * corner.normal + 2]
+				};
+			}
+
+			if (corner.texcoord >= 0)
+			{
+				vertex.uv = {
+					mesh.texcoords[2 * corner.texcoord + 0],
+					mesh.texcoords[2 * corner.texcoord + 1]
+				};
+			}
+
+			indices.push_back(welder.weld(vertex));
+		}
+	}
+
+	OptimizationReport skModel::Builder::optimize(bool optimizeOverdraw)
+	{
+		OptimizationReport report{};
+		assert(lods.empty() && "optimize reorders the whole index buffer, run it before generateLods");
+		if (indices.empty())
+			return report;
+		if (indices.size() % 3 != 0)
+			throw std::runtime_error("index count " + std::to_string(indices.size()) + " is not a multiple of 3");
+
+		report.before = skMeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+
+		std::vector<uint32_t> clusters{};
+		skMeshOptimizer::optimizeVertexCache(indices.data(), indices.size(), vertices.size(), skMeshOptimizer::DEFAULT_CACHE_SIZE,
+			optimizeOverdraw ? &clusters : nullptr);
+		if (optimizeOverdraw)
+			skMeshOptimizer::optimizeOverdraw(indices.data(), indices.size(), clusters, &vertices[0].position, sizeof(Vertex));
+		vertices.resize(skMeshOptimizer::optimizeVertexFetch(vertices.data(), vertices.size(), sizeof(Vertex), indices.data(), indices.size()));
+
+		report.after = skMeshOptimizer::analyzeVertexCache(indices.data(), indices.size(), vertices.size());
+		return report;
+	}
+
+	void skModel::Builder::generateLods(const std::vector<float>& ratios)
+	{
+		lods.clear();
+		if (indices.empty())
+			return;
+
+		// every level is simplified from the full mesh rather than from the previous level, so each error is measured
+		//   against the original surface instead of accumulating
+		const uint32_t baseIndexCount = static_cast<uint32_t>(indices.size());
+		lods.push_back(Lod{ 0, baseIndexCount, 0.f });
+		for (float ratio : ratios)
+		{
+			size_t target = static_cast<size_t>(baseIndexCount * ratio) / 3 * 3;
+			float error = 0.f;
+			std::vector<uint32_t> lodIndices = skMeshSimplifier::simplify(vertices.data(), vertices.size(), indices.data(),
+				baseIndexCount, target, std::numeric_limits<float>::max(), &error);
+			if (lodIndices.empty() || lodIndices.size() > lods.back().indexCount * (1.f - MIN_LOD_REDUCTION))
+				break;
+
+			// the simplifier keeps LOD 0's triangle order, which is already cache friendly. re-sorting only pays off when the
+			//   whole mesh fits 16-bit indices: past that a fresh order spans the entire vertex buffer and the LOD could no
+			//   longer be split into short index submeshes
+			if (vertices.size() <= SHORT_INDEX_RANGE)
+				skMeshOptimizer::optimizeVertexCache(lodIndices.data(), lodIndices.size(), vertices.size());
+			lods.push_back(Lod{ static_cast<uint32_t>(indices.size()), static_cast<uint32_t>(lodIndices.size()), std::max(error, lods.back().error) });
+			indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+		}
+	}
+} // namespace sk
\ No newline at end of file
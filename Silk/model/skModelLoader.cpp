@@ -0,0 +1,118 @@
+#include "skModelLoader.h"
+
+// std
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+namespace sk
+{
+	skModelLoader::skModelLoader(skGeometryArena &arena, skUploadContext &uploader, uint32_t threadCount)
+		: m_arena{ arena }, m_uploader{ uploader }
+	{
+		if (threadCount == 0)
+			threadCount = std::clamp(std::thread::hardware_concurrency(), 2u, 5u) - 1;
+
+		m_workers.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_workers.emplace_back(&skModelLoader::workerLoop, this);
+	}
+
+	skModelLoader::~skModelLoader()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_stop = true;
+		}
+		m_requestAvailable.notify_all();
+
+		// a worker may be blocked on a full staging ring, which only this (the owning) thread can drain
+		for (;;)
+		{
+			{
+				std::lock_guard<std::mutex> lock{ m_mutex };
+				if (m_busyWorkers == 0)
+					break;
+			}
+			m_uploader.submit();
+			m_uploader.waitIdle();
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+		for (auto &worker : m_workers)
+			worker.join();
+	}
+
+	skModelLoader::Handle skModelLoader::load(const std::string &filepath, skModel::VertexFormat format)
+	{
+		auto request = std::make_shared<Request>();
+		request->filepath = filepath;
+		request->format = format;
+		{
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_queue.push_back(request);
+		}
+		m_requestAvailable.notify_one();
+		return Handle{ request };
+	}
+
+	void skModelLoader::update()
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		if ((m_queue.empty() && m_busyWorkers == 0) || m_uploader.stalled())
+			m_uploader.submit();
+		m_uploader.retire();
+
+		std::erase_if(m_uploading, [](const std::shared_ptr<Request> &request)
+			{
+				if (!request->model->isResident())
+					return false;
+				request->status.store(Status::Ready, std::memory_order_release);
+				return true;
+			});
+	}
+
+	uint32_t skModelLoader::pendingCount() const
+	{
+		std::lock_guard<std::mutex> lock{ m_mutex };
+		return static_cast<uint32_t>(m_queue.size() + m_uploading.size()) + m_busyWorkers;
+	}
+
+	void skModelLoader::workerLoop()
+	{
+		for (;;)
+		{
+			std::shared_ptr<Request> request{};
+			{
+				std::unique_lock<std::mutex> lock{ m_mutex };
+				m_requestAvailable.wait(lock, [this] { return m_stop || !m_queue.empty(); });
+				if (m_stop)
+					return;
+				request = std::move(m_queue.front());
+				m_queue.pop_front();
+				m_busyWorkers++;
+			}
+
+			std::shared_ptr<skModel> model{};
+			try
+			{
+				model = skModel::createModelFromFile(m_arena, request->filepath, request->format);
+			}
+			catch (const std::exception &e)
+			{
+				request->error = e.what();
+			}
+
+			std::lock_guard<std::mutex> lock{ m_mutex };
+			m_busyWorkers--;
+			if (model)
+			{
+				request->model = std::move(model);
+				request->status.store(Status::Uploading, std::memory_order_release);
+				m_uploading.push_back(std::move(request));
+			}
+			else
+				request->status.store(Status::Failed, std::memory_order_release);
+		}
+	}
+} // namespace sk
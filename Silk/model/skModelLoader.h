@@ -0,0 +1,96 @@
+#pragma once
+
+#include "skModel.h"
+#include "core/skUploadContext.h"
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace sk
+{
+	/* Loads models on worker threads so the render loop never waits on parsing, optimization or uploads.
+	 *   load() queues a file and returns a handle right away. a worker runs createModelFromFile (mesh cache or obj
+	 *   import), whose arena allocations record their copies into the upload context instead of waiting on the queue.
+	 *   update(), called once per frame by the thread owning the upload context, submits what the workers recorded,
+	 *   retires finished batches and marks a handle ready once its model is resident. until then draw nothing (or a
+	 *   placeholder) for it.
+	 *   the submit waits until every queued request has been recorded (or a worker stalls on a full staging ring), so a
+	 *   scene loaded in one go is uploaded in as few submits as the ring allows. */
+	class skModelLoader
+	{
+	public:
+		enum class Status { Queued, Uploading, Ready, Failed };
+
+	private:
+		struct Request
+		{
+			std::string filepath;
+			skModel::VertexFormat format;
+			std::atomic<Status> status{ Status::Queued };
+			std::shared_ptr<skModel> model{};	// written by the worker before status leaves Queued
+			std::string error{};
+		};
+
+	public:
+		// shared with the loader, stays valid after the loader is gone. copies refer to the same request
+		class Handle
+		{
+		public:
+			Handle() = default;
+
+			bool valid() const { return m_request != nullptr; }
+			Status status() const { return m_request->status.load(std::memory_order_acquire); }
+			bool ready() const { return valid() && status() == Status::Ready; }
+			bool failed() const { return valid() && status() == Status::Failed; }
+			// null until ready
+			std::shared_ptr<skModel> get() const { return ready() ? m_request->model : nullptr; }
+			const std::string &filepath() const { return m_request->filepath; }
+			// empty unless failed
+			const std::string &error() const { static const std::string none{}; return failed() ? m_request->error : none; }
+
+		private:
+			friend class skModelLoader;
+			explicit Handle(std::shared_ptr<Request> request) : m_request{ std::move(request) } {}
+
+			std::shared_ptr<Request> m_request{};
+		};
+
+		// arena must have been created with uploader, both must outlive the loader. threadCount 0 picks one from the
+		//   hardware, leaving a core for the render thread
+		skModelLoader(skGeometryArena &arena, skUploadContext &uploader, uint32_t threadCount = 0);
+		// drops queued requests (they stay Queued) and waits for the ones in progress
+		~skModelLoader();
+
+		skModelLoader(const skModelLoader&) = delete;
+		skModelLoader &operator=(const skModelLoader&) = delete;
+
+		Handle load(const std::string &filepath, skModel::VertexFormat format = skModel::VertexFormat::Full);
+		void update();
+
+		// requests not yet Ready or Failed
+		uint32_t pendingCount() const;
+		uint32_t threadCount() const { return static_cast<uint32_t>(m_workers.size()); }
+
+	private:
+		void workerLoop();
+
+		skGeometryArena &m_arena;
+		skUploadContext &m_uploader;
+		std::vector<std::thread> m_workers{};
+
+		mutable std::mutex m_mutex;
+		std::condition_variable m_requestAvailable;
+		std::deque<std::shared_ptr<Request>> m_queue{};
+		std::vector<std::shared_ptr<Request>> m_uploading{};	// waiting for residency, only update() promotes them
+		uint32_t m_busyWorkers = 0;
+		bool m_stop = false;
+	};
+} // namespace sk
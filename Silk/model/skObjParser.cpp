@@ -0,0 +1,440 @@
+#include "skObjParser.h"
+#include "skMappedFile.h"
+
+// std
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+namespace sk
+{
+	namespace
+	{
+		// below this a chunk is not worth a thread, small files like the ones in res/models parse on the calling thread
+		constexpr size_t MIN_CHUNK_SIZE = 1 << 20;
+		constexpr unsigned CHUNKS_PER_THREAD = 4;
+
+		enum CornerAttribute : uint32_t { ATTRIBUTE_VERTEX = 0, ATTRIBUTE_NORMAL = 1, ATTRIBUTE_TEXCOORD = 2 };
+
+		struct Chunk
+		{
+			const char *begin = nullptr;
+			const char *end = nullptr;
+
+			std::vector<float> positions{};
+			std::vector<float> colors{};
+			std::vector<float> normals{};
+			std::vector<float> texcoords{};
+
+			// polygons as parsed, before triangulation
+			std::vector<ObjCorner> polygonCorners{};
+			std::vector<uint32_t> polygonSizes{};
+			// negative (relative) indices are resolved against the chunk's own counters during the first pass. the ones
+			//   listed here still need the chunk's global base added: (corner << 2) | CornerAttribute
+			std::vector<uint32_t> relativeFixups{};
+			bool hasNgons = false;
+
+			size_t vertexBase = 0;
+			size_t normalBase = 0;
+			size_t texcoordBase = 0;
+			std::vector<ObjCorner> corners{};
+		};
+
+		// runs fn(0..count-1) over up to threadCount threads (the calling thread included), rethrows the first exception
+		template <typename F>
+		void parallelFor(size_t count, unsigned threadCount, F &&fn)
+		{
+			if (threadCount <= 1 || count <= 1)
+			{
+				for (size_t i = 0; i < count; i++)
+					fn(i);
+				return;
+			}
+
+			std::atomic<size_t> next{ 0 };
+			std::exception_ptr error{};
+			std::mutex errorMutex{};
+			auto worker = [&]() {
+				try
+				{
+					for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1))
+						fn(i);
+				}
+				catch (...)
+				{
+					std::lock_guard<std::mutex> lock{ errorMutex };
+					if (!error) error = std::current_exception();
+					next.store(count); // stop handing out work
+				}
+			};
+
+			std::vector<std::thread> workers{};
+			const size_t workerCount = std::min<size_t>(threadCount, count);
+			for (size_t t = 1; t < workerCount; t++)
+				workers.emplace_back(worker);
+			worker();
+			for (auto& thread : workers)
+				thread.join();
+
+			if (error)
+				std::rethrow_exception(error);
+		}
+
+		inline bool isSpace(char c) { return c == ' ' || c == '\t'; }
+
+		inline const char *skipSpace(const char *p, const char *end)
+		{
+			while (p < end && isSpace(*p)) ++p;
+			return p;
+		}
+
+		// parsed as double and narrowed, which is what tinyobj does with real_t = float
+		inline bool parseFloat(const char *&p, const char *end, float &out)
+		{
+			p = skipSpace(p, end);
+			if (p < end && *p == '+') ++p; // from_chars does not accept a leading '+'
+			double value = 0.0;
+			auto [ptr, ec] = std::from_chars(p, end, value);
+			if (ec != std::errc{})
+				return false;
+			out = static_cast<float>(value);
+			p = ptr;
+			return true;
+		}
+
+		inline int parseInt(const char *&p, const char *end)
+		{
+			if (p < end && *p == '+') ++p;
+			int value = 0;
+			auto [ptr, ec] = std::from_chars(p, end, value);
+			p = ptr;
+			return ec == std::errc{} ? value : 0;
+		}
+
+		inline const char *skipToDelimiter(const char *p, const char *end)
+		{
+			while (p < end && *p != '/' && !isSpace(*p)) ++p;
+			return p;
+		}
+
+		// mirrors tinyobj's fixIndex: 1-based positive indices, negative indices relative to the attributes read so far
+		inline int resolveIndex(int index, size_t localCount, bool allowZero, bool &relative, const char *what)
+		{
+			relative = false;
+			if (index > 0) return index - 1;
+			if (index == 0)
+			{
+				if (!allowZero) throw std::runtime_error(std::string("zero ") + what + " index in face");
+				return -1;
+			}
+			relative = true;
+			return static_cast<int>(localCount) + index;
+		}
+
+		void parseFace(const char *p, const char *end, Chunk &chunk)
+		{
+			const size_t localVertices = chunk.positions.size() / 3;
+			const size_t localNormals = chunk.normals.size() / 3;
+			const size_t localTexcoords = chunk.texcoords.size() / 2;
+			const size_t firstCorner = chunk.polygonCorners.size();
+
+			p = skipSpace(p, end);
+			while (p < end)
+			{
+				// v, v/vt, v//vn or v/vt/vn
+				int rawVertex = parseInt(p, end);
+				int rawNormal = 0, rawTexcoord = 0;
+				bool hasNormal = false, hasTexcoord = false;
+				p = skipToDelimiter(p, end);
+				if (p < end && *p == '/')
+				{
+					++p;
+					if (p < end && *p == '/')
+					{
+						++p;
+						rawNormal = parseInt(p, end);
+						hasNormal = true;
+						p = skipToDelimiter(p, end);
+					}
+					else
+					{
+						rawTexcoord = parseInt(p, end);
+						hasTexcoord = true;
+						p = skipToDelimiter(p, end);
+						if (p < end && *p == '/')
+						{
+							++p;
+							rawNormal = parseInt(p, end);
+							hasNormal = true;
+							p = skipToDelimiter(p, end);
+						}
+					}
+				}
+
+				const uint32_t cornerIndex = static_cast<uint32_t>(chunk.polygonCorners.size());
+				ObjCorner corner{};
+				bool relative = false;
+				corner.vertex = resolveIndex(rawVertex, localVertices, false, relative, "vertex");
+				if (relative) chunk.relativeFixups.push_back((cornerIndex << 2) | ATTRIBUTE_VERTEX);
+				if (hasNormal)
+				{
+					corner.normal = resolveIndex(rawNormal, localNormals, true, relative, "normal");
+					if (relative) chunk.relativeFixups.push_back((cornerIndex << 2) | ATTRIBUTE_NORMAL);
+				}
+				if (hasTexcoord)
+				{
+					corner.texcoord = resolveIndex(rawTexcoord, localTexcoords, true, relative, "texcoord");
+					if (relative) chunk.relativeFixups.push_back((cornerIndex << 2) | ATTRIBUTE_TEXCOORD);
+				}
+				chunk.polygonCorners.push_back(corner);
+
+				p = skipSpace(p, end);
+			}
+
+			const size_t cornerCount = chunk.polygonCorners.size() - firstCorner;
+			if (cornerCount < 3)
+			{
+				// degenerate face, tinyobj drops these too
+				while (!chunk.relativeFixups.empty() && (chunk.relativeFixups.back() >> 2) >= firstCorner)
+					chunk.relativeFixups.pop_back();
+				chunk.polygonCorners.resize(firstCorner);
+				return;
+			}
+			chunk.hasNgons |= cornerCount > 4;
+			chunk.polygonSizes.push_back(static_cast<uint32_t>(cornerCount));
+		}
+
+		void parseLine(const char *p, const char *end, Chunk &chunk)
+		{
+			p = skipSpace(p, end);
+			if (end - p < 2 || (p[0] != 'v' && p[0] != 'f'))
+				return;
+
+			if (p[0] == 'v' && isSpace(p[1]))
+			{
+				p += 2;
+				float x = 0.f, y = 0.f, z = 0.f;
+				parseFloat(p, end, x);
+				parseFloat(p, end, y);
+				parseFloat(p, end, z);
+				chunk.positions.insert(chunk.positions.end(), { x, y, z });
+
+				// optional vertex color, all three components or none
+				float r = 1.f, g = 1.f, b = 1.f;
+				if (!(parseFloat(p, end, r) && parseFloat(p, end, g) && parseFloat(p, end, b)))
+					r = g = b = 1.f;
+				chunk.colors.insert(chunk.colors.end(), { r, g, b });
+			}
+			else if (p[0] == 'v' && p[1] == 'n' && end - p > 2 && isSpace(p[2]))
+			{
+				p += 3;
+				float x = 0.f, y = 0.f, z = 0.f;
+				parseFloat(p, end, x);
+				parseFloat(p, end, y);
+				parseFloat(p, end, z);
+				chunk.normals.insert(chunk.normals.end(), { x, y, z });
+			}
+			else if (p[0] == 'v' && p[1] == 't' && end - p > 2 && isSpace(p[2]))
+			{
+				p += 3;
+				float u = 0.f, v = 0.f;
+				parseFloat(p, end, u);
+				parseFloat(p, end, v);
+				chunk.texcoords.insert(chunk.texcoords.end(), { u, v });
+			}
+			else if (p[0] == 'f' && isSpace(p[1]))
+			{
+				parseFace(p + 2, end, chunk);
+			}
+			// everything else (o, g, s, usemtl, mtllib, l, p, comments...) has no bearing on the triangle mesh
+		}
+
+		void parseChunk(Chunk &chunk)
+		{
+			const char *p = chunk.begin;
+			while (p < chunk.end)
+			{
+				const char *lineEnd = static_cast<const char*>(std::memchr(p, '\n', chunk.end - p));
+				if (lineEnd == nullptr) lineEnd = chunk.end;
+				const char *contentEnd = lineEnd;
+				if (contentEnd > p && contentEnd[-1] == '\r') --contentEnd;
+
+				parseLine(p, contentEnd, chunk);
+				p = lineEnd + 1;
+			}
+		}
+
+		void validateCorner(const ObjCorner &corner, size_t vertexCount, size_t normalCount, size_t texcoordCount)
+		{
+			if (corner.vertex < 0 || static_cast<size_t>(corner.vertex) >= vertexCount)
+				throw std::runtime_error("face references a vertex index out of bounds");
+			if (corner.normal >= 0 && static_cast<size_t>(corner.normal) >= normalCount)
+				throw std::runtime_error("face references a normal index out of bounds");
+			if (corner.texcoord >= 0 && static_cast<size_t>(corner.texcoord) >= texcoordCount)
+				throw std::runtime_error("face references a texcoord index out of bounds");
+		}
+
+		// same split rule and float arithmetic as tinyobj: cut the quad along its shorter diagonal
+		void triangulateQuad(const ObjCorner *quad, const std::vector<float> &positions, std::vector<ObjCorner> &out)
+		{
+			const float *v0 = &positions[3 * quad[0].vertex];
+			const float *v1 = &positions[3 * quad[1].vertex];
+			const float *v2 = &positions[3 * quad[2].vertex];
+			const float *v3 = &positions[3 * quad[3].vertex];
+
+			float e02x = v2[0] - v0[0];
+			float e02y = v2[1] - v0[1];
+			float e02z = v2[2] - v0[2];
+			float e13x = v3[0] - v1[0];
+			float e13y = v3[1] - v1[1];
+			float e13z = v3[2] - v1[2];
+
+			float sqr02 = e02x * e02x + e02y * e02y + e02z * e02z;
+			float sqr13 = e13x * e13x + e13y * e13y + e13z * e13z;
+
+			if (sqr02 < sqr13)
+				out.insert(out.end(), { quad[0], quad[1], quad[2], quad[0], quad[2], quad[3] });
+			else
+				out.insert(out.end(), { quad[0], quad[1], quad[3], quad[1], quad[2], quad[3] });
+		}
+
+		template <typename T>
+		void concatenate(std::vector<T> &dst, size_t offset, const std::vector<T> &src)
+		{
+			if (!src.empty())
+				std::memcpy(dst.data() + offset, src.data(), src.size() * sizeof(T));
+		}
+	} // namespace
+
+	bool skObjParser::parse(const std::string& filepath, ObjMesh& mesh, unsigned threadCount, size_t chunkCount)
+	{
+		skMappedFile file{};
+		if (!file.open(filepath))
+			throw std::runtime_error("failed to open file: " + filepath);
+
+		try
+		{
+			return parse(static_cast<const char*>(file.data()), file.size(), mesh, threadCount, chunkCount);
+		}
+		catch (const std::exception& e)
+		{
+			throw std::runtime_error(filepath + ": " + e.what());
+		}
+	}
+
+	bool skObjParser::parse(const char *data, size_t size, ObjMesh& mesh, unsigned threadCount, size_t chunkCount)
+	{
+		mesh = ObjMesh{};
+
+		if (threadCount == 0)
+			threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+		// split into line aligned chunks
+		if (chunkCount == 0)
+			chunkCount = std::min<size_t>(size / MIN_CHUNK_SIZE, threadCount * CHUNKS_PER_THREAD);
+		chunkCount = std::max<size_t>(1, std::min(chunkCount, size));
+		std::vector<Chunk> chunks(chunkCount);
+		const char *cursor = data;
+		const char *end = data + size;
+		for (size_t i = 0; i < chunkCount; i++)
+		{
+			const char *chunkEnd = i + 1 == chunkCount ? end : std::max(cursor, data + size * (i + 1) / chunkCount);
+			if (chunkEnd < end)
+			{
+				const char *newline = static_cast<const char*>(std::memchr(chunkEnd, '\n', end - chunkEnd));
+				chunkEnd = newline ? newline + 1 : end;
+			}
+			chunks[i].begin = cursor;
+			chunks[i].end = chunkEnd;
+			cursor = chunkEnd;
+		}
+
+		// pass 1: parse every chunk independently
+		parallelFor(chunkCount, threadCount, [&](size_t i) { parseChunk(chunks[i]); });
+
+		for (const auto& chunk : chunks)
+			if (chunk.hasNgons) return false;
+
+		// attribute bases of each chunk
+		size_t vertexCount = 0, normalCount = 0, texcoordCount = 0;
+		for (auto& chunk : chunks)
+		{
+			chunk.vertexBase = vertexCount;
+			chunk.normalBase = normalCount;
+			chunk.texcoordBase = texcoordCount;
+			vertexCount += chunk.positions.size() / 3;
+			normalCount += chunk.normals.size() / 3;
+			texcoordCount += chunk.texcoords.size() / 2;
+		}
+
+		mesh.positions.resize(vertexCount * 3);
+		mesh.colors.resize(vertexCount * 3);
+		mesh.normals.resize(normalCount * 3);
+		mesh.texcoords.resize(texcoordCount * 2);
+
+		// pass 2: gather attributes and make relative indices absolute
+		parallelFor(chunkCount, threadCount, [&](size_t i) {
+			Chunk &chunk = chunks[i];
+			concatenate(mesh.positions, chunk.vertexBase * 3, chunk.positions);
+			concatenate(mesh.colors, chunk.vertexBase * 3, chunk.colors);
+			concatenate(mesh.normals, chunk.normalBase * 3, chunk.normals);
+			concatenate(mesh.texcoords, chunk.texcoordBase * 2, chunk.texcoords);
+
+			for (uint32_t fixup : chunk.relativeFixups)
+			{
+				ObjCorner &corner = chunk.polygonCorners[fixup >> 2];
+				switch (fixup & 3)
+				{
+				case ATTRIBUTE_VERTEX: corner.vertex += static_cast<int>(chunk.vertexBase); break;
+				case ATTRIBUTE_NORMAL: corner.normal += static_cast<int>(chunk.normalBase); break;
+				case ATTRIBUTE_TEXCOORD: corner.texcoord += static_cast<int>(chunk.texcoordBase); break;
+				}
+			}
+
+			// the per chunk attribute arrays are no longer needed
+			chunk.positions = {};
+			chunk.colors = {};
+			chunk.normals = {};
+			chunk.texcoords = {};
+		});
+
+		// pass 3: validate and triangulate, quads need the merged positions
+		parallelFor(chunkCount, threadCount, [&](size_t i) {
+			Chunk &chunk = chunks[i];
+			chunk.corners.reserve(chunk.polygonCorners.size() * 3 / 2);
+
+			const ObjCorner *polygon = chunk.polygonCorners.data();
+			for (uint32_t polygonSize : chunk.polygonSizes)
+			{
+				for (uint32_t k = 0; k < polygonSize; k++)
+					validateCorner(polygon[k], vertexCount, normalCount, texcoordCount);
+
+				if (polygonSize == 3)
+					chunk.corners.insert(chunk.corners.end(), polygon, polygon + 3);
+				else
+					triangulateQuad(polygon, mesh.positions, chunk.corners);
+				polygon += polygonSize;
+			}
+			chunk.polygonCorners = {};
+		});
+
+		size_t cornerCount = 0;
+		std::vector<size_t> cornerOffsets(chunkCount);
+		for (size_t i = 0; i < chunkCount; i++)
+		{
+			cornerOffsets[i] = cornerCount;
+			cornerCount += chunks[i].corners.size();
+		}
+
+		mesh.corners.resize(cornerCount);
+		parallelFor(chunkCount, threadCount, [&](size_t i) { concatenate(mesh.corners, cornerOffsets[i], chunks[i].corners); });
+
+		return true;
+	}
+
+} // namespace sk
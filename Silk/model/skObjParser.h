@@ -0,0 +1,45 @@
+#pragma once
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace sk
+{
+	// one triangle corner, indices into the ObjMesh attribute arrays (-1 when the attribute is absent).
+	// same layout as tinyobj::index_t so both readers feed the same welding pass.
+	struct ObjCorner
+	{
+		int vertex = -1;
+		int normal = -1;
+		int texcoord = -1;
+	};
+
+	// flat, triangulated contents of an .obj file. attributes are tightly packed floats (3 per position, color
+	// and normal, 2 per texcoord). colors default to white for positions that do not carry one, like tinyobj.
+	struct ObjMesh
+	{
+		std::vector<float> positions{};
+		std::vector<float> colors{};
+		std::vector<float> normals{};
+		std::vector<float> texcoords{};
+		std::vector<ObjCorner> corners{};
+	};
+
+	/* Multi-threaded .obj reader.
+	 *   the file is memory-mapped and split into line-aligned chunks that are parsed in parallel, then indices are
+	 *   resolved and faces triangulated per chunk (also in parallel) and the chunks are concatenated in file order.
+	 *   output matches tinyobj::LoadObj with triangulation enabled: triangles are kept as-is and quads are split
+	 *   along their shorter diagonal. polygons with more than four corners need tinyobj's ear clipping, in that case
+	 *   parse() returns false and the caller is expected to fall back to tinyobj. */
+	class skObjParser
+	{
+	public:
+		// threadCount == 0 uses every hardware thread. chunkCount == 0 derives the chunks from the file size and thread
+		//   count, anything else forces that many (fewer if the file has fewer bytes), e.g. to exercise the merge on
+		//   small files. throws std::runtime_error on unreadable or malformed files.
+		static bool parse(const std::string& filepath, ObjMesh& mesh, unsigned threadCount = 0, size_t chunkCount = 0);
+		static bool parse(const char *data, size_t size, ObjMesh& mesh, unsigned threadCount = 0, size_t chunkCount = 0);
+	};
+} // namespace sk
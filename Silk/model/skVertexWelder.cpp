@@ -0,0 +1,89 @@
+#include "skVertexWelder.h"
+#include "skUtils.h"
+
+// std
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace sk
+{
+	namespace
+	{
+		constexpr uint32_t EMPTY_SLOT = std::numeric_limits<uint32_t>::max();
+		constexpr size_t VERTEX_WORDS = sizeof(skModel::Vertex) / sizeof(uint32_t);
+
+		static_assert(sizeof(skModel::Vertex) == 11 * sizeof(float), "skModel::Vertex must be tightly packed floats");
+
+		// keeps the load factor at or below 0.8 even if every corner turns out to be unique
+		size_t tableSizeFor(size_t maxVertices)
+		{
+			size_t size = 16;
+			while (size < maxVertices + maxVertices / 4 + 1)
+				size <<= 1;
+			return size;
+		}
+
+		inline glm::vec3 cellOf(const glm::vec3& position, float inverseEpsilon)
+		{
+			return glm::floor(position * inverseEpsilon);
+		}
+	} // namespace
+
+	skVertexWelder::skVertexWelder(std::vector<skModel::Vertex>& vertices, size_t maxVertices, float positionEpsilon)
+		: m_vertices(vertices)
+	{
+		if (maxVertices > EMPTY_SLOT)
+			throw std::runtime_error("too many vertices to weld into 32-bit indices");
+		if (positionEpsilon > 0.f)
+			m_inverseEpsilon = 1.f / positionEpsilon;
+
+		m_slots.assign(tableSizeFor(maxVertices), Slot{ 0, EMPTY_SLOT });
+		m_mask = m_slots.size() - 1;
+	}
+
+	uint64_t skVertexWelder::hash(const skModel::Vertex& vertex) const
+	{
+		skModel::Vertex key = vertex;
+		if (m_inverseEpsilon > 0.f)
+			key.position = cellOf(vertex.position, m_inverseEpsilon);
+
+		uint32_t words[VERTEX_WORDS];
+		std::memcpy(words, &key, sizeof(words));
+		for (size_t i = 0; i < VERTEX_WORDS; i++)
+			words[i] = (words[i] & 0x7fffffffu) == 0 ? 0 : words[i]; // -0.0 == +0.0, they must hash the same
+		return hashBytes(words, sizeof(words));
+	}
+
+	bool skVertexWelder::matches(const skModel::Vertex& stored, const skModel::Vertex& vertex) const
+	{
+		if (m_inverseEpsilon == 0.f)
+			return stored == vertex;
+
+		return cellOf(stored.position, m_inverseEpsilon) == cellOf(vertex.position, m_inverseEpsilon) &&
+			stored.color == vertex.color && stored.normal == vertex.normal && stored.uv == vertex.uv;
+	}
+
+	uint32_t skVertexWelder::weld(const skModel::Vertex& vertex)
+	{
+		const uint64_t h = hash(vertex);
+		const uint32_t tag = static_cast<uint32_t>(h >> 32);
+
+		// linear probing, the table always has free slots so this terminates
+		for (size_t slot = h & m_mask;; slot = (slot + 1) & m_mask)
+		{
+			Slot &entry = m_slots[slot];
+			if (entry.index == EMPTY_SLOT)
+			{
+				assert(m_vertices.size() + 1 < m_slots.size() && "more vertices welded than the welder was sized for");
+				entry.tag = tag;
+				entry.index = static_cast<uint32_t>(m_vertices.size());
+				m_vertices.push_back(vertex);
+				return entry.index;
+			}
+			if (entry.tag == tag && matches(m_vertices[entry.index], vertex))
+				return entry.index;
+		}
+	}
+} // namespace sk
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "skModel.h"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace sk
+{
+	/* Flat open-addressing table that welds identical vertices into one, used by Builder::loadMesh.
+	 *   the table is sized once for the worst case (every corner unique) so it never rehashes, and every slot is
+	 *   8 bytes: a 32-bit hash tag and the index of the vertex in the output array. vertices are hashed over their
+	 *   raw bits a whole word at a time (-0.0 is folded into +0.0 first so the result agrees with Vertex::operator==).
+	 *   weld() is a single find-or-insert probe sequence, no double lookup and no allocation per vertex.
+	 *
+	 *   with positionEpsilon > 0 positions are bucketed into cubes of that size instead of compared exactly: corners
+	 *   whose positions fall in the same cube (and whose other attributes are identical) become one vertex that keeps
+	 *   the position of the first corner seen. cheap, but two points closer than epsilon on either side of a cube face
+	 *   are not merged. */
+	class skVertexWelder
+	{
+	public:
+		// appends unique vertices to vertices, which must outlive the welder. maxVertices is an upper bound on the
+		//   number of weld() calls (e.g. the corner count of the mesh)
+		skVertexWelder(std::vector<skModel::Vertex>& vertices, size_t maxVertices, float positionEpsilon = 0.f);
+
+		skVertexWelder(const skVertexWelder&) = delete;
+		skVertexWelder &operator=(const skVertexWelder&) = delete;
+
+		// returns the index of vertex in the output array, adding it if no equal vertex was seen before
+		uint32_t weld(const skModel::Vertex& vertex);
+
+		// bytes held by the table itself, not counting the output array
+		inline size_t memoryUsage() const { return m_slots.capacity() * sizeof(Slot); }
+
+	private:
+		struct Slot
+		{
+			uint32_t tag;
+			uint32_t index;
+		};
+
+		uint64_t hash(const skModel::Vertex& vertex) const;
+		bool matches(const skModel::Vertex& stored, const skModel::Vertex& vertex) const;
+
+		std::vector<skModel::Vertex>& m_vertices;
+		std::vector<Slot> m_slots{};
+		size_t m_mask = 0;
+		float m_inverseEpsilon = 0.f;
+	};
+} // namespace sk
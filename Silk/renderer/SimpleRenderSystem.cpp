@@ -8,7 +8,9 @@
 
 // std
 #include <stdexcept>
+#include <algorithm>
 #include <array>
+#include <cmath>
 #include <iostream>
 
 namespace sk
@@ -18,11 +20,34 @@ namespace sk
 		glm::mat4 normalMatrix{ 1.f }; // model transform only (?). corresponds to translate * rotate * scale [read right to left]
 	};
 
+	namespace
+	{
+		// Gribb & Hartmann: the planes are rows of the view projection matrix combined, depth runs [0, 1] (GLM_FORCE_DEPTH_ZERO_TO_ONE)
+		SimpleRenderSystem::FrustumPlanes extractFrustumPlanes(const glm::mat4 &viewProjection)
+		{
+			glm::mat4 m = glm::transpose(viewProjection); // m[i] is row i
+			SimpleRenderSystem::FrustumPlanes planes{ m[3] + m[0], m[3] - m[0], m[3] + m[1], m[3] - m[1], m[2], m[3] - m[2] };
+			for (auto &plane : planes)
+				plane /= glm::length(glm::vec3{ plane });
+			return planes;
+		}
+
+		bool isOutside(const SimpleRenderSystem::FrustumPlanes &frustum, const glm::vec3 &center, float radius)
+		{
+			for (const auto &plane : frustum)
+			{
+				if (glm::dot(glm::vec3{ plane }, center) + plane.w < -radius)
+					return true;
+			}
+			return false;
+		}
+	} // namespace
+
 	SimpleRenderSystem::SimpleRenderSystem(skDevice &device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
-		: m_Device{device}
+		: m_Device{device}, m_renderPass{renderPass}
 	{
 		createPipelineLayout(globalSetLayout);
-		createPipeline(renderPass);
+		pipelineFor(skModel::VertexLayout{});
 	}
 
 	SimpleRenderSystem::~SimpleRenderSystem() { vkDestroyPipelineLayout(m_Device.device(), m_pipelineLayout, nullptr); }
@@ -47,48 +72,188 @@ namespace sk
 		}
 	}
 
-	void SimpleRenderSystem::createPipeline(VkRenderPass renderPass)
+	skPipeline &SimpleRenderSystem::pipelineFor(const skModel::VertexLayout &layout)
 	{
+		auto &pipeline = m_pipelines[layout.key()];
+		if (pipeline)
+			return *pipeline;
+
 		assert(m_pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
 		PipelineConfigInfo pipelineConfig{};
 		skPipeline::defaultPipelineConfigInfo(pipelineConfig);
+		pipelineConfig.bindingDescriptions = layout.getBindingDescriptions();
+		pipelineConfig.attributeDescriptions = layout.getAttributeDescriptions();
 		//a render pass is basically an outline for the structure/format of the framebuffer.
-		pipelineConfig.renderPass = renderPass;
+		pipelineConfig.renderPass = m_renderPass;
 		pipelineConfig.pipelineLayout = m_pipelineLayout;
-		m_skPipeline = std::make_unique<skPipeline>(
+
+		// the packed format only differs in how the normal is decoded
+		pipeline = std::make_unique<skPipeline>(
 			m_Device,
-			"res\\shaders\\bin\\simple_shader.vert.spv",
+			layout.format == skModel::VertexFormat::Packed ? "res\\shaders\\bin\\simple_shader_packed.vert.spv" : "res\\shaders\\bin\\simple_shader.vert.spv",
 			"res\\shaders\\bin\\simple_shader.frag.spv",
 			pipelineConfig);
+		return *pipeline;
 	}
 
 	void SimpleRenderSystem::renderGameObjects(FrameInfo &frameInfo)
 	{
-		// do not forget to bind the pipeline!
-		m_skPipeline->bind(frameInfo.commandBuffer);
+		// everything that touches shared state happens here, on the calling thread: residency checks and placements go
+		//   through the arena, pipelines are created on first use. all once per model of the registry, objects only look
+		//   theirs up
+		const skGameObjectRegistry &gameObjects = frameInfo.gameObjects;
+		m_modelPipelines.resize(gameObjects.modelCount());
+		for (uint32_t i = 0; i < gameObjects.modelCount(); i++)
+		{
+			skModel *model = gameObjects.model(i);
+			m_modelPipelines[i] = nullptr; // evicted or still uploading, nothing to show
+			if (model == nullptr || !model->isResident())
+				continue;
+			model->updatePlacement();
+			m_modelPipelines[i] = &pipelineFor(model->layout());
+		}
+
+		m_drawList.clear();
+		std::span<const skGameObjectRegistry::ModelHandle> modelHandles = gameObjects.modelHandles();
+		for (uint32_t i = 0; i < modelHandles.size(); i++) {
+			const skGameObjectRegistry::ModelHandle handle = modelHandles[i];
+			if (handle == skGameObjectRegistry::NO_MODEL || m_modelPipelines[handle] == nullptr) continue;
+			DrawItem item{};
+			item.object = i;
+			item.model = gameObjects.model(handle);
+			item.pipeline = m_modelPipelines[handle];
+			m_drawList.push_back(item);
+		}
+
+		// matrices of the objects moved since the last frame, blocks without one are skipped
+		skTransformSystem &transforms = frameInfo.gameObjects.transforms();
+		if (frameInfo.jobSystem != nullptr && transforms.blockCount() > TRANSFORM_BLOCKS_PER_JOB)
+		{
+			frameInfo.jobSystem->parallelFor("transforms", transforms.blockCount(), TRANSFORM_BLOCKS_PER_JOB,
+				[&](uint32_t begin, uint32_t end) { transforms.update(begin, end); });
+		}
+		else
+			transforms.update();
 
+		const FrustumPlanes frustum = extractFrustumPlanes(frameInfo.camera.getProjection() * frameInfo.camera.getView());
+		const glm::vec3 cameraPosition = glm::inverse(frameInfo.camera.getView())[3];
+
+		const size_t drawCount = m_drawList.size();
+		if (frameInfo.jobSystem != nullptr && drawCount > OBJECTS_PER_PREPARE_JOB)
+		{
+			frameInfo.jobSystem->parallelFor("prepare draws", static_cast<uint32_t>(drawCount), OBJECTS_PER_PREPARE_JOB,
+				[&](uint32_t begin, uint32_t end) { prepareDraws(frameInfo, begin, end, frustum); });
+		}
+		else
+			prepareDraws(frameInfo, 0, drawCount, frustum);
+
+		if (frameInfo.parallelRecorder != nullptr && frameInfo.parallelRecorder->inPass())
+		{
+			// contiguous slices keep the draw order of the inline path once the secondaries are executed in order
+			uint32_t sliceCount = static_cast<uint32_t>(std::clamp<size_t>((drawCount + MIN_OBJECTS_PER_SLICE - 1) / MIN_OBJECTS_PER_SLICE,
+				1, frameInfo.parallelRecorder->maxSlices()));
+			m_slices.resize(std::max<size_t>(m_slices.size(), sliceCount));
+			for (uint32_t i = 0; i < sliceCount; i++)
+				m_slices[i].cullingStats = CullingStats{};
+
+			// secondaries execute in slice order: the scope opens in the first and closes in the last
+			const skGpuProfiler::Scope scope = frameInfo.gpuProfiler != nullptr ? frameInfo.gpuProfiler->reserve("scene_draws")
+				: skGpuProfiler::INVALID_SCOPE;
+			frameInfo.parallelRecorder->record(sliceCount, [&](uint32_t slice, VkCommandBuffer commandBuffer)
+				{
+					if (slice == 0 && frameInfo.gpuProfiler != nullptr)
+						frameInfo.gpuProfiler->writeBegin(commandBuffer, scope);
+					recordDraws(frameInfo, commandBuffer, drawCount * slice / sliceCount, drawCount * (slice + 1) / sliceCount,
+						frustum, cameraPosition, m_slices[slice]);
+					if (slice == sliceCount - 1 && frameInfo.gpuProfiler != nullptr)
+						frameInfo.gpuProfiler->writeEnd(commandBuffer, scope);
+				});
+
+			m_cullingStats = CullingStats{};
+			for (uint32_t i = 0; i < sliceCount; i++)
+			{
+				const CullingStats &stats = m_slices[i].cullingStats;
+				m_cullingStats.objectsCulled += stats.objectsCulled;
+				m_cullingStats.meshletsTested += stats.meshletsTested;
+				m_cullingStats.meshletsBackfacing += stats.meshletsBackfacing;
+				m_cullingStats.meshletsOutsideFrustum += stats.meshletsOutsideFrustum;
+				m_cullingStats.trianglesCulled += stats.trianglesCulled;
+			}
+			return;
+		}
+
+		m_slices.resize(std::max<size_t>(m_slices.size(), 1));
+		m_slices[0].cullingStats = CullingStats{};
+		if (frameInfo.gpuProfiler != nullptr)
+		{
+			const skGpuProfiler::Scope scope = frameInfo.gpuProfiler->begin(frameInfo.commandBuffer, "scene_draws");
+			recordDraws(frameInfo, frameInfo.commandBuffer, 0, drawCount, frustum, cameraPosition, m_slices[0]);
+			frameInfo.gpuProfiler->end(frameInfo.commandBuffer, scope);
+		}
+		else
+			recordDraws(frameInfo, frameInfo.commandBuffer, 0, drawCount, frustum, cameraPosition, m_slices[0]);
+		m_cullingStats = m_slices[0].cullingStats;
+	}
+
+	void SimpleRenderSystem::prepareDraws(const FrameInfo &frameInfo, size_t first, size_t last, const FrustumPlanes &frustum)
+	{
+		const skTransformSystem &transforms = frameInfo.gameObjects.transforms();
+		for (size_t i = first; i < last; i++)
+		{
+			DrawItem &item = m_drawList[i];
+
+			item.modelMatrix = transforms.modelMatrix(item.object);
+			item.normalMatrix = transforms.normalMatrix(item.object); // transformation of normal matrices when obj is transformed (requires diff procedure than transforming obj itself)
+			glm::vec3 scale = glm::abs(transforms.scale(item.object));
+			item.maxScale = std::max({ scale.x, scale.y, scale.z });
+			item.lod = selectLod(*item.model, item.maxScale, item.modelMatrix, frameInfo);
+
+			// the whole object here, its meshlets while recording
+			item.visible = !m_meshletCulling ||
+				!isOutside(frustum, item.modelMatrix * glm::vec4{ item.model->boundsCenter(), 1.f }, item.model->boundsRadius() * item.maxScale);
+		}
+	}
+
+	void SimpleRenderSystem::recordDraws(const FrameInfo &frameInfo, VkCommandBuffer commandBuffer, size_t first, size_t last,
+		const FrustumPlanes &frustum, const glm::vec3 &cameraPosition, SliceScratch &scratch)
+	{
+		// pipelines are bound per vertex layout below, the descriptor set stays bound across them (same pipeline layout)
 		vkCmdBindDescriptorSets(
-			frameInfo.commandBuffer,
+			commandBuffer,
 			VK_PIPELINE_BIND_POINT_GRAPHICS,
 			m_pipelineLayout,
 			0, 1,
 			&frameInfo.globalDescriptorSet,
-			0, nullptr
+			1, &frameInfo.globalUboOffset
 		);
 
 		// update (akin to onUpdate function)
-		for (auto& kv : frameInfo.gameObjects) {
-			auto& obj = kv.second;
-			if (obj.model == nullptr) continue;
+		skPipeline *boundPipeline = nullptr;
+		skGeometryArena::BindState boundGeometry{}; // models sharing arena blocks skip the rebind
+		for (size_t i = first; i < last; i++) {
+			const DrawItem &item = m_drawList[i];
+			skModel &model = *item.model;
+			if (!item.visible)
+			{
+				scratch.cullingStats.objectsCulled++;
+				continue;
+			}
+
+			// do not forget to bind the pipeline!
+			if (item.pipeline != boundPipeline)
+			{
+				item.pipeline->bind(commandBuffer);
+				boundPipeline = item.pipeline;
+			}
 
 			// push constants before issuing draw call
 			SimplePushConstantData push{};
-			push.modelMatrix = obj.transform.mat4(); // returns transformation of this object ( projection * view * model)
-			push.normalMatrix = obj.transform.normalMatrix(); // transformation of normal matrices when obj is transformed (requires diff procedure than transforming obj itself)
+			push.modelMatrix = item.modelMatrix * model.positionDequantize(); // returns transformation of this object ( projection * view * model)
+			push.normalMatrix = item.normalMatrix;
 
 			vkCmdPushConstants(
-				frameInfo.commandBuffer,
+				commandBuffer,
 				m_pipelineLayout,
 				VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
 				0,
@@ -97,9 +262,70 @@ namespace sk
 			);
 
 			//bind model and draw
-			obj.model->bind(frameInfo.commandBuffer);
-			obj.model->draw(frameInfo.commandBuffer);
+			model.bind(commandBuffer, &boundGeometry);
+			if (m_meshletCulling && !model.meshlets(item.lod).empty())
+			{
+				cullMeshlets(model, item.lod, item.modelMatrix, item.maxScale, frustum,
+					glm::vec3{ glm::inverse(item.modelMatrix) * glm::vec4{ cameraPosition, 1.f } }, scratch);
+				model.drawMeshlets(commandBuffer, item.lod, scratch.meshletVisibility.data());
+			}
+			else
+				model.draw(commandBuffer, item.lod);
+		}
+	}
+
+	void SimpleRenderSystem::cullMeshlets(const skModel &model, uint32_t lod, const glm::mat4 &modelMatrix, float maxScale,
+		const FrustumPlanes &frustum, const glm::vec3 &cameraModelPosition, SliceScratch &scratch) const
+	{
+		std::span<const skModel::Meshlet> meshlets = model.meshlets(lod);
+		scratch.meshletVisibility.resize(meshlets.size());
+		CullingStats &stats = scratch.cullingStats;
+		stats.meshletsTested += static_cast<uint32_t>(meshlets.size());
+
+		for (size_t i = 0; i < meshlets.size(); i++)
+		{
+			const skModel::Meshlet &meshlet = meshlets[i];
+
+			// back face test in model space: which side of a plane a point lies on survives any affine transform, so the
+			//   cones need no transforming even under non-uniform scale
+			glm::vec3 toMeshlet = meshlet.center - cameraModelPosition;
+			bool backfacing = glm::dot(toMeshlet, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(toMeshlet) + meshlet.radius;
+			bool outside = !backfacing && isOutside(frustum, modelMatrix * glm::vec4{ meshlet.center, 1.f }, meshlet.radius * maxScale);
+
+			scratch.meshletVisibility[i] = !backfacing && !outside;
+			if (backfacing) stats.meshletsBackfacing++;
+			if (outside) stats.meshletsOutsideFrustum++;
+			if (!scratch.meshletVisibility[i]) stats.trianglesCulled += meshlet.indexCount / 3;
+		}
+	}
+
+	uint32_t SimpleRenderSystem::selectLod(const skModel &model, float maxScale, const glm::mat4 &modelMatrix, const FrameInfo &frameInfo) const
+	{
+		if (model.lodCount() <= 1)
+			return 0;
+
+		const glm::mat4 &projection = frameInfo.camera.getProjection();
+
+		// pixels covered by one world unit: proj[1][1] maps the view height onto [-1, 1]. a perspective projection
+		//   (w = view z) additionally divides by depth, measured at the sphere's nearest point to stay conservative
+		float pixelsPerUnit = std::abs(projection[1][1]) * .5f * static_cast<float>(frameInfo.extent.height);
+		if (projection[2][3] != 0.f)
+		{
+			glm::vec3 center = modelMatrix * glm::vec4{ model.boundsCenter(), 1.f };
+			float depth = (frameInfo.camera.getView() * glm::vec4{ center, 1.f }).z - model.boundsRadius() * maxScale;
+			if (depth <= 0.f)
+				return 0; // camera inside the bounds
+			pixelsPerUnit /= depth;
+		}
+
+		uint32_t lod = 0;
+		for (uint32_t i = 1; i < model.lodCount(); i++)
+		{
+			if (model.lod(i).error * maxScale * pixelsPerUnit > m_lodErrorThreshold)
+				break;
+			lod = i;
 		}
+		return lod;
 	}
 
 } // namespace sk
\ No newline at end of file
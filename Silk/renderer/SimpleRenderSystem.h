@@ -8,7 +8,9 @@
 #include "renderer/skFrameInfo.h"
 
 // std
+#include <array>
 #include <memory>
+#include <unordered_map>
 #include <vector>
 
 namespace sk
@@ -16,6 +18,25 @@ namespace sk
 	class SimpleRenderSystem
 	{
 	public:
+		// world space, xyz points into the frustum
+		using FrustumPlanes = std::array<glm::vec4, 6>;
+
+		// what the last renderGameObjects skipped
+		struct CullingStats {
+			uint32_t objectsCulled = 0;			// whole object outside the frustum
+			uint32_t meshletsTested = 0;
+			uint32_t meshletsBackfacing = 0;
+			uint32_t meshletsOutsideFrustum = 0;
+			uint64_t trianglesCulled = 0;		// by meshlet culling, culled objects not included
+		};
+
+		// fewer objects than this per recording thread are not worth a secondary command buffer of their own
+		static constexpr uint32_t MIN_OBJECTS_PER_SLICE = 64;
+		// objects per job when preparing draws on the job system
+		static constexpr uint32_t OBJECTS_PER_PREPARE_JOB = 256;
+		// blocks of TRANSFORM_BLOCK_SIZE objects per job when updating transforms on the job system
+		static constexpr uint32_t TRANSFORM_BLOCKS_PER_JOB = 64;
+
 		SimpleRenderSystem(skDevice &device, VkRenderPass renderpass, VkDescriptorSetLayout globalSetLayout);
 		~SimpleRenderSystem();
 
@@ -23,15 +44,60 @@ namespace sk
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
+		// records inline into frameInfo.commandBuffer, or in parallel slices when frameInfo.parallelRecorder is set. the
+		//   per-object work before recording runs on frameInfo.jobSystem when set
 		void renderGameObjects(FrameInfo &frameInfo);
 
+		// largest on-screen deviation (in pixels) a coarser LOD may introduce before the next finer one is drawn instead
+		void setLodErrorThreshold(float pixels) { m_lodErrorThreshold = pixels; }
+		// object and meshlet (frustum + normal cone) culling, on by default
+		void setMeshletCulling(bool enabled) { m_meshletCulling = enabled; }
+		const CullingStats &cullingStats() const { return m_cullingStats; }
 
 	private:
+		struct DrawItem
+		{
+			uint32_t object;	// dense index into frameInfo.gameObjects
+			skModel *model;
+			skPipeline *pipeline;
+			// filled by prepareDraws
+			glm::mat4 modelMatrix;
+			glm::mat4 normalMatrix;
+			float maxScale;
+			uint32_t lod;
+			bool visible;	// bounds inside the frustum (or culling off)
+		};
+
+		// per recording thread, slices never share one
+		struct SliceScratch
+		{
+			std::vector<uint8_t> meshletVisibility{};
+			CullingStats cullingStats{};
+		};
+
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
-		void createPipeline(VkRenderPass renderPass);
+		// transforms, LOD and object culling of draws [first, last) of m_drawList, touches nothing but those items
+		void prepareDraws(const FrameInfo &frameInfo, size_t first, size_t last, const FrustumPlanes &frustum);
+		// records draws [first, last) of m_drawList into commandBuffer
+		void recordDraws(const FrameInfo &frameInfo, VkCommandBuffer commandBuffer, size_t first, size_t last,
+			const FrustumPlanes &frustum, const glm::vec3 &cameraPosition, SliceScratch &scratch);
+		// one pipeline per vertex layout in use, created the first time a model with that layout is drawn
+		skPipeline &pipelineFor(const skModel::VertexLayout &layout);
+		// coarsest LOD whose error, projected at the nearest point of the model's bounding sphere, stays under the threshold
+		uint32_t selectLod(const skModel &model, float maxScale, const glm::mat4 &modelMatrix, const FrameInfo &frameInfo) const;
+		// fills scratch.meshletVisibility for the meshlets of lod
+		void cullMeshlets(const skModel &model, uint32_t lod, const glm::mat4 &modelMatrix, float maxScale,
+			const FrustumPlanes &frustum, const glm::vec3 &cameraModelPosition, SliceScratch &scratch) const;
 
 		skDevice &m_Device;
-		std::unique_ptr<skPipeline> m_skPipeline;
+		VkRenderPass m_renderPass;
+		std::unordered_map<uint32_t, std::unique_ptr<skPipeline>> m_pipelines;
 		VkPipelineLayout m_pipelineLayout;
+		float m_lodErrorThreshold = 1.f;
+		bool m_meshletCulling = true;
+		std::vector<DrawItem> m_drawList{};			// rebuilt every frame, reused
+		std::vector<skPipeline*> m_modelPipelines{};	// by model handle for the frame being built, null while not resident
+		std::vector<SliceScratch> m_slices{};		// reused across objects and frames
+		CullingStats m_cullingStats{};
 	};
 } // namespace sk
\ No newline at end of file
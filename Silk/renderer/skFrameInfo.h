@@ -1,6 +1,10 @@
 #pragma once
 
 #include "camera/skCamera.h"
+#include "core/skFrameAllocator.h"
+#include "core/skGpuProfiler.h"
+#include "core/skJobSystem.h"
+#include "renderer/skParallelRecorder.h"
 #include "skGameObject.h"
 
 // lib
@@ -8,6 +12,15 @@
 
 namespace sk
 {
+	// set 0, binding 0 of every pipeline, one per frame from the frame allocator
+	struct GlobalUbo
+	{
+		glm::mat4 projectionView{ 1.f };
+		glm::vec4 ambientLightColor{ 1.f, 1.f, 1.f, .02f }; // w is intensity
+		glm::vec4 lightPosition{ -1.f };
+		alignas(16) glm::vec4 lightColor{ 1.f };		// w is light intensity
+	};
+
 	struct FrameInfo
 	{
 		int frameIndex;
@@ -15,6 +28,15 @@ namespace sk
 		VkCommandBuffer commandBuffer;
 		skCamera& camera;
 		VkDescriptorSet globalDescriptorSet;
-		skGameObject::Map &gameObjects;
+		uint32_t globalUboOffset; // dynamic offset of this frame's GlobalUbo, bind globalDescriptorSet with it
+		skGameObjectRegistry &gameObjects;
+		VkExtent2D extent; // of the render target, for screen-space metrics such as LOD selection
+		skFrameAllocator &frameAllocator; // per-frame uniforms, per-draw data, dynamic vertices
+		// set when the pass was begun for secondary command buffers, render systems then record through it
+		skParallelRecorder *parallelRecorder = nullptr;
+		// per-object work (transforms, LOD selection, culling) runs as jobs when set, inline otherwise
+		skJobSystem *jobSystem = nullptr;
+		// GPU time of the passes and systems that open scopes on it, when set
+		skGpuProfiler *gpuProfiler = nullptr;
 	};
 } // namespace sk
@@ -0,0 +1,143 @@
+#include "skParallelRecorder.h"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace sk
+{
+	skParallelRecorder::skParallelRecorder(skDevice &device, skJobSystem &jobSystem, uint32_t frameCount, uint32_t sliceCount)
+		: m_Device{ device }, m_jobSystem{ jobSystem }
+	{
+		if (sliceCount == 0)
+			sliceCount = m_jobSystem.threadCount();
+
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = m_Device.findPhysicalQueueFamilies().graphicsFamily;
+		// reset as a whole every frame, never buffer by buffer
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		m_slices.resize(sliceCount);
+		for (auto &slice : m_slices)
+		{
+			slice.pools.resize(frameCount);
+			slice.buffers.resize(frameCount);
+			for (auto &pool : slice.pools)
+			{
+				if (vkCreateCommandPool(m_Device.device(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+					throw std::runtime_error("Failed to create recording command pool!");
+			}
+		}
+	}
+
+	skParallelRecorder::~skParallelRecorder()
+	{
+		// destroying a pool frees its command buffers
+		for (auto &slice : m_slices)
+		{
+			for (auto pool : slice.pools)
+				vkDestroyCommandPool(m_Device.device(), pool, nullptr);
+		}
+	}
+
+	void skParallelRecorder::beginPass(uint32_t frameIndex, VkCommandBuffer primary, VkRenderPass renderPass,
+		VkFramebuffer framebuffer, VkExtent2D extent)
+	{
+		assert(frameIndex < m_slices[0].pools.size() && "Frame index out of range");
+		m_frameIndex = frameIndex;
+		m_primary = primary;
+		m_extent = extent;
+
+		m_inheritance = VkCommandBufferInheritanceInfo{};
+		m_inheritance.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		m_inheritance.renderPass = renderPass;
+		m_inheritance.subpass = 0;
+		m_inheritance.framebuffer = framebuffer;
+
+		// the frame's fence has signaled, none of its secondaries is pending anymore
+		for (auto &slice : m_slices)
+		{
+			vkResetCommandPool(m_Device.device(), slice.pools[frameIndex], 0);
+			slice.used = 0;
+		}
+	}
+
+	void skParallelRecorder::record(uint32_t sliceCount, const RecordFn &fn)
+	{
+		assert(inPass() && "Cannot record secondaries outside of a pass begun for them");
+		sliceCount = std::min(sliceCount, maxSlices());
+		if (sliceCount == 0)
+			return;
+
+		// buffers are taken (and allocated when the pool has none left) here, before any job touches its pool
+		std::vector<VkCommandBuffer> secondaries(sliceCount);
+		for (uint32_t i = 0; i < sliceCount; i++)
+		{
+			SliceState &slice = m_slices[i];
+			auto &buffers = slice.buffers[m_frameIndex];
+			if (slice.used == buffers.size())
+			{
+				VkCommandBufferAllocateInfo allocInfo{};
+				allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+				allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+				allocInfo.commandPool = slice.pools[m_frameIndex];
+				allocInfo.commandBufferCount = 1;
+
+				VkCommandBuffer commandBuffer;
+				if (vkAllocateCommandBuffers(m_Device.device(), &allocInfo, &commandBuffer) != VK_SUCCESS)
+					throw std::runtime_error("Failed to allocate secondary command buffer!");
+				buffers.push_back(commandBuffer);
+			}
+			slice.current = secondaries[i] = buffers[slice.used++];
+			slice.error = nullptr;
+		}
+
+		if (sliceCount == 1)
+			recordSlice(0, fn);
+		else
+		{
+			m_jobSystem.parallelFor("record slice", sliceCount, 1, [this, &fn](uint32_t begin, uint32_t end) {
+				for (uint32_t i = begin; i < end; i++)
+					recordSlice(i, fn);
+			});
+		}
+
+		for (uint32_t i = 0; i < sliceCount; i++)
+		{
+			if (m_slices[i].error)
+				std::rethrow_exception(m_slices[i].error);
+		}
+		vkCmdExecuteCommands(m_primary, sliceCount, secondaries.data());
+	}
+
+	void skParallelRecorder::recordSlice(uint32_t slice, const RecordFn &fn)
+	{
+		SliceState &state = m_slices[slice];
+		try
+		{
+			VkCommandBufferBeginInfo beginInfo{};
+			beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+			beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+			beginInfo.pInheritanceInfo = &m_inheritance;
+			if (vkBeginCommandBuffer(state.current, &beginInfo) != VK_SUCCESS)
+				throw std::runtime_error("Failed to begin secondary command buffer!");
+
+			// dynamic state does not carry over from the primary
+			VkViewport viewport{ 0.f, 0.f, static_cast<float>(m_extent.width), static_cast<float>(m_extent.height), 0.f, 1.f };
+			VkRect2D scissor{ { 0, 0 }, m_extent };
+			vkCmdSetViewport(state.current, 0, 1, &viewport);
+			vkCmdSetScissor(state.current, 0, 1, &scissor);
+
+			fn(slice, state.current);
+
+			if (vkEndCommandBuffer(state.current) != VK_SUCCESS)
+				throw std::runtime_error("Failed to record secondary command buffer!");
+		}
+		catch (...)
+		{
+			state.error = std::current_exception();
+		}
+	}
+} // namespace sk
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "core/skDevice.h"
+#include "core/skJobSystem.h"
+
+// std
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <vector>
+
+namespace sk
+{
+	/* Records a render pass's draws on several threads at once, as secondary command buffers.
+	 *   every slice owns a command pool per frame in flight (pools are externally synchronized and a slice is recorded by
+	 *   one job at a time, so no two threads ever share one) and the frame's pools are reset wholesale when its pass
+	 *   begins, which the renderer does after the frame's fence signaled. record() runs the slices as jobs of the job
+	 *   system, the calling thread helping, then executes the secondaries in slice order so the draw order is the same as
+	 *   recording them inline.
+	 *   secondaries inherit nothing but the render pass: each starts with the viewport and scissor set and the callback
+	 *   binds its own pipeline, descriptor sets and buffers. */
+	class skParallelRecorder
+	{
+	public:
+		// records one slice into commandBuffer, runs on whichever thread took the slice's job
+		using RecordFn = std::function<void(uint32_t slice, VkCommandBuffer commandBuffer)>;
+
+		// sliceCount bounds the slices of one record() call, 0 picks the job system's thread count
+		skParallelRecorder(skDevice &device, skJobSystem &jobSystem, uint32_t frameCount, uint32_t sliceCount = 0);
+		~skParallelRecorder();
+
+		skParallelRecorder(const skParallelRecorder&) = delete;
+		skParallelRecorder &operator=(const skParallelRecorder&) = delete;
+
+		// called by skRenderer right after beginning a pass with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS
+		void beginPass(uint32_t frameIndex, VkCommandBuffer primary, VkRenderPass renderPass, VkFramebuffer framebuffer,
+			VkExtent2D extent);
+		void endPass() { m_primary = VK_NULL_HANDLE; }
+		bool inPass() const { return m_primary != VK_NULL_HANDLE; }
+
+		// records sliceCount (at most maxSlices()) secondaries in parallel and executes them into the pass. may be called
+		//   several times per pass, e.g. once per render system. rethrows the first exception a slice threw
+		void record(uint32_t sliceCount, const RecordFn &fn);
+
+		uint32_t maxSlices() const { return static_cast<uint32_t>(m_slices.size()); }
+
+	private:
+		struct SliceState
+		{
+			std::vector<VkCommandPool> pools{};						// per frame in flight
+			std::vector<std::vector<VkCommandBuffer>> buffers{};	// per frame, allocated on demand, reused after reset
+			uint32_t used = 0;										// buffers of the current frame handed out this pass
+			VkCommandBuffer current = VK_NULL_HANDLE;
+			std::exception_ptr error{};
+		};
+
+		void recordSlice(uint32_t slice, const RecordFn &fn);
+
+		skDevice &m_Device;
+		skJobSystem &m_jobSystem;
+		std::vector<SliceState> m_slices{};
+
+		uint32_t m_frameIndex = 0;
+		VkCommandBuffer m_primary = VK_NULL_HANDLE;
+		VkCommandBufferInheritanceInfo m_inheritance{};
+		VkExtent2D m_extent{};
+	};
+} // namespace sk
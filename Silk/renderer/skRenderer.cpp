@@ -7,11 +7,29 @@
 
 namespace sk
 {
-	skRenderer::skRenderer(skWindow& window, skDevice& device)
-		: m_skWindow{ window }, m_Device{ device }
+	skRenderer::skRenderer(skWindow& window, skDevice& device, skJobSystem& jobSystem)
+		: m_skWindow{ &window }, m_Device{ device }, m_jobSystem{ jobSystem }
+	{
+		init();
+	}
+
+	skRenderer::skRenderer(skDevice& device, skJobSystem& jobSystem, VkExtent2D extent)
+		: m_Device{ device }, m_jobSystem{ jobSystem }, m_offscreenExtent{ extent }
+	{
+		if (!m_Device.isHeadless())
+			throw std::runtime_error("Offscreen rendering needs a headless device.\n");
+		if (extent.width == 0 || extent.height == 0)
+			throw std::runtime_error("Offscreen targets need a non-empty extent.\n");
+		init();
+	}
+
+	void skRenderer::init()
 	{
 		recreateSwapChain();
 		createCommandBuffers();
+		m_frameAllocator = std::make_unique<skFrameAllocator>(m_Device, skSwapChain::MAX_FRAMES_IN_FLIGHT);
+		m_parallelRecorder = std::make_unique<skParallelRecorder>(m_Device, m_jobSystem, skSwapChain::MAX_FRAMES_IN_FLIGHT);
+		m_gpuProfiler = std::make_unique<skGpuProfiler>(m_Device, skSwapChain::MAX_FRAMES_IN_FLIGHT);
 	}
 
 	skRenderer::~skRenderer()
@@ -22,10 +40,11 @@ namespace sk
 
 	void skRenderer::recreateSwapChain()
 	{
-		auto extent = m_skWindow.getExtent();
+		// offscreen targets keep their extent
+		auto extent = m_skWindow != nullptr ? m_skWindow->getExtent() : m_offscreenExtent;
 		while (extent.width == 0 || extent.height == 0)
 		{
-			extent = m_skWindow.getExtent();
+			extent = m_skWindow->getExtent();
 			glfwWaitEvents();
 		}
 
@@ -48,6 +67,14 @@ namespace sk
 		// future optimization: if renderpass is compatible, do nothing else
 	}
 
+	void skRenderer::setRecordingSliceCount(uint32_t sliceCount)
+	{
+		assert(!m_isFrameStarted && "Can't change the recording slices while a frame is in progress.\n");
+		vkDeviceWaitIdle(m_Device.device());
+		m_parallelRecorder.reset();
+		m_parallelRecorder = std::make_unique<skParallelRecorder>(m_Device, m_jobSystem, skSwapChain::MAX_FRAMES_IN_FLIGHT, sliceCount);
+	}
+
 	void skRenderer::createCommandBuffers()
 	{
 		m_commandBuffers.resize(skSwapChain::MAX_FRAMES_IN_FLIGHT);
@@ -81,6 +108,8 @@ namespace sk
 		assert(!m_isFrameStarted && "Cant' call beginFrame while already in progress.\n");
 	
 		auto result = m_skSwapChain->acquireNextImage(&m_currentImageIndex);
+		m_frameTimings = m_skSwapChain->lastTimings();
+		m_frameTimings.submit = m_frameTimings.present = {}; // still the previous frame's
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR)
 		{
@@ -93,6 +122,8 @@ namespace sk
 		}
 
 		m_isFrameStarted = true;
+		// acquireNextImage waited on this frame's fence, nothing reads its region anymore
+		m_frameAllocator->beginFrame(m_currentFrameIndex);
 
 		auto commandBuffer = getCurrentCommandBuffer();
 		VkCommandBufferBeginInfo beginInfo{};
@@ -101,6 +132,9 @@ namespace sk
 		if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to begin recording command buffer.\n");
 		}
+		// the fence also covers the timestamps this slot wrote last time
+		m_gpuProfiler->beginFrame(m_currentFrameIndex, commandBuffer);
+		m_frameScope = m_gpuProfiler->begin(commandBuffer, "frame");
 
 		return commandBuffer;
 	}
@@ -109,14 +143,18 @@ namespace sk
 	{
 		assert(m_isFrameStarted && "Can't call endFrame while frame is not in progress.\n");
 		auto commandBuffer = getCurrentCommandBuffer();
+		m_gpuProfiler->end(commandBuffer, m_frameScope);
 		if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
 			throw std::runtime_error("Failed to record command buffer.\n");
 		}
+		m_frameAllocator->flush();
 		
 		auto result = m_skSwapChain->submitCommandBuffers(&commandBuffer, &m_currentImageIndex);
-		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_skWindow.wasWindowResized())
+		m_frameTimings = m_skSwapChain->lastTimings(); // before the swap chain may be recreated
+		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || (m_skWindow != nullptr && m_skWindow->wasWindowResized()))
 		{
-			m_skWindow.resetWindowResizedFlag();
+			if (m_skWindow != nullptr)
+				m_skWindow->resetWindowResizedFlag();
 			recreateSwapChain();
 		}
 
@@ -128,7 +166,7 @@ namespace sk
 		m_currentFrameIndex = (m_currentFrameIndex + 1) % skSwapChain::MAX_FRAMES_IN_FLIGHT;
 	}
 
-	void skRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer)
+	void skRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents)
 	{
 		assert(m_isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress.\n");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Can't begin render pass on command buffer from a different frame.\n");
@@ -152,7 +190,15 @@ namespace sk
 		// VK_SUBPASS_CONTENTS_INLINE flag means that the subsequent commands will be recorded/embedded to a primary command buffer.
 		// VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS is the alternative to this flag and it means that subsequent commands will be executed from a secondary command buffer.
 		// this implies that there is no mixing- that is, we cannot have a renderpass that uses both inline and secondary command buffers at the same time.
-		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		m_passScope = m_gpuProfiler->begin(commandBuffer, "scene_pass");
+		vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, contents);
+		if (contents == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+		{
+			// only vkCmdExecuteCommands is allowed in such a pass, the secondaries set viewport and scissor themselves
+			m_parallelRecorder->beginPass(m_currentFrameIndex, commandBuffer, renderPassInfo.renderPass, renderPassInfo.framebuffer,
+				renderPassInfo.renderArea.extent);
+			return;
+		}
 
 		VkViewport viewport{};
 		viewport.x = 0.0f;
@@ -170,7 +216,9 @@ namespace sk
 	{
 		assert(m_isFrameStarted && "Can't call endSwapChainRenderPass if frame is not in progress.\n");
 		assert(commandBuffer == getCurrentCommandBuffer() && "Can't end render pass on command buffer from a different frame.\n");
+		m_parallelRecorder->endPass();
 		vkCmdEndRenderPass(commandBuffer);
+		m_gpuProfiler->end(commandBuffer, m_passScope);
 	}
 
 } // namespace sk
\ No newline at end of file
@@ -3,7 +3,11 @@
 #include "window/skWindow.h"
 #include "core/skSwapChain.h"
 #include "core/skDevice.h"
+#include "core/skFrameAllocator.h"
+#include "core/skJobSystem.h"
+#include "core/skGpuProfiler.h"
 #include "model/skModel.h"
+#include "renderer/skParallelRecorder.h"
 
 // std
 #include <cassert>
@@ -15,7 +19,9 @@ namespace sk
 	class skRenderer
 	{
 	public:
-		skRenderer(skWindow &window, skDevice &device);
+		skRenderer(skWindow &window, skDevice &device, skJobSystem &jobSystem);
+		// headless, into offscreen targets of the given extent. the device must be headless as well
+		skRenderer(skDevice &device, skJobSystem &jobSystem, VkExtent2D extent);
 		~skRenderer();
 
 		// delete copy constructors because we're managing vulkan objects in this class
@@ -24,12 +30,15 @@ namespace sk
 
 		VkCommandBuffer beginFrame();
 		void endFrame();
-		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
+		// with VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS the pass only takes secondaries, recorded through
+		//   getParallelRecorder().record()
+		void beginSwapChainRenderPass(VkCommandBuffer commandBuffer, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 		void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
 		// getters
 		inline VkRenderPass getSwapChainRenderPass() const { return m_skSwapChain->getRenderPass(); }
 		inline float getAspectRatio() const { return m_skSwapChain->extentAspectRatio(); }
+		inline VkExtent2D getSwapChainExtent() const { return m_skSwapChain->getSwapChainExtent(); }
 		inline bool isFrameInProgress() const { return m_isFrameStarted; }
 		inline int getFrameIndex() const {
 			assert(m_isFrameStarted && "Cannot get frame index when frame not in progress.\n");
@@ -39,19 +48,41 @@ namespace sk
 			assert(m_isFrameStarted && "Cannot get command buffer when frame not in progress.\n");
 			return m_commandBuffers[m_currentFrameIndex];
 		}
+		// rewound by beginFrame once the frame's fence signaled, flushed by endFrame
+		inline skFrameAllocator &getFrameAllocator() { return *m_frameAllocator; }
+		inline skParallelRecorder &getParallelRecorder() { return *m_parallelRecorder; }
+		// the "frame" and "scene_pass" scopes are written here, systems add their own between beginFrame and endFrame
+		inline skGpuProfiler &getGpuProfiler() { return *m_gpuProfiler; }
+		// where the last frame blocked: fence wait and acquire in beginFrame, submit and present in endFrame
+		inline const skSwapChain::Timings &getFrameTimings() const { return m_frameTimings; }
+
+		// secondary command buffers recorded in parallel per record() call, as jobs of the job system. 0 picks its thread
+		//   count. waits for the device to go idle, so not per frame
+		void setRecordingSliceCount(uint32_t sliceCount);
+		inline uint32_t getRecordingSliceCount() const { return m_parallelRecorder->maxSlices(); }
 
 	private:
+		void init();
 		void createCommandBuffers();
 		void freeCommandBuffers();
 		void recreateSwapChain();
 
-		skWindow &m_skWindow;
+		skWindow *m_skWindow = nullptr; // null when headless
 		skDevice &m_Device;
+		skJobSystem &m_jobSystem;
+		VkExtent2D m_offscreenExtent{};
 		std::unique_ptr<skSwapChain> m_skSwapChain;
 		std::vector<VkCommandBuffer> m_commandBuffers;
+		std::unique_ptr<skFrameAllocator> m_frameAllocator;
+		std::unique_ptr<skParallelRecorder> m_parallelRecorder;
+		std::unique_ptr<skGpuProfiler> m_gpuProfiler;
+		skGpuProfiler::Scope m_frameScope = skGpuProfiler::INVALID_SCOPE;
+		skGpuProfiler::Scope m_passScope = skGpuProfiler::INVALID_SCOPE;
+
+		skSwapChain::Timings m_frameTimings{};
 
 		uint32_t m_currentImageIndex;
-		int m_currentFrameIndex;
+		int m_currentFrameIndex{ 0 };
 		bool m_isFrameStarted{ false };
 	};
 } // namespace sk
\ No newline at end of file
@@ -0,0 +1,47 @@
+#version 450
+
+layout(location = 0) in vec3 a_Position; // unorm16 in [0, 1] of the mesh AABB, push.modelMatrix undoes it
+layout(location = 1) in vec3 a_Color;
+layout(location = 2) in vec2 a_Normal; // octahedral, see skModel::VertexFormat::Packed
+layout(location = 3) in vec3 a_UV;
+
+layout(location = 0) out vec3 o_fragColor;
+layout(location = 1) out vec3 o_fragPosWorld;
+layout(location = 2) out vec3 o_fragNormalWorld;
+
+
+layout(set = 0, binding = 0) uniform GlobalUbo
+{
+	mat4 projection;
+	mat4 view;
+	vec4 ambientLightColor; // w is intensity
+	vec3 lightPosition;
+	vec4 lightColor;
+} ubo;
+
+//the name of the uniform doesn't have to match the name of the struct
+// the order of the fields MUST match the order of the struct we created (see SimplePushConstantData in SimpleRenderSystem.cpp)
+layout (push_constant) uniform Push
+{ 
+	mat4 modelMatrix;
+	mat4 normalMatrix;
+} push;
+
+vec3 octahedralDecode(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	if (n.z < 0.0)
+		n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+	return normalize(n);
+}
+
+void main()
+{
+	vec4 positionWorld = push.modelMatrix * vec4(a_Position, 1.0);
+	gl_Position = ubo.projection * ubo.view * positionWorld;
+	// temporary: this is only correct in certain situations!
+	// mat3(push.modelMatrix) converts modelMatrix from a mat4 to a mat3 by truncating last column and row.
+	o_fragNormalWorld = normalize(mat3(push.normalMatrix) * octahedralDecode(a_Normal));
+	o_fragPosWorld = positionWorld.xyz;
+	o_fragColor = a_Color;
+}
\ No newline at end of file
@@ -0,0 +1,79 @@
+#include "skCameraPath.h"
+#include "skSceneGenerator.h"
+
+// libs
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace sk
+{
+	namespace
+	{
+		glm::vec3 catmullRom(const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3, float t)
+		{
+			float t2 = t * t, t3 = t2 * t;
+			return .5f * (2.f * p1 + (p2 - p0) * t + (2.f * p0 - 5.f * p1 + 4.f * p2 - p3) * t2 + (3.f * p1 - p0 - 3.f * p2 + p3) * t3);
+		}
+	} // namespace
+
+	skCameraPath::skCameraPath(std::vector<Key> keys, float duration)
+		: m_keys{ std::move(keys) }, m_duration{ duration }
+	{
+		assert(!m_keys.empty() && "A camera path needs at least one key");
+		assert(m_duration > 0.f && "A camera path needs a positive duration");
+	}
+
+	skCameraPath skCameraPath::orbit(const glm::vec3 &center, float radius, float height, float duration, uint32_t keyCount)
+	{
+		keyCount = std::max(4u, keyCount);
+		std::vector<Key> keys(keyCount);
+		for (uint32_t i = 0; i < keyCount; i++)
+		{
+			float angle = glm::two_pi<float>() * i / keyCount;
+			keys[i].position = center + glm::vec3{ radius * std::cos(angle), height, radius * std::sin(angle) };
+			keys[i].target = center;
+		}
+		return skCameraPath{ std::move(keys), duration };
+	}
+
+	skCameraPath skCameraPath::flythrough(uint64_t seed, float halfSize, float duration, uint32_t keyCount)
+	{
+		keyCount = std::max(2u, keyCount);
+		skRandom random{ seed };
+		std::vector<Key> keys(keyCount);
+		for (Key &key : keys)
+			key.position = { random.uniform(-halfSize, halfSize), random.uniform(-halfSize, halfSize), random.uniform(-halfSize, halfSize) };
+		for (uint32_t i = 0; i < keyCount; i++)
+			keys[i].target = keys[(i + 1) % keyCount].position;
+		return skCameraPath{ std::move(keys), duration };
+	}
+
+	skCameraPath::Key skCameraPath::sample(float time) const
+	{
+		const size_t count = m_keys.size();
+		float position = std::fmod(time / m_duration, 1.f);
+		if (position < 0.f)
+			position += 1.f;
+		position *= count;
+		const size_t segment = std::min(static_cast<size_t>(position), count - 1);
+		const float t = position - segment;
+
+		const Key &k0 = m_keys[(segment + count - 1) % count], &k1 = m_keys[segment];
+		const Key &k2 = m_keys[(segment + 1) % count], &k3 = m_keys[(segment + 2) % count];
+		return { catmullRom(k0.position, k1.position, k2.position, k3.position, t),
+			catmullRom(k0.target, k1.target, k2.target, k3.target, t) };
+	}
+
+	void skCameraPath::apply(skCamera &camera, float time) const
+	{
+		Key key = sample(time);
+		// the view needs a direction, a path folding back on itself may briefly put the target onto the camera
+		if (glm::length(key.target - key.position) < 1e-4f)
+			key.target = key.position + glm::vec3{ 0.f, 0.f, 1.f };
+		camera.setViewTarget(key.position, key.target);
+	}
+} // namespace sk
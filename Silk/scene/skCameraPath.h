@@ -0,0 +1,47 @@
+#pragma once
+
+#include "camera/skCamera.h"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace sk
+{
+	/* Scripted camera motion, so benchmark runs see the same views frame for frame.
+	 *   a closed loop of keys, evenly spaced over duration seconds. positions and targets are interpolated separately
+	 *   with uniform Catmull-Rom splines, which pass through every key and keep the motion smooth across keys. */
+	class skCameraPath
+	{
+	public:
+		struct Key
+		{
+			glm::vec3 position{};
+			glm::vec3 target{};
+		};
+
+		// at least one key, duration in seconds for the whole loop
+		skCameraPath(std::vector<Key> keys, float duration);
+
+		// keyCount keys on a circle of radius around center, raised by height, looking at the center
+		static skCameraPath orbit(const glm::vec3 &center, float radius, float height, float duration, uint32_t keyCount = 16);
+		// keyCount seeded random keys in the cube of halfSize around the origin, each looking towards the next. flies
+		//   through the scene rather than around it, so culling and LOD selection change from frame to frame
+		static skCameraPath flythrough(uint64_t seed, float halfSize, float duration, uint32_t keyCount = 8);
+
+		// any time, the path loops
+		Key sample(float time) const;
+		void apply(skCamera &camera, float time) const;
+
+		float duration() const { return m_duration; }
+
+	private:
+		std::vector<Key> m_keys;
+		float m_duration;
+	};
+} // namespace sk
@@ -0,0 +1,163 @@
+#include "skSceneGenerator.h"
+
+// libs
+#include <glm/gtc/constants.hpp>
+
+// std
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace sk
+{
+	namespace
+	{
+		constexpr float GRID_AMPLITUDE = .08f;
+		constexpr float MIN_OBJECT_SCALE = .4f;	// of the spacing, the procedural meshes are about 1 unit across
+		constexpr float MAX_OBJECT_SCALE = .8f;
+	} // namespace
+
+	skModel::Builder skSceneGenerator::grid(uint32_t quads, float frequency, const glm::vec3 &color)
+	{
+		quads = std::max(1u, quads);
+		const uint32_t side = quads + 1;
+		skModel::Builder builder{};
+		builder.vertices.reserve(static_cast<size_t>(side) * side);
+		for (uint32_t z = 0; z < side; z++)
+		{
+			for (uint32_t x = 0; x < side; x++)
+			{
+				float fx = static_cast<float>(x) / quads, fz = static_cast<float>(z) / quads;
+				float height = GRID_AMPLITUDE * std::sin(fx * frequency) * std::cos(fz * frequency);
+				// gradient of the height field gives the normal
+				float dx = GRID_AMPLITUDE * frequency * std::cos(fx * frequency) * std::cos(fz * frequency);
+				float dz = -GRID_AMPLITUDE * frequency * std::sin(fx * frequency) * std::sin(fz * frequency);
+
+				skModel::Vertex vertex{};
+				vertex.position = { fx - .5f, height, fz - .5f };
+				vertex.color = color;
+				vertex.normal = glm::normalize(glm::vec3{ -dx, 1.f, -dz });
+				vertex.uv = { fx, fz };
+				builder.vertices.push_back(vertex);
+			}
+		}
+
+		builder.indices.reserve(static_cast<size_t>(quads) * quads * 6);
+		for (uint32_t z = 0; z < quads; z++)
+		{
+			for (uint32_t x = 0; x < quads; x++)
+			{
+				uint32_t a = z * side + x, b = a + 1, c = a + side + 1, d = a + side;
+				builder.indices.insert(builder.indices.end(), { a, c, b, a, d, c });
+			}
+		}
+		return builder;
+	}
+
+	skModel::Builder skSceneGenerator::sphere(uint32_t rings, uint32_t segments, const glm::vec3 &color)
+	{
+		rings = std::max(2u, rings);
+		segments = std::max(3u, segments);
+		skModel::Builder builder{};
+		builder.vertices.reserve(static_cast<size_t>(rings + 1) * (segments + 1));
+		for (uint32_t ring = 0; ring <= rings; ring++)
+		{
+			float theta = glm::pi<float>() * ring / rings;
+			for (uint32_t segment = 0; segment <= segments; segment++)
+			{
+				float phi = glm::two_pi<float>() * segment / segments;
+				glm::vec3 normal{ std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi) };
+
+				skModel::Vertex vertex{};
+				vertex.position = normal * .5f;
+				vertex.color = color;
+				vertex.normal = normal;
+				vertex.uv = { static_cast<float>(segment) / segments, static_cast<float>(ring) / rings };
+				builder.vertices.push_back(vertex);
+			}
+		}
+
+		// the first and last ring are single triangles, their quads would be degenerate at the poles
+		builder.indices.reserve(static_cast<size_t>(rings - 1) * segments * 6);
+		for (uint32_t ring = 0; ring < rings; ring++)
+		{
+			for (uint32_t segment = 0; segment < segments; segment++)
+			{
+				uint32_t a = ring * (segments + 1) + segment, b = a + 1, c = a + segments + 1, d = c + 1;
+				if (ring != 0)
+					builder.indices.insert(builder.indices.end(), { a, b, c });
+				if (ring != rings - 1)
+					builder.indices.insert(builder.indices.end(), { b, d, c });
+			}
+		}
+		return builder;
+	}
+
+	skSceneGenerator::skSceneGenerator(skGeometryArena &arena, const Settings &settings)
+		: m_arena{ arena }, m_settings{ settings }
+	{
+	}
+
+	float skSceneGenerator::sceneSize() const
+	{
+		return m_settings.spacing * std::cbrt(static_cast<float>(std::max(1u, m_settings.objectCount)));
+	}
+
+	std::shared_ptr<skModel> skSceneGenerator::createProceduralModel(uint32_t index, skRandom &random)
+	{
+		// about trianglesPerObject triangles: a grid has 2 * quads^2, a sphere with twice as many segments as rings
+		//   4 * rings * (rings - 1)
+		const float triangles = static_cast<float>(std::max(1u, m_settings.trianglesPerObject));
+		const glm::vec3 color{ random.uniform(.2f, 1.f), random.uniform(.2f, 1.f), random.uniform(.2f, 1.f) };
+		const float frequency = random.uniform(4.f, 16.f);
+		const uint32_t rings = static_cast<uint32_t>(std::lround((1.f + std::sqrt(1.f + triangles)) * .5f));
+		const uint32_t quads = static_cast<uint32_t>(std::lround(std::sqrt(triangles * .5f)));
+		skModel::Builder builder = index % 2 == 0 ? sphere(rings, 2 * rings, color) : grid(quads, frequency, color);
+
+		builder.optimize();
+		if (m_settings.generateLods)
+			builder.generateLods();
+		return std::make_shared<skModel>(m_arena, builder);
+	}
+
+	skSceneGenerator::Stats skSceneGenerator::generate(skGameObjectRegistry &gameObjects)
+	{
+		skRandom random{ m_settings.seed };
+		const uint32_t objectCount = m_settings.objectCount;
+		const uint32_t fileCount = static_cast<uint32_t>(m_settings.modelFiles.size());
+		const uint32_t uniqueCount = std::max(1u, static_cast<uint32_t>(std::lround(m_settings.uniqueModelRatio * objectCount)));
+		const uint32_t proceduralCount = uniqueCount > fileCount ? uniqueCount - fileCount : (fileCount == 0 ? 1 : 0);
+
+		std::vector<skGameObjectRegistry::ModelHandle> models{};
+		models.reserve(fileCount + proceduralCount);
+		for (const std::string &file : m_settings.modelFiles)
+			models.push_back(gameObjects.addModel(skModel::createModelFromFile(m_arena, file)));
+		for (uint32_t i = 0; i < proceduralCount; i++)
+			models.push_back(gameObjects.addModel(createProceduralModel(i, random)));
+
+		Stats stats{};
+		stats.models = static_cast<uint32_t>(models.size());
+		for (skGameObjectRegistry::ModelHandle model : models)
+			stats.modelTriangles += gameObjects.model(model)->lod(0).indexCount / 3;
+
+		const float halfSize = sceneSize() * .5f;
+		gameObjects.reserve(gameObjects.size() + objectCount);
+		for (uint32_t i = 0; i < objectCount; i++)
+		{
+			const skGameObjectRegistry::ModelHandle model = models[random.below(stats.models)];
+			TransformComponent transform{};
+			transform.translation = { random.uniform(-halfSize, halfSize), random.uniform(-halfSize, halfSize),
+				random.uniform(-halfSize, halfSize) };
+			transform.rotation = { random.uniform(0.f, glm::two_pi<float>()), random.uniform(0.f, glm::two_pi<float>()),
+				random.uniform(0.f, glm::two_pi<float>()) };
+			transform.scale = glm::vec3{ m_settings.spacing * random.uniform(MIN_OBJECT_SCALE, MAX_OBJECT_SCALE) };
+			gameObjects.setModel(gameObjects.create(transform), model);
+			stats.sceneTriangles += gameObjects.model(model)->lod(0).indexCount / 3;
+		}
+		stats.objects = objectCount;
+
+		std::cout << "Generated " << stats.objects << " objects from " << stats.models << " models (seed " << m_settings.seed
+			<< "), " << stats.modelTriangles << " triangles stored, " << stats.sceneTriangles << " placed" << std::endl;
+		return stats;
+	}
+} // namespace sk
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "model/skGeometryArena.h"
+#include "model/skModel.h"
+#include "skGameObject.h"
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace sk
+{
+	// splitmix64. the std distributions differ between standard libraries, this gives the same scene everywhere
+	class skRandom
+	{
+	public:
+		explicit skRandom(uint64_t seed) : m_state{ seed } {}
+
+		uint64_t next()
+		{
+			uint64_t z = (m_state += 0x9E3779B97F4A7C15ull);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			return z ^ (z >> 31);
+		}
+		// [0, 1), from the top 24 bits so every value is exact in a float
+		float uniform() { return static_cast<float>(next() >> 40) * (1.f / 16777216.f); }
+		float uniform(float min, float max) { return min + (max - min) * uniform(); }
+		// [0, count)
+		uint32_t below(uint32_t count) { return static_cast<uint32_t>((next() >> 32) * count >> 32); }
+
+	private:
+		uint64_t m_state;
+	};
+
+	/* Deterministic synthetic scenes for scalability tests.
+	 *   objectCount objects share max(1, uniqueModelRatio * objectCount) models, built from procedural meshes of about
+	 *   trianglesPerObject triangles (displaced grids and UV spheres, alternating) plus one instanced copy of each model
+	 *   file, if any. objects are scattered through a cube whose size keeps the density constant, so the camera paths
+	 *   of skCameraPath see a similar crowd at any count. the same settings and seed always give the same scene. */
+	class skSceneGenerator
+	{
+	public:
+		struct Settings
+		{
+			uint64_t seed = 1;
+			uint32_t objectCount = 1000;
+			uint32_t trianglesPerObject = 2000;	// of the procedural meshes, model files keep their own
+			float uniqueModelRatio = .01f;
+			std::vector<std::string> modelFiles{};	// e.g. res/models/*.obj, counted among the unique models
+			float spacing = .6f;				// average distance between neighbouring objects
+			bool generateLods = false;			// skModel::Builder::generateLods on the procedural meshes, slow at high counts
+		};
+
+		struct Stats
+		{
+			uint32_t objects = 0;
+			uint32_t models = 0;
+			uint64_t modelTriangles = 0;	// geometry stored, each unique model once
+			uint64_t sceneTriangles = 0;	// geometry placed, every object's LOD 0
+		};
+
+		// grid of quads * quads quads, displaced by a sine wave, 1 unit wide and centered on the origin in xz
+		static skModel::Builder grid(uint32_t quads, float frequency, const glm::vec3 &color);
+		// rings rings of segments quads around the y axis, radius .5, outward facing
+		static skModel::Builder sphere(uint32_t rings, uint32_t segments, const glm::vec3 &color);
+
+		// models are suballocated from arena, which must outlive the game objects
+		skSceneGenerator(skGeometryArena &arena, const Settings &settings);
+
+		// appends the objects to gameObjects. the models' uploads are left in the arena's upload context, submit and wait
+		//   on it before the first frame
+		Stats generate(skGameObjectRegistry &gameObjects);
+
+		// the cube the objects are scattered through, centered on the origin
+		float sceneSize() const;
+
+	private:
+		std::shared_ptr<skModel> createProceduralModel(uint32_t index, skRandom &random);
+
+		skGeometryArena &m_arena;
+		Settings m_settings;
+	};
+} // namespace sk
@@ -0,0 +1,86 @@
+#include "skSimulation.h"
+
+// std
+#include <cassert>
+
+namespace sk
+{
+	skSimulation::skSimulation(float tickRate) : m_tickRate{ tickRate }
+	{
+		assert(tickRate > 0.f && "Simulation tick rate must be positive");
+	}
+
+	skSimulation::~skSimulation()
+	{
+		stop();
+	}
+
+	void skSimulation::start()
+	{
+		assert(!m_running && "Simulation already running");
+		publish();
+		m_running = true;
+		m_thread = std::thread{ &skSimulation::run, this };
+	}
+
+	void skSimulation::stop()
+	{
+		m_running = false;
+		if (m_thread.joinable())
+			m_thread.join();
+	}
+
+	const SceneSnapshot &skSimulation::latestSnapshot(bool *newSnapshot)
+	{
+		bool acquired = m_snapshots.acquire();
+		if (newSnapshot != nullptr)
+			*newSnapshot = acquired;
+		return m_snapshots.readSlot();
+	}
+
+	void skSimulation::run()
+	{
+		using clock = std::chrono::steady_clock;
+		const float dt = 1.f / m_tickRate;
+		const auto period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<float>{ dt });
+
+		auto next = clock::now();
+		while (m_running.load(std::memory_order_relaxed))
+		{
+			tick(dt);
+			publish();
+			m_tickCount.fetch_add(1, std::memory_order_relaxed);
+
+			// fixed steps keep the simulation independent of how often it gets to run, a few late ones are caught up on
+			next += period;
+			auto now = clock::now();
+			if (now - next > period * MAX_CATCH_UP_TICKS)
+				next = now;
+			std::this_thread::sleep_until(next);
+		}
+	}
+
+	void skSimulation::tick(float dt)
+	{
+		m_cameraController.moveInPlaneXZ(m_actions.load(std::memory_order_relaxed), dt, m_viewer);
+		m_tick++;
+		m_time += dt;
+	}
+
+	void skSimulation::publish()
+	{
+		// the slot last held a snapshot from two publishes ago, its transforms are still current unless they changed
+		//   since. assigning reuses its vector
+		SceneSnapshot &snapshot = m_snapshots.writeSlot();
+		snapshot.tick = m_tick;
+		snapshot.time = m_time;
+		snapshot.camera = m_viewer;
+		if (snapshot.transformsRevision != m_transformsRevision)
+		{
+			snapshot.transforms.assign(m_transforms.begin(), m_transforms.end());
+			snapshot.transformsRevision = m_transformsRevision;
+		}
+		snapshot.published = std::chrono::steady_clock::now();
+		m_snapshots.publish();
+	}
+} // namespace sk
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "core/skTripleBuffer.h"
+#include "controller/KeyboardMovementController.h"
+#include "skGameObject.h"
+
+// libs
+#include <glm/glm.hpp>
+
+// std
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace sk
+{
+	// everything the renderer needs from one simulation tick, never modified once published
+	struct SceneSnapshot
+	{
+		uint64_t tick = 0;
+		float time = 0.f;	// simulated seconds
+		std::chrono::steady_clock::time_point published{};
+
+		TransformComponent camera{};	// translation and rotation for skCamera::setViewYXZ
+
+		glm::vec4 ambientLightColor{ 1.f, 1.f, 1.f, .02f }; // w is intensity
+		glm::vec4 lightPosition{ -1.f };
+		glm::vec4 lightColor{ 1.f };	// w is light intensity
+
+		// only copied by publish when transformsRevision moved past the slot's, the render side skips applying them
+		//   the same way: a static scene costs nothing per tick
+		uint64_t transformsRevision = 0;
+		std::vector<std::pair<skEntity, TransformComponent>> transforms{};
+	};
+
+	/* Runs the game state on its own thread at a fixed tick, apart from rendering.
+	 *   a stall in the render loop (fences, present) no longer stretches simulation steps and a slow tick no longer
+	 *   delays a frame. the simulation owns the camera and the object transforms, after every tick it publishes them as a
+	 *   SceneSnapshot through a triple buffer, the render thread picks up the newest one per frame without either side
+	 *   waiting. input comes the other way: glfw only reads keys on the main thread, which samples them once per frame
+	 *   into an atomic the simulation reads every tick. */
+	class skSimulation
+	{
+	public:
+		explicit skSimulation(float tickRate);
+		// stops the thread if still running
+		~skSimulation();
+
+		skSimulation(const skSimulation&) = delete;
+		skSimulation &operator=(const skSimulation&) = delete;
+
+		// initial state, before start()
+		void addObject(skEntity id, const TransformComponent &transform)
+		{
+			m_transforms.emplace_back(id, transform);
+			m_transformsRevision++;
+		}
+		void setCamera(const TransformComponent &camera) { m_viewer = camera; }
+
+		// publishes the initial state as tick 0, then ticks on the simulation thread until stop()
+		void start();
+		void stop();
+
+		// main thread: samples the controller's keys for the next ticks
+		void sampleInput(GLFWwindow *window) { m_actions.store(m_cameraController.readActions(window), std::memory_order_relaxed); }
+
+		// render thread: the newest published snapshot, valid until the next call. newSnapshot tells whether it changed
+		const SceneSnapshot &latestSnapshot(bool *newSnapshot = nullptr);
+
+		float tickRate() const { return m_tickRate; }
+		// ticks run since start(), any thread
+		uint64_t tickCount() const { return m_tickCount.load(std::memory_order_relaxed); }
+
+	private:
+		// more ticks than this behind schedule (e.g. after a breakpoint) are dropped rather than caught up on
+		static constexpr uint32_t MAX_CATCH_UP_TICKS = 5;
+
+		void run();
+		void tick(float dt);
+		void publish();
+
+		float m_tickRate;
+		std::thread m_thread{};
+		std::atomic<bool> m_running{ false };
+		std::atomic<uint32_t> m_actions{ 0 };	// KeyboardMovementController::Action bits
+		std::atomic<uint64_t> m_tickCount{ 0 };
+		skTripleBuffer<SceneSnapshot> m_snapshots{};
+
+		// owned by the simulation thread while it runs
+		TransformComponent m_viewer{};
+		KeyboardMovementController m_cameraController{};
+		std::vector<std::pair<skEntity, TransformComponent>> m_transforms{};
+		uint64_t m_transformsRevision = 0;	// bumped by anything changing m_transforms
+		uint64_t m_tick = 0;
+		float m_time = 0.f;
+	};
+} // namespace sk
@@ -1,66 +1,104 @@
 #include "skGameObject.h"
 
+// std
+#include <algorithm>
+
 namespace sk
 {
+	skEntity skGameObjectRegistry::create(const TransformComponent &transform)
+	{
+		skEntity entity{};
+		if (m_freeSlots.empty())
+		{
+			entity.index = static_cast<uint32_t>(m_sparse.size());
+			m_sparse.push_back(skEntity::INVALID_INDEX);
+			m_generations.push_back(0);
+		}
+		else
+		{
+			entity.index = m_freeSlots.back();
+			m_freeSlots.pop_back();
+		}
+		entity.generation = m_generations[entity.index];
+
+		m_sparse[entity.index] = size();
+		m_entities.push_back(entity);
+		m_transforms.push(transform);
+		m_modelHandles.push_back(NO_MODEL);
+		m_colors.push_back(glm::vec3{});
+		return entity;
+	}
 
-	glm::mat4 TransformComponent::mat4()
+	bool skGameObjectRegistry::destroy(skEntity entity)
 	{
-		const float c3 = glm::cos(rotation.z);
-		const float s3 = glm::sin(rotation.z);
-		const float c2 = glm::cos(rotation.x);
-		const float s2 = glm::sin(rotation.x);
-		const float c1 = glm::cos(rotation.y);
-		const float s1 = glm::sin(rotation.y);
-		return glm::mat4{
-			{
-				scale.x * (c1 * c3 + s1 * s2 * s3),
-				scale.x * (c2 * s3),
-				scale.x * (c1 * s2 * s3 - c3 * s1),
-				0.0f,
-			},
-			{
-				scale.y * (c3 * s1 * s2 - c1 * s3),
-				scale.y * (c2 * c3),
-				scale.y * (c1 * c3 * s2 + s1 * s3),
-				0.0f,
-			},
-			{
-				scale.z * (c2 * s1),
-				scale.z * (-s2),
-				scale.z * (c1 * c2),
-				0.0f,
-			},
-			{translation.x, translation.y, translation.z, 1.0f} };
+		if (!contains(entity))
+			return false;
+
+		// the last object fills the hole, so the arrays stay dense
+		const uint32_t hole = m_sparse[entity.index];
+		const uint32_t last = size() - 1;
+		if (hole != last)
+		{
+			m_entities[hole] = m_entities[last];
+			m_modelHandles[hole] = m_modelHandles[last];
+			m_colors[hole] = m_colors[last];
+			m_sparse[m_entities[hole].index] = hole;
+		}
+		m_entities.pop_back();
+		m_transforms.removeSwap(hole);
+		m_modelHandles.pop_back();
+		m_colors.pop_back();
+
+		m_sparse[entity.index] = skEntity::INVALID_INDEX;
+		m_generations[entity.index]++;
+		m_freeSlots.push_back(entity.index);
+		return true;
 	}
 
-	glm::mat3 TransformComponent::normalMatrix()
+	void skGameObjectRegistry::clear()
 	{
-		const float c3 = glm::cos(rotation.z);
-		const float s3 = glm::sin(rotation.z);
-		const float c2 = glm::cos(rotation.x);
-		const float s2 = glm::sin(rotation.x);
-		const float c1 = glm::cos(rotation.y);
-		const float s1 = glm::sin(rotation.y);
-		const glm::vec3 invScale = 1.f / scale;
+		for (const skEntity &entity : m_entities)
+		{
+			m_sparse[entity.index] = skEntity::INVALID_INDEX;
+			m_generations[entity.index]++;
+			m_freeSlots.push_back(entity.index);
+		}
+		m_entities.clear();
+		m_transforms.clear();
+		m_modelHandles.clear();
+		m_colors.clear();
+		m_models.clear();
+		m_modelIndices.clear();
+	}
 
+	void skGameObjectRegistry::reserve(uint32_t count)
+	{
+		m_sparse.reserve(count);
+		m_generations.reserve(count);
+		m_entities.reserve(count);
+		m_transforms.reserve(count);
+		m_modelHandles.reserve(count);
+		m_colors.reserve(count);
+	}
+
+	skGameObjectRegistry::ModelHandle skGameObjectRegistry::addModel(std::shared_ptr<skModel> model)
+	{
+		if (model == nullptr)
+			return NO_MODEL;
+		auto [it, inserted] = m_modelIndices.try_emplace(model.get(), static_cast<ModelHandle>(m_models.size()));
+		if (inserted)
+			m_models.push_back(std::move(model));
+		return it->second;
+	}
 
-		return glm::mat3 {
-			{
-				invScale.x * (c1 * c3 + s1 * s2 * s3),
-				invScale.x * (c2 * s3),
-				invScale.x * (c1 * s2 * s3 - c3 * s1),
-			},
-			{
-				invScale.y * (c3 * s1 * s2 - c1 * s3),
-				invScale.y * (c2 * c3),
-				invScale.y * (c1 * c3 * s2 + s1 * s3),
-			},
-			{
-				invScale.z * (c2 * s1),
-				invScale.z * (-s2),
-				invScale.z * (c1 * c2),
-			},
-		};
+	void skGameObjectRegistry::releaseModel(ModelHandle handle)
+	{
+		assert(handle < m_models.size() && "Invalid ModelHandle");
+		if (m_models[handle] == nullptr)
+			return;
+		m_modelIndices.erase(m_models[handle].get());
+		m_models[handle].reset();
+		std::replace(m_modelHandles.begin(), m_modelHandles.end(), handle, NO_MODEL);
 	}
 
 } // namespace sk
\ No newline at end of file
@@ -1,60 +1,111 @@
 #pragma once
 
-//libs
-#include <glm/gtc/matrix_transform.hpp>
-
 #include "model/skModel.h"
+#include "skTransformSystem.h"
 
 // std
+#include <cassert>
+#include <cstdint>
 #include <memory>
+#include <span>
 #include <unordered_map>
+#include <vector>
 
 namespace sk
 {
-	struct TransformComponent
+	// handle of a game object. index is its slot in the registry, generation counts how often that slot was reused, so the
+	//   handle of a destroyed object never resolves to whatever took its slot later
+	struct skEntity
 	{
-		glm::vec3 translation{}; // (position offset)
-		glm::vec3 scale{ 1.f, 1.f, 1.f};
-		glm::vec3 rotation{};
-
-		// Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
-		// Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
-		// https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
-		// This is more efficient than our previous way of computing the rotation.
-		glm::mat4 mat4();
-
-		// transform for normal vectors. requires a different procedure (inverse-transpose of model transformation matrix --> [(M)^-1]^T )
-		glm::mat3 normalMatrix();
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+
+		uint32_t index = INVALID_INDEX;
+		uint32_t generation = 0;
+
+		bool operator==(const skEntity &other) const = default;
 	};
 
-	class skGameObject
+	/* Game objects as a sparse set: each component lives in a dense array, element i of every array belongs to
+	 *   entities()[i]. render systems walk the arrays front to back instead of hopping between hash nodes, so iteration is
+	 *   linear in the object count. the sparse array maps an entity's slot to its dense index, create and destroy are
+	 *   O(1) (destroy moves the last object into the hole, dense order is not stable across it).
+	 *   transforms are a skTransformSystem, which splits them by axis and caches their matrices between changes.
+	 *   models are kept once in a table of the registry and referenced by index, objects sharing a model no longer
+	 *   touch a reference count. */
+	class skGameObjectRegistry
 	{
 	public:
-		using id_t = unsigned int;
-		using Map = std::unordered_map<id_t, skGameObject>;
+		using ModelHandle = uint32_t;
+		static constexpr ModelHandle NO_MODEL = ~0u;
+
+		skGameObjectRegistry() = default;
+
+		skGameObjectRegistry(const skGameObjectRegistry &) = delete;
+		skGameObjectRegistry &operator=(const skGameObjectRegistry &) = delete;
 
-		static skGameObject createGameObject()
+		skEntity create(const TransformComponent &transform = {});
+		// false when entity was already destroyed
+		bool destroy(skEntity entity);
+		bool contains(skEntity entity) const
 		{
-			static id_t currentId = 0;
-			return skGameObject{ currentId++ }; // assigns a unique id each on call.
+			return entity.index < m_sparse.size() && m_generations[entity.index] == entity.generation && m_sparse[entity.index] != skEntity::INVALID_INDEX;
 		}
+		// objects and models. handles given out before stay invalid, generations are kept
+		void clear();
+		void reserve(uint32_t count);
+		uint32_t size() const { return static_cast<uint32_t>(m_entities.size()); }
 
-		// delete copy constructors
-		skGameObject(const skGameObject &) = delete;
-		skGameObject &operator=(const skGameObject &) = delete;
-		// default move operators (somehow used when std::move() is used?)
-		skGameObject(skGameObject&&) = default;
-		skGameObject& operator=(skGameObject&&) = default;
+		// components of a live entity. the whole transform gathers (and on set compares) all nine floats, the single
+		//   components below only touch their own three arrays
+		TransformComponent transform(skEntity entity) const { return m_transforms.get(denseIndex(entity)); }
+		void setTransform(skEntity entity, const TransformComponent &transform) { m_transforms.set(denseIndex(entity), transform); }
+		glm::vec3 translation(skEntity entity) const { return m_transforms.translation(denseIndex(entity)); }
+		void setTranslation(skEntity entity, const glm::vec3 &translation) { m_transforms.setTranslation(denseIndex(entity), translation); }
+		glm::vec3 rotation(skEntity entity) const { return m_transforms.rotation(denseIndex(entity)); }
+		void setRotation(skEntity entity, const glm::vec3 &rotation) { m_transforms.setRotation(denseIndex(entity), rotation); }
+		glm::vec3 scale(skEntity entity) const { return m_transforms.scale(denseIndex(entity)); }
+		void setScale(skEntity entity, const glm::vec3 &scale) { m_transforms.setScale(denseIndex(entity), scale); }
+		glm::vec3 &color(skEntity entity) { return m_colors[denseIndex(entity)]; }
+		ModelHandle modelHandle(skEntity entity) const { return m_modelHandles[denseIndex(entity)]; }
+		void setModel(skEntity entity, ModelHandle model) { m_modelHandles[denseIndex(entity)] = model; }
 
-		inline id_t getId() const { return m_id; }
+		// adds model to the table, or returns its handle when already there. the table only grows until clear(), released
+		//   slots stay empty so no handle ever refers to another model
+		ModelHandle addModel(std::shared_ptr<skModel> model);
+		// drops the table's reference to a model and leaves the objects using it without one. the model goes once nothing
+		//   else holds it, its geometry once the frames drawing it retired (see skGeometryArena::free)
+		void releaseModel(ModelHandle handle);
+		// nullptr for NO_MODEL and released models
+		skModel *model(ModelHandle handle) const { return handle == NO_MODEL ? nullptr : m_models[handle].get(); }
+		uint32_t modelCount() const { return static_cast<uint32_t>(m_models.size()); }
 
-		std::shared_ptr<skModel> model{};
-		glm::vec3 color{};
-		TransformComponent transform{};
+		// dense arrays, all of size(), and the transforms by dense index
+		std::span<const skEntity> entities() const { return m_entities; }
+		skTransformSystem &transforms() { return m_transforms; }
+		const skTransformSystem &transforms() const { return m_transforms; }
+		std::span<const ModelHandle> modelHandles() const { return m_modelHandles; }
+		std::span<glm::vec3> colors() { return m_colors; }
+		std::span<const glm::vec3> colors() const { return m_colors; }
 
 	private:
-		// constructor is private to ensure every game object has a unique id
-		skGameObject(id_t objId) : m_id{ objId } {}
-		id_t m_id;
+		uint32_t denseIndex(skEntity entity) const
+		{
+			assert(contains(entity) && "Stale or invalid skEntity");
+			return m_sparse[entity.index];
+		}
+
+		// by entity index
+		std::vector<uint32_t> m_sparse{};		// dense index, INVALID_INDEX while the slot is free
+		std::vector<uint32_t> m_generations{};
+		std::vector<uint32_t> m_freeSlots{};
+
+		// dense
+		std::vector<skEntity> m_entities{};
+		skTransformSystem m_transforms{};
+		std::vector<ModelHandle> m_modelHandles{};
+		std::vector<glm::vec3> m_colors{};
+
+		std::vector<std::shared_ptr<skModel>> m_models{};
+		std::unordered_map<const skModel*, ModelHandle> m_modelIndices{};
 	};
 } // namespace sk
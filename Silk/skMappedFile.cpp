@@ -0,0 +1,126 @@
+#include "skMappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace sk
+{
+	skMappedFile::~skMappedFile() { close(); }
+
+#ifdef _WIN32
+	bool skMappedFile::open(const std::string& filepath)
+	{
+		close();
+
+		HANDLE file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+			return false;
+
+		LARGE_INTEGER fileSize{};
+		if (!GetFileSizeEx(file, &fileSize))
+		{
+			CloseHandle(file);
+			return false;
+		}
+
+		m_fileHandle = file;
+		m_size = static_cast<size_t>(fileSize.QuadPart);
+		m_isOpen = true;
+
+		// CreateFileMapping refuses zero sized files, so an empty file is "open" with no data
+		if (m_size == 0)
+			return true;
+
+		HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (mapping == nullptr)
+		{
+			close();
+			return false;
+		}
+		m_mappingHandle = mapping;
+
+		m_data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		if (m_data == nullptr)
+		{
+			close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void skMappedFile::close()
+	{
+		if (m_data)
+			UnmapViewOfFile(m_data);
+		if (m_mappingHandle)
+			CloseHandle(static_cast<HANDLE>(m_mappingHandle));
+		if (m_fileHandle)
+			CloseHandle(static_cast<HANDLE>(m_fileHandle));
+
+		m_data = nullptr;
+		m_mappingHandle = nullptr;
+		m_fileHandle = nullptr;
+		m_size = 0;
+		m_isOpen = false;
+	}
+#else
+	bool skMappedFile::open(const std::string& filepath)
+	{
+		close();
+
+		int fd = ::open(filepath.c_str(), O_RDONLY);
+		if (fd < 0)
+			return false;
+
+		struct stat st{};
+		if (fstat(fd, &st) != 0)
+		{
+			::close(fd);
+			return false;
+		}
+
+		m_fd = fd;
+		m_size = static_cast<size_t>(st.st_size);
+		m_isOpen = true;
+
+		// mmap refuses zero sized mappings, so an empty file is "open" with no data
+		if (m_size == 0)
+			return true;
+
+		void *mapped = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (mapped == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+		m_data = mapped;
+
+		// we read front to back, let the kernel prefetch accordingly
+		madvise(mapped, m_size, MADV_SEQUENTIAL);
+		return true;
+	}
+
+	void skMappedFile::close()
+	{
+		if (m_data)
+			munmap(const_cast<void*>(m_data), m_size);
+		if (m_fd >= 0)
+			::close(m_fd);
+
+		m_data = nullptr;
+		m_fd = -1;
+		m_size = 0;
+		m_isOpen = false;
+	}
+#endif
+
+} // namespace sk
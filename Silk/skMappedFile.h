@@ -0,0 +1,40 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <string>
+
+namespace sk
+{
+	// read-only memory mapping of a whole file. the mapping lives as long as the object does.
+	class skMappedFile
+	{
+	public:
+		skMappedFile() = default;
+		~skMappedFile();
+
+		// delete copy constructors, the object owns os handles
+		skMappedFile(const skMappedFile&) = delete;
+		skMappedFile &operator=(const skMappedFile&) = delete;
+
+		// returns false if the file does not exist or cannot be mapped; an empty file maps to size() == 0
+		bool open(const std::string& filepath);
+		void close();
+
+		inline bool isOpen() const { return m_isOpen; }
+		inline const void *data() const { return m_data; }
+		inline size_t size() const { return m_size; }
+
+	private:
+		const void *m_data = nullptr;
+		size_t m_size = 0;
+		bool m_isOpen = false;
+
+#ifdef _WIN32
+		void *m_fileHandle = nullptr;
+		void *m_mappingHandle = nullptr;
+#else
+		int m_fd = -1;
+#endif
+	};
+} // namespace sk
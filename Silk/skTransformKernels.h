@@ -0,0 +1,131 @@
+#pragma once
+
+// std
+#include <cstdint>
+
+// the x86 kernels need SSE2, which every x64 (and /arch:SSE2 x86) target has. elsewhere skTransformSystem stays scalar
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SK_TRANSFORM_SSE2
+#endif
+
+namespace sk
+{
+	// the structure-of-arrays inputs and matrix outputs of skTransformSystem, as the kernels see them
+	struct TransformArrays
+	{
+		const float *translation[3];
+		const float *rotation[3];
+		const float *scale[3];
+		float *modelMatrices;	// 16 floats per object, column major like glm::mat4
+		float *normalMatrices;	// the same layout, the mat3 in the upper left and w = 1
+	};
+
+	// objects per kernel call, skTransformSystem keeps its arrays padded to a multiple of it
+	constexpr uint32_t TRANSFORM_BLOCK_SIZE = 8;
+	// the kernels' sincos reduces by pi / 4 in three parts (Cephes), accurate up to here. blocks holding a larger angle
+	//   return false and go through the scalar path instead
+	constexpr float TRANSFORM_KERNEL_MAX_ANGLE = 8192.f;
+
+	// evaluates the TRANSFORM_BLOCK_SIZE objects from first, false (and nothing written) when an angle is out of range
+	using TransformKernel = bool (*)(const TransformArrays &arrays, uint32_t first);
+
+	// null when not built for this target or, for AVX2, not supported by the CPU running it
+	TransformKernel transformKernelSse2();
+	TransformKernel transformKernelAvx2();
+
+	/* The kernel shared by skTransformKernelsSse2.cpp and skTransformKernelsAvx2.cpp, each instantiating it with a
+	 *   wrapper of its intrinsics (Ops::Float and Ops::Int, WIDTH lanes). the AVX2 file is compiled for AVX2 on its own,
+	 *   so nothing but this header and the intrinsics may be included there: an inline function it shares with the
+	 *   rest of the program could end up in the binary as the AVX2 copy. */
+	template<typename Ops>
+	inline void sinCos(typename Ops::Float x, typename Ops::Float &sin, typename Ops::Float &cos)
+	{
+		using Float = typename Ops::Float;
+		using Int = typename Ops::Int;
+
+		const Float signSin = Ops::bitAnd(x, Ops::set(-0.f));
+		x = Ops::abs(x);
+
+		// octant j rounded up to even, x - j * pi / 4 in three steps to keep the bits the product loses
+		Int j = Ops::toInt(Ops::mul(x, Ops::set(1.27323954473516f)));
+		j = Ops::andInt(Ops::addInt(j, Ops::setInt(1)), Ops::setInt(~1));
+		const Float y = Ops::toFloat(j);
+		x = Ops::add(x, Ops::mul(y, Ops::set(-0.78515625f)));
+		x = Ops::add(x, Ops::mul(y, Ops::set(-2.4187564849853515625e-4f)));
+		x = Ops::add(x, Ops::mul(y, Ops::set(-3.77489497744594108e-8f)));
+
+		const Float flipSin = Ops::asFloat(Ops::shiftSign(Ops::andInt(j, Ops::setInt(4))));
+		const Float signCos = Ops::asFloat(Ops::shiftSign(Ops::andNotInt(Ops::subInt(j, Ops::setInt(2)), Ops::setInt(4))));
+		const Float sinPolynomial = Ops::asFloat(Ops::isZero(Ops::andInt(j, Ops::setInt(2))));
+
+		const Float z = Ops::mul(x, x);
+		Float polyCos = Ops::add(Ops::mul(Ops::set(2.443315711809948e-5f), z), Ops::set(-1.388731625493765e-3f));
+		polyCos = Ops::add(Ops::mul(polyCos, z), Ops::set(4.166664568298827e-2f));
+		polyCos = Ops::mul(Ops::mul(polyCos, z), z);
+		polyCos = Ops::add(Ops::sub(polyCos, Ops::mul(z, Ops::set(.5f))), Ops::set(1.f));
+		Float polySin = Ops::add(Ops::mul(Ops::set(-1.9515295891e-4f), z), Ops::set(8.3321608736e-3f));
+		polySin = Ops::add(Ops::mul(polySin, z), Ops::set(-1.6666654611e-1f));
+		polySin = Ops::add(Ops::mul(Ops::mul(polySin, z), x), x);
+
+		// octants 1 and 2 (mod 4) swap the polynomials
+		sin = Ops::bitXor(Ops::select(sinPolynomial, polySin, polyCos), Ops::bitXor(signSin, flipSin));
+		cos = Ops::bitXor(Ops::select(sinPolynomial, polyCos, polySin), signCos);
+	}
+
+	// same products in the same order as TransformComponent::mat4() and normalMatrix(), only sin and cos differ
+	template<typename Ops>
+	inline bool evaluateTransformBlock(const TransformArrays &arrays, uint32_t first)
+	{
+		using Float = typename Ops::Float;
+
+		const Float maxAngle = Ops::set(TRANSFORM_KERNEL_MAX_ANGLE);
+		for (uint32_t i = first; i < first + TRANSFORM_BLOCK_SIZE; i += Ops::WIDTH)
+		{
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				if (Ops::anyGreater(Ops::abs(Ops::load(arrays.rotation[axis] + i)), maxAngle))
+					return false;
+			}
+		}
+
+		const Float zero = Ops::set(0.f);
+		const Float one = Ops::set(1.f);
+		for (uint32_t i = first; i < first + TRANSFORM_BLOCK_SIZE; i += Ops::WIDTH)
+		{
+			Float s1, c1, s2, c2, s3, c3;
+			sinCos<Ops>(Ops::load(arrays.rotation[1] + i), s1, c1);
+			sinCos<Ops>(Ops::load(arrays.rotation[0] + i), s2, c2);
+			sinCos<Ops>(Ops::load(arrays.rotation[2] + i), s3, c3);
+
+			const Float r00 = Ops::add(Ops::mul(c1, c3), Ops::mul(Ops::mul(s1, s2), s3));
+			const Float r01 = Ops::mul(c2, s3);
+			const Float r02 = Ops::sub(Ops::mul(Ops::mul(c1, s2), s3), Ops::mul(c3, s1));
+			const Float r10 = Ops::sub(Ops::mul(Ops::mul(c3, s1), s2), Ops::mul(c1, s3));
+			const Float r11 = Ops::mul(c2, c3);
+			const Float r12 = Ops::add(Ops::mul(Ops::mul(c1, c3), s2), Ops::mul(s1, s3));
+			const Float r20 = Ops::mul(c2, s1);
+			const Float r21 = Ops::bitXor(s2, Ops::set(-0.f));
+			const Float r22 = Ops::mul(c1, c2);
+
+			const Float sx = Ops::load(arrays.scale[0] + i);
+			const Float sy = Ops::load(arrays.scale[1] + i);
+			const Float sz = Ops::load(arrays.scale[2] + i);
+			float *model = arrays.modelMatrices + i * 16;
+			Ops::storeColumns(model + 0, Ops::mul(sx, r00), Ops::mul(sx, r01), Ops::mul(sx, r02), zero);
+			Ops::storeColumns(model + 4, Ops::mul(sy, r10), Ops::mul(sy, r11), Ops::mul(sy, r12), zero);
+			Ops::storeColumns(model + 8, Ops::mul(sz, r20), Ops::mul(sz, r21), Ops::mul(sz, r22), zero);
+			Ops::storeColumns(model + 12, Ops::load(arrays.translation[0] + i), Ops::load(arrays.translation[1] + i),
+				Ops::load(arrays.translation[2] + i), one);
+
+			const Float ix = Ops::div(one, sx);
+			const Float iy = Ops::div(one, sy);
+			const Float iz = Ops::div(one, sz);
+			float *normal = arrays.normalMatrices + i * 16;
+			Ops::storeColumns(normal + 0, Ops::mul(ix, r00), Ops::mul(ix, r01), Ops::mul(ix, r02), zero);
+			Ops::storeColumns(normal + 4, Ops::mul(iy, r10), Ops::mul(iy, r11), Ops::mul(iy, r12), zero);
+			Ops::storeColumns(normal + 8, Ops::mul(iz, r20), Ops::mul(iz, r21), Ops::mul(iz, r22), zero);
+			Ops::storeColumns(normal + 12, zero, zero, zero, one);
+		}
+		return true;
+	}
+} // namespace sk
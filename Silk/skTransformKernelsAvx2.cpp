@@ -0,0 +1,92 @@
+// compiled with AVX2 enabled (-mavx2, /arch:AVX2 on x64), see skTransformKernels.h before including anything else here
+#include "skTransformKernels.h"
+
+// msvc accepts the AVX2 intrinsics without /arch:AVX2, gcc and clang only when the file is built for it
+#if defined(SK_TRANSFORM_SSE2) && (defined(__AVX2__) || defined(_MSC_VER))
+#define SK_TRANSFORM_AVX2
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+namespace sk
+{
+#ifdef SK_TRANSFORM_AVX2
+	namespace
+	{
+		struct Avx2
+		{
+			static constexpr uint32_t WIDTH = 8;
+			using Float = __m256;
+			using Int = __m256i;
+
+			static Float set(float value) { return _mm256_set1_ps(value); }
+			static Float load(const float *source) { return _mm256_loadu_ps(source); }
+			static Float add(Float a, Float b) { return _mm256_add_ps(a, b); }
+			static Float sub(Float a, Float b) { return _mm256_sub_ps(a, b); }
+			static Float mul(Float a, Float b) { return _mm256_mul_ps(a, b); }
+			static Float div(Float a, Float b) { return _mm256_div_ps(a, b); }
+			static Float bitAnd(Float a, Float b) { return _mm256_and_ps(a, b); }
+			static Float bitXor(Float a, Float b) { return _mm256_xor_ps(a, b); }
+			static Float abs(Float a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+			static Float select(Float mask, Float a, Float b) { return _mm256_blendv_ps(b, a, mask); }
+			static bool anyGreater(Float a, Float b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ)) != 0; }
+
+			static Int setInt(int value) { return _mm256_set1_epi32(value); }
+			static Int toInt(Float a) { return _mm256_cvttps_epi32(a); }
+			static Float toFloat(Int a) { return _mm256_cvtepi32_ps(a); }
+			static Float asFloat(Int a) { return _mm256_castsi256_ps(a); }
+			static Int addInt(Int a, Int b) { return _mm256_add_epi32(a, b); }
+			static Int subInt(Int a, Int b) { return _mm256_sub_epi32(a, b); }
+			static Int andInt(Int a, Int b) { return _mm256_and_si256(a, b); }
+			static Int andNotInt(Int a, Int b) { return _mm256_andnot_si256(a, b); }
+			static Int shiftSign(Int a) { return _mm256_slli_epi32(a, 29); } // bit 2 to the sign bit
+			static Int isZero(Int a) { return _mm256_cmpeq_epi32(a, _mm256_setzero_si256()); }
+
+			// column (x, y, z, w) of WIDTH objects, lane k to destination + k * 16. the shuffles stay within 128 bit
+			//   halves, so the low half ends up with objects 0 to 3 and the high half with 4 to 7
+			static void storeColumns(float *destination, Float x, Float y, Float z, Float w)
+			{
+				const Float xy0 = _mm256_unpacklo_ps(x, y);
+				const Float xy1 = _mm256_unpackhi_ps(x, y);
+				const Float zw0 = _mm256_unpacklo_ps(z, w);
+				const Float zw1 = _mm256_unpackhi_ps(z, w);
+				const Float columns[4] = {
+					_mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(1, 0, 1, 0)),
+					_mm256_shuffle_ps(xy0, zw0, _MM_SHUFFLE(3, 2, 3, 2)),
+					_mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(1, 0, 1, 0)),
+					_mm256_shuffle_ps(xy1, zw1, _MM_SHUFFLE(3, 2, 3, 2)),
+				};
+				for (uint32_t k = 0; k < 4; k++)
+				{
+					_mm_storeu_ps(destination + k * 16, _mm256_castps256_ps128(columns[k]));
+					_mm_storeu_ps(destination + (k + 4) * 16, _mm256_extractf128_ps(columns[k], 1));
+				}
+			}
+		};
+
+		bool evaluateAvx2(const TransformArrays &arrays, uint32_t first) { return evaluateTransformBlock<Avx2>(arrays, first); }
+
+		bool cpuSupportsAvx2()
+		{
+#ifdef _MSC_VER
+			// AVX2 in leaf 7, and the OS saving the ymm registers (OSXSAVE, AVX, XCR0 bits 1 and 2)
+			int info[4];
+			__cpuid(info, 1);
+			if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6)
+				return false;
+			__cpuidex(info, 7, 0);
+			return (info[1] & (1 << 5)) != 0;
+#else
+			__builtin_cpu_init();
+			return __builtin_cpu_supports("avx2");
+#endif
+		}
+	} // namespace
+
+	TransformKernel transformKernelAvx2() { return cpuSupportsAvx2() ? evaluateAvx2 : nullptr; }
+#else
+	TransformKernel transformKernelAvx2() { return nullptr; }
+#endif
+} // namespace sk
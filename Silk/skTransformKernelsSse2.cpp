@@ -0,0 +1,59 @@
+#include "skTransformKernels.h"
+
+#ifdef SK_TRANSFORM_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace sk
+{
+#ifdef SK_TRANSFORM_SSE2
+	namespace
+	{
+		struct Sse2
+		{
+			static constexpr uint32_t WIDTH = 4;
+			using Float = __m128;
+			using Int = __m128i;
+
+			static Float set(float value) { return _mm_set1_ps(value); }
+			static Float load(const float *source) { return _mm_loadu_ps(source); }
+			static Float add(Float a, Float b) { return _mm_add_ps(a, b); }
+			static Float sub(Float a, Float b) { return _mm_sub_ps(a, b); }
+			static Float mul(Float a, Float b) { return _mm_mul_ps(a, b); }
+			static Float div(Float a, Float b) { return _mm_div_ps(a, b); }
+			static Float bitAnd(Float a, Float b) { return _mm_and_ps(a, b); }
+			static Float bitXor(Float a, Float b) { return _mm_xor_ps(a, b); }
+			static Float abs(Float a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+			static Float select(Float mask, Float a, Float b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+			static bool anyGreater(Float a, Float b) { return _mm_movemask_ps(_mm_cmpgt_ps(a, b)) != 0; }
+
+			static Int setInt(int value) { return _mm_set1_epi32(value); }
+			static Int toInt(Float a) { return _mm_cvttps_epi32(a); }
+			static Float toFloat(Int a) { return _mm_cvtepi32_ps(a); }
+			static Float asFloat(Int a) { return _mm_castsi128_ps(a); }
+			static Int addInt(Int a, Int b) { return _mm_add_epi32(a, b); }
+			static Int subInt(Int a, Int b) { return _mm_sub_epi32(a, b); }
+			static Int andInt(Int a, Int b) { return _mm_and_si128(a, b); }
+			static Int andNotInt(Int a, Int b) { return _mm_andnot_si128(a, b); }
+			static Int shiftSign(Int a) { return _mm_slli_epi32(a, 29); } // bit 2 to the sign bit
+			static Int isZero(Int a) { return _mm_cmpeq_epi32(a, _mm_setzero_si128()); }
+
+			// column (x, y, z, w) of WIDTH objects, lane k to destination + k * 16
+			static void storeColumns(float *destination, Float x, Float y, Float z, Float w)
+			{
+				_MM_TRANSPOSE4_PS(x, y, z, w);
+				_mm_storeu_ps(destination, x);
+				_mm_storeu_ps(destination + 16, y);
+				_mm_storeu_ps(destination + 32, z);
+				_mm_storeu_ps(destination + 48, w);
+			}
+		};
+
+		bool evaluateSse2(const TransformArrays &arrays, uint32_t first) { return evaluateTransformBlock<Sse2>(arrays, first); }
+	} // namespace
+
+	TransformKernel transformKernelSse2() { return evaluateSse2; }
+#else
+	TransformKernel transformKernelSse2() { return nullptr; }
+#endif
+} // namespace sk
@@ -0,0 +1,241 @@
+#include "skTransformSystem.h"
+
+// std
+#include <algorithm>
+#include <cstring>
+
+namespace sk
+{
+	glm::mat4 TransformComponent::mat4()
+	{
+		const float c3 = glm::cos(rotation.z);
+		const float s3 = glm::sin(rotation.z);
+		const float c2 = glm::cos(rotation.x);
+		const float s2 = glm::sin(rotation.x);
+		const float c1 = glm::cos(rotation.y);
+		const float s1 = glm::sin(rotation.y);
+		return glm::mat4{
+			{
+				scale.x * (c1 * c3 + s1 * s2 * s3),
+				scale.x * (c2 * s3),
+				scale.x * (c1 * s2 * s3 - c3 * s1),
+				0.0f,
+			},
+			{
+				scale.y * (c3 * s1 * s2 - c1 * s3),
+				scale.y * (c2 * c3),
+				scale.y * (c1 * c3 * s2 + s1 * s3),
+				0.0f,
+			},
+			{
+				scale.z * (c2 * s1),
+				scale.z * (-s2),
+				scale.z * (c1 * c2),
+				0.0f,
+			},
+			{translation.x, translation.y, translation.z, 1.0f} };
+	}
+
+	glm::mat3 TransformComponent::normalMatrix()
+	{
+		const float c3 = glm::cos(rotation.z);
+		const float s3 = glm::sin(rotation.z);
+		const float c2 = glm::cos(rotation.x);
+		const float s2 = glm::sin(rotation.x);
+		const float c1 = glm::cos(rotation.y);
+		const float s1 = glm::sin(rotation.y);
+		const glm::vec3 invScale = 1.f / scale;
+
+		return glm::mat3 {
+			{
+				invScale.x * (c1 * c3 + s1 * s2 * s3),
+				invScale.x * (c2 * s3),
+				invScale.x * (c1 * s2 * s3 - c3 * s1),
+			},
+			{
+				invScale.y * (c3 * s1 * s2 - c1 * s3),
+				invScale.y * (c2 * c3),
+				invScale.y * (c1 * c3 * s2 + s1 * s3),
+			},
+			{
+				invScale.z * (c2 * s1),
+				invScale.z * (-s2),
+				invScale.z * (c1 * c2),
+			},
+		};
+	}
+
+	skTransformSystem::skTransformSystem()
+	{
+		setKernel(Kernel::Avx2);
+	}
+
+	void skTransformSystem::push(const TransformComponent &transform)
+	{
+		if (m_size == m_dirty.size())
+		{
+			// another block of identity transforms, kernels always read whole blocks
+			const size_t padded = m_dirty.size() + TRANSFORM_BLOCK_SIZE;
+			for (uint32_t axis = 0; axis < 3; axis++)
+			{
+				m_translation[axis].resize(padded, 0.f);
+				m_rotation[axis].resize(padded, 0.f);
+				m_scale[axis].resize(padded, 1.f);
+			}
+			m_modelMatrices.resize(padded, glm::mat4{ 1.f });
+			m_normalMatrices.resize(padded, glm::mat4{ 1.f });
+			m_dirty.resize(padded, 0);
+		}
+
+		const uint32_t index = m_size++;
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			m_translation[axis][index] = transform.translation[axis];
+			m_rotation[axis][index] = transform.rotation[axis];
+			m_scale[axis][index] = transform.scale[axis];
+		}
+		m_dirty[index] = 1;
+	}
+
+	void skTransformSystem::removeSwap(uint32_t index)
+	{
+		const uint32_t last = m_size - 1;
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			m_translation[axis][index] = m_translation[axis][last];
+			m_rotation[axis][index] = m_rotation[axis][last];
+			m_scale[axis][index] = m_scale[axis][last];
+
+			// back to padding
+			m_translation[axis][last] = 0.f;
+			m_rotation[axis][last] = 0.f;
+			m_scale[axis][last] = 1.f;
+		}
+		m_modelMatrices[index] = m_modelMatrices[last];
+		m_normalMatrices[index] = m_normalMatrices[last];
+		m_dirty[index] = m_dirty[last];
+		m_dirty[last] = 0;
+		m_size--;
+	}
+
+	void skTransformSystem::clear()
+	{
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			m_translation[axis].clear();
+			m_rotation[axis].clear();
+			m_scale[axis].clear();
+		}
+		m_modelMatrices.clear();
+		m_normalMatrices.clear();
+		m_dirty.clear();
+		m_size = 0;
+	}
+
+	void skTransformSystem::reserve(uint32_t count)
+	{
+		const size_t padded = (static_cast<size_t>(count) + TRANSFORM_BLOCK_SIZE - 1) / TRANSFORM_BLOCK_SIZE * TRANSFORM_BLOCK_SIZE;
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			m_translation[axis].reserve(padded);
+			m_rotation[axis].reserve(padded);
+			m_scale[axis].reserve(padded);
+		}
+		m_modelMatrices.reserve(padded);
+		m_normalMatrices.reserve(padded);
+		m_dirty.reserve(padded);
+	}
+
+	TransformComponent skTransformSystem::get(uint32_t index) const
+	{
+		TransformComponent transform{};
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			transform.translation[axis] = m_translation[axis][index];
+			transform.rotation[axis] = m_rotation[axis][index];
+			transform.scale[axis] = m_scale[axis][index];
+		}
+		return transform;
+	}
+
+	void skTransformSystem::set(uint32_t index, const TransformComponent &transform)
+	{
+		// the simulation hands over every transform each tick, most of them unchanged
+		if (get(index) == transform)
+			return;
+		for (uint32_t axis = 0; axis < 3; axis++)
+		{
+			m_translation[axis][index] = transform.translation[axis];
+			m_rotation[axis][index] = transform.rotation[axis];
+			m_scale[axis][index] = transform.scale[axis];
+		}
+		m_dirty[index] = 1;
+	}
+
+	void skTransformSystem::markAllDirty()
+	{
+		std::memset(m_dirty.data(), 1, m_size);
+	}
+
+	uint32_t skTransformSystem::update(uint32_t firstBlock, uint32_t lastBlock)
+	{
+		static_assert(TRANSFORM_BLOCK_SIZE == sizeof(uint64_t), "a block's dirty flags are tested as one uint64_t");
+		static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "the kernels write matrices as 16 packed floats");
+
+		const TransformArrays arrays{
+			{ m_translation[0].data(), m_translation[1].data(), m_translation[2].data() },
+			{ m_rotation[0].data(), m_rotation[1].data(), m_rotation[2].data() },
+			{ m_scale[0].data(), m_scale[1].data(), m_scale[2].data() },
+			reinterpret_cast<float *>(m_modelMatrices.data()),
+			reinterpret_cast<float *>(m_normalMatrices.data()),
+		};
+
+		uint32_t evaluated = 0;
+		for (uint32_t block = firstBlock; block < lastBlock; block++)
+		{
+			uint8_t *dirty = m_dirty.data() + block * TRANSFORM_BLOCK_SIZE;
+			uint64_t flags;
+			std::memcpy(&flags, dirty, sizeof(flags));
+			if (flags == 0)
+				continue;
+
+			const uint32_t first = block * TRANSFORM_BLOCK_SIZE;
+			if (m_kernelFn == nullptr || !m_kernelFn(arrays, first))
+				evaluateScalar(first);
+			std::memset(dirty, 0, TRANSFORM_BLOCK_SIZE);
+			evaluated++;
+		}
+		return evaluated;
+	}
+
+	void skTransformSystem::evaluateScalar(uint32_t first)
+	{
+		for (uint32_t i = first; i < std::min(first + TRANSFORM_BLOCK_SIZE, m_size); i++)
+		{
+			TransformComponent transform = get(i);
+			m_modelMatrices[i] = transform.mat4();
+			m_normalMatrices[i] = glm::mat4{ transform.normalMatrix() };
+		}
+	}
+
+	skTransformSystem::Kernel skTransformSystem::setKernel(Kernel kernel)
+	{
+		m_kernelFn = nullptr;
+		if (kernel == Kernel::Avx2 && (m_kernelFn = transformKernelAvx2()) != nullptr)
+			return m_kernel = Kernel::Avx2;
+		if (kernel != Kernel::Scalar && (m_kernelFn = transformKernelSse2()) != nullptr)
+			return m_kernel = Kernel::Sse2;
+		return m_kernel = Kernel::Scalar;
+	}
+
+	const char *skTransformSystem::toString(Kernel kernel)
+	{
+		switch (kernel)
+		{
+		case Kernel::Sse2: return "sse2";
+		case Kernel::Avx2: return "avx2";
+		default: return "scalar";
+		}
+	}
+
+} // namespace sk
@@ -0,0 +1,116 @@
+#pragma once
+
+//libs
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "skTransformKernels.h"
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace sk
+{
+	struct TransformComponent
+	{
+		glm::vec3 translation{}; // (position offset)
+		glm::vec3 scale{ 1.f, 1.f, 1.f};
+		glm::vec3 rotation{};
+
+		// Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
+		// Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
+		// https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
+		// This is more efficient than our previous way of computing the rotation.
+		glm::mat4 mat4();
+
+		// transform for normal vectors. requires a different procedure (inverse-transpose of model transformation matrix --> [(M)^-1]^T )
+		glm::mat3 normalMatrix();
+
+		bool operator==(const TransformComponent &other) const = default;
+	};
+
+	/* The transforms of skGameObjectRegistry, one array per component (translation.x, translation.y, ...) so a SIMD
+	 *   lane maps to an object, plus each object's model and normal matrix as of the last update().
+	 *   TransformComponent::mat4() and normalMatrix() took six sin/cos each for every object every frame, static ones
+	 *   included. set() only marks an object dirty when its transform changed, update() skips blocks of
+	 *   TRANSFORM_BLOCK_SIZE objects without a dirty one and evaluates the others with the widest kernel the CPU has,
+	 *   both matrices in the same pass. the kernels' sincos keeps results within a few ulp of the scalar path (the
+	 *   "transforms" benchmark checks), blocks with angles past TRANSFORM_KERNEL_MAX_ANGLE fall back to it. */
+	class skTransformSystem
+	{
+	public:
+		enum class Kernel { Scalar, Sse2, Avx2 };
+
+		// picks the widest kernel this build and CPU support
+		skTransformSystem();
+
+		skTransformSystem(const skTransformSystem &) = delete;
+		skTransformSystem &operator=(const skTransformSystem &) = delete;
+
+		uint32_t size() const { return m_size; }
+		// dirty until the next update()
+		void push(const TransformComponent &transform);
+		// moves the last object into index, as skGameObjectRegistry::destroy does with the other components
+		void removeSwap(uint32_t index);
+		void clear();
+		void reserve(uint32_t count);
+
+		TransformComponent get(uint32_t index) const;
+		// marks index dirty, unless transform equals the current one
+		void set(uint32_t index, const TransformComponent &transform);
+		void markAllDirty();
+		// single components, mark index dirty without comparing
+		glm::vec3 translation(uint32_t index) const { return load(m_translation, index); }
+		glm::vec3 rotation(uint32_t index) const { return load(m_rotation, index); }
+		glm::vec3 scale(uint32_t index) const { return load(m_scale, index); }
+		void setTranslation(uint32_t index, const glm::vec3 &translation) { store(m_translation, index, translation); }
+		void setRotation(uint32_t index, const glm::vec3 &rotation) { store(m_rotation, index, rotation); }
+		void setScale(uint32_t index, const glm::vec3 &scale) { store(m_scale, index, scale); }
+
+		// evaluates the matrices of the dirty objects
+		void update() { update(0, blockCount()); }
+		// blocks [firstBlock, lastBlock) only, disjoint ranges may be updated on different threads. returns the blocks
+		//   evaluated
+		uint32_t update(uint32_t firstBlock, uint32_t lastBlock);
+		uint32_t blockCount() const { return (m_size + TRANSFORM_BLOCK_SIZE - 1) / TRANSFORM_BLOCK_SIZE; }
+
+		// as of the last update()
+		const glm::mat4 &modelMatrix(uint32_t index) const { return m_modelMatrices[index]; }
+		// the mat3 in the upper left, as the push constants take it
+		const glm::mat4 &normalMatrix(uint32_t index) const { return m_normalMatrices[index]; }
+
+		Kernel kernel() const { return m_kernel; }
+		// falls back to the next narrower kernel while kernel is not available, returns the one in use
+		Kernel setKernel(Kernel kernel);
+		static const char *toString(Kernel kernel);
+
+	private:
+		using Component = std::array<std::vector<float>, 3>;
+
+		static glm::vec3 load(const Component &component, uint32_t index)
+		{
+			return { component[0][index], component[1][index], component[2][index] };
+		}
+		void store(Component &component, uint32_t index, const glm::vec3 &value)
+		{
+			for (uint32_t axis = 0; axis < 3; axis++)
+				component[axis][index] = value[axis];
+			m_dirty[index] = 1;
+		}
+		// objects of the block starting at first, through TransformComponent
+		void evaluateScalar(uint32_t first);
+
+		// by component axis, padded to whole blocks with identity transforms
+		Component m_translation{};
+		Component m_rotation{};
+		Component m_scale{};
+		std::vector<glm::mat4> m_modelMatrices{};
+		std::vector<glm::mat4> m_normalMatrices{};
+		std::vector<uint8_t> m_dirty{};	// one per object, read a block at a time
+		uint32_t m_size = 0;
+
+		Kernel m_kernel = Kernel::Scalar;
+		TransformKernel m_kernelFn = nullptr;	// null for Kernel::Scalar
+	};
+} // namespace sk
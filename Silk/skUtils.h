@@ -1,6 +1,8 @@
 #pragma once
 
 // std
+#include <cstdint>
+#include <cstring>
 #include <functional>
 
 namespace sk
@@ -10,4 +12,35 @@ namespace sk
 		seed ^= std::hash<T>{}(v) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 		(hashCombine(seed, rest), ...);
 	};
+
+	// 64-bit hash of a raw byte range. consumes whole 8-byte words and finishes with the murmur3 avalanche,
+	// which is plenty for content fingerprints and hash tables (not meant to be cryptographic).
+	inline uint64_t hashBytes(const void *data, size_t size, uint64_t seed = 0)
+	{
+		constexpr uint64_t k = 0x9e3779b97f4a7c15ull;
+		const unsigned char *bytes = static_cast<const unsigned char*>(data);
+		uint64_t h = seed ^ (size * k);
+
+		size_t i = 0;
+		for (; i + 8 <= size; i += 8) {
+			uint64_t word;
+			std::memcpy(&word, bytes + i, 8);
+			word *= 0xbf58476d1ce4e5b9ull;
+			word ^= word >> 31;
+			h = (h ^ word) * k;
+			h ^= h >> 29;
+		}
+		if (i < size) {
+			uint64_t tail = 0;
+			std::memcpy(&tail, bytes + i, size - i);
+			h = (h ^ (tail * 0xbf58476d1ce4e5b9ull)) * k;
+		}
+
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdull;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ull;
+		h ^= h >> 33;
+		return h;
+	}
 } // namespace sk